@@ -167,8 +167,8 @@ void initData(RunTimeOpts *rtOpts, PtpClock *ptpClock)
 	    ptpClock->netPath.interfaceID[PTP_UUID_LENGTH - 2]);
 
 	/*Init other stuff*/
-	ptpClock->number_foreign_records = 0;
   	ptpClock->max_foreign_records = rtOpts->max_foreign_records;
+	clearForeign(ptpClock);
 }
 
 /* memcmp behaviour: -1: a<b, 1: a>b, 0: a=b */
@@ -200,6 +200,157 @@ cmpPortIdentity(const PortIdentity *a, const PortIdentity *b)
 
 }
 
+/* hash a port identity into a foreign master index slot */
+static UInteger16
+foreignIndexHash(const PortIdentity *portIdentity, UInteger16 size)
+{
+	Octet key[CLOCK_IDENTITY_LENGTH + sizeof(UInteger16)];
+
+	memcpy(key, portIdentity->clockIdentity, CLOCK_IDENTITY_LENGTH);
+	memcpy(key + CLOCK_IDENTITY_LENGTH, &portIdentity->portNumber, sizeof(UInteger16));
+
+	return fnvHash(key, sizeof(key), size);
+}
+
+/* insert foreign[record] into the index */
+void
+indexForeign(int record, PtpClock *ptpClock)
+{
+	UInteger16 slot;
+
+	if(ptpClock->foreignIndex == NULL) {
+		return;
+	}
+
+	slot = foreignIndexHash(&ptpClock->foreign[record].foreignMasterPortIdentity,
+				ptpClock->foreignIndexSize);
+
+	/* the index is at least twice the record size, so a free slot always exists */
+	while(ptpClock->foreignIndex[slot] >= 0) {
+		slot = (slot + 1) % ptpClock->foreignIndexSize;
+	}
+
+	ptpClock->foreignIndex[slot] = record;
+}
+
+/*
+ * (Re)build the foreign master index from the record table, resizing it to
+ * match max_foreign_records. Needed after records are overwritten or the table grows.
+ */
+Boolean
+rebuildForeignIndex(PtpClock *ptpClock)
+{
+	int i;
+	UInteger16 size = 2 * ptpClock->max_foreign_records + 1;
+	Integer16 *index = ptpClock->foreignIndex;
+
+	if(size != ptpClock->foreignIndexSize || index == NULL) {
+		index = (Integer16*)malloc(size * sizeof(Integer16));
+		if(index == NULL) {
+			PERROR("failed to allocate memory for foreign master index");
+			return FALSE;
+		}
+		SAFE_FREE(ptpClock->foreignIndex);
+		ptpClock->foreignIndex = index;
+		ptpClock->foreignIndexSize = size;
+	}
+
+	for(i = 0; i < size; i++) {
+		index[i] = -1;
+	}
+
+	for(i = 0; i < ptpClock->number_foreign_records; i++) {
+		indexForeign(i, ptpClock);
+	}
+
+	return TRUE;
+}
+
+/* return the foreign[] index of the given port identity, or -1 if not known */
+int
+findForeign(const PortIdentity *portIdentity, const PtpClock *ptpClock)
+{
+	int n, record;
+	UInteger16 slot;
+
+	if(ptpClock->foreignIndex == NULL) {
+		return -1;
+	}
+
+	slot = foreignIndexHash(portIdentity, ptpClock->foreignIndexSize);
+
+	for(n = 0; n < ptpClock->foreignIndexSize; n++) {
+		record = ptpClock->foreignIndex[slot];
+		if(record < 0) {
+			return -1;
+		}
+		if(!cmpPortIdentity(&ptpClock->foreign[record].foreignMasterPortIdentity, portIdentity)) {
+			return record;
+		}
+		slot = (slot + 1) % ptpClock->foreignIndexSize;
+	}
+
+	return -1;
+}
+
+/* drop all foreign master records */
+void
+clearForeign(PtpClock *ptpClock)
+{
+	ptpClock->counters.foreignRemoved += ptpClock->number_foreign_records;
+	ptpClock->number_foreign_records = 0;
+	ptpClock->foreign_record_i = 0;
+	/* slots will be reused: the next bmc() must not trust the old ranking */
+	ptpClock->bmcChanged = BMC_CHANGED_ALL;
+	ptpClock->counters.foreignCount = 0;
+	rebuildForeignIndex(ptpClock);
+}
+
+/*
+ * Double the foreign master record table, up to ptpengine:foreignrecord_capacity_max.
+ * Returns FALSE if the table cannot grow, and records have to be overwritten.
+ */
+Boolean
+growForeign(const RunTimeOpts *rtOpts, PtpClock *ptpClock)
+{
+	Integer16 oldMax = ptpClock->max_foreign_records;
+	Integer16 newMax;
+	int best = -1;
+	ForeignMasterRecord *records;
+
+	if(rtOpts->foreignRecordCapacityMax <= oldMax) {
+		return FALSE;
+	}
+
+	newMax = min(2 * oldMax, rtOpts->foreignRecordCapacityMax);
+
+	if(ptpClock->bestMaster != NULL) {
+		best = ptpClock->bestMaster - ptpClock->foreign;
+	}
+
+	records = (ForeignMasterRecord*)realloc(ptpClock->foreign, newMax * sizeof(ForeignMasterRecord));
+	if(records == NULL) {
+		PERROR("failed to grow foreign master record");
+		return FALSE;
+	}
+	memset(records + oldMax, 0, (newMax - oldMax) * sizeof(ForeignMasterRecord));
+
+	ptpClock->foreign = records;
+	if(best >= 0) {
+		ptpClock->bestMaster = &records[best];
+	}
+
+	ptpClock->max_foreign_records = newMax;
+	if(!rebuildForeignIndex(ptpClock)) {
+		ptpClock->max_foreign_records = oldMax;
+		return FALSE;
+	}
+
+	INFO("Foreign master record grown from %d to %d entries\n", oldMax, newMax);
+
+	return TRUE;
+}
+
 /* compare portIdentity to an empty one */
 Boolean portIdentityEmpty(PortIdentity *portIdentity) {
 
@@ -753,11 +904,37 @@ bmcStateDecision(ForeignMasterRecord *foreign, const RunTimeOpts *rtOpts, PtpClo
 
 
 
+/*
+ * Request a bmc() run. record is the foreign[] index of the record whose
+ * BMC inputs changed, or BMC_CHANGED_ALL. As long as a single record other
+ * than the best one changed, bmc() only needs to compare it with the best.
+ * Anything else affecting the BMC (D0, disqualification, the best record
+ * itself) must use BMC_CHANGED_ALL.
+ */
+void
+bmcRecordChanged(PtpClock *ptpClock, int record)
+{
+
+	if(ptpClock->bmcChanged == BMC_CHANGED_NONE) {
+		ptpClock->bmcChanged = record;
+	} else if(ptpClock->bmcChanged != record) {
+		ptpClock->bmcChanged = BMC_CHANGED_ALL;
+	}
+
+	ptpClock->record_update = TRUE;
+
+}
+
 UInteger8
 bmc(ForeignMasterRecord *foreignMaster,
     const RunTimeOpts *rtOpts, PtpClock *ptpClock)
 {
 	Integer16 i,best;
+	Integer16 changed = ptpClock->bmcChanged;
+	Boolean incremental;
+
+	ptpClock->bmcChanged = BMC_CHANGED_NONE;
+	ptpClock->counters.bmcRuns++;
 
 	DBGV("number_foreign_records : %d \n", ptpClock->number_foreign_records);
 	if (!ptpClock->number_foreign_records)
@@ -766,14 +943,39 @@ bmc(ForeignMasterRecord *foreignMaster,
 			return ptpClock->portDS.portState;
 		}
 
-	for (i=1,best = 0; i<ptpClock->number_foreign_records;i++)
-		if ((bmcDataSetComparison(&foreignMaster[i], &foreignMaster[best],
-					  ptpClock, rtOpts)) < 0)
-			best = i;
+	best = ptpClock->foreign_record_best;
+
+	/*
+	 * Everything but one record is as it was at the last run, and the
+	 * best record is not the one that changed: the best record is either
+	 * still the best, or beaten by the changed one.
+	 */
+	incremental = changed >= 0 && changed < ptpClock->number_foreign_records &&
+		    best >= 0 && best < ptpClock->number_foreign_records &&
+		    changed != best && ptpClock->bestMaster == &foreignMaster[best];
+
+	if (incremental) {
+		ptpClock->counters.bmcComparisonsSkipped += ptpClock->number_foreign_records - 2;
+		if ((bmcDataSetComparison(&foreignMaster[changed], &foreignMaster[best],
+					  ptpClock, rtOpts)) < 0) {
+			best = changed;
+		} else if (ptpClock->portDS.portState == ptpClock->bmcState) {
+			/* best record and D0 unchanged: the decision would be the same */
+			DBGV("Best record : %d (unchanged)\n", best);
+			ptpClock->counters.bmcDecisionsSkipped++;
+			return ptpClock->portDS.portState;
+		}
+	} else {
+		for (i=1,best = 0; i<ptpClock->number_foreign_records;i++)
+			if ((bmcDataSetComparison(&foreignMaster[i], &foreignMaster[best],
+						  ptpClock, rtOpts)) < 0)
+				best = i;
+	}
 
 	DBGV("Best record : %d \n",best);
 	ptpClock->foreign_record_best = best;
 	ptpClock->bestMaster = &foreignMaster[best];
-	return (bmcStateDecision(ptpClock->bestMaster,
-				 rtOpts,ptpClock));
+	ptpClock->bmcState = bmcStateDecision(ptpClock->bestMaster,
+				 rtOpts,ptpClock);
+	return ptpClock->bmcState;
 }
@@ -79,6 +79,10 @@
 /* g.8265.1 local preference, lowest value */
 #define LOWEST_LOCALPREFERENCE 255
 
+/* PtpClock.bmcChanged: no single record known to be the only change / everything may have changed */
+#define BMC_CHANGED_NONE -1
+#define BMC_CHANGED_ALL -2
+
 /*
 section 7.6.2.4, page 55:
 248     Default. This clockClass shall be used if none of the other clockClass definitions apply.
@@ -467,6 +471,8 @@ enum {
 
 /* constants used for unicast grant processing */
 #define UNICAST_GRANT_REFRESH_INTERVAL 1
+/* number of slots in the unicast transmission timing wheels */
+#define UNICAST_WHEEL_SLOTS 256
 #define GRANT_NOT_FOUND -1
 #define GRANT_NONE_LEFT -2
 
@@ -65,6 +65,10 @@ typedef struct
 	uint32_t stateTransitions;	  /* number of state changes */
 	uint32_t bestMasterChanges;		  /* number of BM changes as result of BMC */
 	uint32_t announceTimeouts;	  /* number of announce receipt timeouts */
+	uint32_t bmcRuns;		  /* number of bmc() runs */
+	uint32_t bmcComparisonsSkipped;	  /* dataset comparisons avoided by incremental bmc() runs */
+	uint32_t bmcDecisionsSkipped;	  /* state decisions avoided: best record and D0 unchanged */
+	uint32_t delayRespTemplateBuilds; /* Delay_Resp templates (re)built after a dataset change */
 
 	/* discarded / uknown / ignored */
 	uint32_t discardedMessages;	  /* only messages we shouldn't be receiving - ignored from self don't count */
@@ -131,8 +135,9 @@ typedef struct {
 } ClockStatusInfo;
 
 typedef struct UnicastGrantTable UnicastGrantTable;
+typedef struct UnicastGrantData UnicastGrantData;
 
-typedef struct {
+struct UnicastGrantData {
 	UInteger32      duration;		/* grant duration */
 	Boolean		requestable;		/* is this mesage type even requestable? */
 	Boolean		requested;		/* slave: we have requested this */
@@ -142,14 +147,18 @@ typedef struct {
 	Integer8	logMinInterval;		/* minimum interval we're going to request */
 	Integer8	logMaxInterval;		/* maximum interval we're going to request */
 	UInteger16	sentSeqId;		/* used by masters: last sent sequence id */
-	UInteger32	intervalCounter;	/* used as a modulo counter to allow different message rates for different slaves */
 	Boolean		expired;		/* TRUE -> grant has expired */
 	Boolean         granted;		/* master: we have granted this, slave: we have been granted this */
 	UInteger32      timeLeft;		/* countdown timer for aging out grants */
 	UInteger16      messageType;		/* message type this grant is for */
 	UnicastGrantTable *parent;		/* parent entry (that has transportAddress and portIdentity */
 	Boolean		receiving;		/* keepalive: used to detect if message of this type is being received */
-} UnicastGrantData;
+	Boolean		listed;			/* master: grant is on the active grant list for its message type */
+	Boolean		scheduled;		/* master: grant is on the timing wheel for its message type */
+	UInteger32	wheelDue;		/* master: wheel tick of the next transmission */
+	UInteger32	wheelPeriod;		/* master: wheel ticks between transmissions */
+	UnicastGrantData *wheelNext;		/* master: next grant in the same wheel slot */
+};
 
 struct UnicastGrantTable {
 	Integer32		transportAddress;	/* IP address of slave (or master) */
@@ -162,12 +171,41 @@ struct UnicastGrantTable {
 	TimeInternal		lastSyncTimestamp;		/* last Sync message timestamp sent */
 };
 
-/* Unicast index holder: data + port mask */
+/*
+ * Unicast index holder: open addressing tables keyed by port identity and by
+ * transport address, pointing into the grant table, + port mask
+ */
 typedef struct {
-	UnicastGrantTable* data[UNICAST_MAX_DESTINATIONS];
+	UnicastGrantTable* nodes;	/* the grant table being indexed */
+	int capacity;			/* number of entries in the grant table */
+	int used;			/* grant table entries below this may be in use */
+	UnicastGrantTable** data;	/* keyed by (masked) port identity */
+	UnicastGrantTable** addr;	/* keyed by transport address */
+	int size;			/* slots in each of the above - power of 2 */
 	UInteger16 portMask;
 } UnicastGrantIndex;
 
+/*
+ * master: timing wheel scheduling transmission of one message type to each grantee.
+ * The wheel advances once per transmission timer expiry; every grant sits in the slot
+ * of its next due tick, so grants at different rates cost nothing until they are due.
+ */
+typedef struct {
+	UnicastGrantData** slots;	/* grants linked through wheelNext, by due tick */
+	UInteger32* load;		/* transmissions falling into each slot per wheel revolution */
+	UnicastGrantData** due;		/* grants due on the current tick */
+	int size;			/* number of slots - power of 2 */
+	int capacity;			/* size of the due array */
+	UInteger32 tick;		/* current tick */
+	int subTicks;			/* wheel ticks per port message interval */
+} UnicastWheel;
+
+/* master: grants of one message type we may be transmitting, so we do not walk the whole grant table */
+typedef struct {
+	UnicastGrantData** data;
+	int count;
+} UnicastGrantList;
+
 /* Unicast destination configuration: Address, domain, preference, last Sync timestamp sent */
 typedef struct {
     Integer32 		transportAddress;		/* destination address */
@@ -180,6 +218,43 @@ typedef struct {
     Integer32 transportAddress;
 } SyncDestEntry;
 
+/* Sync sent with its TX timestamp not yet collected (pipelined unicast Sync) */
+typedef struct {
+    Integer32 transportAddress;
+    UInteger16 sequenceId;
+    Boolean done;
+} SyncPendingEntry;
+
+/* everything a Delay_Resp (+ PTPMON TLVs) template depends on, other than the request itself */
+typedef struct {
+    UInteger8 transportSpecific;
+    UInteger4 versionNumber;
+    UInteger8 domainNumber;
+    PortIdentity portIdentity;
+    Integer8 logMinDelayReqInterval;
+    /* PTPMON only - zeroed otherwise */
+    Boolean ptpmon;
+    Boolean mtie;
+    Enumeration8 portState;
+    Integer32 parentAddress;
+    ParentDS parentDS;
+    UInteger16 stepsRemoved;
+    TimePropertiesDS timePropertiesDS;
+    Boolean statsCalculated;
+    UInteger16 windowNumber;
+    int statsUpdateInterval;
+    double ofmMinFinal;
+    double ofmMaxFinal;
+} DelayRespTemplateKey;
+
+/* pre-packed Delay_Resp: only the per-request fields are patched in for each response */
+typedef struct {
+    Boolean valid;
+    int length;
+    DelayRespTemplateKey key;
+    Octet buf[PACKET_SIZE];
+} DelayRespTemplate;
+
 /**
  * \struct PtpClock
  * \brief Main program data structure
@@ -209,22 +284,41 @@ typedef struct {
 	Integer16  foreign_record_i;
 	Integer16  foreign_record_best;
 	Boolean  record_update;    /* should we run bmc() after receiving an announce message? */
+	/* open addressing index into foreign[] keyed by port identity, -1 = free slot */
+	Integer16 *foreignIndex;
+	UInteger16 foreignIndexSize;
+	/* defaultDS as of the last bmc() run - a change also triggers bmc() */
+	DefaultDS bmcDefaultDS;
+	/* the only foreign record changed since the last bmc() run, or BMC_CHANGED_xxx */
+	Integer16 bmcChanged;
+	/* state returned by the last bmc() state decision */
+	UInteger8 bmcState;
 
 	Boolean disabled;	/* port is permanently disabled */
 
 	/* unicast grant table - our own grants or our slaves' grants or grants to peers */
-	UnicastGrantTable unicastGrants[UNICAST_MAX_DESTINATIONS];
-	/* our trivial index table to speed up lookups */
+	UnicastGrantTable *unicastGrants;
+	/* number of entries in the above table (ptpengine:unicast_grant_capacity) */
+	int unicastGrantCapacity;
+	/* hash index into the above table */
 	UnicastGrantIndex grantIndex;
+	/* granted entries for each message type */
+	UnicastGrantList activeGrants[PTP_MAX_MESSAGE_INDEXED];
+	/* per-grant Sync and Announce transmission schedule */
+	UnicastWheel syncWheel;
+	UnicastWheel announceWheel;
 	/* current parent from the above table */
 	UnicastGrantTable *parentGrants;
 	/* previous parent's grants when changing parents: if not null, this is what should be canceled */
 	UnicastGrantTable *previousGrants;
 	/* another index to match unicast Sync with FollowUp when we can't capture the destination address of Sync */
-	SyncDestEntry syncDestIndex[UNICAST_MAX_DESTINATIONS];
+	SyncDestEntry *syncDestIndex;
+	/* Syncs awaiting TX timestamps when pipelining unicast Sync transmission */
+	SyncPendingEntry *syncPending;
+	int syncPendingCount;
 
-	/* unicast destinations parsed from config */
-	UnicastDestination unicastDestinations[UNICAST_MAX_DESTINATIONS];
+	/* unicast destinations parsed from config, sized like the grant table */
+	UnicastDestination *unicastDestinations;
 	int unicastDestinationCount;
 
 	/* number of slaves we have granted Announce to */
@@ -257,6 +351,10 @@ typedef struct {
 	Octet msgObuf[PACKET_SIZE];
 	Octet msgIbuf[PACKET_SIZE];
 
+	/* master: Delay_Resp templates - plain and with PTPMON TLVs */
+	DelayRespTemplate delayRespTemplate;
+	DelayRespTemplate ptpMonTemplate;
+
 	int followUpGap;
 
 	TimeInternal  pdelay_req_receive_time;
@@ -272,8 +370,9 @@ typedef struct {
 	TimeInternal	pdelaySM;
 	TimeInternal	delayMS;
 	TimeInternal	delaySM;
-	TimeInternal  lastSyncCorrectionField;
-	TimeInternal  lastPdelayRespCorrectionField;
+	ScaledNanoseconds delayMSScaled;	/* delayMS with the fractional ns kept for updateDelay */
+	ScaledNanoseconds lastSyncCorrectionField;
+	ScaledNanoseconds lastPdelayRespCorrectionField;
 	TimeInternal	lastOriginTimestamp;
 
 	Boolean  sentPdelayReq;
@@ -301,6 +400,8 @@ typedef struct {
 
 	/*Stats header will be re-printed when set to true*/
 	Boolean resetStatisticsLog;
+	/* capture file section header will be re-written when set to true */
+	Boolean resetCaptureLog;
 
 	int listenCount; // number of consecutive resets to listening
 	int resetCount;
@@ -360,6 +461,8 @@ typedef struct {
 	 * management messages and SNMP eventually
 	*/
 	PtpEngineSlaveStats slaveStats;
+	/* MTIE / TDEV / ADEV of offset from master, NULL when disabled */
+	PhaseStability *stability;
 
 	OutlierFilter 	oFilterMS;
 	OutlierFilter	oFilterSM;
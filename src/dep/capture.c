@@ -0,0 +1,278 @@
+/*-
+ * Copyright (c) 2026 PTPd contributors,
+ *
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file   capture.c
+ * @date   Sun Oct 18 07:53:38 2026
+ *
+ * @brief  pcap-ng capture of PTP messages with their timestamps
+ *
+ * The file layout is described in pcapng.h. The sockets only give us the
+ * PTP payload, so the UDP and IP (or Ethernet) headers are made up from
+ * what we know about the message - they are there so that the usual
+ * tools can dissect the capture. Like the binary statistics log, blocks
+ * are fully buffered and written out once per second.
+ */
+
+#include "../ptpd.h"
+
+/* largest block: Ethernet header, IPv4 + UDP header, message, options */
+#define CAPTURE_BLOCK_MAX	(sizeof(PcapngEnhancedPacket) + 64 + PACKET_SIZE + 64)
+
+static const Octet etherDst[ETHER_ADDR_LEN] = { 0x01, 0x1b, 0x19, 0x00, 0x00, 0x00 };
+
+static int
+putOption(char *buf, uint16_t code, const void *value, uint16_t length)
+{
+
+	PcapngOption *option = (PcapngOption*)buf;
+	int padded = PCAPNG_PAD(length);
+
+	option->code = code;
+	option->length = length;
+	memset(buf + sizeof(PcapngOption), 0, padded);
+	memcpy(buf + sizeof(PcapngOption), value, length);
+
+	return sizeof(PcapngOption) + padded;
+
+}
+
+/* close the block: end of options, then the total length at both ends */
+static int
+endBlock(char *buf, int length)
+{
+
+	PcapngBlockHeader *block = (PcapngBlockHeader*)buf;
+	uint32_t *trailer;
+
+	length += putOption(buf + length, PCAPNG_OPT_ENDOFOPT, NULL, 0);
+	trailer = (uint32_t*)(buf + length);
+	length += sizeof(uint32_t);
+	block->length = length;
+	*trailer = length;
+
+	return length;
+
+}
+
+/* start a new section: written when the file is opened, and again when truncated or rotated */
+static void
+writeCaptureHeader(LogFileHandler *handler, const RunTimeOpts *rtOpts)
+{
+
+	uint32_t buf[64];
+	char *pos = (char*)buf;
+	PcapngSectionHeader *shb = (PcapngSectionHeader*)pos;
+	PcapngInterfaceDescription *idb;
+	int length;
+	uint8_t tsresol = 9;
+
+	memset(buf, 0, sizeof(buf));
+
+	shb->block.type = PCAPNG_BLOCK_SHB;
+	shb->magic = PCAPNG_BYTE_ORDER_MAGIC;
+	shb->versionMajor = PCAPNG_VERSION_MAJOR;
+	shb->versionMinor = PCAPNG_VERSION_MINOR;
+	shb->sectionLength = -1;
+	length = sizeof(PcapngSectionHeader);
+	/* no section options: end of options is optional, the trailer is not */
+	*(uint32_t*)(pos + length) = length + sizeof(uint32_t);
+	length += sizeof(uint32_t);
+	shb->block.length = length;
+	pos += length;
+
+	idb = (PcapngInterfaceDescription*)pos;
+	idb->block.type = PCAPNG_BLOCK_IDB;
+	idb->linkType = (rtOpts->transport == IEEE_802_3) ?
+			PCAPNG_LINKTYPE_ETHERNET : PCAPNG_LINKTYPE_IPV4;
+	idb->snapLength = 0;
+	length = sizeof(PcapngInterfaceDescription);
+	length += putOption(pos + length, PCAPNG_OPT_IF_NAME, rtOpts->ifaceName,
+				strlen(rtOpts->ifaceName));
+	length += putOption(pos + length, PCAPNG_OPT_IF_TSRESOL, &tsresol, sizeof(tsresol));
+	pos += endBlock(pos, length);
+
+	/* maintainLogSize() writes it again at the start of every new file */
+	logWrite(LOGJOB_WRITE, LOGWRITE_HEADER, 0, handler, NULL, buf, pos - (char*)buf);
+
+}
+
+static uint16_t
+ipChecksum(const uint8_t *header, int length)
+{
+
+	uint32_t sum = 0;
+	int i;
+
+	for(i = 0; i < length; i += 2) {
+		sum += (header[i] << 8) | header[i + 1];
+	}
+
+	while(sum >> 16) {
+		sum = (sum & 0xFFFF) + (sum >> 16);
+	}
+
+	return ~sum;
+
+}
+
+/* made up link layer headers in front of the message, returns their length */
+static int
+putLinkHeaders(uint8_t *buf, const RunTimeOpts *rtOpts, PtpClock *ptpClock,
+		int messageLength, Boolean event, Boolean outbound)
+{
+
+	Integer32 src, dst;
+	uint16_t port = htons(event ? PTP_EVENT_PORT : PTP_GENERAL_PORT);
+	uint16_t field;
+
+	if(rtOpts->transport == IEEE_802_3) {
+		memcpy(buf, etherDst, ETHER_ADDR_LEN);
+		if(outbound) {
+			memcpy(buf + ETHER_ADDR_LEN, ptpClock->netPath.interfaceID, ETHER_ADDR_LEN);
+		} else {
+			memset(buf + ETHER_ADDR_LEN, 0, ETHER_ADDR_LEN);
+		}
+		field = htons(PTP_ETHER_TYPE);
+		memcpy(buf + 2 * ETHER_ADDR_LEN, &field, 2);
+		return 2 * ETHER_ADDR_LEN + 2;
+	}
+
+	if(outbound) {
+		src = ptpClock->netPath.interfaceAddr.s_addr;
+		dst = ptpClock->netPath.multicastAddr;
+		if((rtOpts->ipMode == IPMODE_HYBRID || rtOpts->ipMode == IPMODE_UNICAST) &&
+		    ptpClock->bestMaster != NULL && ptpClock->bestMaster->sourceAddr) {
+			dst = ptpClock->bestMaster->sourceAddr;
+		}
+	} else {
+		src = ptpClock->netPath.lastSourceAddr;
+		dst = ptpClock->netPath.lastDestAddr ? ptpClock->netPath.lastDestAddr :
+				ptpClock->netPath.multicastAddr;
+	}
+
+	/* IPv4: no options, don't fragment */
+	memset(buf, 0, 28);
+	buf[0] = 0x45;
+	field = htons(28 + messageLength);
+	memcpy(buf + 2, &field, 2);
+	buf[6] = 0x40;
+	buf[8] = rtOpts->ttl ? rtOpts->ttl : 64;
+	buf[9] = IPPROTO_UDP;
+	memcpy(buf + 12, &src, 4);
+	memcpy(buf + 16, &dst, 4);
+	field = htons(ipChecksum(buf, 20));
+	memcpy(buf + 10, &field, 2);
+
+	/* UDP: checksum 0 - not computed */
+	memcpy(buf + 20, &port, 2);
+	memcpy(buf + 22, &port, 2);
+	field = htons(8 + messageLength);
+	memcpy(buf + 24, &field, 2);
+
+	return 28;
+
+}
+
+/*
+ * Write one message to the capture file. timestamp is the one the protocol
+ * will use; outbound messages are our own Delay_Req, written when their
+ * transmit timestamp is known. General messages are not timestamped on
+ * receipt, so they are written with the timestamp of the last event
+ * message - keeping the file in order and on the protocol's timescale.
+ */
+void
+captureMessage(PtpClock *ptpClock, const Octet *buf, int length,
+	const TimeInternal *timestamp, Boolean outbound)
+{
+
+	extern RunTimeOpts rtOpts;
+	static Integer32 lastFlush = 0;
+	static TimeInternal lastTimestamp = { 0, 0 };
+	static int errorMsg = 0;
+	uint32_t block[(CAPTURE_BLOCK_MAX + 3) / 4];
+	char *pos = (char*)block;
+	PcapngEnhancedPacket *epb = (PcapngEnhancedPacket*)pos;
+	LogFileHandler *handler = &rtOpts.captureLog;
+	char comment[32];
+	uint64_t ns;
+	uint32_t epbFlags = outbound ? PCAPNG_EPB_OUTBOUND : PCAPNG_EPB_INBOUND;
+	int packetLength, commentLength;
+	int flags = 0;
+	Boolean event = (buf[0] & 0x0F) < 0x08;
+
+	if(!handler->logEnabled || handler->logFP == NULL || length <= 0 || length > PACKET_SIZE) {
+		return;
+	}
+
+	if(ptpClock->resetCaptureLog) {
+		ptpClock->resetCaptureLog = FALSE;
+		writeCaptureHeader(handler, &rtOpts);
+	}
+
+	if(event) {
+		lastTimestamp = *timestamp;
+	}
+
+	memset(epb, 0, sizeof(PcapngEnhancedPacket));
+	ns = (uint64_t)lastTimestamp.seconds * 1000000000ULL + lastTimestamp.nanoseconds;
+
+	epb->block.type = PCAPNG_BLOCK_EPB;
+	epb->interfaceId = 0;
+	epb->timestampHigh = ns >> 32;
+	epb->timestampLow = ns & 0xFFFFFFFF;
+
+	pos += sizeof(PcapngEnhancedPacket);
+	packetLength = putLinkHeaders((uint8_t*)pos, &rtOpts, ptpClock, length, event, outbound);
+	memcpy(pos + packetLength, buf, length);
+	packetLength += length;
+	memset(pos + packetLength, 0, PCAPNG_PAD(packetLength) - packetLength);
+	epb->capturedLength = epb->packetLength = packetLength;
+	pos += PCAPNG_PAD(packetLength);
+
+	pos += putOption(pos, PCAPNG_OPT_EPB_FLAGS, &epbFlags, sizeof(epbFlags));
+
+	if(ptpClock->clockDriver != NULL) {
+		commentLength = snprintf(comment, sizeof(comment), PCAPNG_COMMENT_FREQUENCY"%.03f",
+				    ptpClock->clockDriver->lastFrequency);
+		pos += putOption(pos, PCAPNG_OPT_COMMENT, comment, commentLength);
+	}
+
+	if(lastTimestamp.seconds != lastFlush) {
+		lastFlush = lastTimestamp.seconds;
+		flags = LOGWRITE_FLUSH | LOGWRITE_MAINTAIN;
+	}
+
+	if(!logWrite(LOGJOB_WRITE, flags, 0, handler, NULL, block,
+		    endBlock((char*)block, pos - (char*)block))) {
+		if(!errorMsg) {
+		    WARNING("Could not queue capture file entry\n");
+		}
+		errorMsg = TRUE;
+	}
+
+}
@@ -197,10 +197,17 @@ loadDefaultSettings( RunTimeOpts* rtOpts )
 	rtOpts->unicastGrantDuration = 300;
 	rtOpts->unicastAcceptAny = FALSE;
 	rtOpts->unicastPortMask = 0;
+	rtOpts->unicastGrantCapacity = UNICAST_MAX_DESTINATIONS;
+	rtOpts->unicastTxSpread = 1;
+	rtOpts->unicastSyncPipelining = FALSE;
+	rtOpts->unicastBatchTransmit = FALSE;
+	rtOpts->batchReceive = FALSE;
 
 	rtOpts->noAdjust = NO_ADJUST;  // false
 	rtOpts->logStatistics = TRUE;
 	rtOpts->statisticsTimestamp = TIMESTAMP_DATETIME;
+	rtOpts->statisticsFileFormat = STATSFILE_CSV;
+	rtOpts->statusFileFormat = STATUSFILE_TEXT;
 
 	rtOpts->periodicUpdates = FALSE; /* periodically log a status update */
 
@@ -211,6 +218,7 @@ loadDefaultSettings( RunTimeOpts* rtOpts )
 	rtOpts->inboundLatency.nanoseconds = DEFAULT_INBOUND_LATENCY;
 	rtOpts->outboundLatency.nanoseconds = DEFAULT_OUTBOUND_LATENCY;
 	rtOpts->max_foreign_records = DEFAULT_MAX_FOREIGN_RECORDS;
+	rtOpts->foreignRecordCapacityMax = 0;
 	rtOpts->nonDaemon = FALSE;
 
 	/*
@@ -324,6 +332,9 @@ loadDefaultSettings( RunTimeOpts* rtOpts )
 	rtOpts->clockOutlierFilterCutoff = 5.0;
 	rtOpts->clockOutlierFilterBlockTimeout = 30; /* filter block timeout */
 
+	rtOpts->clockOffsetSamples = 0; /* adaptive */
+	rtOpts->clockOffsetRejectPercentile = 0; /* fastest sample only */
+
 	/* disabled by default */
 	rtOpts->announceTimeoutGracePeriod = 0;
 
@@ -339,6 +350,9 @@ loadDefaultSettings( RunTimeOpts* rtOpts )
 	rtOpts-> cpuNumber = -1;
 #endif /* (linux && HAVE_SCHED_H) || HAVE_SYS_CPUSET_H*/
 
+	rtOpts->rtPriority = 0;
+	rtOpts->housekeepingThread = FALSE;
+
 	rtOpts->oFilterMSConfig.enabled = FALSE;
 	rtOpts->oFilterMSConfig.discard = TRUE;
 	rtOpts->oFilterMSConfig.autoTune = TRUE;
@@ -391,6 +405,7 @@ loadDefaultSettings( RunTimeOpts* rtOpts )
 
 	/* How often refresh statistics (seconds) */
 	rtOpts->statsUpdateInterval = 30;
+	strncpy(rtOpts->stabilityIntervals, STABILITY_DEFAULT_INTERVALS, sizeof(rtOpts->stabilityIntervals));
 
 	/* How long to wait for one-way delay prefiltering */
 	rtOpts->calibrationDelay = 0;
@@ -402,6 +417,11 @@ loadDefaultSettings( RunTimeOpts* rtOpts )
 	/* status file options */
 	rtOpts->statusFileUpdateInterval = 1;
 
+	/* telemetry ring options */
+	rtOpts->telemetryEnabled = FALSE;
+	strncpy(rtOpts->telemetryFile, DEFAULT_TELEMETRYFILE, PATH_MAX);
+	rtOpts->telemetryCapacity = DEFAULT_TELEMETRY_CAPACITY;
+
 	rtOpts->ofmAlarmThreshold = 0;
 
 	/* panic mode options */
@@ -456,6 +476,15 @@ loadDefaultSettings( RunTimeOpts* rtOpts )
 	rtOpts->eventLog.unlinkOnClose = FALSE;
 	rtOpts->eventLog.maxSize = 0;
 
+	rtOpts->captureLog.logID = "capture";
+	rtOpts->captureLog.openMode = "a+";
+	rtOpts->captureLog.logFP = NULL;
+	rtOpts->captureLog.truncateOnReopen = FALSE;
+	rtOpts->captureLog.unlinkOnClose = FALSE;
+	rtOpts->captureLog.maxSize = 0;
+	/* fully buffered, flushed once per second by captureMessage() */
+	rtOpts->captureLog.bufferSize = PCAPNG_BUFFER_SIZE;
+
 	rtOpts->statusLog.logID = "status";
 	rtOpts->statusLog.openMode = "w";
 	strncpy(rtOpts->statusLog.logPath, DEFAULT_STATUSFILE, PATH_MAX);
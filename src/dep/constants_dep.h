@@ -158,6 +158,10 @@ if it's POSIX compatible, if you succeed, report it to ptpd-devel@sourceforge.ne
 /* default status file location */
 #define DEFAULT_STATUSFILE DEFAULT_LOCKDIR"/"PTPD_PROGNAME".status"
 
+/* default telemetry ring location - should be on tmpfs */
+#define DEFAULT_TELEMETRYFILE "/dev/shm/"PTPD_PROGNAME".telemetry"
+#define DEFAULT_TELEMETRY_CAPACITY 4096
+
 /* Highest log level (default) catches all */
 #define LOG_ALL LOG_DEBUGV
 
@@ -170,6 +174,13 @@ if it's POSIX compatible, if you succeed, report it to ptpd-devel@sourceforge.ne
 /* wait a maximum of 2 ms for a late TX timestamp after all retries*/
 #define LATE_TXTIMESTAMP_FINAL_US 2000
 
+/* pipelined TX timestamp collection: maximum wait for the next TX timestamp */
+#define TXTIMESTAMP_PIPELINE_WAIT_US 2000
+
+/* batched receive: packets drained per wakeup and ancillary data size per packet */
+#define NET_RX_BATCH_SIZE 64
+#define NET_RX_CONTROL_SIZE 256
+
 /* drift recovery metod for use with -F */
 enum {
 	DRIFT_RESET = 0,
@@ -193,6 +204,18 @@ enum {
 	TIMESTAMP_BOTH
 };
 
+/* statistics file format */
+enum {
+	STATSFILE_CSV,
+	STATSFILE_BINARY
+};
+
+/* status file format */
+enum {
+	STATUSFILE_TEXT,
+	STATUSFILE_JSON
+};
+
 /* servo dT calculation mode */
 enum {
 	DT_NONE,
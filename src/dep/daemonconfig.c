@@ -1007,6 +1007,43 @@ parseConfig ( int opCode, void *opArg, dictionary* dict, RunTimeOpts *rtOpts )
 	"	 This option can be used as a workaround where a node sends signaling messages and\n"
 	"	 timing messages with different port identities", RANGECHECK_RANGE, 0,65535);
 
+	parseResult &= configMapInt(opCode, opArg, dict, target, "ptpengine:unicast_grant_capacity",
+		PTPD_RESTART_DAEMON, INTTYPE_INT, &rtOpts->unicastGrantCapacity, rtOpts->unicastGrantCapacity,
+		"Maximum number of unicast negotiation nodes (slaves) a master can serve.\n"
+	"	 The grant table is allocated at startup, so this is not limited by the\n"
+	"	 compile-time maximum number of unicast destinations.", RANGECHECK_RANGE, UNICAST_MAX_DESTINATIONS, 16384);
+
+	parseResult &= configMapInt(opCode, opArg, dict, target, "ptpengine:unicast_tx_spread",
+		PTPD_RESTART_PROTOCOL, INTTYPE_INT, &rtOpts->unicastTxSpread, rtOpts->unicastTxSpread,
+		"When running unicast negotiation (master), divide each Sync and Announce interval\n"
+	"	 into this many slots and spread the slaves evenly between them, instead of\n"
+	"	 sending to all slaves at once. Must be a power of 2. 1 disables spreading.", RANGECHECK_RANGE, 1, 16);
+
+	CONFIG_CONDITIONAL_ASSERTION(rtOpts->unicastTxSpread & (rtOpts->unicastTxSpread - 1),
+					"ptpengine:unicast_tx_spread must be a power of 2\n");
+
+	parseResult &= configMapBoolean(opCode, opArg, dict, target, "ptpengine:unicast_sync_pipelining",
+		PTPD_RESTART_NONE, &rtOpts->unicastSyncPipelining, rtOpts->unicastSyncPipelining,
+		"When running as unicast master with software or hardware TX timestamping,\n"
+	"        send Sync messages to all destinations first, and then collect the TX timestamps\n"
+	"        as they arrive, sending each FollowUp as soon as its timestamp is available.\n"
+	"        Without this, each Sync waits for its own TX timestamp before the next one is sent.");
+
+	parseResult &= configMapBoolean(opCode, opArg, dict, target, "ptpengine:unicast_batch_transmit",
+		PTPD_RESTART_NETWORK, &rtOpts->unicastBatchTransmit, rtOpts->unicastBatchTransmit,
+		"When running as unicast master over UDP/IPv4, pack Sync, FollowUp and Announce\n"
+	"        once per interval and send the copies to all destinations with a single\n"
+	"        sendmmsg() call, patching only the per-destination fields. Syncs are batched\n"
+	"        only when ptpengine:unicast_sync_pipelining is enabled and TX timestamps\n"
+	"        are delivered through the socket error queue.");
+
+	parseResult &= configMapBoolean(opCode, opArg, dict, target, "ptpengine:batch_receive",
+		PTPD_RESTART_NETWORK, &rtOpts->batchReceive, rtOpts->batchReceive,
+		"Wait for traffic with epoll() and read all queued packets from each socket\n"
+	"        with a single recvmmsg() call instead of one packet per socket per select().\n"
+	"        Useful for masters serving many unicast slaves. Linux only; ignored when\n"
+	"        using pcap or SNMP, or when TX timestamps are looped back.");
+
 	CONFIG_KEY_CONDITIONAL_WARNING_ISSET((rtOpts->transport == IEEE_802_3) && rtOpts->unicastNegotiation,
 	 			    "ptpengine:unicast_negotiation",
 				"Unicast negotiation cannot be used with Ethernet transport\n");
@@ -1293,6 +1330,13 @@ parseConfig ( int opCode, void *opArg, dictionary* dict, RunTimeOpts *rtOpts )
 		PTPD_RESTART_DAEMON, INTTYPE_I16, &rtOpts->max_foreign_records, rtOpts->max_foreign_records,
 	"Foreign master record size (Maximum number of foreign masters).",RANGECHECK_RANGE,5,10);
 
+	parseResult &= configMapInt(opCode, opArg, dict, target, "ptpengine:foreignrecord_capacity_max",
+		PTPD_RESTART_DAEMON, INTTYPE_I16, &rtOpts->foreignRecordCapacityMax, rtOpts->foreignRecordCapacityMax,
+	"Maximum size the foreign master record can grow to when more masters are seen\n"
+	"	 than ptpengine:foreignrecord_capacity allows. The record doubles in size each time\n"
+	"	 it fills up. 0 or a value not above ptpengine:foreignrecord_capacity disables growth\n"
+	"	 and the oldest records are overwritten instead.",RANGECHECK_RANGE,0,1024);
+
 	parseResult &= configMapInt(opCode, opArg, dict, target, "ptpengine:ptp_allan_variance", PTPD_UPDATE_DATASETS, INTTYPE_U16, &rtOpts->clockQuality.offsetScaledLogVariance, rtOpts->clockQuality.offsetScaledLogVariance,
 	"Specify Allan variance announced in master state.",RANGECHECK_RANGE,0,65535);
 
@@ -1859,7 +1903,7 @@ parseConfig ( int opCode, void *opArg, dictionary* dict, RunTimeOpts *rtOpts )
 		"Permit access control list for timing packets. Format is a series of \n"
         "        comma, space or tab separated  network prefixes: IPv4 addresses or full CIDR notation a.b.c.d/x,\n"
         "        where a.b.c.d is the subnet and x is the decimal mask, or a.b.c.d/v.x.y.z where a.b.c.d is the\n"
-        "        subnet and v.x.y.z is the 4-octet mask. The match is performed on the source IP address of the\n"
+        "        subnet and v.x.y.z is the 4-octet mask, which must be contiguous. The match is performed on the source IP address of the\n"
         "        incoming messages. IP access lists are only supported when using the IP transport.");
 
 	parseResult &= configMapString(opCode, opArg, dict, target, "ptpengine:timing_acl_deny",
@@ -1867,7 +1911,7 @@ parseConfig ( int opCode, void *opArg, dictionary* dict, RunTimeOpts *rtOpts )
 		"Deny access control list for timing packets. Format is a series of \n"
         "        comma, space or tab separated  network prefixes: IPv4 addresses or full CIDR notation a.b.c.d/x,\n"
         "        where a.b.c.d is the subnet and x is the decimal mask, or a.b.c.d/v.x.y.z where a.b.c.d is the\n"
-        "        subnet and v.x.y.z is the 4-octet mask. The match is performed on the source IP address of the\n"
+        "        subnet and v.x.y.z is the 4-octet mask, which must be contiguous. The match is performed on the source IP address of the\n"
         "        incoming messages. IP access lists are only supported when using the IP transport.");
 
 	parseResult &= configMapString(opCode, opArg, dict, target, "ptpengine:management_acl_permit",
@@ -1875,7 +1919,7 @@ parseConfig ( int opCode, void *opArg, dictionary* dict, RunTimeOpts *rtOpts )
 		"Permit access control list for management messages and monitoring extensions. Format is a series of \n"
 	"	 comma, space or tab separated  network prefixes: IPv4 addresses or full CIDR notation a.b.c.d/x,\n"
 	"	 where a.b.c.d is the subnet and x is the decimal mask, or a.b.c.d/v.x.y.z where a.b.c.d is the\n"
-	"        subnet and v.x.y.z is the 4-octet mask. The match is performed on the source IP address of the\n"
+	"        subnet and v.x.y.z is the 4-octet mask, which must be contiguous. The match is performed on the source IP address of the\n"
 	"        incoming messages. IP access lists are only supported when using the IP transport.");
 
 	parseResult &= configMapString(opCode, opArg, dict, target, "ptpengine:management_acl_deny",
@@ -1883,7 +1927,7 @@ parseConfig ( int opCode, void *opArg, dictionary* dict, RunTimeOpts *rtOpts )
 		"Deny access control list for management messages and monitoring extensions. Format is a series of \n"
         "        comma, space or tab separated  network prefixes: IPv4 addresses or full CIDR notation a.b.c.d/x,\n"
         "        where a.b.c.d is the subnet and x is the decimal mask, or a.b.c.d/v.x.y.z where a.b.c.d is the\n"
-        "        subnet and v.x.y.z is the 4-octet mask. The match is performed on the source IP address of the\n"
+        "        subnet and v.x.y.z is the 4-octet mask, which must be contiguous. The match is performed on the source IP address of the\n"
         "        incoming messages. IP access lists are only supported when using the IP transport.");
 
 
@@ -2096,6 +2140,18 @@ parseConfig ( int opCode, void *opArg, dictionary* dict, RunTimeOpts *rtOpts )
 		PTPD_RESTART_FILTERS, INTTYPE_INT, &rtOpts->clockOutlierFilterBlockTimeout, rtOpts->clockOutlierFilterBlockTimeout,
 		"Maximum blocking time (seconds) before outlier filter is reset",RANGECHECK_RANGE,0,3600);
 
+	parseResult &= configMapInt(opCode, opArg, dict, target, "clock:offset_samples",
+		PTPD_RESTART_NONE, INTTYPE_INT, &rtOpts->clockOffsetSamples, rtOpts->clockOffsetSamples,
+		"Number of samples taken for each inter-clock offset measurement (HW to system clock).\n"
+	"	 0 = adaptive: the number is chosen per clock from the measured read latency\n"
+	"	 distribution, so that each measurement very likely contains a fast sample.",RANGECHECK_RANGE,0,OFFSETEST_MAX_SAMPLES);
+
+	parseResult &= configMapInt(opCode, opArg, dict, target, "clock:offset_reject_percentile",
+		PTPD_RESTART_NONE, INTTYPE_INT, &rtOpts->clockOffsetRejectPercentile, rtOpts->clockOffsetRejectPercentile,
+		"Inter-clock offset measurement: reject samples whose read latency is above this\n"
+	"	 percentile of the latency distribution and average the remaining samples.\n"
+	"	 0 = use only the fastest sample of each measurement.",RANGECHECK_RANGE,0,99);
+
 
 	/* END inter-clock filter settings */
 
@@ -2325,6 +2381,29 @@ parseConfig ( int opCode, void *opArg, dictionary* dict, RunTimeOpts *rtOpts )
 		"Truncate the sync packet record file every time it is (re) opened:\n"
 	"	 startup and SIGHUP.");
 
+	/* if capture file specified, enable packet capture */
+	CONFIG_KEY_TRIGGER("global:capture_file", rtOpts->captureLog.logEnabled,TRUE,FALSE);
+	parseResult &= configMapString(opCode, opArg, dict, target, "global:capture_file",
+		PTPD_RESTART_LOGGING, rtOpts->captureLog.logPath, sizeof(rtOpts->captureLog.logPath), rtOpts->captureLog.logPath,
+		"File (pcap-ng) used to capture received PTP messages and sent Delay Requests\n"
+	"	 with their timestamps and the clock's frequency adjustment. Enables capture\n"
+	"	 when set. Replay with ptpd-sim -p to evaluate servo and filter settings.");
+
+	parseResult &= configMapInt(opCode, opArg, dict, target, "global:capture_file_max_size",
+		PTPD_RESTART_LOGGING, INTTYPE_U32, &rtOpts->captureLog.maxSize, rtOpts->captureLog.maxSize,
+		"Maximum capture file size (in kB) - file will be truncated\n"
+	"	if size exceeds the limit. 0 - no limit.", RANGECHECK_MIN,0,0);
+
+	parseResult &= configMapInt(opCode, opArg, dict, target, "global:capture_file_max_files",
+		PTPD_RESTART_LOGGING, INTTYPE_INT, &rtOpts->captureLog.maxFiles, rtOpts->captureLog.maxFiles,
+		"Enable log rotation of the capture file up to n files.\n"
+	"	 0 - do not rotate.\n", RANGECHECK_RANGE,0, 100);
+
+	parseResult &= configMapBoolean(opCode, opArg, dict, target, "global:capture_file_truncate",
+		PTPD_RESTART_LOGGING, &rtOpts->captureLog.truncateOnReopen, rtOpts->captureLog.truncateOnReopen,
+		"Truncate the capture file every time it is (re) opened:\n"
+	"	 startup and SIGHUP.");
+
 	/* if status file specified, enable status logging*/
 	CONFIG_KEY_TRIGGER("global:status_file", rtOpts->statusLog.logEnabled,TRUE,FALSE);
 	parseResult &= configMapString(opCode, opArg, dict, target, "global:status_file",
@@ -2340,6 +2419,37 @@ parseConfig ( int opCode, void *opArg, dictionary* dict, RunTimeOpts *rtOpts )
 		"Status file update interval in seconds.", RANGECHECK_RANGE,
 	1,30);
 
+	parseResult &= configMapSelectValue(opCode, opArg, dict, target, "global:status_file_format",
+		PTPD_RESTART_LOGGING, &rtOpts->statusFileFormat, rtOpts->statusFileFormat,
+		"Format of the status file:\n"
+	"        text - human-readable\n"
+	"        json - a single JSON object with the same information, for monitoring\n"
+	"               agents. Times and offsets are in seconds.\n",
+		"text",		STATUSFILE_TEXT,
+		"json",		STATUSFILE_JSON, NULL
+		);
+
+	/* if telemetry file specified, enable telemetry */
+	CONFIG_KEY_TRIGGER("global:telemetry_file", rtOpts->telemetryEnabled,TRUE,FALSE);
+	parseResult &= configMapString(opCode, opArg, dict, target, "global:telemetry_file",
+		PTPD_RESTART_LOGGING, rtOpts->telemetryFile, sizeof(rtOpts->telemetryFile), rtOpts->telemetryFile,
+	"File (memory-mapped ring buffer) receiving raw servo samples: T1-T4, correction,\n"
+	"	 filtered offset and delay, servo output and clock state, one record per\n"
+	"	 offset or delay update. Should be placed on tmpfs. Read with ptpd-telemetry.");
+	/* telemetry can be disabled even if file specified */
+	parseResult &= configMapBoolean(opCode, opArg, dict, target, "global:log_telemetry",
+		PTPD_RESTART_LOGGING, &rtOpts->telemetryEnabled, rtOpts->telemetryEnabled,
+		"Enable / disable writing servo samples to the telemetry ring.");
+
+	parseResult &= configMapInt(opCode, opArg, dict, target, "global:telemetry_capacity",
+		PTPD_RESTART_LOGGING, INTTYPE_INT, &rtOpts->telemetryCapacity, rtOpts->telemetryCapacity,
+		"Number of records held in the telemetry ring before the oldest are overwritten.\n"
+	"	 Must be a power of 2.", RANGECHECK_RANGE,
+	TELEMETRY_MIN_CAPACITY, TELEMETRY_MAX_CAPACITY);
+
+	CONFIG_CONDITIONAL_ASSERTION(rtOpts->telemetryCapacity & (rtOpts->telemetryCapacity - 1),
+					"global:telemetry_capacity must be a power of 2\n");
+
 #ifdef RUNTIME_DEBUG
 	parseResult &= configMapSelectValue(opCode, opArg, dict, target, "global:debug_level",
 		PTPD_RESTART_NONE, (uint8_t*)&rtOpts->debug_level, rtOpts->debug_level,
@@ -2418,6 +2528,20 @@ parseConfig ( int opCode, void *opArg, dictionary* dict, RunTimeOpts *rtOpts )
 		PTPD_RESTART_LOGGING, &rtOpts->statisticsLog.truncateOnReopen, rtOpts->statisticsLog.truncateOnReopen,
 		"Truncate the statistics file every time it is (re) opened: startup and SIGHUP.");
 
+	parseResult &= configMapSelectValue(opCode, opArg, dict, target, "global:statistics_file_format",
+		PTPD_RESTART_LOGGING, &rtOpts->statisticsFileFormat, rtOpts->statisticsFileFormat,
+		"Format of the statistics file:\n"
+	"        csv    - text, one comma-separated line per entry\n"
+	"        binary - fixed size binary records, buffered and written out\n"
+	"                 once per second. Convert to CSV with ptpd-stats2csv.\n",
+		"csv",		STATSFILE_CSV,
+		"binary",	STATSFILE_BINARY, NULL
+		);
+
+	/* binary statistics are fully buffered and flushed by logStatistics() */
+	rtOpts->statisticsLog.bufferSize = (rtOpts->statisticsFileFormat == STATSFILE_BINARY) ?
+						STATSLOG_BUFFER_SIZE : 0;
+
 	parseResult &= configMapBoolean(opCode, opArg, dict, target, "global:dump_packets",
 		PTPD_RESTART_NONE, &rtOpts->displayPackets, rtOpts->displayPackets,
 		"Dump the contents of every PTP packet");
@@ -2479,11 +2603,42 @@ parseConfig ( int opCode, void *opArg, dictionary* dict, RunTimeOpts *rtOpts )
 	-1,255);
 #endif /* (linux && HAVE_SCHED_H) || HAVE_SYS_CPUSET_H */
 
+#if defined(linux) && defined(HAVE_SCHED_H)
+	parseResult &= configMapInt(opCode, opArg, dict, target, "global:rt_priority", PTPD_RESTART_DAEMON, INTTYPE_INT, &rtOpts->rtPriority, rtOpts->rtPriority,
+		"Run the "PTPD_PROGNAME" protocol thread with SCHED_FIFO real-time scheduling at this priority.\n"
+	"        0 = normal scheduling. Best combined with global:housekeeping_thread, so that\n"
+	"        file and syslog output are not done at real-time priority.", RANGECHECK_RANGE,
+	0,99);
+#else
+	if (!(opCode & CFGOP_PARSE_QUIET) && CONFIG_ISSET("global:rt_priority"))
+	    INFO("Real-time scheduling not supported on this platform - global:rt_priority ignored.\n");
+#endif /* linux && HAVE_SCHED_H */
+
+#ifdef PTPD_HOUSEKEEPING_THREAD
+	parseResult &= configMapBoolean(opCode, opArg, dict, target, "global:housekeeping_thread",
+		PTPD_RESTART_DAEMON, &rtOpts->housekeepingThread, rtOpts->housekeepingThread,
+		"Write the log, statistics, record and status files and syslog messages from a separate\n"
+	"        thread. The protocol thread only queues the output and never waits for disk I/O.\n"
+	"        If the queue fills up, output is dropped (and this is reported) rather than delaying PTP.");
+#else
+	if (!(opCode & CFGOP_PARSE_QUIET) && CONFIG_ISSET("global:housekeeping_thread"))
+	    INFO("Threads not supported on this platform - global:housekeeping_thread ignored.\n");
+#endif /* PTPD_HOUSEKEEPING_THREAD */
+
 	parseResult &= configMapInt(opCode, opArg, dict, target, "global:statistics_update_interval",
 		PTPD_RESTART_NONE, INTTYPE_INT, &rtOpts->statsUpdateInterval,
 								rtOpts->statsUpdateInterval,
 		"Clock synchronisation statistics update interval in seconds\n", RANGECHECK_RANGE,1, 60);
 
+	parseResult &= configMapString(opCode, opArg, dict, target, "global:stability_intervals",
+		PTPD_RESTART_FILTERS, rtOpts->stabilityIntervals, sizeof(rtOpts->stabilityIntervals), rtOpts->stabilityIntervals,
+		"Observation intervals (seconds) at which MTIE, TDEV and ADEV of the offset from master\n"
+	"	 are computed while in slave state, once the clock is locked (or with clock:no_adjust).\n"
+	"	 Comma, tab or space-separated list of up to 8 integers (1 .. 100000). Results are\n"
+	"	 refreshed every global:statistics_update_interval and reported in the status file,\n"
+	"	 via SNMP and PTPMON. Long intervals are rounded to a multiple of the decimated sample\n"
+	"	 period. Empty = disabled.");
+
 	parseResult &= configMapBoolean(opCode, opArg, dict, target, "global:periodic_updates",
 		PTPD_RESTART_LOGGING, &rtOpts->periodicUpdates, rtOpts->periodicUpdates,
 		"Log a status update every time statistics are updated (global:statistics_update_interval).\n"
@@ -2580,6 +2735,12 @@ parseConfig ( int opCode, void *opArg, dictionary* dict, RunTimeOpts *rtOpts )
 		}
 	}
 
+	if(parseStabilityIntervals(rtOpts->stabilityIntervals, NULL, STABILITY_MAX_INTERVALS) < 0) {
+		ERROR("Error while parsing stability intervals: \"%s\" - expecting up to %d integers (1 .. %d)\n",
+			rtOpts->stabilityIntervals, STABILITY_MAX_INTERVALS, STABILITY_MAX_TAU);
+		parseResult = FALSE;
+	}
+
 	/* Scale the maxPPM to PPB */
 	rtOpts->servoMaxPpb *= 1000;
 	rtOpts->servoMaxPpb_hw *= 1000;
@@ -2,6 +2,7 @@
 #define DATATYPES_DEP_H_
 
 #include "../ptp_primitives.h"
+#include "../ptp_datatypes.h"
 
 /**
 *\file
@@ -49,6 +50,7 @@ typedef struct {
 	BondSlave slaves[BOND_SLAVES_MAX];
 	Boolean activeChanged;
 	Boolean countChanged;
+	int ifIndex;		/* the bond device, for matching link notifications */
 } BondInfo;
 
 typedef struct {
@@ -86,6 +88,50 @@ typedef struct {
 	VlanInfo vlanInfo;
 } InterfaceInfo;
 
+/**
+* \brief Batch of unicast messages queued for a single sendmmsg() call
+*
+* Each slot holds a full copy of the packed message, so the caller only
+* patches the per-destination fields after netBatchAdd().
+ */
+typedef struct {
+	int capacity;
+	int count;
+	Octet *buf;
+	struct sockaddr_in *addr;
+	struct iovec *iov;
+#ifdef HAVE_SENDMMSG
+	struct mmsghdr *msg;
+#endif /* HAVE_SENDMMSG */
+} NetTxBatch;
+
+/**
+* \brief Single packet received by the batched receive engine
+ */
+typedef struct {
+	Octet buf[PACKET_SIZE];
+	char control[NET_RX_CONTROL_SIZE];
+	ssize_t length;
+	Boolean event;
+	TimeInternal timestamp;
+	Integer32 sourceAddr;
+	Integer32 destAddr;
+	struct sockaddr_in addr;
+	struct iovec iov;
+} NetRxSlot;
+
+/**
+* \brief Packets drained from the event and general sockets in one wakeup
+ */
+typedef struct {
+	int capacity;
+	int count;
+	NetRxSlot *slots;
+#ifdef HAVE_RECVMMSG
+	struct mmsghdr *msg;
+#endif /* HAVE_RECVMMSG */
+} NetRxRing;
+
 
 /**
 * \brief Struct describing network transport data
@@ -135,6 +181,16 @@ typedef struct {
 	int ignorePackets;
 	Ipv4AccessList* timingAcl;
 	Ipv4AccessList* managementAcl;
+	/* unicast fan-out batches for the event and general ports */
+	NetTxBatch eventBatch;
+	NetTxBatch generalBatch;
+	/* epoll receive engine - only used when rxRing.capacity > 0 */
+	int epollFd;
+	int epollNtpFd;		/* NTP control socket while in the epoll set, else -1 */
+	NetRxRing rxRing;
+	/* rtnetlink link notifications, -1 if not available: interface state is polled */
+	int linkSock;
+	Boolean linkChanged;
 
 } NetPath;
 
@@ -149,6 +205,18 @@ typedef struct {
 	Boolean logEnabled;
 	Boolean truncateOnReopen;
 	Boolean unlinkOnClose;
+	size_t bufferSize;	/* 0 = line buffered, otherwise fully buffered with this size */
+	/* owned by whoever writes the file: the housekeeping thread, if running */
+	char *header;		/* last LOGWRITE_HEADER data, written again after rotation / truncation */
+	size_t headerLength;
+	volatile uint32_t rotations;	/* files rotated / truncated by maintainLogSize() */
+	volatile uint32_t rotateErrors;	/* rotations which could not open a new file */
+	volatile uint32_t replaceErrors;	/* LOGJOB_REPLACE writes which failed */
+	volatile int replaceErrno;	/* errno of the last failed replace */
+	/* owned by the protocol thread: what reportHousekeeping() has logged so far */
+	uint32_t reportedRotations;
+	uint32_t reportedErrors;
+	uint32_t reportedReplaceErrors;
 
 	uint32_t lastHash;
 	UInteger32 maxSize;
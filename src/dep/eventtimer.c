@@ -131,3 +131,26 @@ freeEventTimer
 	*timer = NULL;
 
 }
+
+/* first timer in the list, for implementations that need to walk all timers */
+EventTimer*
+getEventTimerList(void)
+{
+	return _first;
+}
+
+#ifndef PTPD_TIMERFD
+
+/* signal driven timers interrupt the wait by themselves */
+int
+getEventTimerFd(void)
+{
+	return -1;
+}
+
+void
+armEventTimers(void)
+{
+}
+
+#endif /* !PTPD_TIMERFD */
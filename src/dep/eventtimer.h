@@ -51,12 +51,15 @@ struct EventTimer {
 	Boolean (*isRunning) (EventTimer* timer);	
 
 	/* implementation data */
-#ifdef PTPD_PTIMERS
+#if defined(PTPD_TIMERFD)
+	uint64_t deadline;		/* CLOCK_MONOTONIC, ns */
+	uint64_t period;		/* ns */
+#elif defined(PTPD_PTIMERS)
 	timer_t timerId;
 #else
 	int32_t itimerInterval;
 	int32_t itimerLeft;
-#endif /* PTPD_PTIMERS */
+#endif /* PTPD_TIMERFD / PTPD_PTIMERS */
 
 	/* linked list */
 	EventTimer *_first;
@@ -69,9 +72,16 @@ EventTimer *createEventTimer(const char *id);
 void freeEventTimer(EventTimer **timer);
 void setupEventTimer(EventTimer *timer);
 
+EventTimer *getEventTimerList();
+
 void startEventTimers();
 void shutdownEventTimers();
 
+/* descriptor the main loop waits on next to its sockets, -1 if timers are signal driven */
+int getEventTimerFd();
+/* arm the descriptor for the earliest deadline - call before every wait */
+void armEventTimers();
+
 
 #endif /* EVENTTIMER_H_ */
 
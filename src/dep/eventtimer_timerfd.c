@@ -0,0 +1,248 @@
+/*-
+ * Copyright (c) 2026 PTPd contributors,
+ *
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/**
+ * @file   eventtimer_timerfd.c
+ * @date   Sun Oct 18 07:30:19 2026
+ *
+ * @brief  EventTimer implementation using a single timerfd
+ *
+ * No signals: every timer only keeps a deadline. Before the main loop
+ * waits for packets, armEventTimers() sets one timerfd to the earliest
+ * deadline, and the timerfd is waited on together with the sockets, so
+ * the loop wakes up exactly when a packet arrives or a timer is due.
+ * Expiry is checked against CLOCK_MONOTONIC when the timer is polled.
+ * There are only ever a couple of dozen timers, so finding the earliest
+ * deadline is a walk of the timer list rather than a heap.
+ */
+
+#include "../ptpd.h"
+
+#include <sys/timerfd.h>
+
+static int timerFd = -1;
+static uint64_t armedDeadline = 0;	/* 0 = disarmed */
+
+static void eventTimerStart_timerfd(EventTimer *timer, double interval);
+static void eventTimerStop_timerfd(EventTimer *timer);
+static void eventTimerReset_timerfd(EventTimer *timer);
+static void eventTimerShutdown_timerfd(EventTimer *timer);
+static Boolean eventTimerIsRunning_timerfd(EventTimer *timer);
+static Boolean eventTimerIsExpired_timerfd(EventTimer *timer);
+
+static uint64_t
+monotonicNs(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* flag the timer if its deadline has passed and move the deadline past now */
+static void
+checkDeadline(EventTimer *timer, uint64_t now)
+{
+
+	if(!timer->running || now < timer->deadline) {
+		return;
+	}
+
+	timer->expired = TRUE;
+	/* periods missed in the meantime are skipped, like posix timer overruns */
+	timer->deadline += ((now - timer->deadline) / timer->period + 1) * timer->period;
+
+}
+
+void
+setupEventTimer(EventTimer *timer)
+{
+
+	if(timer == NULL) {
+	    return;
+	}
+
+	memset(timer, 0, sizeof(EventTimer));
+
+	timer->start = eventTimerStart_timerfd;
+	timer->stop = eventTimerStop_timerfd;
+	timer->reset = eventTimerReset_timerfd;
+	timer->shutdown = eventTimerShutdown_timerfd;
+	timer->isExpired = eventTimerIsExpired_timerfd;
+	timer->isRunning = eventTimerIsRunning_timerfd;
+
+}
+
+static void
+eventTimerStart_timerfd(EventTimer *timer, double interval)
+{
+
+	timer->period = interval * 1E9;
+
+	if(timer->period < EVENTTIMER_MIN_INTERVAL_US * 1000) {
+	    timer->period = EVENTTIMER_MIN_INTERVAL_US * 1000;
+	}
+
+	timer->deadline = monotonicNs() + timer->period;
+	timer->expired = FALSE;
+	timer->running = TRUE;
+
+	DBG2("timerStart:     Set timer %s to %f\n", timer->id, interval);
+
+}
+
+static void
+eventTimerStop_timerfd(EventTimer *timer)
+{
+
+	timer->running = FALSE;
+	DBG2("timerStop: stopped timer %s\n", timer->id);
+
+}
+
+static void
+eventTimerReset_timerfd(EventTimer *timer)
+{
+}
+
+static void
+eventTimerShutdown_timerfd(EventTimer *timer)
+{
+	timer->running = FALSE;
+}
+
+static Boolean
+eventTimerIsRunning_timerfd(EventTimer *timer)
+{
+
+	DBG2("timerIsRunning:   Timer %s %s running\n", timer->id,
+		timer->running ? "is" : "is not");
+
+	return timer->running;
+}
+
+static Boolean
+eventTimerIsExpired_timerfd(EventTimer *timer)
+{
+
+	Boolean ret;
+
+	checkDeadline(timer, monotonicNs());
+
+	ret = timer->expired;
+
+	DBG2("timerIsExpired:   Timer %s %s expired\n", timer->id,
+		timer->expired ? "is" : "is not");
+
+	if(ret) {
+	    timer->expired = FALSE;
+	}
+
+	return ret;
+
+}
+
+void
+startEventTimers(void)
+{
+
+	DBG("initTimer\n");
+
+	if(timerFd >= 0) {
+	    return;
+	}
+
+	timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if(timerFd < 0) {
+	    PERROR("Could not create timerfd - timers will not wake up the main loop");
+	}
+
+	armedDeadline = 0;
+
+}
+
+void
+shutdownEventTimers(void)
+{
+
+	if(timerFd >= 0) {
+	    close(timerFd);
+	    timerFd = -1;
+	}
+
+}
+
+int
+getEventTimerFd(void)
+{
+	return timerFd;
+}
+
+void
+armEventTimers(void)
+{
+
+	EventTimer *timer;
+	struct itimerspec its;
+	uint64_t now = monotonicNs();
+	uint64_t earliest = 0;
+
+	if(timerFd < 0) {
+	    return;
+	}
+
+	/*
+	 * Timers which went off and were not polled yet are flagged now, so
+	 * a timer nobody looks at in the current state cannot keep the
+	 * deadline in the past and spin the loop.
+	 */
+	for(timer = getEventTimerList(); timer != NULL; timer = timer->_next) {
+	    checkDeadline(timer, now);
+	    if(timer->running && (earliest == 0 || timer->deadline < earliest)) {
+		earliest = timer->deadline;
+	    }
+	}
+
+	/* still armed for the same deadline and it has not fired yet */
+	if(earliest == armedDeadline) {
+	    return;
+	}
+
+	memset(&its, 0, sizeof(its));
+	its.it_value.tv_sec = earliest / 1000000000ULL;
+	its.it_value.tv_nsec = earliest % 1000000000ULL;
+
+	/* re-arming also clears the descriptor's readable state */
+	if(timerfd_settime(timerFd, TFD_TIMER_ABSTIME, &its, NULL) < 0) {
+	    PERROR("Could not arm timerfd");
+	    armedDeadline = 0;
+	    return;
+	}
+
+	armedDeadline = earliest;
+
+}
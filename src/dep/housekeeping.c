@@ -0,0 +1,450 @@
+/*-
+ * Copyright (c) 2026 PTPd contributors,
+ *
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file   housekeeping.c
+ * @date   Sun Oct 18 07:17:07 2026
+ *
+ * @brief  Housekeeping thread: log, statistics and status file output
+ *
+ * All file and syslog output goes through logWrite(). Without the
+ * housekeeping thread (the default), logWrite() performs the write there
+ * and then. With global:housekeeping_thread enabled, the protocol thread
+ * only formats its output and copies it into a single-producer,
+ * single-consumer ring; a separate normal priority thread does the
+ * writing, flushing, size checks and log rotation. The protocol thread
+ * never takes a lock or waits for the disk: if the ring is full, output
+ * is dropped and counted.
+ *
+ * Anything which closes or reopens log files on the protocol thread
+ * (SIGHUP, shutdown) calls syncHousekeeping() first, which waits until the
+ * ring is empty - the housekeeping thread only touches files while
+ * processing a job, so the files are then safe to use.
+ *
+ * The housekeeping thread itself never logs: logging reads protocol
+ * state and writes to the event log from the protocol thread. Log
+ * rotations, failed status file replacements and dropped jobs are
+ * counted, and the protocol thread reports them through
+ * reportHousekeeping(). File headers are queued with
+ * LOGWRITE_HEADER, so whichever thread rotates a file can start the new
+ * one with its header before any record queued behind the rotation.
+ */
+
+#include "../ptpd.h"
+
+#ifdef PTPD_HOUSEKEEPING_THREAD
+#include <pthread.h>
+#include <semaphore.h>
+#endif /* PTPD_HOUSEKEEPING_THREAD */
+
+typedef struct {
+	uint32_t length;		/* whole entry including data, multiple of 8 */
+	uint16_t type;			/* LOGJOB_xxx */
+	uint16_t flags;			/* LOGWRITE_xxx */
+	int priority;			/* syslog priority */
+	LogFileHandler *handler;	/* target file, or NULL to use fp */
+	FILE *fp;			/* target stream when handler is NULL: stdout / stderr */
+	uint32_t dataLength;
+	uint32_t pad;
+	/* followed by data */
+} LogJob;
+
+#define LOGJOB_ALIGN(len) (((len) + 7) & ~7)
+
+static void
+runJob(int type, int flags, int priority, LogFileHandler *handler, FILE *fp, const void *data, size_t length)
+{
+
+	switch(type) {
+
+	    case LOGJOB_SYSLOG:
+		syslog(priority, "%s", (const char*)data);
+		return;
+
+	    case LOGJOB_REPLACE:
+		if(handler == NULL || handler->logFP == NULL) {
+			return;
+		}
+		/* write a new file and rename it over the old one: readers never see a partial file */
+		{
+		    char tmpPath[PATH_MAX + 8];
+		    struct stat st;
+
+		    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", handler->logPath);
+		    if((fp = fopen(tmpPath, "w")) == NULL) {
+			handler->replaceErrno = errno;
+			__sync_fetch_and_add(&handler->replaceErrors, 1);
+			return;
+		    }
+		    if(!fstat(fileno(handler->logFP), &st)) {
+			fchmod(fileno(fp), st.st_mode & 07777);
+		    }
+		    if(fwrite(data, length, 1, fp) != 1 || fflush(fp) != 0 ||
+			rename(tmpPath, handler->logPath) < 0) {
+			handler->replaceErrno = errno;
+			__sync_fetch_and_add(&handler->replaceErrors, 1);
+			fclose(fp);
+			unlink(tmpPath);
+			return;
+		    }
+		    /* publish the new stream before closing the old one: logFP is never stale */
+		    {
+			FILE *oldFP = handler->logFP;
+			__sync_synchronize();
+			handler->logFP = fp;
+			__sync_synchronize();
+			fclose(oldFP);
+		    }
+		}
+		return;
+
+	    case LOGJOB_WRITE:
+		if(handler != NULL) {
+			fp = handler->logFP;
+		}
+		if(fp == NULL) {
+			return;
+		}
+		/* keep a copy of the header for maintainLogSize() to start new files with */
+		if(handler != NULL && (flags & LOGWRITE_HEADER)) {
+			char *header = realloc(handler->header, length);
+			if(header != NULL) {
+				memcpy(header, data, length);
+				handler->header = header;
+				handler->headerLength = length;
+			}
+		}
+		fwrite(data, length, 1, fp);
+		if(flags & LOGWRITE_FLUSH) {
+			fflush(fp);
+		}
+		if(handler != NULL && (flags & LOGWRITE_MAINTAIN)) {
+			maintainLogSize(handler);
+		}
+		return;
+
+	    default:
+		return;
+
+	}
+
+}
+
+#ifdef PTPD_HOUSEKEEPING_THREAD
+
+static struct {
+	Boolean running;
+	volatile Boolean stop;
+	pthread_t thread;
+	pthread_t producer;		/* the protocol thread - the only one allowed to queue */
+	sem_t wakeup;
+	char *buffer;
+	size_t size;
+	volatile size_t head;		/* advanced by the producer */
+	volatile size_t tail;		/* advanced by the consumer once the job is done */
+	volatile uint32_t dropped;
+	uint32_t reported;		/* dropped jobs logged so far, producer only */
+} hk;
+
+static void*
+housekeepingThread(void *arg)
+{
+
+	size_t head, pos;
+	LogJob *job;
+
+	while(TRUE) {
+
+		head = hk.head;
+		__sync_synchronize();
+
+		while(hk.tail != head) {
+			pos = hk.tail & (hk.size - 1);
+			/* not enough room left for a job header: producer wrapped */
+			if(hk.size - pos < sizeof(LogJob)) {
+				hk.tail += hk.size - pos;
+				continue;
+			}
+			job = (LogJob*)(hk.buffer + pos);
+			runJob(job->type, job->flags, job->priority, job->handler, job->fp,
+				(char*)job + sizeof(LogJob), job->dataLength);
+			__sync_synchronize();
+			hk.tail += job->length;
+		}
+
+		if(hk.stop) {
+			break;
+		}
+
+		while(sem_wait(&hk.wakeup) < 0 && errno == EINTR);
+
+	}
+
+	return NULL;
+
+}
+
+Boolean
+startHousekeeping(void)
+{
+
+	sigset_t all, old;
+	int err;
+
+	if(hk.running) {
+		return TRUE;
+	}
+
+	memset(&hk, 0, sizeof(hk));
+	hk.size = HOUSEKEEPING_QUEUE_SIZE;
+
+	if((hk.buffer = malloc(hk.size)) == NULL) {
+		PERROR("Could not allocate housekeeping queue");
+		return FALSE;
+	}
+
+	if(sem_init(&hk.wakeup, 0, 0) < 0) {
+		PERROR("Could not initialise housekeeping thread semaphore");
+		SAFE_FREE(hk.buffer);
+		return FALSE;
+	}
+
+	/*
+	 * The protocol thread relies on signals (timers, SIGHUP, SIGINT)
+	 * interrupting its select(), so they must never be delivered here.
+	 */
+	sigfillset(&all);
+	pthread_sigmask(SIG_BLOCK, &all, &old);
+	err = pthread_create(&hk.thread, NULL, housekeepingThread, NULL);
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+	if(err) {
+		ERROR("Could not start housekeeping thread: %s\n", strerror(err));
+		sem_destroy(&hk.wakeup);
+		SAFE_FREE(hk.buffer);
+		return FALSE;
+	}
+
+	hk.producer = pthread_self();
+	__sync_synchronize();
+	hk.running = TRUE;
+
+	INFO("Started housekeeping thread: log, statistics and status output no longer block the protocol\n");
+
+	return TRUE;
+
+}
+
+void
+stopHousekeeping(void)
+{
+
+	if(!hk.running) {
+		return;
+	}
+
+	hk.stop = TRUE;
+	sem_post(&hk.wakeup);
+	pthread_join(hk.thread, NULL);
+
+	hk.running = FALSE;
+	sem_destroy(&hk.wakeup);
+	SAFE_FREE(hk.buffer);
+
+}
+
+/* wait until everything queued so far has been written */
+void
+syncHousekeeping(void)
+{
+
+	if(!hk.running || !pthread_equal(pthread_self(), hk.producer)) {
+		return;
+	}
+
+	while(hk.tail != hk.head) {
+		sem_post(&hk.wakeup);
+		usleep(1000);
+	}
+
+	__sync_synchronize();
+
+}
+
+static Boolean
+queueJob(int type, int flags, int priority, LogFileHandler *handler, FILE *fp, const void *data, size_t length)
+{
+
+	size_t need = LOGJOB_ALIGN(sizeof(LogJob) + length);
+	size_t head = hk.head;
+	size_t pos = head & (hk.size - 1);
+	size_t contiguous = hk.size - pos;
+	size_t skip = 0;
+	size_t used;
+	LogJob *job;
+
+	/* job does not fit before the end of the ring: skip (or pad) to the start */
+	if(need > contiguous) {
+		skip = contiguous;
+	}
+
+	used = head - hk.tail;
+
+	if(need > hk.size / 2 || used + skip + need > hk.size) {
+		__sync_fetch_and_add(&hk.dropped, 1);
+		return FALSE;
+	}
+
+	if(skip) {
+		if(skip >= sizeof(LogJob)) {
+			job = (LogJob*)(hk.buffer + pos);
+			job->length = skip;
+			job->type = LOGJOB_PAD;
+		}
+		pos = 0;
+	}
+
+	job = (LogJob*)(hk.buffer + pos);
+	job->length = need;
+	job->type = type;
+	job->flags = flags;
+	job->priority = priority;
+	job->handler = handler;
+	job->fp = fp;
+	job->dataLength = length;
+	memcpy((char*)job + sizeof(LogJob), data, length);
+
+	__sync_synchronize();
+	hk.head = head + skip + need;
+
+	/* only enters the kernel if the housekeeping thread is asleep */
+	sem_post(&hk.wakeup);
+
+	return TRUE;
+
+}
+
+#else
+
+Boolean
+startHousekeeping(void)
+{
+	ERROR("Housekeeping thread is not supported on this platform\n");
+	return FALSE;
+}
+
+void
+stopHousekeeping(void)
+{
+}
+
+void
+syncHousekeeping(void)
+{
+}
+
+#endif /* PTPD_HOUSEKEEPING_THREAD */
+
+/*
+ * Write data to a log file handler (or to fp, if handler is NULL), or send
+ * it to syslog. Queued to the housekeeping thread if it is running and we
+ * are the protocol thread, done directly otherwise.
+ */
+Boolean
+logWrite(int type, int flags, int priority, LogFileHandler *handler, FILE *fp, const void *data, size_t length)
+{
+
+#ifdef PTPD_HOUSEKEEPING_THREAD
+	if(hk.running && pthread_equal(pthread_self(), hk.producer)) {
+		return queueJob(type, flags, priority, handler, fp, data, length);
+	}
+#endif /* PTPD_HOUSEKEEPING_THREAD */
+
+	runJob(type, flags, priority, handler, fp, data, length);
+	return TRUE;
+
+}
+
+/* log what the writer did to one file since we last looked */
+static void
+reportLogFile(LogFileHandler *handler)
+{
+
+	uint32_t rotations = handler->rotations;
+	uint32_t errors = handler->rotateErrors;
+	uint32_t replaceErrors = handler->replaceErrors;
+
+	if(rotations != handler->reportedRotations) {
+		if(handler->maxFiles) {
+			INFO("Rotated %s file - size above %dkB\n", handler->logID, handler->maxSize);
+		} else {
+			INFO("Truncated %s file - size above %dkB\n", handler->logID, handler->maxSize);
+		}
+		handler->reportedRotations = rotations;
+	}
+
+	if(errors != handler->reportedErrors) {
+		WARNING("Could not rotate / truncate %s file %s (%u times)\n", handler->logID,
+			handler->logPath, errors - handler->reportedErrors);
+		handler->reportedErrors = errors;
+	}
+
+	if(replaceErrors != handler->reportedReplaceErrors) {
+		WARNING("Could not replace %s file %s: %s (%u times)\n", handler->logID,
+			handler->logPath, strerror(handler->replaceErrno),
+			replaceErrors - handler->reportedReplaceErrors);
+		handler->reportedReplaceErrors = replaceErrors;
+	}
+
+}
+
+/*
+ * Log file rotations, failed status file writes and dropped writes. Whatever writes the files does
+ * not log - it may not be the protocol thread - so the protocol thread
+ * calls this regularly to report for it.
+ */
+void
+reportHousekeeping(RunTimeOpts *rtOpts)
+{
+
+#ifdef PTPD_HOUSEKEEPING_THREAD
+	uint32_t dropped = hk.dropped;
+
+	if(hk.running && dropped != hk.reported) {
+		WARNING("Housekeeping queue full: %u log / status writes dropped\n",
+			dropped - hk.reported);
+		hk.reported = dropped;
+	}
+#endif /* PTPD_HOUSEKEEPING_THREAD */
+
+	reportLogFile(&rtOpts->eventLog);
+	reportLogFile(&rtOpts->statisticsLog);
+	reportLogFile(&rtOpts->recordLog);
+	reportLogFile(&rtOpts->captureLog);
+	reportLogFile(&rtOpts->statusLog);
+
+}
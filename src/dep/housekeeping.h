@@ -0,0 +1,59 @@
+/*-
+ * Copyright (c) 2026 PTPd contributors,
+ *
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file   housekeeping.h
+ * @date   Sun Oct 18 07:17:07 2026
+ *
+ * @brief  Housekeeping thread: log, statistics and status file output
+ *
+ */
+
+#ifndef PTPD_HOUSEKEEPING_H_
+#define PTPD_HOUSEKEEPING_H_
+
+#if defined(HAVE_PTHREAD_H) && defined(HAVE_SEMAPHORE_H)
+#define PTPD_HOUSEKEEPING_THREAD
+#endif
+
+/* logWrite() job types */
+enum {
+	LOGJOB_PAD = 0,		/* queue internal: skip to the start of the ring */
+	LOGJOB_WRITE,		/* append data to the file */
+	LOGJOB_REPLACE,		/* replace the file with data, atomically via rename() (status file) */
+	LOGJOB_SYSLOG		/* send data (a string) to syslog */
+};
+
+/* logWrite() flags */
+#define LOGWRITE_FLUSH		(1<<0)	/* fflush() after writing */
+#define LOGWRITE_MAINTAIN	(1<<1)	/* check the size limit and rotate / truncate if needed */
+#define LOGWRITE_HEADER		(1<<2)	/* data is the file header: also write it after each rotation */
+
+/* size of the queue between the protocol and housekeeping threads, power of 2 */
+#define HOUSEKEEPING_QUEUE_SIZE	262144
+
+#endif /* PTPD_HOUSEKEEPING_H_ */
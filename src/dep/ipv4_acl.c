@@ -33,6 +33,10 @@
  *
  * Functions in this file parse, create and match IPv4 ACLs.
  *
+ * Each mask table is compiled into a prefix trie when the ACL is created,
+ * so matching an address costs at most one step per ACL_TRIE_STRIDE bits
+ * of the address regardless of the number of entries. The trie works on
+ * a byte array key of any length, so the same code can serve IPv6 ACLs.
  */
 
 #include "../ptpd.h"
@@ -102,11 +106,13 @@ static int ipToArray(const char* text, uint8_t dest[], int maxOctets, Boolean is
 
 	}
 
-	dest[count++] = (uint8_t)octet;
+	/* If we're parsing a mask and an octet was less than 0xFF, whole rest must be zeros */
+	if(isMask && count > 0 && dest[count - 1] < 255 && octet != 0) {
+	    result = -1;
+	    goto end;
+	}
 
-	/* If we're parsing a mask and an octet is less than 0xFF, whole rest is zeros */
-	if(isMask && octet < 255)
-		goto end;
+	dest[count++] = (uint8_t)octet;
     }
 
     end:
@@ -174,9 +180,15 @@ static int parseAclEntry(const char* line, AclEntry* acl) {
     } else {
 
 	acl->bitmask = (mask_octets[0] << 24) | (mask_octets[1] << 16) | ( mask_octets[2] << 8) | mask_octets[3];
-	uint32_t tmp = acl->bitmask;
+	/* the ACL is matched as a prefix trie: a mask like 255.255.253.0 is not a prefix */
+	if(~acl->bitmask & (~acl->bitmask + 1)) {
+	    result = -1;
+	    goto end;
+	}
+	/* count the leading ones - shifting by 32 would be undefined for a /32 mask */
 	int count = 0;
-	for(tmp = acl->bitmask;tmp<<count;count++);
+	while(count < 32 && (acl->bitmask & (0x80000000U >> count)))
+	    count++;
 	acl->netmask=count;
     }
 
@@ -202,6 +214,11 @@ cmpAclEntry(const void *p1, const void *p2)
 		return 1;
 	if(left->network < right->network)
 		return -1;
+	/* same network: shorter prefix first, it is the one matched first */
+	if(left->netmask > right->netmask)
+		return 1;
+	if(left->netmask < right->netmask)
+		return -1;
 	return 0;
 
 }
@@ -256,6 +273,128 @@ maskParser(const char* input, AclEntry* output)
 
 }
 
+/* get stride number pos (0 = most significant) of a network order key - two strides per byte */
+#define ACL_KEY_STRIDE(key, pos) \
+	(((key)[(pos) >> 1] >> (((pos) & 1) ? 0 : ACL_TRIE_STRIDE)) & (ACL_TRIE_FANOUT - 1))
+
+/* Allocate a trie node with all slots empty */
+static int32_t
+aclTrieNewNode(MaskTable* table)
+{
+
+	int i;
+	int32_t node = table->trieSize++;
+
+	for(i = 0; i < ACL_TRIE_FANOUT; i++) {
+		table->trie[node].slot[i].child = 0;
+		table->trie[node].slot[i].entry = -1;
+	}
+
+	return node;
+
+}
+
+/*
+ * Add a prefix of prefixLen bits to the trie, pointing at entry. A prefix
+ * not ending on a stride boundary is expanded into all the slots it covers
+ * in its last node. Where prefixes overlap, a slot keeps the shortest one:
+ * that is the one a scan of the sorted table would hit first, so hit
+ * counters stay where they always were. Equal prefixes: the first one wins.
+ */
+static void
+aclTrieInsert(MaskTable* table, const uint8_t *key, int prefixLen, int entry)
+{
+
+	int i, first, count;
+	int depth = (prefixLen > 0) ? (prefixLen - 1) / ACL_TRIE_STRIDE : 0;
+	int32_t node = 0;
+	AclTrieSlot *slot;
+
+	for(i = 0; i < depth; i++) {
+		slot = &table->trie[node].slot[ACL_KEY_STRIDE(key, i)];
+		if(slot->child == 0) {
+			slot->child = aclTrieNewNode(table);
+		}
+		node = slot->child;
+	}
+
+	count = 1 << ((depth + 1) * ACL_TRIE_STRIDE - prefixLen);
+	first = ACL_KEY_STRIDE(key, depth) & ~(count - 1);
+
+	for(i = first; i < first + count; i++) {
+		slot = &table->trie[node].slot[i];
+		if(slot->entry < 0 || table->entries[slot->entry].netmask > prefixLen) {
+			slot->entry = entry;
+		}
+	}
+
+}
+
+/*
+ * Find the entry matching a key of keyBits bits, or -1. The first entry
+ * found on the way down is returned: any match decides the lookup, and
+ * it is the shortest matching prefix.
+ */
+static int
+aclTrieMatch(const MaskTable* table, const uint8_t *key, int keyBits)
+{
+
+	int i;
+	int levels = keyBits / ACL_TRIE_STRIDE;
+	const AclTrieSlot *slot;
+	int32_t node = 0;
+
+	for(i = 0; i < levels; i++) {
+		slot = &table->trie[node].slot[ACL_KEY_STRIDE(key, i)];
+		if(slot->entry >= 0) {
+			return slot->entry;
+		}
+		if((node = slot->child) == 0) {
+			return -1;
+		}
+	}
+
+	return -1;
+
+}
+
+/* Write an IPv4 address (host order) as a network order key */
+static inline void
+ipv4ToKey(const uint32_t addr, uint8_t key[4])
+{
+	key[0] = addr >> 24;
+	key[1] = addr >> 16;
+	key[2] = addr >> 8;
+	key[3] = addr;
+}
+
+/* Build the prefix trie from the entries of a mask table */
+static void
+compileMaskTable(MaskTable* table)
+{
+
+	int i;
+	uint8_t key[4];
+
+	/* worst case: every entry is a /32 sharing nothing with the others */
+	table->trie = (AclTrieNode*)calloc(1 + table->numEntries * (32 / ACL_TRIE_STRIDE - 1),
+					    sizeof(AclTrieNode));
+	table->trieSize = 0;
+	aclTrieNewNode(table);
+
+	for(i = 0; i < table->numEntries; i++) {
+		ipv4ToKey(table->entries[i].network, key);
+		aclTrieInsert(table, key, table->entries[i].netmask, i);
+	}
+
+	/* give back what the worst case did not need */
+	table->trie = (AclTrieNode*)realloc(table->trie, table->trieSize * sizeof(AclTrieNode));
+
+	DBG("Compiled access list of %d entries into %d trie nodes\n",
+		table->numEntries, table->trieSize);
+
+}
+
 /* Create a maskTable from a text ACL */
 static MaskTable*
 createMaskTable(const char* input)
@@ -266,6 +405,7 @@ createMaskTable(const char* input)
 		ret=(MaskTable*)calloc(1,sizeof(MaskTable));
 		ret->entries = (AclEntry*)calloc(masksFound, sizeof(AclEntry));
 		ret->numEntries = maskParser(input,ret->entries);
+		compileMaskTable(ret);
 		return ret;
 	} else {
 		ERROR("Error while parsing access list: \"%s\"\n", input);
@@ -309,6 +449,7 @@ static void freeMaskTable(MaskTable** table)
 	free((*table)->entries);
 	(*table)->entries = NULL;
     }
+    SAFE_FREE((*table)->trie);
     free(*table);
     *table = NULL;
 }
@@ -350,14 +491,15 @@ matchAddress(const uint32_t addr, MaskTable* table)
 {
 
 	int i;
+	uint8_t key[4];
 	if(table == NULL || table->entries == NULL || table->numEntries==0)
 	    return -1;
-	for(i = 0; i < table->numEntries; i++) {
+	ipv4ToKey(addr, key);
+	i = aclTrieMatch(table, key, 32);
+	if(i >= 0) {
 		DBGV("addr: %08x, addr & mask: %08x, network: %08x\n",addr, table->entries[i].bitmask & addr, table->entries[i].network);
-		if((table->entries[i].bitmask & addr) == table->entries[i].network) {
-			table->entries[i].hitCount++;
-			return 1;
-		}
+		table->entries[i].hitCount++;
+		return 1;
 	}
 
 	return 0;
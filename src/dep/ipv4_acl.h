@@ -23,9 +23,24 @@ typedef struct {
 	uint32_t hitCount;
 } AclEntry;
 
+/* compiled prefix trie: ACL_TRIE_STRIDE bits of the address per level */
+#define ACL_TRIE_STRIDE 4
+#define ACL_TRIE_FANOUT (1 << ACL_TRIE_STRIDE)
+
+typedef struct {
+	int32_t child;		/* index of the child node, 0 = none (root is never a child) */
+	int32_t entry;		/* index of the shortest entry covering this slot, -1 = none */
+} AclTrieSlot;
+
+typedef struct {
+	AclTrieSlot slot[ACL_TRIE_FANOUT];
+} AclTrieNode;
+
 typedef struct {
 	int numEntries;
 	AclEntry* entries;
+	int trieSize;		/* number of nodes used */
+	AclTrieNode* trie;	/* compiled from entries, used for matching */
 } MaskTable;
 
 typedef struct {
@@ -1864,6 +1864,22 @@ msgPackFollowUp(Octet * buf, Timestamp * preciseOriginTimestamp, PtpClock * ptpC
 		flip32(preciseOriginTimestamp->nanosecondsField);
 }
 
+/* Overwrite the sequenceId of an already packed message */
+void
+msgPatchSequenceId(Octet * buf, UInteger16 sequenceId)
+{
+	*(UInteger16 *) (buf + 30) = flip16(sequenceId);
+}
+
+/* Overwrite the (precise) origin timestamp of an already packed Sync or FollowUp */
+void
+msgPatchTimestamp(Octet * buf, const Timestamp * timestamp)
+{
+	*(UInteger16 *) (buf + 34) = flip16(timestamp->secondsField.msb);
+	*(UInteger32 *) (buf + 36) = flip32(timestamp->secondsField.lsb);
+	*(UInteger32 *) (buf + 40) = flip32(timestamp->nanosecondsField);
+}
+
 /*Unpack Follow_up message from IN buffer of ptpClock to msgtmp.follow*/
 void
 msgUnpackFollowUp(Octet * buf, MsgFollowUp * follow)
@@ -1953,20 +1969,30 @@ msgPackDelayResp(Octet * buf, MsgHeader * header, Timestamp * receiveTimestamp,
 
 	/* -- PTP_UNICAST flag will be set in netsend* if needed */
 
-	memset((buf + 8), 0, 8);
+	*(UInteger8 *) (buf + 32) = 0x03;
+
+	msgPatchDelayResp(buf, header, receiveTimestamp, ptpClock);
+}
 
+/*
+ * Write the fields of a packed Delay_Resp which depend on the Delay_Req
+ * being answered, so a previously packed response can be reused
+ */
+void
+msgPatchDelayResp(Octet * buf, MsgHeader * header, Timestamp * receiveTimestamp, PtpClock * ptpClock)
+{
 	/* Copy correctionField of PdelayReqMessage */
 	*(Integer32 *) (buf + 8) = flip32(header->correctionField.msb);
 	*(Integer32 *) (buf + 12) = flip32(header->correctionField.lsb);
 
 	*(UInteger16 *) (buf + 30) = flip16(header->sequenceId);
 
-	*(UInteger8 *) (buf + 32) = 0x03;
-
 	 /* Table 24 - unless it's multicast, logMessageInterval remains    0x7F */
 	 /* really tempting to cheat here, at least for hybrid, but standard is a standard */
 	if ((header->flagField0 & PTP_UNICAST) != PTP_UNICAST) {
 	    *(Integer8 *) (buf + 33) = ptpClock->portDS.logMinDelayReqInterval;
+	} else {
+	    *(UInteger8 *) (buf + 33) = 0x7F;
 	}
 
 	/* Pdelay_resp message */
@@ -83,18 +83,33 @@
 #include <linux/net_tstamp.h>
 #include <linux/sockios.h>
 #include <linux/ethtool.h>
+#include <poll.h>
 #endif /* SO_TIMESTAMPING */
 
 #include "linux/if_bonding.h"
 #include "linux/if_vlan.h"
 
+#ifdef HAVE_LINUX_RTNETLINK_H
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#endif /* HAVE_LINUX_RTNETLINK_H */
+
 static Boolean bondQuery(char *ifaceName, ifbond *ifb);
 static Boolean bondSlaveQuery(char *ifaceName, ifslave *ifs, int member);
 static void getBondInfo(char *ifaceName, BondInfo *info);
 static void getVlanInfo(char* ifaceName, VlanInfo *info);
+static void netInitLinkMonitor(NetPath *netPath);
+static void netShutdownLinkMonitor(NetPath *netPath);
+static void netReceiveLinkEvents(NetPath *netPath);
 static Boolean getHwTs(const char *ifaceName, const RunTimeOpts *rtOpts, HwTsInfo *target, Boolean quiet);
 static Boolean initHwTs(char *ifaceName, HwTsInfo *info);
 static ssize_t netr(Octet * buf, TimeInternal * time, NetPath * netPath, int flags);
+static Boolean netGetRecvTimestamp(struct msghdr *msg, Octet *buf, NetPath *netPath, TimeInternal *time, int flags);
+static Boolean netInitTxBatch(NetTxBatch *batch, int capacity);
+static void netFreeTxBatch(NetTxBatch *batch);
+static int netBatchFlush(NetPath *netPath, NetTxBatch *batch, Integer32 sock, UInteger16 port);
+static Boolean netInitRxRing(NetPath *netPath, const RunTimeOpts *rtOpts);
+static void netShutdownRxRing(NetPath *netPath);
 
 
 /**
@@ -190,6 +205,11 @@ netShutdown(NetPath * netPath, PtpClock *ptpClock)
 
 	freeIpv4AccessList(&netPath->timingAcl);
 	freeIpv4AccessList(&netPath->managementAcl);
+
+	netFreeTxBatch(&netPath->eventBatch);
+	netFreeTxBatch(&netPath->generalBatch);
+	netShutdownRxRing(netPath);
+	netShutdownLinkMonitor(netPath);
 /*
 	freeClockDriver(&ptpClock->clockDriver);
 	freeClockDriver(&ptpClock->clockDriver2);
@@ -796,8 +816,107 @@ getTxTimestamp(NetPath* netPath,TimeInternal* timeStamp) {
 	return FALSE;
 
 }
+
+/*
+ * Find the PTP message in a frame returned from the error queue. Most drivers
+ * hand back the whole frame (Ethernet, optional VLAN tag, IPv4, UDP), which
+ * also gives us the destination address; otherwise assume the PTP payload only.
+ */
+static Boolean
+parseTxTimestampFrame(const Octet *buf, ssize_t length, Enumeration4 *messageType, UInteger16 *sequenceId, Integer32 *dst)
+{
+	const Octet *ptp = buf;
+	size_t offset = ETHER_HDR_LEN;
+	uint16_t etherType;
+	UInteger16 seq;
+	struct ip iph;
+
+	*dst = 0;
+
+	if(length >= (ssize_t)(PACKET_BEGIN_UDP + HEADER_LENGTH)) {
+		memcpy(&etherType, buf + 2 * ETHER_ADDR_LEN, sizeof(etherType));
+		if(ntohs(etherType) == ETHERTYPE_VLAN) {
+			memcpy(&etherType, buf + 2 * ETHER_ADDR_LEN + 4, sizeof(etherType));
+			offset += 4;
+		}
+		if((ntohs(etherType) == ETHERTYPE_IP) && ((buf[offset] >> 4) == 4)) {
+			memcpy(&iph, buf + offset, sizeof(iph));
+			*dst = iph.ip_dst.s_addr;
+			ptp = buf + offset + iph.ip_hl * 4 + sizeof(struct udphdr);
+		}
+	}
+
+	if((ptp + HEADER_LENGTH > buf + length) || ((ptp[1] & 0x0F) != VERSION_PTP)) {
+		return FALSE;
+	}
+
+	memcpy(&seq, ptp + 30, sizeof(seq));
+	*sequenceId = flip16(seq);
+	*messageType = ptp[0] & 0x0F;
+
+	return TRUE;
+}
 #endif /* SO_TIMESTAMPING */
 
+/*
+ * Collect one TX timestamp from the error queue, waiting up to waitUs microseconds
+ * for it to arrive. Used for deferred timestamp collection after a number of event
+ * messages were sent with netSendEvent(..., NULL): the message type, sequence ID
+ * and (where available) destination address are returned so the caller can match
+ * the timestamp against its pending transmissions.
+ */
+Boolean
+netRecvTxTimestamp(NetPath *netPath, TimeInternal *timeStamp, Enumeration4 *messageType,
+		    UInteger16 *sequenceId, Integer32 *dst, int waitUs)
+{
+#if defined(SO_TIMESTAMPING) && defined(SO_TIMESTAMPNS)
+	Octet buf[PACKET_SIZE];
+	struct pollfd pfd;
+	ssize_t length;
+
+	if(!netPath->txTimestamping || netPath->txLoop) {
+		return FALSE;
+	}
+
+	/* no events requested: POLLERR is only reported when the error queue is not empty */
+	pfd.fd = netPath->eventSock;
+	pfd.events = 0;
+	pfd.revents = 0;
+
+	while(TRUE) {
+		if(poll(&pfd, 1, (waitUs + 999) / 1000) <= 0) {
+			return FALSE;
+		}
+		if(!(pfd.revents & POLLERR)) {
+			return FALSE;
+		}
+
+		length = netr(buf, timeStamp, netPath, MSG_ERRQUEUE);
+
+		if(length < 0) {
+			clearTime(timeStamp);
+			ERROR("netRecvTxTimestamp: Failed to poll error queue for SO_TIMESTAMPING transmit time: %s\n", strerror(errno));
+			return FALSE;
+		}
+
+		if(length == 0) {
+			DBG("netRecvTxTimestamp: Received no data from TX error queue\n");
+			return FALSE;
+		}
+
+		if(parseTxTimestampFrame(buf, length, messageType, sequenceId, dst)) {
+			DBG("netRecvTxTimestamp: Grabbed sent msg via errqueue: %d bytes, seq %d, at %d.%d\n",
+			    length, *sequenceId, timeStamp->seconds, timeStamp->nanoseconds);
+			return TRUE;
+		}
+
+		DBG("netRecvTxTimestamp: could not parse looped TX message - discarding\n");
+	}
+#else
+	return FALSE;
+#endif /* SO_TIMESTAMPING */
+}
+
 
 static Boolean
 netInitHwTimestamping(NetPath *netPath, const RunTimeOpts *rtOpts) {
@@ -1205,7 +1324,7 @@ netInit(NetPath * netPath, RunTimeOpts * rtOpts, PtpClock * ptpClock)
 		pcap_set_promisc(netPath->pcapEvent, promisc);
 		pcap_set_snaplen(netPath->pcapEvent, PACKET_SIZE);
 		pcap_set_timeout(netPath->pcapEvent, PCAP_TIMEOUT);
-		pcap_set_buffer_size(netPath->pcapEvent, 1024 * 2 * UNICAST_MAX_DESTINATIONS);
+		pcap_set_buffer_size(netPath->pcapEvent, 1024 * 2 * rtOpts->unicastGrantCapacity);
 		pcap_activate(netPath->pcapEvent);
 */
 		if (pcap_compile(netPath->pcapEvent, &program,
@@ -1343,8 +1462,8 @@ netInit(NetPath * netPath, RunTimeOpts * rtOpts, PtpClock * ptpClock)
 
                     DBG("eventSock rcvbuff : %d\n", n);
 
-                    if(n < (UNICAST_MAX_DESTINATIONS * 1024)) {
-                        n = UNICAST_MAX_DESTINATIONS * 1024;
+                    if(n < (rtOpts->unicastGrantCapacity * 1024)) {
+                        n = rtOpts->unicastGrantCapacity * 1024;
                         if (setsockopt(netPath->eventSock, SOL_SOCKET, SO_RCVBUF, &n, sizeof(n)) < 0) {
                             DBG("Failed to increase event socket receive buffer\n");
                         }
@@ -1356,8 +1475,8 @@ netInit(NetPath * netPath, RunTimeOpts * rtOpts, PtpClock * ptpClock)
 
                     DBG("genetalSock rcvbuff : %d\n", n);
 
-                    if(n < (UNICAST_MAX_DESTINATIONS * 1024)) {
-                        n = UNICAST_MAX_DESTINATIONS * 1024;
+                    if(n < (rtOpts->unicastGrantCapacity * 1024)) {
+                        n = rtOpts->unicastGrantCapacity * 1024;
                         if (setsockopt(netPath->generalSock, SOL_SOCKET, SO_RCVBUF, &n, sizeof(n)) < 0) {
                             DBG("Failed to increase general socket receive buffer\n");
                         }
@@ -1412,7 +1531,7 @@ netInit(NetPath * netPath, RunTimeOpts * rtOpts, PtpClock * ptpClock)
 		if(rtOpts->unicastDestinationsSet) {
 
 		    ptpClock->unicastDestinationCount = parseUnicastConfig(rtOpts,
-			    UNICAST_MAX_DESTINATIONS, ptpClock->unicastDestinations);
+			    ptpClock->unicastGrantCapacity, ptpClock->unicastDestinations);
 			    DBG("configured %d unicast destinations\n",ptpClock->unicastDestinationCount);
 
 		}
@@ -1521,6 +1640,27 @@ netInit(NetPath * netPath, RunTimeOpts * rtOpts, PtpClock * ptpClock)
 			rtOpts->managementAclDenyText, rtOpts->managementAclOrder);
 	}
 
+	/* unicast fan-out batches - only useful for an IPv4 unicast master */
+	netFreeTxBatch(&netPath->eventBatch);
+	netFreeTxBatch(&netPath->generalBatch);
+	if(rtOpts->unicastBatchTransmit && (rtOpts->transport == UDP_IPV4) &&
+	    (rtOpts->ipMode == IPMODE_UNICAST) && !rtOpts->slaveOnly) {
+		if(!netInitTxBatch(&netPath->eventBatch, max(rtOpts->unicastGrantCapacity, UNICAST_MAX_DESTINATIONS)) ||
+		    !netInitTxBatch(&netPath->generalBatch, max(rtOpts->unicastGrantCapacity, UNICAST_MAX_DESTINATIONS))) {
+			WARNING("Could not allocate unicast transmit batches - sending one message at a time\n");
+			netFreeTxBatch(&netPath->eventBatch);
+			netFreeTxBatch(&netPath->generalBatch);
+		}
+	}
+
+	/* before the receive ring: it is waited on along with the sockets */
+	netShutdownLinkMonitor(netPath);
+	netInitLinkMonitor(netPath);
+
+	netShutdownRxRing(netPath);
+	if(rtOpts->batchReceive && !netInitRxRing(netPath, rtOpts)) {
+		INFO("Batched receive not available - using select()\n");
+	}
 
 	return TRUE;
 }
@@ -1530,6 +1670,8 @@ int
 netSelect(TimeInternal * timeout, NetPath * netPath, fd_set *readfds)
 {
 	int ret, nfds;
+	int timerFd = getEventTimerFd();
+	int ntpFd = ntpdControlFd();
 	struct timeval tv, *tv_ptr;
 
 
@@ -1575,6 +1717,29 @@ netSelect(TimeInternal * timeout, NetPath * netPath, fd_set *readfds)
 #ifdef PTPD_PCAP
 	}
 #endif
+
+	/* event timers not driven by signals need to be waited on as well */
+	if (timerFd >= 0) {
+		armEventTimers();
+		FD_SET(timerFd, readfds);
+		if (nfds < timerFd)
+			nfds = timerFd;
+	}
+
+	/* responses from ntpd to requests in flight */
+	if (ntpFd >= 0) {
+		FD_SET(ntpFd, readfds);
+		if (nfds < ntpFd)
+			nfds = ntpFd;
+	}
+
+	/* interface, bond and VLAN changes */
+	if (netPath->linkSock >= 0) {
+		FD_SET(netPath->linkSock, readfds);
+		if (nfds < netPath->linkSock)
+			nfds = netPath->linkSock;
+	}
+
 	nfds++;
 
 #if defined PTPD_SNMP
@@ -1608,9 +1773,434 @@ if (rtOpts.snmpEnabled) {
 	netsnmp_check_outstanding_agent_requests();
 }
 #endif
+
+	/* a timer going off is not traffic: callers only look at the sockets */
+	if (ret > 0 && timerFd >= 0 && FD_ISSET(timerFd, readfds)) {
+		FD_CLR(timerFd, readfds);
+		ret--;
+	}
+
+	if (ret > 0 && ntpFd >= 0 && FD_ISSET(ntpFd, readfds)) {
+		FD_CLR(ntpFd, readfds);
+		ret--;
+		ntpdControlReceive();
+	}
+
+	if (ret > 0 && netPath->linkSock >= 0 && FD_ISSET(netPath->linkSock, readfds)) {
+		FD_CLR(netPath->linkSock, readfds);
+		ret--;
+		netReceiveLinkEvents(netPath);
+	}
+
 	return ret;
 }
 
+/*
+ * Walk the ancillary data of a received message: store the destination address
+ * in netPath->lastDestAddr and the receive (or TX if flags contain MSG_ERRQUEUE)
+ * timestamp in time. Returns TRUE if a timestamp was found.
+ */
+static Boolean
+netGetRecvTimestamp(struct msghdr *msg, Octet *buf, NetPath *netPath, TimeInternal *time, int flags)
+{
+	struct cmsghdr *cmsg;
+
+#if defined(SO_TIMESTAMPNS) || defined(SO_TIMESTAMPING)
+	struct timespec * ts;
+#elif defined(SO_BINTIME)
+	struct bintime * bt;
+	struct timespec ts;
+#endif
+	
+#if defined(SO_TIMESTAMP)
+	struct timeval * tv;
+#endif
+	Boolean timestampValid = FALSE;
+
+	for (cmsg = CMSG_FIRSTHDR(msg); cmsg != NULL;
+	     cmsg = CMSG_NXTHDR(msg, cmsg)) {
+
+#ifdef IP_PKTINFO
+		if ((cmsg->cmsg_level == IPPROTO_IP) &&
+		    (cmsg->cmsg_type == IP_PKTINFO)) {
+			struct in_pktinfo *pi =
+			(struct in_pktinfo *) CMSG_DATA(cmsg);
+			netPath->lastDestAddr = pi->ipi_addr.s_addr;
+			DBG("IP_PKTINFO Dst: %s\n", inet_ntoa(pi->ipi_addr));
+		}
+#endif
+
+#ifdef IP_RECVDSTADDR
+		if ((cmsg->cmsg_level == IPPROTO_IP) &&
+		    (cmsg->cmsg_type == IP_RECVDSTADDR)) {
+			struct in_addr *pa = (struct in_addr *) CMSG_DATA(cmsg);
+			netPath->lastDestAddr = pa->s_addr;
+			DBG("IP_RECVDSTADDR Dst: %s\n", inet_ntoa(*pa));
+		}
+#endif
+		if (cmsg->cmsg_level == SOL_SOCKET) {
+#if defined(SO_TIMESTAMPING)
+			if(cmsg->cmsg_type == SO_TIMESTAMPING) {
+				ts = (struct timespec *)CMSG_DATA(cmsg);
+				if(netPath->hwTimestamping) {
+					if (cmsg->cmsg_len >= sizeof(*ts) * 3) {
+					    time->seconds = ts[2].tv_sec;
+					    time->nanoseconds = ts[2].tv_nsec;
+					} else {
+					    ERROR("SO_TIMESTAMPING: HW timestamp control message too short\n");
+					    return FALSE;
+					}
+				} else {
+					    time->seconds = ts[0].tv_sec;
+					    time->nanoseconds = ts[0].tv_nsec;
+				}
+				timestampValid = TRUE;
+				if((flags & MSG_ERRQUEUE) && netPath->txLoop) {
+					char tmpB[PACKET_SIZE];
+					memset(tmpB,0,PACKET_SIZE);
+					memcpy(tmpB, buf, PACKET_SIZE);
+					memset(buf,0,PACKET_SIZE);
+					memcpy(buf, tmpB + 42, PACKET_SIZE - 42);
+				}
+
+				DBG("rcvevent: SO_TIMESTAMPING %s time stamp: %us %dns\n", 
+				    (flags & MSG_ERRQUEUE) ? "TX" : "RX" ,
+				     time->seconds, time->nanoseconds);
+				break;
+			}
+#endif
+
+#if defined(SO_TIMESTAMPNS)
+			if(cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+				ts = (struct timespec *)CMSG_DATA(cmsg);
+				time->seconds = ts->tv_sec;
+				time->nanoseconds = ts->tv_nsec;
+				timestampValid = TRUE;
+				DBGV("kernel NANO recv time stamp %us %dns\n",
+				     time->seconds, time->nanoseconds);
+				break;
+			}
+#elif defined(SO_BINTIME)
+			if(cmsg->cmsg_type == SCM_BINTIME) {
+				bt = (struct bintime *)CMSG_DATA(cmsg);
+				bintime2timespec(bt, &ts);
+				time->seconds = ts.tv_sec;
+				time->nanoseconds = ts.tv_nsec;
+				timestampValid = TRUE;
+				DBGV("kernel NANO recv time stamp %us %dns\n",
+				     time->seconds, time->nanoseconds);
+				break;
+			}
+#endif
+		
+#if defined(SO_TIMESTAMP)
+			if(cmsg->cmsg_type == SCM_TIMESTAMP) {
+				tv = (struct timeval *)CMSG_DATA(cmsg);
+				time->seconds = tv->tv_sec;
+				time->nanoseconds = tv->tv_usec * 1000;
+				timestampValid = TRUE;
+				DBGV("kernel MICRO recv time stamp %us %dns\n",
+				     time->seconds, time->nanoseconds);
+			}
+#endif
+		 }
+
+	}
+
+	return timestampValid;
+}
+
+/*
+ * Set up the epoll receive engine: one epoll set for both sockets and a ring of
+ * NET_RX_BATCH_SIZE packets drained with recvmmsg(). Linux only. Not used with pcap, SNMP
+ * (which needs select()) or TX timestamps looped back through the error queue.
+ */
+static Boolean
+netInitRxRing(NetPath *netPath, const RunTimeOpts *rtOpts)
+{
+#if defined(HAVE_SYS_EPOLL_H) && defined(HAVE_RECVMMSG)
+	int i;
+	struct epoll_event ev;
+	NetRxRing *ring = &netPath->rxRing;
+
+#ifdef PTPD_PCAP
+	if(netPath->pcapEvent != NULL || netPath->pcapGeneral != NULL) {
+		return FALSE;
+	}
+#endif /* PTPD_PCAP */
+
+#ifdef PTPD_SNMP
+	if(rtOpts->snmpEnabled) {
+		return FALSE;
+	}
+#endif /* PTPD_SNMP */
+
+	if(netPath->txTimestamping && netPath->txLoop) {
+		return FALSE;
+	}
+
+	if(netPath->eventSock < 0 || netPath->generalSock < 0) {
+		return FALSE;
+	}
+
+	netPath->epollFd = epoll_create(2);
+	if(netPath->epollFd < 0) {
+		PERROR("Could not create epoll instance");
+		return FALSE;
+	}
+
+	/* added by netRecvBatch() while NTP control requests are in flight */
+	netPath->epollNtpFd = -1;
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.fd = netPath->eventSock;
+	if(epoll_ctl(netPath->epollFd, EPOLL_CTL_ADD, netPath->eventSock, &ev) < 0) {
+		PERROR("Could not add event socket to epoll set");
+		close(netPath->epollFd);
+		return FALSE;
+	}
+	ev.data.fd = netPath->generalSock;
+	if(epoll_ctl(netPath->epollFd, EPOLL_CTL_ADD, netPath->generalSock, &ev) < 0) {
+		PERROR("Could not add general socket to epoll set");
+		close(netPath->epollFd);
+		return FALSE;
+	}
+	/* event timers not driven by signals need to be waited on as well */
+	if((ev.data.fd = getEventTimerFd()) >= 0 &&
+	    epoll_ctl(netPath->epollFd, EPOLL_CTL_ADD, ev.data.fd, &ev) < 0) {
+		PERROR("Could not add event timers to epoll set");
+		close(netPath->epollFd);
+		return FALSE;
+	}
+	if((ev.data.fd = netPath->linkSock) >= 0 &&
+	    epoll_ctl(netPath->epollFd, EPOLL_CTL_ADD, ev.data.fd, &ev) < 0) {
+		PERROR("Could not add netlink socket to epoll set");
+		close(netPath->epollFd);
+		return FALSE;
+	}
+
+	ring->slots = calloc(NET_RX_BATCH_SIZE, sizeof(NetRxSlot));
+	ring->msg = calloc(NET_RX_BATCH_SIZE, sizeof(struct mmsghdr));
+	if(ring->slots == NULL || ring->msg == NULL) {
+		SAFE_FREE(ring->slots);
+		SAFE_FREE(ring->msg);
+		close(netPath->epollFd);
+		return FALSE;
+	}
+
+	for(i = 0; i < NET_RX_BATCH_SIZE; i++) {
+		ring->slots[i].iov.iov_base = ring->slots[i].buf;
+		ring->slots[i].iov.iov_len = PACKET_SIZE;
+		ring->msg[i].msg_hdr.msg_name = &ring->slots[i].addr;
+		ring->msg[i].msg_hdr.msg_iov = &ring->slots[i].iov;
+		ring->msg[i].msg_hdr.msg_iovlen = 1;
+		ring->msg[i].msg_hdr.msg_control = ring->slots[i].control;
+	}
+
+	ring->count = 0;
+	ring->capacity = NET_RX_BATCH_SIZE;
+
+	INFO("Using epoll with batched receive (%d packets per wakeup)\n", ring->capacity);
+
+	return TRUE;
+#else
+	return FALSE;
+#endif /* HAVE_SYS_EPOLL_H && HAVE_RECVMMSG */
+}
+
+static void
+netShutdownRxRing(NetPath *netPath)
+{
+	if(netPath->rxRing.capacity == 0) {
+		return;
+	}
+
+	close(netPath->epollFd);
+	netPath->epollFd = -1;
+	netPath->epollNtpFd = -1;
+	SAFE_FREE(netPath->rxRing.slots);
+#ifdef HAVE_RECVMMSG
+	SAFE_FREE(netPath->rxRing.msg);
+#endif /* HAVE_RECVMMSG */
+	netPath->rxRing.capacity = 0;
+	netPath->rxRing.count = 0;
+}
+
+#if defined(HAVE_SYS_EPOLL_H) && defined(HAVE_RECVMMSG)
+/*
+ * Read as many packets as fit in the ring from one socket. Packets that cannot be
+ * used (truncated, or event messages without a timestamp) are kept with zero length.
+ * Returns the number of slots filled, or -1 on socket error.
+ */
+static int
+netDrainSocket(NetPath *netPath, Integer32 sock, Boolean event)
+{
+	NetRxRing *ring = &netPath->rxRing;
+	NetRxSlot *slot;
+	struct msghdr *hdr;
+	int first = ring->count;
+	int received = 0;
+	int i;
+	ssize_t ret;
+	if(first >= ring->capacity) {
+		return 0;
+	}
+
+	/* recvmmsg() overwrites the lengths, so reset them every time */
+	for(i = first; i < ring->capacity; i++) {
+		hdr = &ring->msg[i].msg_hdr;
+		hdr->msg_namelen = sizeof(struct sockaddr_in);
+		hdr->msg_controllen = event ? NET_RX_CONTROL_SIZE : 0;
+		hdr->msg_flags = 0;
+	}
+
+	do {
+		ret = recvmmsg(sock, ring->msg + first, ring->capacity - first, MSG_DONTWAIT, NULL);
+	} while (ret < 0 && errno == EINTR);
+
+	if(ret < 0) {
+		return (errno == EAGAIN) ? 0 : -1;
+	}
+	received = ret;
+
+	for(i = first; i < first + received; i++) {
+
+		slot = &ring->slots[i];
+		hdr = &ring->msg[i].msg_hdr;
+		slot->length = ring->msg[i].msg_len;
+		slot->event = event;
+		slot->sourceAddr = slot->addr.sin_addr.s_addr;
+		slot->destAddr = 0;
+		clearTime(&slot->timestamp);
+
+		netPath->receivedPacketsTotal++;
+		/* do not report "from self" */
+		if(!slot->sourceAddr || (slot->sourceAddr != netPath->interfaceAddr.s_addr)) {
+			netPath->receivedPackets++;
+		}
+
+		if (hdr->msg_flags & MSG_TRUNC) {
+			ERROR("received truncated message\n");
+			slot->length = 0;
+			continue;
+		}
+
+		if(!event) {
+			continue;
+		}
+
+		if (hdr->msg_flags & MSG_CTRUNC) {
+			ERROR("received truncated ancillary data\n");
+			slot->length = 0;
+			continue;
+		}
+
+		netPath->lastDestAddr = 0;
+		if(!netGetRecvTimestamp(hdr, slot->buf, netPath, &slot->timestamp, 0)) {
+			DBG("netDrainSocket: no receive time stamp\n");
+			slot->length = 0;
+			continue;
+		}
+		slot->destAddr = netPath->lastDestAddr;
+
+	}
+
+	ring->count += received;
+
+	return received;
+}
+#endif /* HAVE_SYS_EPOLL_H && HAVE_RECVMMSG */
+
+/*
+ * Wait for traffic using epoll and drain the event, then the general socket into
+ * netPath->rxRing. Returns the number of packets queued, 0 on timeout or signal,
+ * -1 on error. A NULL timeout blocks until data arrives or a signal is received.
+ */
+int
+netRecvBatch(TimeInternal *timeout, NetPath *netPath)
+{
+#if defined(HAVE_SYS_EPOLL_H) && defined(HAVE_RECVMMSG)
+	struct epoll_event ev, events[5];
+	char discard[PACKET_SIZE];
+	int ret, i;
+	int ntpFd = ntpdControlFd();
+	int timeoutMs = -1;
+	Boolean eventReady = FALSE, generalReady = FALSE;
+
+	netPath->rxRing.count = 0;
+
+	if (timeout) {
+		if(isTimeNegative(timeout)) {
+			ERROR("Negative timeout attempted for epoll_wait()\n");
+			return -1;
+		}
+		timeoutMs = timeout->seconds * 1000 + timeout->nanoseconds / 1000000;
+	}
+
+	armEventTimers();
+
+	/*
+	 * Responses from ntpd to requests in flight: the control socket is only watched
+	 * while there are any. MOD first, as a closed socket leaves the set by itself
+	 * and ntpd control may have been restarted on a socket with the same number.
+	 */
+	if(netPath->epollNtpFd >= 0 && netPath->epollNtpFd != ntpFd) {
+		/* fails harmlessly if the socket has been closed since */
+		epoll_ctl(netPath->epollFd, EPOLL_CTL_DEL, netPath->epollNtpFd, NULL);
+	}
+	netPath->epollNtpFd = -1;
+	if(ntpFd >= 0) {
+		memset(&ev, 0, sizeof(ev));
+		ev.events = EPOLLIN;
+		ev.data.fd = ntpFd;
+		if(epoll_ctl(netPath->epollFd, EPOLL_CTL_MOD, ntpFd, &ev) == 0 ||
+		    (errno == ENOENT && epoll_ctl(netPath->epollFd, EPOLL_CTL_ADD, ntpFd, &ev) == 0)) {
+			netPath->epollNtpFd = ntpFd;
+		} else {
+			DBG("netRecvBatch: could not add NTP control socket to epoll set: %s\n", strerror(errno));
+		}
+	}
+
+	ret = epoll_wait(netPath->epollFd, events, sizeof(events) / sizeof(events[0]), timeoutMs);
+
+	if (ret < 0) {
+		return (errno == EAGAIN || errno == EINTR) ? 0 : -1;
+	}
+
+	for(i = 0; i < ret; i++) {
+		if(events[i].data.fd == netPath->eventSock) {
+			/* stale TX timestamps keep EPOLLERR raised - nobody is waiting for them now */
+			if((events[i].events & EPOLLERR) || netPath->txDelayed) {
+				while(recv(netPath->eventSock, discard, PACKET_SIZE, MSG_ERRQUEUE | MSG_DONTWAIT) > 0) {
+					DBG("netRecvBatch: Flushed errqueue\n");
+				}
+				netPath->txDelayed = FALSE;
+			}
+			eventReady = (events[i].events & EPOLLIN) != 0;
+		} else if(events[i].data.fd == netPath->generalSock) {
+			generalReady = (events[i].events & EPOLLIN) != 0;
+		} else if(events[i].data.fd == netPath->linkSock) {
+			netReceiveLinkEvents(netPath);
+		} else if(events[i].data.fd == netPath->epollNtpFd) {
+			ntpdControlReceive();
+		}
+	}
+
+	if(eventReady && netDrainSocket(netPath, netPath->eventSock, TRUE) < 0) {
+		return -1;
+	}
+
+	if(generalReady && netDrainSocket(netPath, netPath->generalSock, FALSE) < 0) {
+		return -1;
+	}
+
+	return netPath->rxRing.count;
+#else
+	return -1;
+#endif /* HAVE_SYS_EPOLL_H && HAVE_RECVMMSG */
+}
+
 /**
  * store received data from network to "buf" , get and store the
  * SO_TIMESTAMP value in "time" for an event message
@@ -1652,18 +2242,6 @@ netr(Octet * buf, TimeInternal * time, NetPath * netPath, int flags)
 		char	control[256];
 	}     cmsg_un;
 
-	struct cmsghdr *cmsg;
-
-#if defined(SO_TIMESTAMPNS) || defined(SO_TIMESTAMPING)
-	struct timespec * ts;
-#elif defined(SO_BINTIME)
-	struct bintime * bt;
-	struct timespec ts;
-#endif
-	
-#if defined(SO_TIMESTAMP)
-	struct timeval * tv;
-#endif
 	Boolean timestampValid = FALSE;
 	netPath->lastDestAddr = 0;
 #ifdef PTPD_PCAP
@@ -1740,95 +2318,7 @@ netr(Octet * buf, TimeInternal * time, NetPath * netPath, int flags)
 			return 0;
 		}
 
-		for (cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL;
-		     cmsg = CMSG_NXTHDR(&msg, cmsg)) {
-
-#ifdef IP_PKTINFO
-			if ((cmsg->cmsg_level == IPPROTO_IP) &&
-			    (cmsg->cmsg_type == IP_PKTINFO)) {
-				struct in_pktinfo *pi =
-				(struct in_pktinfo *) CMSG_DATA(cmsg);
-				netPath->lastDestAddr = pi->ipi_addr.s_addr;
-				DBG("IP_PKTINFO Dst: %s\n", inet_ntoa(pi->ipi_addr));
-			}
-#endif
-
-#ifdef IP_RECVDSTADDR
-			if ((cmsg->cmsg_level == IPPROTO_IP) &&
-			    (cmsg->cmsg_type == IP_RECVDSTADDR)) {
-				struct in_addr *pa = (struct in_addr *) CMSG_DATA(cmsg);
-				netPath->lastDestAddr = pa->s_addr;
-				DBG("IP_RECVDSTADDR Dst: %s\n", inet_ntoa(*pa));
-			}
-#endif
-			if (cmsg->cmsg_level == SOL_SOCKET) {
-#if defined(SO_TIMESTAMPING)
-				if(cmsg->cmsg_type == SO_TIMESTAMPING) {
-					ts = (struct timespec *)CMSG_DATA(cmsg);
-					if(netPath->hwTimestamping) {
-						if (cmsg->cmsg_len >= sizeof(*ts) * 3) {
-						    time->seconds = ts[2].tv_sec;
-						    time->nanoseconds = ts[2].tv_nsec;
-						} else {
-						    ERROR("SO_TIMESTAMPING: HW timestamp control message too short\n");
-						    return 0;
-						}
-					} else {
-						    time->seconds = ts[0].tv_sec;
-						    time->nanoseconds = ts[0].tv_nsec;
-					}
-					timestampValid = TRUE;
-					if((flags & MSG_ERRQUEUE) && netPath->txLoop) {
-						char tmpB[PACKET_SIZE];
-						memset(tmpB,0,PACKET_SIZE);
-						memcpy(tmpB, buf, PACKET_SIZE);
-						memset(buf,0,PACKET_SIZE);
-						memcpy(buf, tmpB + 42, PACKET_SIZE - 42);
-					}
-
-					DBG("rcvevent: SO_TIMESTAMPING %s time stamp: %us %dns\n", 
-					    (flags & MSG_ERRQUEUE) ? "TX" : "RX" ,
-					     time->seconds, time->nanoseconds);
-					break;
-				}
-#endif
-
-#if defined(SO_TIMESTAMPNS)
-				if(cmsg->cmsg_type == SCM_TIMESTAMPNS) {
-					ts = (struct timespec *)CMSG_DATA(cmsg);
-					time->seconds = ts->tv_sec;
-					time->nanoseconds = ts->tv_nsec;
-					timestampValid = TRUE;
-					DBGV("kernel NANO recv time stamp %us %dns\n",
-					     time->seconds, time->nanoseconds);
-					break;
-				}
-#elif defined(SO_BINTIME)
-				if(cmsg->cmsg_type == SCM_BINTIME) {
-					bt = (struct bintime *)CMSG_DATA(cmsg);
-					bintime2timespec(bt, &ts);
-					time->seconds = ts.tv_sec;
-					time->nanoseconds = ts.tv_nsec;
-					timestampValid = TRUE;
-					DBGV("kernel NANO recv time stamp %us %dns\n",
-					     time->seconds, time->nanoseconds);
-					break;
-				}
-#endif
-			
-#if defined(SO_TIMESTAMP)
-				if(cmsg->cmsg_type == SCM_TIMESTAMP) {
-					tv = (struct timeval *)CMSG_DATA(cmsg);
-					time->seconds = tv->tv_sec;
-					time->nanoseconds = tv->tv_usec * 1000;
-					timestampValid = TRUE;
-					DBGV("kernel MICRO recv time stamp %us %dns\n",
-					     time->seconds, time->nanoseconds);
-				}
-#endif
-			 }
-
-		}
+		timestampValid = netGetRecvTimestamp(&msg, buf, netPath, time, flags);
 
 		if (!timestampValid) {
 			/*
@@ -2036,6 +2526,9 @@ netSendPcapEther(Octet * buf,  UInteger16 length,
 // destinationAddress: destination:
 //   if filled, send to this unicast dest;
 //   if zero, sending to multicast.
+// tim: TX timestamp output:
+//   if NULL, do not wait for the TX timestamp - the caller
+//   collects it later using netRecvTxTimestamp().
 //
 ///
 /// TODO: merge these 2 functions into one
@@ -2113,9 +2606,9 @@ netSendEvent(Octet * buf, UInteger16 length, NetPath * netPath,
 #else
 
 #ifdef PTPD_PCAP
-			if((netPath->pcapEvent == NULL) && netPath->txTimestamping && !netPath->txLoop) {
+			if((netPath->pcapEvent == NULL) && netPath->txTimestamping && !netPath->txLoop && (tim != NULL)) {
 #else
-			if(netPath->txTimestamping && !netPath->txLoop) {
+			if(netPath->txTimestamping && !netPath->txLoop && (tim != NULL)) {
 #endif /* PTPD_PCAP */
 				if(!getTxTimestamp(netPath, tim)) {
 //					netPath->txTimestampFailure = TRUE;
@@ -2148,9 +2641,9 @@ netSendEvent(Octet * buf, UInteger16 length, NetPath * netPath,
 #ifdef SO_TIMESTAMPING
 
 #ifdef PTPD_PCAP
-			if((netPath->pcapEvent == NULL) && netPath->txTimestamping && !netPath->txLoop) {
+			if((netPath->pcapEvent == NULL) && netPath->txTimestamping && !netPath->txLoop && (tim != NULL)) {
 #else
-			if(netPath->txTimestamping && !netPath->txLoop) {
+			if(netPath->txTimestamping && !netPath->txLoop && (tim != NULL)) {
 #endif /* PTPD_PCAP */
 				if(!getTxTimestamp(netPath, tim)) {
 					if (tim) {
@@ -2405,6 +2898,143 @@ netSendPeerEvent(Octet * buf, UInteger16 length, NetPath * netPath, const RunTim
 
 
 
+/* allocate a batch of capacity message slots, PACKET_SIZE each */
+static Boolean
+netInitTxBatch(NetTxBatch *batch, int capacity)
+{
+	int i;
+
+	memset(batch, 0, sizeof(NetTxBatch));
+
+	batch->buf = calloc(capacity, PACKET_SIZE);
+	batch->addr = calloc(capacity, sizeof(struct sockaddr_in));
+	batch->iov = calloc(capacity, sizeof(struct iovec));
+#ifdef HAVE_SENDMMSG
+	batch->msg = calloc(capacity, sizeof(struct mmsghdr));
+	if(batch->msg == NULL) {
+		netFreeTxBatch(batch);
+		return FALSE;
+	}
+#endif /* HAVE_SENDMMSG */
+
+	if(batch->buf == NULL || batch->addr == NULL || batch->iov == NULL) {
+		netFreeTxBatch(batch);
+		return FALSE;
+	}
+
+	for(i = 0; i < capacity; i++) {
+		batch->iov[i].iov_base = batch->buf + i * PACKET_SIZE;
+		batch->addr[i].sin_family = AF_INET;
+#ifdef HAVE_SENDMMSG
+		batch->msg[i].msg_hdr.msg_name = &batch->addr[i];
+		batch->msg[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+		batch->msg[i].msg_hdr.msg_iov = &batch->iov[i];
+		batch->msg[i].msg_hdr.msg_iovlen = 1;
+#endif /* HAVE_SENDMMSG */
+	}
+
+	batch->capacity = capacity;
+
+	return TRUE;
+}
+
+static void
+netFreeTxBatch(NetTxBatch *batch)
+{
+	SAFE_FREE(batch->buf);
+	SAFE_FREE(batch->addr);
+	SAFE_FREE(batch->iov);
+#ifdef HAVE_SENDMMSG
+	SAFE_FREE(batch->msg);
+#endif /* HAVE_SENDMMSG */
+	batch->capacity = 0;
+	batch->count = 0;
+}
+
+/*
+ * Queue a copy of a packed message for a unicast destination and return
+ * the slot so the caller can patch the per-destination fields.
+ * Returns NULL if batching is disabled or the batch is full.
+ */
+Octet*
+netBatchAdd(NetTxBatch *batch, const Octet *buf, UInteger16 length, Integer32 destinationAddress)
+{
+	Octet *slot;
+
+	if((batch->count >= batch->capacity) || (length > PACKET_SIZE) || !destinationAddress) {
+		return NULL;
+	}
+
+	slot = batch->iov[batch->count].iov_base;
+	memcpy(slot, buf, length);
+	/* always unicast - see netSendEvent() */
+	*(char *)(slot + 6) |= PTP_UNICAST;
+
+	batch->iov[batch->count].iov_len = length;
+	batch->addr[batch->count].sin_addr.s_addr = destinationAddress;
+	batch->count++;
+
+	return slot;
+}
+
+/* send all queued messages, return the number of messages sent */
+static int
+netBatchFlush(NetPath *netPath, NetTxBatch *batch, Integer32 sock, UInteger16 port)
+{
+	int i;
+	int sent = 0;
+	ssize_t ret;
+
+	for(i = 0; i < batch->count; i++) {
+		batch->addr[i].sin_port = htons(port);
+	}
+
+#ifdef HAVE_SENDMMSG
+	while(sent < batch->count) {
+		ret = sendmmsg(sock, batch->msg + sent, batch->count - sent, 0);
+		if(ret <= 0) {
+			if(ret < 0 && errno == EINTR) {
+				continue;
+			}
+			DBG("Error sending unicast message batch: %d of %d sent\n", sent, batch->count);
+			break;
+		}
+		sent += ret;
+	}
+#else
+	for(i = 0; i < batch->count; i++) {
+		ret = sendto(sock, batch->iov[i].iov_base, batch->iov[i].iov_len, 0,
+			     (struct sockaddr *)&batch->addr[i],
+			     sizeof(struct sockaddr_in));
+		if (ret <= 0) {
+			DBG("Error sending unicast message batch: %d of %d sent\n", sent, batch->count);
+			break;
+		}
+		sent++;
+	}
+#endif /* HAVE_SENDMMSG */
+
+	netPath->sentPackets += sent;
+	netPath->sentPacketsTotal += sent;
+
+	batch->count = 0;
+
+	return sent;
+}
+
+int
+netBatchFlushEvent(NetPath *netPath)
+{
+	return netBatchFlush(netPath, &netPath->eventBatch, netPath->eventSock, PTP_EVENT_PORT);
+}
+
+int
+netBatchFlushGeneral(NetPath *netPath)
+{
+	return netBatchFlush(netPath, &netPath->generalBatch, netPath->generalSock, PTP_GENERAL_PORT);
+}
+
+
 /*
  * refresh IGMP on a timeout
  */
@@ -2543,6 +3173,7 @@ static void getBondInfo(char *ifaceName, BondInfo *info)
     info->bonded = TRUE;
     info->activeBackup = (ifb.bond_mode == BOND_MODE_ACTIVEBACKUP);
     info->slaveCount = getBondSlaves(ifaceName, info);
+    info->ifIndex = max(getInterfaceIndex(ifaceName), 0);
 
     if(info->activeSlave.id >= 0) {
 	info->activeCount = 1;
@@ -2550,14 +3181,15 @@ static void getBondInfo(char *ifaceName, BondInfo *info)
 	info->activeCount = 0;
     }
 
+    /* updates are event-driven: a change must not be seen again on the next update */
+    info->activeChanged = FALSE;
+    info->countChanged = FALSE;
+
     if(info->updated) {
 	if (strncmp(lastInfo.activeSlave.name, info->activeSlave.name, IFACE_NAME_LENGTH)) {
 	    info->activeChanged = TRUE;
 	} else if (lastInfo.slaveCount != info->slaveCount) {
 	    info->countChanged = TRUE;
-	} else {
-	    info->activeChanged = FALSE;
-	    info->countChanged = FALSE;
 	}
     }
 
@@ -2611,6 +3243,169 @@ static void getVlanInfo(char* ifaceName, VlanInfo *info)
 
 }
 
+#ifdef HAVE_LINUX_RTNETLINK_H
+
+/*
+ * Subscribe to rtnetlink link notifications. Bond failover, slaves joining
+ * or leaving the bond and links going up or down are then seen as soon as
+ * the kernel reports them, instead of by polling the bonding and VLAN ioctls.
+ */
+static void
+netInitLinkMonitor(NetPath *netPath)
+{
+
+    struct sockaddr_nl addr;
+
+    netPath->linkChanged = FALSE;
+
+    if((netPath->linkSock = socket(AF_NETLINK, SOCK_RAW, NETLINK_ROUTE)) < 0) {
+	PERROR("Could not open netlink socket - polling interface state");
+	return;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = RTMGRP_LINK;
+
+    if(bind(netPath->linkSock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+	PERROR("Could not subscribe to link notifications - polling interface state");
+	close(netPath->linkSock);
+	netPath->linkSock = -1;
+	return;
+    }
+
+    DBG("Monitoring interface changes via netlink\n");
+
+}
+
+static void
+netShutdownLinkMonitor(NetPath *netPath)
+{
+
+    if(netPath->linkSock >= 0) {
+	close(netPath->linkSock);
+    }
+
+    netPath->linkSock = -1;
+
+}
+
+/* is the link notification about our interface, its bond or a bond member */
+static Boolean
+isOurLink(const NetPath *netPath, struct nlmsghdr *nlh)
+{
+
+    const InterfaceInfo *info = &netPath->interfaceInfo;
+    const BondInfo *bond = &info->bondInfo;
+    struct ifinfomsg *ifi = NLMSG_DATA(nlh);
+    struct rtattr *rta;
+    int len = IFLA_PAYLOAD(nlh);
+    const char *name = NULL;
+    int master = 0;
+
+    if(ifi->ifi_index == info->ifIndex) {
+	return TRUE;
+    }
+
+    if(!bond->bonded || bond->ifIndex <= 0) {
+	return FALSE;
+    }
+
+    if(ifi->ifi_index == bond->ifIndex) {
+	return TRUE;
+    }
+
+    for(rta = IFLA_RTA(ifi); RTA_OK(rta, len); rta = RTA_NEXT(rta, len)) {
+	if(rta->rta_type == IFLA_IFNAME) {
+	    name = RTA_DATA(rta);
+	} else if(rta->rta_type == IFLA_MASTER) {
+	    master = *(int*)RTA_DATA(rta);
+	}
+    }
+
+    if(master == bond->ifIndex) {
+	return TRUE;
+    }
+
+    /* a member released from the bond no longer has IFLA_MASTER */
+    for(int i = 0; name != NULL && i < bond->slaveCount && i < BOND_SLAVES_MAX; i++) {
+	if(!strncmp(name, bond->slaves[i].name, IFACE_NAME_LENGTH)) {
+	    return TRUE;
+	}
+    }
+
+    return FALSE;
+
+}
+
+/* drain link notifications, flag the interface for an update if any were ours */
+static void
+netReceiveLinkEvents(NetPath *netPath)
+{
+
+    char buf[8192] __attribute__((aligned(NLMSG_ALIGNTO)));
+    struct nlmsghdr *nlh;
+    int len;
+
+    for(;;) {
+
+	len = recv(netPath->linkSock, buf, sizeof(buf), MSG_DONTWAIT);
+
+	if(len < 0) {
+	    if(errno == EINTR) {
+		continue;
+	    }
+	    /* the socket buffer overflowed and notifications were lost: check anyway */
+	    if(errno == ENOBUFS) {
+		DBG("netReceiveLinkEvents: netlink overrun\n");
+		netPath->linkChanged = TRUE;
+		continue;
+	    }
+	    if(errno != EAGAIN && errno != EWOULDBLOCK) {
+		DBG("netReceiveLinkEvents: recv() failed: %s\n", strerror(errno));
+	    }
+	    return;
+	}
+
+	if(len == 0) {
+	    return;
+	}
+
+	for(nlh = (struct nlmsghdr*)buf; NLMSG_OK(nlh, len); nlh = NLMSG_NEXT(nlh, len)) {
+	    if((nlh->nlmsg_type == RTM_NEWLINK || nlh->nlmsg_type == RTM_DELLINK) &&
+		isOurLink(netPath, nlh)) {
+		    DBGV("netReceiveLinkEvents: link %d changed\n",
+			((struct ifinfomsg*)NLMSG_DATA(nlh))->ifi_index);
+		    netPath->linkChanged = TRUE;
+	    }
+	}
+
+    }
+
+}
+
+#else
+
+static void
+netInitLinkMonitor(NetPath *netPath)
+{
+    netPath->linkSock = -1;
+    netPath->linkChanged = FALSE;
+}
+
+static void
+netShutdownLinkMonitor(NetPath *netPath)
+{
+    netPath->linkSock = -1;
+}
+
+static void
+netReceiveLinkEvents(NetPath *netPath)
+{
+}
+
+#endif /* HAVE_LINUX_RTNETLINK_H */
+
 void updateInterfaceInfo(NetPath * netPath, RunTimeOpts * rtOpts, PtpClock * ptpClock)
 {
 
@@ -65,13 +65,31 @@
 
 #define NTP_PORT 123
 
-char *ntpdc_pktdata;
+/*
+ * These are used to help the magic with old and new versions of ntpd.
+ */
+#define IMPL_XNTPD      3
+int impl_ver = IMPL_XNTPD;
+#define REQ_LEN_NOMAC   (offsetof(struct req_pkt, keyid))
+static int req_pkt_size = REQ_LEN_NOMAC;
+#define	ERR_INCOMPLETE		16
+#define	ERR_TIMEOUT		17
+
+/* the controller served by the main loop - there is only ever one */
+static NTPoptions *activeOptions = NULL;
+static NTPcontrol *activeControl = NULL;
+
+static int ntpdStartRequest(NTPoptions* options, NTPcontrol* control, int reqcode,
+			    int auth, uint32_t flags, int esize);
+static void ntpdReceive(NTPoptions* options, NTPcontrol* control);
+static void ntpdTick(NTPoptions* options, NTPcontrol* control);
+static Boolean requestsInFlight(NTPcontrol* control);
 
 Boolean
 ntpInit(NTPoptions* options, NTPcontrol* control)
 {
 
-	int res = TRUE;
+	int res;
 	TimingService service = control->timingService;
 
 	control->sockFD = -1;
@@ -81,6 +99,7 @@ ntpInit(NTPoptions* options, NTPcontrol* control)
 	memset(control, 0, sizeof(*control));
 	/* preserve TimingService... temporary */
 	control->timingService = service;
+	control->sockFD = -1;
 
 	if(!hostLookup(options->hostAddress, &control->serverAddress)) {
                 control->serverAddress = 0;
@@ -92,40 +111,74 @@ ntpInit(NTPoptions* options, NTPcontrol* control)
                 return FALSE;
         }
 
+	activeOptions = options;
+	activeControl = control;
+
 	/* This will attempt to read the ntpd control flags for the first time */
 	res = ntpdInControl(options, control);
-	
-       if (res != INFO_YES && res != INFO_NO) {
+
+	if (res != NTPCONTROL_PENDING) {
 		return FALSE;
 	}
 
-	DBGV("NTPd original flags: %d\n", control->originalFlags);
 	return TRUE;
 }
 
+/* no main loop to deliver responses: wait for them, bounded by the request retries */
+static void
+ntpdWait(NTPoptions* options, NTPcontrol* control)
+{
+
+	fd_set fds;
+	struct timeval tv;
+	int n;
+	int retries = NTP_EINTR_RETRIES;
+
+	while(control->sockFD >= 0 && requestsInFlight(control)) {
+
+		tv.tv_sec = 0;
+		tv.tv_usec = NTP_CONTROL_TICK * 1000000;
+		FD_ZERO(&fds);
+		FD_SET(control->sockFD, &fds);
+		n = select(control->sockFD + 1, &fds, NULL, NULL, &tv);
+
+		if(n > 0) {
+			ntpdReceive(options, control);
+		} else if(n == 0) {
+			ntpdTick(options, control);
+		} else if(errno != EINTR || !retries--) {
+			DBG("ntpdWait(): select failed: %s\n", strerror(errno));
+			return;
+		}
+	}
+
+}
+
 Boolean
 ntpShutdown(NTPoptions* options, NTPcontrol* control)
 {
 
+	/* the TimingService is going away, nobody to hand the results to */
+	control->onResponse = NULL;
+
 	/* Attempt reverting ntpd flags to the original value */
-	if(control->flagsCaptured) {
-		/* we only control the kernel and ntp flags */
-	/* just to avoid -Wunused* */
-#ifdef RUNTIME_DEBUG
-		int resC = ntpdClearFlags(options, control, ~(control->originalFlags) & (INFO_FLAG_KERNEL | INFO_FLAG_NTP));
-		int resS = ntpdSetFlags(options, control, control->originalFlags & (INFO_FLAG_KERNEL | INFO_FLAG_NTP));
-		DBGV("Attempting to revert NTPd flags to %d - result: clear %d set %d\n", control->originalFlags,
-			    resC, resS);
-#else
+	if(control->flagsCaptured && control->sockFD >= 0) {
+		/* we only control the kernel and ntp flags - both requests go out at once */
 		ntpdClearFlags(options, control, ~(control->originalFlags) & (INFO_FLAG_KERNEL | INFO_FLAG_NTP));
 		ntpdSetFlags(options, control, control->originalFlags & (INFO_FLAG_KERNEL | INFO_FLAG_NTP));
-#endif /* RUNTIME_DEBUG */
+		DBGV("Attempting to revert NTPd flags to %d\n", control->originalFlags);
+		ntpdWait(options, control);
 	}
 
         if (control->sockFD > 0)
                 close(control->sockFD);
         control->sockFD = -1;
 
+	if(activeControl == control) {
+		activeControl = NULL;
+		activeOptions = NULL;
+	}
+
 	return TRUE;
 }
 
@@ -153,34 +206,6 @@ ntpSend(NTPcontrol* control, Octet * buf, UInteger16 length)
         return ret;
 }
 
-
-/*
- * Default values we use
- */
-#define	DEFHOST		"localhost"	/* default host name */
-#define	DEFTIMEOUT	(5)		/* 5 second time out */
-#define	DEFSTIMEOUT	(2)		/* 2 second time out after first */
-#define	DEFDELAY	0x51EB852	/* 20 milliseconds, l_fp fraction */
-#define	LENHOSTNAME	256		/* host name is 256 characters long */
-#define	MAXCMDS		100		/* maximum commands on cmd line */
-#define	MAXHOSTS	200		/* maximum hosts on cmd line */
-#define	MAXLINE		512		/* maximum line length */
-#define	MAXTOKENS	(1+1+MAXARGS+MOREARGS+2)	/* maximum number of usable tokens */
-#define	SCREENWIDTH  	78		/* nominal screen width in columns */
-
-#define	INITDATASIZE	(sizeof(struct resp_pkt) * 16)
-#define	INCDATASIZE	(sizeof(struct resp_pkt) * 8)
-
-/*
- * These are used to help the magic with old and new versions of ntpd.
- */
-#define IMPL_XNTPD      3
-int impl_ver = IMPL_XNTPD;
-#define REQ_LEN_NOMAC   (offsetof(struct req_pkt, keyid))
-static int req_pkt_size = REQ_LEN_NOMAC;
-#define	ERR_INCOMPLETE		16
-#define	ERR_TIMEOUT		17
-
 static void
 get_systime(
         l_fp *now               /* system time */
@@ -250,9 +275,9 @@ NTPDCrequest(
 	l_fp	ts;
 	l_fp *	ptstamp;
 	int	maclen;
-	static char *key;
+	char key[21];
 
-	key=calloc(21,sizeof(char));
+	memset(key, 0, sizeof(key));
 	strncpy(key,options->key,20);
 
 	memset(&qpkt, 0, sizeof(qpkt));
@@ -285,11 +310,10 @@ NTPDCrequest(
 	HTONL_FP(&ts, ptstamp);
 
 	maclen = MD5authencrypt(key, (void *)&qpkt, reqsize,options->keyId);
-	free(key);
 	if (!maclen || (maclen != (16 + sizeof(keyid_t))))
 	 { 
 		ERROR("Error while computing NTP MD5 hash\n");
-		return 1;
+		return -1;
 	}
 
 	return ntpSend(control, (Octet *)&qpkt, reqsize + maclen);
@@ -297,24 +321,6 @@ NTPDCrequest(
 }
 
 
-/*
- * checkitems - utility to print a message if no items were returned
- */
-/*
-static int
-checkitems(
-	int items
-
-	)
-{
-	if (items == 0) {
-
-		return 0;
-	}
-	return 1;
-}
-*/
-
 /*
  * checkitemsize - utility to print a message if the item size is wrong
  */
@@ -350,256 +356,325 @@ check1item(
 	return 1;
 }
 
-static int
-NTPDCresponse(
-	NTPoptions* options,
-	NTPcontrol* control,
-	int reqcode,
-	int *ritems,
-	int *rsize,
-	char **rdata,
-	int esize
-	)
+static Boolean
+requestsInFlight(NTPcontrol* control)
 {
-	struct resp_pkt rpkt;
-	struct timeval tvo;
-	int items;
 	int i;
-	int size;
-	int datasize;
-	char *datap;
-	char *tmp_data;
-	char haveseq[MAXSEQ+1];
-	int firstpkt;
-	int lastseq;
-	int numrecv;
-	int seq;
-	fd_set fds;
-	int n;
-	int pad;
-	int retries = NTP_EINTR_RETRIES;
 
-        int ntpdc_pktdatasize;
+	for(i = 0; i < NTPREQ_MAX; i++) {
+		if(control->requests[i].inFlight) {
+			return TRUE;
+		}
+	}
 
-	int implcode=(u_char)3;
+	return FALSE;
+}
 
-	static  struct timeval tvout = { DEFTIMEOUT, 0 };   /* time out for reads */
-	static  struct timeval tvsout = { DEFSTIMEOUT, 0 }; /* secondary time out */
+static NTPrequest*
+getRequest(NTPcontrol* control, int reqcode)
+{
+	switch(reqcode) {
+	case REQ_SYS_INFO:
+		return &control->requests[NTPREQ_SYS_INFO];
+	case REQ_SET_SYS_FLAG:
+		return &control->requests[NTPREQ_SET_FLAGS];
+	case REQ_CLR_SYS_FLAG:
+		return &control->requests[NTPREQ_CLR_FLAGS];
+	default:
+		return NULL;
+	}
+}
 
-//	static char *currenthost = "localhost";
+/* (re)transmit a request, starting the response over */
+static Boolean
+sendRequest(NTPoptions* options, NTPcontrol* control, NTPrequest* request)
+{
 
-        ntpdc_pktdatasize = INITDATASIZE;
-        ntpdc_pktdata = realloc(ntpdc_pktdata,INITDATASIZE);
+	struct conf_sys_flags sys;
 
-	/*
-	 * This is pretty tricky.  We may get between 1 and many packets
-	 * back in response to the request.  We peel the data out of
-	 * each packet and collect it in one long block.  When the last
-	 * packet in the sequence is received we'll know how many we
-	 * should have had.  Note we use one long time out, should reconsider.
-	 */
-	*ritems = 0;
-	*rsize = 0;
-	firstpkt = 1;
-	numrecv = 0;
+	memset(request->haveseq, 0, sizeof(request->haveseq));
+	request->lastseq = 999;	/* too big to be a sequence number */
+	request->numrecv = 0;
+	request->items = 0;
+	request->itemsize = 0;
+	request->datasize = 0;
+	request->ticksLeft = NTP_REQUEST_TIMEOUT;
 
-	lastseq = 999;	/* too big to be a sequence number */
-	memset(haveseq, 0, sizeof(haveseq));
+	if(request->reqcode == REQ_SYS_INFO) {
+		return NTPDCrequest(options, control, request->reqcode, request->auth,
+				    0, 0, NULL) > 0;
+	}
 
+	sys.flags = htonl(request->flags);
+	return NTPDCrequest(options, control, request->reqcode, request->auth,
+			    1, sizeof(struct conf_sys_flags), (char *)&sys) > 0;
 
-    again:
-	if (firstpkt)
-		tvo = tvout;
-	else
-		tvo = tvsout;
-	do {
-	    FD_ZERO(&fds);
-	    FD_SET(control->sockFD, &fds);
-	    n = select(control->sockFD+1, &fds, (fd_set *)0, (fd_set *)0, &tvo);
-	    if(n == -1) {
-		if(errno == EINTR) {
-		DBG("NTPDCresponse(): EINTR caught\n");
-		    retries--;
-		} else {
-		    retries = 0;
-		}
-	    }
-	} while ((n == -1) && retries);
+}
 
-	if (n == -1) {
-	    DBG("NTPDCresponse(): select failed - not EINTR: %s\n", strerror(errno));
-		return -1;
+/* read the flags from a system info response, captured the first time round */
+static int
+sysInfoResult(NTPcontrol* control, NTPrequest* request)
+{
+
+	struct info_sys *is = (struct info_sys*)request->data;
+
+	if (!check1item(request->items)) {
+	    return INFO_ERR_EMPTY;
+	}
+
+	if (!checkitemsize(request->itemsize, sizeof(struct info_sys)) &&
+	    !checkitemsize(request->itemsize, v4sizeof(struct info_sys))) {
+	    return INFO_ERR_EMPTY;
+	}
+
+	if (is->flags & INFO_FLAG_NTP) DBGV("NTP flag seen: ntp\n");
+	if (is->flags & INFO_FLAG_KERNEL) DBGV("NTP flag seen: kernel\n");
+
+	if(!control->flagsCaptured) {
+		control->originalFlags = is->flags;
+		 /* we only control the kernel and ntp flags */
+		control->originalFlags &= (INFO_FLAG_KERNEL | INFO_FLAG_NTP);
+		control->flagsCaptured = TRUE;
+		DBGV("NTPd original flags: %d\n", control->originalFlags);
+		return INFO_YES;
+	}
+
+	if ((is->flags & INFO_FLAG_NTP) || (is->flags & INFO_FLAG_KERNEL))
+	{
+		return INFO_YES;
 	}
-	if (n == 0) {
-		DBG("NTP response select timeout");
-		if (firstpkt) {
-			return ERR_TIMEOUT;
-		} else {
-			return ERR_INCOMPLETE;
+
+	return INFO_NO;
+
+}
+
+static void
+completeRequest(NTPcontrol* control, NTPrequest* request, int res)
+{
+
+	request->inFlight = FALSE;
+
+	if(request->reqcode == REQ_SYS_INFO) {
+
+		if(res == INFO_OKAY) {
+			res = sysInfoResult(control, request);
+		}
+
+		switch (res) {
+
+		case INFO_YES:
+		case INFO_NO:
+			break;
+
+		case -1:
+			DBG("Could not connect to NTP daemon\n");
+			break;
+
+		case ERR_TIMEOUT:
+
+			DBG("Timeout while connecting to NTP daemon\n");
+			break;
+
+		case INFO_ERR_AUTH:
+
+			DBG("NTP permission denied: check NTP key id, key and if key is trusted and is a request key\n");
+			break;
+
+		default:
+		ERROR("NTP protocol error\n");
+
+		}
+
+	} else {
+
+		switch (res) {
+
+		case INFO_OKAY:
+			break;
+
+		case -1:
+			if(!control->requestFailed) ERROR("Cannot connect to NTP daemon\n");
+			break;
+
+		case INFO_ERR_AUTH:
+
+			if(!control->requestFailed) ERROR("NTP permission denied: check key id, password and NTP configuration\n");
+			break;
+
+		case ERR_TIMEOUT:
+
+			if(!control->requestFailed) ERROR("Timeout while connecting to NTP daemon\n");
+			break;
+
+		default:
+		ERROR("NTP protocol error\n");
+
 		}
+
 	}
 
-	n = recv(control->sockFD, (char *)&rpkt, sizeof(rpkt), 0);
+	DBGV("NTP request %d complete, result %d\n", request->reqcode, res);
 
-	if (n == -1) {
-	    DBG("NTP response recv failed\n");
-	    return -1;
+	if(control->onResponse != NULL) {
+		control->onResponse(control, request->reqcode, res);
 	}
 
+}
+
+/* one response packet: validate, match to the request in flight and collect its items */
+static void
+processResponse(NTPoptions* options, NTPcontrol* control, struct resp_pkt *rpkt, int n)
+{
+
+	NTPrequest *request;
+	int items;
+	int i;
+	int size;
+	int datasize;
+	char *datap;
+	char *tmp_data;
+	int seq;
+	int pad;
 
 	/*
 	 * Check for format errors.  Bug proofing.
 	 */
 	if (n < RESP_HEADER_SIZE) {
-		goto again;
+		return;
 	}
 
-
-
-	if (INFO_VERSION(rpkt.rm_vn_mode) > NTP_VERSION ||
-	    INFO_VERSION(rpkt.rm_vn_mode) < NTP_OLDVERSION) {
-/*		if (debug)
-		    printf("Packet received with version %d\n",
-			   INFO_VERSION(rpkt.rm_vn_mode));
-*/
-
-		goto again;
+	if (INFO_VERSION(rpkt->rm_vn_mode) > NTP_VERSION ||
+	    INFO_VERSION(rpkt->rm_vn_mode) < NTP_OLDVERSION) {
+		return;
 	}
 
-	if (INFO_MODE(rpkt.rm_vn_mode) != MODE_PRIVATE) {
-/*		if (debug)
-		    printf("Packet received with mode %d\n",
-			   INFO_MODE(rpkt.rm_vn_mode));
-*/
-
-		goto again;
-
+	if (INFO_MODE(rpkt->rm_vn_mode) != MODE_PRIVATE) {
+		return;
 	}
-	if (INFO_IS_AUTH(rpkt.auth_seq)) {
-/*
-		if (debug)
-		    printf("Encrypted packet received\n");
-*/
-		goto again;
+
+	if (INFO_IS_AUTH(rpkt->auth_seq)) {
+		return;
 	}
-	if (!ISRESPONSE(rpkt.rm_vn_mode)) {
-/*
-		if (debug)
-		    printf("Received request packet, wanted response\n");
-*/
-		goto again;
+
+	if (!ISRESPONSE(rpkt->rm_vn_mode)) {
+		return;
 	}
-	if (INFO_MBZ(rpkt.mbz_itemsize) != 0) {
-/*
-		if (debug)
-		    printf("Received packet with nonzero MBZ field!\n");
-*/
-		goto again;
+
+	if (INFO_MBZ(rpkt->mbz_itemsize) != 0) {
+		return;
 	}
 
 	/*
-	 * Check implementation/request.  Could be old data getting to us.
+	 * Check implementation/request.  Could be old data getting to us,
+	 * or the response to a request that has already timed out.
 	 */
+	request = getRequest(control, rpkt->request);
 
-	if (rpkt.implementation != implcode || rpkt.request != reqcode) {
-/*
-		if (debug)
-		    printf(
-			    "Received implementation/request of %d/%d, wanted %d/%d",
-			    rpkt.implementation, rpkt.request,
-			    implcode, reqcode);
-*/
-		goto again;
+	if (rpkt->implementation != IMPL_XNTPD || request == NULL || !request->inFlight) {
+		DBGV("Discarding NTP response to request %d\n", rpkt->request);
+		return;
 	}
 
 	/*
-	 * Check the error code.  If non-zero, return it.
+	 * Check the error code.  If non-zero, the request is done.
 	 */
-	if (INFO_ERR(rpkt.err_nitems) != INFO_OKAY) {
-/*
-		if (debug && ISMORE(rpkt.rm_vn_mode)) {
-			printf("Error code %d received on not-final packet\n",
-			       INFO_ERR(rpkt.err_nitems));
+	if (INFO_ERR(rpkt->err_nitems) != INFO_OKAY) {
+
+		/*
+		 * Try to be compatible with older implementations of ntpd.
+		 */
+		if (INFO_ERR(rpkt->err_nitems) == INFO_ERR_FMT && req_pkt_size != 48) {
+#ifdef RUNTIME_DEBUG
+			int oldsize  = req_pkt_size;
+#endif /* RUNTIME_DEBUG */
+
+			switch(req_pkt_size) {
+			case REQ_LEN_NOMAC:
+				req_pkt_size = 160;
+				break;
+			case 160:
+				req_pkt_size = 48;
+				break;
+			}
+			if (impl_ver == IMPL_XNTPD) {
+				DBGV(
+				    "NTPDC ***Warning changing to older implementation\n");
+				completeRequest(control, request, INFO_ERR_IMPL);
+				return;
+			}
+
+			DBGV(
+			    "NTPDC ***Warning changing the request packet size from %d to %d\n",
+			    oldsize, req_pkt_size);
+			if(!sendRequest(options, control, request)) {
+				completeRequest(control, request, -1);
+			}
+			return;
 		}
-*/
-		return (int)INFO_ERR(rpkt.err_nitems);
+
+		completeRequest(control, request, (int)INFO_ERR(rpkt->err_nitems));
+		return;
 	}
 
 	/*
 	 * Collect items and size.  Make sure they make sense.
 	 */
-	items = INFO_NITEMS(rpkt.err_nitems);
+	items = INFO_NITEMS(rpkt->err_nitems);
 
-	size = INFO_ITEMSIZE(rpkt.mbz_itemsize);
-	if (esize > size)
-		pad = esize - size;
+	size = INFO_ITEMSIZE(rpkt->mbz_itemsize);
+	if (request->esize > size)
+		pad = request->esize - size;
 	else
 		pad = 0;
 	datasize = items * size;
 
 	if ((size_t)datasize > (n-RESP_HEADER_SIZE)) {
-/*		if (debug)
-		    printf(
-			    "Received items %d, size %d (total %d), data in packet is %lu\n",
-			    items, size, datasize, (u_long)(n-RESP_HEADER_SIZE));
-*/
-		goto again;
-
+		return;
 	}
 
 	/*
 	 * If this isn't our first packet, make sure the size matches
 	 * the other ones.
 	 */
-	if (!firstpkt && esize != *rsize) {
-/*		if (debug)
-		    printf("Received itemsize %d, previous %d\n",
-			   size, *rsize);
-*/
-		goto again;
+	if (request->numrecv > 0 && size + pad != request->itemsize) {
+		return;
 	}
+
 	/*
-	 * If we've received this before, +toss it
+	 * If we've received this before, toss it
 	 */
-	seq = INFO_SEQ(rpkt.auth_seq);
-	if (haveseq[seq]) {
-/*		if (debug)
-		    printf("Received duplicate sequence number %d\n", seq);
-*/
-		goto again;
+	seq = INFO_SEQ(rpkt->auth_seq);
+	if (request->haveseq[seq]) {
+		return;
 	}
-	haveseq[seq] = 1;
 
 	/*
 	 * If this is the last in the sequence, record that.
 	 */
-	if (!ISMORE(rpkt.rm_vn_mode)) {
-		if (lastseq != 999) {
+	if (!ISMORE(rpkt->rm_vn_mode)) {
+		if (request->lastseq != 999) {
 			DBGV("NTPDC Received second end sequence packet\n");
-			goto again;
+			return;
 		}
-		lastseq = seq;
+		request->lastseq = seq;
 	}
 
-	*rdata = datap = ntpdc_pktdata;
+	request->haveseq[seq] = 1;
 
 	/*
-	 * So far, so good.  Copy this data into the output array.
+	 * We only ever ask for a single item - a response this size is not ours.
 	 */
-	if ((datap + datasize + (pad * items)) > (ntpdc_pktdata + ntpdc_pktdatasize)) {
-		int offset = datap - ntpdc_pktdata;
-
-		ntpdc_pktdatasize += INCDATASIZE;
-		ntpdc_pktdata = realloc(ntpdc_pktdata, (size_t)ntpdc_pktdatasize);
-		*rdata = ntpdc_pktdata; /* might have been realloced ! */
-		datap = ntpdc_pktdata + offset;
+	if (request->datasize + items * (size + pad) > (int)sizeof(request->data)) {
+		completeRequest(control, request, INFO_ERR_FMT);
+		return;
 	}
+
 	/*
 	 * We now move the pointer along according to size and number of
 	 * items.  This is so we can play nice with older implementations
 	 */
-
-	tmp_data = rpkt.data;
+	datap = request->data + request->datasize;
+	tmp_data = rpkt->data;
 	for (i = 0; i < items; i++) {
 		memcpy(datap, tmp_data, (unsigned)size);
 		tmp_data += size;
@@ -607,161 +682,139 @@ NTPDCresponse(
 		datap += size + pad;
 	}
 
-	if (firstpkt) {
-		firstpkt = 0;
-		*rsize = size + pad;
-	}
-	*ritems += items;
+	request->datasize = datap - request->data;
+	request->itemsize = size + pad;
+	request->items += items;
 
 	/*
 	 * Finally, check the count of received packets.  If we've got them
-	 * all, return
+	 * all, the request is done.
 	 */
-	++numrecv;
+	++request->numrecv;
 
-	if (numrecv <= lastseq)
-		goto again;
+	if (request->numrecv > request->lastseq) {
+		completeRequest(control, request, INFO_OKAY);
+	}
 
-	return INFO_OKAY;
 }
 
-static int
-NTPDCquery(
-	NTPoptions* options,
-	NTPcontrol* control,
-	int reqcode,
-	int auth,
-	int qitems,
-	int qsize,
-	char *qdata,
-	int *ritems,
-	int *rsize,
-	char **rdata,
- 	int quiet_mask,
-	int esize
-	)
+static void
+ntpdReceive(NTPoptions* options, NTPcontrol* control)
 {
-	int res;
+
+	struct resp_pkt rpkt;
+	int n;
 	int retries = NTP_EINTR_RETRIES;
-	char junk[512];
-	fd_set fds;
-	struct timeval tvzero;
-//	int implcode=(u_char)3;
 
-	/*
-	 * Poll the socket and clear out any pending data
-	 */
-again:
-	do {
-		tvzero.tv_sec = tvzero.tv_usec = 0;
-		FD_ZERO(&fds);
-		FD_SET(control->sockFD, &fds);
-		res = select(control->sockFD+1, &fds, (fd_set *)0, (fd_set *)0, &tvzero);
-
-		if (res == -1) {
-			if((errno == EINTR) && retries ) {
-			    DBG("NTPDCquery(): select EINTR caught");
-			    retries--;
-			    res = 1;
-			    continue;
+	while(control->sockFD >= 0) {
+
+		n = recv(control->sockFD, (char *)&rpkt, sizeof(rpkt), MSG_DONTWAIT);
+
+		if (n < 0) {
+			if (errno == EINTR && retries--) {
+				continue;
+			}
+			if (errno != EAGAIN && errno != EWOULDBLOCK) {
+				DBG("NTP response recv failed: %s\n", strerror(errno));
 			}
-			DBG("NTPDCquery(): select() error - not EINTR: %s\n", strerror(errno));
-			return -1;
-		} else if (res > 0) {
-		    (void) recv(control->sockFD, junk, sizeof junk, 0);
-		    }
-	} while (res > 0);
+			return;
+		}
 
-	/*
-	 * send a request
-	 */
-	res = NTPDCrequest(options, control, reqcode, auth, qitems, qsize, qdata);
-	if (res <= 0) {
-		return res;
+		processResponse(options, control, &rpkt, n);
 	}
-	/*
-	 * Get the response.  If we got a standard error, print a message
-	 */
-	res = NTPDCresponse(options, control, reqcode, ritems, rsize, rdata, esize);
 
-	/*
-	 * Try to be compatible with older implementations of ntpd.
-	 */
-	if (res == INFO_ERR_FMT && req_pkt_size != 48) {
-#ifdef RUNTIME_DEBUG
-		int oldsize  = req_pkt_size;
-#endif /* RUNTIME_DEBUG */
+}
 
-		switch(req_pkt_size) {
-		case REQ_LEN_NOMAC:
-			req_pkt_size = 160;
-			break;
-		case 160:
-			req_pkt_size = 48;
-			break;
+/* one NTP_CONTROL_TICK has passed: retransmit or give up on requests still waiting */
+static void
+ntpdTick(NTPoptions* options, NTPcontrol* control)
+{
+
+	NTPrequest *request;
+	int i;
+
+	for(i = 0; i < NTPREQ_MAX; i++) {
+
+		request = &control->requests[i];
+
+		if(!request->inFlight || --request->ticksLeft > 0) {
+			continue;
 		}
-		if (impl_ver == IMPL_XNTPD) {
-			DBGV(
-			    "NTPDC ***Warning changing to older implementation\n");
-			return INFO_ERR_IMPL;
+
+		if(request->retriesLeft > 0) {
+			request->retriesLeft--;
+			DBG("NTP request %d timed out - retransmitting\n", request->reqcode);
+			if(!sendRequest(options, control, request)) {
+				completeRequest(control, request, -1);
+			}
+			continue;
 		}
 
-		DBGV(
-		    "NTPDC ***Warning changing the request packet size from %d to %d\n",
-		    oldsize, req_pkt_size);
-		goto again;
+		completeRequest(control, request, request->numrecv ? ERR_INCOMPLETE : ERR_TIMEOUT);
+
 	}
 
-	return res;
 }
 
-int
-ntpdControlFlags(NTPoptions* options, NTPcontrol* control, int req, int flags)
+/*
+ * Send a request unless the same one is already in flight.
+ * Returns NTPCONTROL_PENDING, the result is handed to control->onResponse.
+ */
+static int
+ntpdStartRequest(NTPoptions* options, NTPcontrol* control, int reqcode,
+		int auth, uint32_t flags, int esize)
 {
-	struct conf_sys_flags sys;
-	int items;
-	int itemsize;
-	char *dummy;
-	int res;
 
-	sys.flags = 0;
-	res = 0;
-	sys.flags = flags;
+	NTPrequest *request = getRequest(control, reqcode);
 
-	sys.flags = htonl(sys.flags);
+	if(request == NULL || control->sockFD < 0) {
+		return -1;
+	}
 
-	res = NTPDCquery(options, control, req, 1, 1,
-		      sizeof(struct conf_sys_flags), (char *)&sys, &items,
-		      &itemsize, &dummy, 0, sizeof(struct conf_sys_flags));
+	if(request->inFlight && request->flags == flags) {
+		return NTPCONTROL_PENDING;
+	}
 
-	if ((res != INFO_OKAY) && (sys.flags == 0))
-	    return 0;
+	/* nothing in flight: whatever is queued on the socket is stale */
+	if(!requestsInFlight(control)) {
+		ntpdReceive(options, control);
+	}
 
-	if (res != INFO_OKAY) {
+	request->inFlight = FALSE;
+	request->reqcode = reqcode;
+	request->auth = auth;
+	request->flags = flags;
+	request->esize = esize;
+	request->retriesLeft = NTP_REQUEST_RETRIES;
 
-	switch (res) {
+	if(!sendRequest(options, control, request)) {
+		return -1;
+	}
 
-	case -1:
-		if(!control->requestFailed) ERROR("Cannot connect to NTP daemon\n");
-		break;
+	request->inFlight = TRUE;
 
-	case INFO_ERR_AUTH:
+	return NTPCONTROL_PENDING;
 
-		if(!control->requestFailed) ERROR("NTP permission denied: check key id, password and NTP configuration\n");
-		break;		
+}
 
-	case ERR_TIMEOUT:
+Boolean
+ntpdRequestPending(NTPcontrol* control, int reqcode)
+{
+	NTPrequest *request = getRequest(control, reqcode);
 
-		if(!control->requestFailed) ERROR("Timeout while connecting to NTP daemon\n");
-		break;
+	return request != NULL && request->inFlight;
+}
 
-	default:
-	ERROR("NTP protocol error\n");
+int
+ntpdControlFlags(NTPoptions* options, NTPcontrol* control, int req, int flags)
+{
 
-	}
-	}
+	/* nothing to set or clear */
+	if (flags == 0)
+	    return INFO_OKAY;
 
-	return res;
+	return ntpdStartRequest(options, control, req, 1, flags,
+				sizeof(struct conf_sys_flags));
 
 }
 
@@ -769,12 +822,8 @@ int
 ntpdSetFlags(NTPoptions* options, NTPcontrol* control, int flags)
 {
 
-	int res;
-	ntpdc_pktdata = malloc(INITDATASIZE);
 	DBGV("Setting NTP flags %d\n", flags);
-	res=ntpdControlFlags(options, control, REQ_SET_SYS_FLAG, flags);
-	free(ntpdc_pktdata);
-	return res;
+	return ntpdControlFlags(options, control, REQ_SET_SYS_FLAG, flags);
 
 }
 
@@ -782,93 +831,53 @@ int
 ntpdClearFlags(NTPoptions* options, NTPcontrol* control, int flags)
 {
 
-	int res;
-	ntpdc_pktdata = malloc(INITDATASIZE);
 	DBGV("Clearing NTP flags %d\n", flags);
-	res=ntpdControlFlags(options, control, REQ_CLR_SYS_FLAG, flags);
-	free(ntpdc_pktdata);
-	return res;
-}
+	return ntpdControlFlags(options, control, REQ_CLR_SYS_FLAG, flags);
 
+}
 
+/* ask if ntpd is controlling the clock - INFO_YES or INFO_NO is handed to control->onResponse */
 int
 ntpdInControl(NTPoptions* options, NTPcontrol* control)
 {
-	struct info_sys *is;
-	int items;
-	int itemsize;
-	int res;
-        ntpdc_pktdata = malloc(INITDATASIZE);
-	res = NTPDCquery(options, control, REQ_SYS_INFO, 0, 0, 0, (char *)NULL,
-		      &items, &itemsize, (void *)&is, 0,
-		      sizeof(struct info_sys));
-
-	if ( res != 0 )
-	    goto end;
-
-	if (!check1item(items)) {
-
-	    res=INFO_ERR_EMPTY;
-	    goto end;
-	}
 
+	return ntpdStartRequest(options, control, REQ_SYS_INFO, 0, 0,
+				sizeof(struct info_sys));
 
-	if (!checkitemsize(itemsize, sizeof(struct info_sys)) &&
-	    !checkitemsize(itemsize, v4sizeof(struct info_sys))) {
-	
-	    res=INFO_ERR_EMPTY;
-	    goto end;
-	}	
+}
 
-	if (is->flags & INFO_FLAG_NTP) DBGV("NTP flag seen: ntp\n");
-	if (is->flags & INFO_FLAG_KERNEL) DBGV("NTP flag seen: kernel\n");
+int
+ntpdControlFd(void)
+{
 
-	if(!control->flagsCaptured) {
-		control->originalFlags = is->flags;
-		 /* we only control the kernel and ntp flags */
-		control->originalFlags &= (INFO_FLAG_KERNEL | INFO_FLAG_NTP);
-		control->flagsCaptured = TRUE;
-		res = INFO_YES;
-		goto end;
+	if(activeControl == NULL || activeControl->sockFD < 0) {
+		return -1;
 	}
 
-	if ((is->flags & INFO_FLAG_NTP) || (is->flags & INFO_FLAG_KERNEL))
-	{
-		res=INFO_YES;
-	} else  {
-
-		res=INFO_NO;
+	if(!requestsInFlight(activeControl)) {
+		return -1;
 	}
 
-	end:
-
-	free(ntpdc_pktdata);
-
-
-	if (res != INFO_YES && res != INFO_NO) {
-
-	switch (res) {
+	return activeControl->sockFD;
 
-	case -1:
-		DBG("Could not connect to NTP daemon\n");
-		break;
-
-	case ERR_TIMEOUT:
+}
 
-		DBG("Timeout while connecting to NTP daemon\n");
-		break;
+void
+ntpdControlReceive(void)
+{
 
-	case INFO_ERR_AUTH:
+	if(activeControl != NULL) {
+		ntpdReceive(activeOptions, activeControl);
+	}
 
-		DBG("NTP permission denied: check NTP key id, key and if key is trusted and is a request key\n");
-		break;		
+}
 
-	default:
-	ERROR("NTP protocol error\n");
+void
+ntpdControlTimeout(void)
+{
 
+	if(activeControl != NULL) {
+		ntpdTick(activeOptions, activeControl);
 	}
-	}
-	return res;
 
 }
-
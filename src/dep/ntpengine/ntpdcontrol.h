@@ -21,36 +21,13 @@ typedef struct {
 	Octet hostAddress[MAXHOSTNAMELEN];
 } NTPoptions;
 
-typedef struct {
-	Boolean operational;
-	Boolean enabled;
-	Boolean isRequired;
-	Boolean inControl;
-	Boolean isFailOver;
-	Boolean checkFailed;
-	Boolean requestFailed;
-	Boolean flagsCaptured;
-	int originalFlags;
-	Integer32 serverAddress;
-	Integer32 sockFD;
-	struct TimingService timingService;
-} NTPcontrol;
-
-Boolean ntpInit(NTPoptions* options, NTPcontrol* control);
-Boolean ntpShutdown(NTPoptions* options, NTPcontrol* control);
-int ntpdControlFlags(NTPoptions* options, NTPcontrol* control, int req, int flags);
-int ntpdSetFlags(NTPoptions* options, NTPcontrol* control, int flags);
-int ntpdClearFlags(NTPoptions* options, NTPcontrol* control, int flags);
-int ntpdInControl(NTPoptions* options, NTPcontrol* control);
-//Boolean ntpdControl(NTPoptions* options, NTPcontrol* control, Boolean quiet);
-
-
 #define NTPCONTROL_YES		128
 #define NTPCONTROL_NO		129
 #define NTPCONTROL_AUTHERR	18
 #define NTPCONTROL_TIMEOUT	19
 #define NTPCONTROL_PROTOERR	20
 #define NTPCONTROL_NETERR	21
+#define NTPCONTROL_PENDING	22	/* request sent, result delivered later */
 
 
 typedef struct {
@@ -350,13 +327,80 @@ struct conf_sys_flags {
 
 #define NTP_VERSION     ((u_char)4)
 
-#define DEFTIMEOUT      (5)             /* 5 second time out */
-#define DEFSTIMEOUT     (2)             /* 2 second time out after first */
-
-#define INITDATASIZE    (sizeof(struct resp_pkt) * 16)
-#define INCDATASIZE     (sizeof(struct resp_pkt) * 8)
+/*
+ * Requests are asynchronous: they are sent and the main loop delivers
+ * the responses - the control socket is waited on together with the PTP
+ * sockets, and NTPCONTROL_TIMER drives timeouts and retransmissions.
+ * ntpd matches responses to requests by request code only, so there is
+ * one request slot per request code we use, and requests with different
+ * codes are in flight at the same time.
+ */
+#define NTP_CONTROL_TICK	0.1	/* timeout timer interval (s) */
+#define NTP_REQUEST_TIMEOUT	20	/* ticks to wait for a response */
+#define NTP_REQUEST_RETRIES	2	/* retransmissions before giving up */
 
 /* how many time select() will retry on EINTR */
 #define NTP_EINTR_RETRIES 5
 
+enum {
+	NTPREQ_SYS_INFO = 0,
+	NTPREQ_SET_FLAGS,
+	NTPREQ_CLR_FLAGS,
+	NTPREQ_MAX
+};
+
+typedef struct {
+	Boolean inFlight;
+	int reqcode;
+	int auth;
+	uint32_t flags;			/* data item of set / clear flags */
+	int esize;			/* expected response item size */
+	int ticksLeft;
+	int retriesLeft;
+	/* response reassembly */
+	char haveseq[MAXSEQ + 1];
+	int lastseq;
+	int numrecv;
+	int items;
+	int itemsize;
+	int datasize;
+	char data[RESP_DATA_SIZE];
+} NTPrequest;
+
+typedef struct NTPcontrol NTPcontrol;
+
+struct NTPcontrol {
+	Boolean operational;
+	Boolean enabled;
+	Boolean isRequired;
+	Boolean inControl;
+	Boolean isFailOver;
+	Boolean checkFailed;
+	Boolean requestFailed;
+	Boolean flagsCaptured;
+	int originalFlags;
+	Integer32 serverAddress;
+	Integer32 sockFD;
+	int releaseReason;
+	Boolean logRelease;
+	NTPrequest requests[NTPREQ_MAX];
+	/* called with INFO_OKAY, INFO_YES / INFO_NO or an error when a request completes */
+	void (*onResponse) (NTPcontrol *control, int reqcode, int result);
+	struct TimingService timingService;
+};
+
+Boolean ntpInit(NTPoptions* options, NTPcontrol* control);
+Boolean ntpShutdown(NTPoptions* options, NTPcontrol* control);
+int ntpdControlFlags(NTPoptions* options, NTPcontrol* control, int req, int flags);
+int ntpdSetFlags(NTPoptions* options, NTPcontrol* control, int flags);
+int ntpdClearFlags(NTPoptions* options, NTPcontrol* control, int flags);
+int ntpdInControl(NTPoptions* options, NTPcontrol* control);
+Boolean ntpdRequestPending(NTPcontrol* control, int reqcode);
+//Boolean ntpdControl(NTPoptions* options, NTPcontrol* control, Boolean quiet);
+
+/* main loop side, for the controller started with ntpInit() */
+int ntpdControlFd(void);	/* socket to wait on, -1 if nothing is in flight */
+void ntpdControlReceive(void);
+void ntpdControlTimeout(void);
+
 #endif /* NTPDCONTROL_H */
@@ -0,0 +1,120 @@
+/*-
+ * Copyright (c) 2026 PTPd contributors,
+ *
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file   pcapng.h
+ * @date   Sun Oct 18 07:53:38 2026
+ *
+ * @brief  Packet capture file (global:capture_file) layout
+ *
+ * The capture file is pcap-ng, readable by Wireshark and tcpdump. Every
+ * time the file is opened, truncated or rotated, a new section starts: a
+ * section header block and one interface description block with
+ * nanosecond timestamp resolution. Every PTP message ptpd receives - and
+ * every Delay_Req it sends - is written as an enhanced packet block, its
+ * timestamp being the one the protocol used: hardware or kernel timestamp,
+ * UTC offset applied, latency correction subtracted. The packet flags
+ * carry the direction, and a comment carries the frequency adjustment of
+ * the clock the message was timestamped with, so ptpd-sim can undo the
+ * servo's work and replay the capture through a different one.
+ *
+ * Blocks are written in host byte order. This header is shared with
+ * ptpd-sim and must not depend on ptpd.h.
+ */
+
+#ifndef PTPD_PCAPNG_H_
+#define PTPD_PCAPNG_H_
+
+#include <stdint.h>
+
+#define PCAPNG_BLOCK_SHB	0x0A0D0D0A
+#define PCAPNG_BLOCK_IDB	0x00000001
+#define PCAPNG_BLOCK_EPB	0x00000006
+
+#define PCAPNG_BYTE_ORDER_MAGIC	0x1A2B3C4D
+#define PCAPNG_VERSION_MAJOR	1
+#define PCAPNG_VERSION_MINOR	0
+
+/* option codes */
+#define PCAPNG_OPT_ENDOFOPT	0
+#define PCAPNG_OPT_COMMENT	1
+#define PCAPNG_OPT_IF_NAME	2
+#define PCAPNG_OPT_IF_TSRESOL	9
+#define PCAPNG_OPT_EPB_FLAGS	2
+
+/* epb_flags direction bits */
+#define PCAPNG_EPB_INBOUND	1
+#define PCAPNG_EPB_OUTBOUND	2
+
+/* link types: UDP transports are written as raw IPv4, 802.3 as Ethernet */
+#define PCAPNG_LINKTYPE_ETHERNET	1
+#define PCAPNG_LINKTYPE_IPV4		228
+
+/* blocks and options are padded to 32 bits */
+#define PCAPNG_PAD(len)		(((len) + 3) & ~3)
+
+/* EPB comment: frequency adjustment in ppb when the message was timestamped */
+#define PCAPNG_COMMENT_FREQUENCY	"ppb="
+
+/* stdio buffer used for the capture file: written out when full or once per second */
+#define PCAPNG_BUFFER_SIZE	65536
+
+typedef struct {
+	uint32_t type;
+	uint32_t length;		/* whole block, including the trailing length copy */
+} PcapngBlockHeader;
+
+typedef struct {
+	PcapngBlockHeader block;
+	uint32_t magic;
+	uint16_t versionMajor;
+	uint16_t versionMinor;
+	int64_t sectionLength;		/* -1: not known */
+} PcapngSectionHeader;
+
+typedef struct {
+	PcapngBlockHeader block;
+	uint16_t linkType;
+	uint16_t reserved;
+	uint32_t snapLength;
+} PcapngInterfaceDescription;
+
+typedef struct {
+	PcapngBlockHeader block;
+	uint32_t interfaceId;
+	uint32_t timestampHigh;		/* nanoseconds since the epoch */
+	uint32_t timestampLow;
+	uint32_t capturedLength;
+	uint32_t packetLength;
+} PcapngEnhancedPacket;
+
+typedef struct {
+	uint16_t code;
+	uint16_t length;		/* value length, without the padding */
+} PcapngOption;
+
+#endif /* PTPD_PCAPNG_H_ */
@@ -254,8 +254,11 @@ void msgPackAnnounce(Octet * buf, UInteger16, PtpClock*);
 #endif /* PTPD_SLAVE_ONLY */
 void msgPackSync(Octet * buf, UInteger16, Timestamp*,PtpClock*);
 void msgPackFollowUp(Octet * buf,Timestamp*,PtpClock*, const UInteger16);
+void msgPatchSequenceId(Octet * buf, UInteger16);
+void msgPatchTimestamp(Octet * buf, const Timestamp*);
 void msgPackDelayReq(Octet * buf,Timestamp *,PtpClock *);
 void msgPackDelayResp(Octet * buf,MsgHeader *,Timestamp *,PtpClock *);
+void msgPatchDelayResp(Octet * buf,MsgHeader *,Timestamp *,PtpClock *);
 void msgPackPdelayReq(Octet * buf,Timestamp*,PtpClock*);
 void msgPackPdelayResp(Octet * buf,MsgHeader*,Timestamp*,PtpClock*);
 void msgPackPdelayRespFollowUp(Octet * buf,MsgHeader*,Timestamp*,PtpClock*, const UInteger16);
@@ -392,12 +395,17 @@ Boolean testInterface(char* ifaceName, const RunTimeOpts* rtOpts);
 Boolean netInit(NetPath*,RunTimeOpts*,PtpClock*);
 Boolean netShutdown(NetPath*, PtpClock*);
 int netSelect(TimeInternal*,NetPath*,fd_set*);
+int netRecvBatch(TimeInternal*,NetPath*);
 ssize_t netRecvEvent(Octet*,TimeInternal*,NetPath*,int);
 ssize_t netRecvGeneral(Octet*,NetPath*);
 ssize_t netSendEvent(Octet*,UInteger16,NetPath*,const RunTimeOpts*,Integer32,TimeInternal*);
 ssize_t netSendGeneral(Octet*,UInteger16,NetPath*,const RunTimeOpts*,Integer32 );
 ssize_t netSendPeerGeneral(Octet*,UInteger16,NetPath*,const RunTimeOpts*, Integer32);
 ssize_t netSendPeerEvent(Octet*,UInteger16,NetPath*,const RunTimeOpts*,Integer32,TimeInternal*);
+Boolean netRecvTxTimestamp(NetPath*,TimeInternal*,Enumeration4*,UInteger16*,Integer32*,int);
+Octet* netBatchAdd(NetTxBatch*,const Octet*,UInteger16,Integer32);
+int netBatchFlushEvent(NetPath*);
+int netBatchFlushGeneral(NetPath*);
 Boolean netRefreshIGMP(NetPath *, const RunTimeOpts *, PtpClock *);
 Boolean hostLookup(const char* hostname, Integer32* addr);
 void updateInterfaceInfo(NetPath * netPath, RunTimeOpts * rtOpts, PtpClock * ptpClock);
@@ -424,25 +432,72 @@ void alarmHandler_snmp(AlarmEntry *alarm);
 /** \}*/
 #endif
 
+/** \name servoarith.c
+ * -Offset and delay arithmetic of the clock servo, shared with ptpd-sim*/
+ /**\{*/
+
+ScaledNanoseconds calcMeanPathDelay(ScaledNanoseconds,ScaledNanoseconds,ScaledNanoseconds);
+ScaledNanoseconds correctedDelay(ScaledNanoseconds,ScaledNanoseconds);
+Integer32 filterOffsetFromMaster(offset_from_master_filter*,Integer32);
+Integer32 filterMeanPathDelay(one_way_delay_filter*,Integer32,Integer16);
+Integer32 filterPeerMeanPathDelay(one_way_delay_filter*,Integer32,Integer16);
+
+/** \}*/
+
 /** \name servo.c
  * -Clock servo*/
  /**\{*/
 
 void initClock(const RunTimeOpts*,PtpClock*);
-void updatePeerDelay (one_way_delay_filter*, const RunTimeOpts*,PtpClock*,TimeInternal*,Boolean);
-void updateDelay (one_way_delay_filter*, const RunTimeOpts*, PtpClock*,TimeInternal*);
+void updatePeerDelay (one_way_delay_filter*, const RunTimeOpts*,PtpClock*,ScaledNanoseconds,Boolean);
+void updateDelay (one_way_delay_filter*, const RunTimeOpts*, PtpClock*,ScaledNanoseconds);
 void updateOffset(TimeInternal*,TimeInternal*,
-  offset_from_master_filter*,const RunTimeOpts*,PtpClock*,TimeInternal*);
+  offset_from_master_filter*,const RunTimeOpts*,PtpClock*,ScaledNanoseconds);
 void checkOffset(const RunTimeOpts*, PtpClock*);
 void updateClock(const RunTimeOpts*,PtpClock*);
 void stepClock(const RunTimeOpts * rtOpts, PtpClock * ptpClock, Boolean force);
 
 /** \}*/
 
+/** \name telemetry.c
+ * -Memory-mapped servo telemetry ring*/
+ /**\{*/
+
+Boolean restartTelemetry(RunTimeOpts *rtOpts);
+void stopTelemetry(RunTimeOpts *rtOpts);
+void writeTelemetry(const TelemetryRing *ring, uint8_t type, UInteger16 sequenceId,
+	const TimeInternal *t1, const TimeInternal *t2,
+	const TimeInternal *t3, const TimeInternal *t4,
+	const TimeInternal *correction, const PtpClock *ptpClock);
+
+/** \}*/
+
+/** \name capture.c
+ * -pcap-ng capture of received messages for offline replay*/
+ /**\{*/
+
+void captureMessage(PtpClock *ptpClock, const Octet *buf, int length,
+	const TimeInternal *timestamp, Boolean outbound);
+
+/** \}*/
+
+/** \name housekeeping.c
+ * -Log, statistics and status file output, optionally in a separate thread*/
+ /**\{*/
+
+Boolean startHousekeeping(void);
+void stopHousekeeping(void);
+void syncHousekeeping(void);
+void reportHousekeeping(RunTimeOpts *rtOpts);
+Boolean logWrite(int type, int flags, int priority, LogFileHandler *handler, FILE *fp, const void *data, size_t length);
+
+/** \}*/
+
 /** \name startup.c (Unix API dependent)
  * -Handle with runtime options*/
  /**\{*/
 int setCpuAffinity(int cpu);
+int setRealtimePriority(int priority);
 PtpClock * ptpdStartup(int,char**,Integer16*,RunTimeOpts*);
 
 void ptpdShutdown(PtpClock * ptpClock);
@@ -481,6 +536,7 @@ void periodicUpdate(const RunTimeOpts *rtOpts, PtpClock *ptpClock);
 void displayStatus(PtpClock *ptpClock, const char *prefixMessage);
 void displayPortIdentity(PortIdentity *port, const char *prefixMessage);
 int snprint_PortIdentity(char *s, int max_len, const PortIdentity *id);
+int snprint_Percentiles(char *s, int max_len, const char *prefix, const double *values, const char *separator);
 Boolean nanoSleep(TimeInternal*);
 
 double getRand(void);
@@ -518,6 +574,7 @@ resetWarnings(const RunTimeOpts * rtOpts, PtpClock * ptpClock);
 void updatePtpEngineStats (PtpClock* ptpClock, const RunTimeOpts* rtOpts);
 
 void writeStatusFile(PtpClock *ptpClock, const RunTimeOpts *rtOpts, Boolean quiet);
+void invalidateStatusFile(void);
 
 
 #endif /*PTPD_DEP_H_*/
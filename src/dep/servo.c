@@ -83,6 +83,9 @@ initClock(const RunTimeOpts * rtOpts, PtpClock * ptpClock)
 	clearTime(&ptpClock->currentDS.meanPathDelay);
 	clearTime(&ptpClock->delaySM);
 	clearTime(&ptpClock->delayMS);
+	ptpClock->delayMSScaled = 0;
+	ptpClock->lastSyncCorrectionField = 0;
+	ptpClock->lastPdelayRespCorrectionField = 0;
 
 	ptpClock->ofm_filt.y           = 0;
 	ptpClock->ofm_filt.nsec_prev   = 0;
@@ -90,6 +93,9 @@ initClock(const RunTimeOpts * rtOpts, PtpClock * ptpClock)
 	ptpClock->mpdIirFilter.s_exp       = 0;  /* clears one-way delay filter */
 	ptpClock->offsetFirstUpdated   = FALSE;
 
+	/* a step or a new master breaks the phase record */
+	resetPhaseStability(ptpClock->stability, 0.0);
+
 	ptpClock->char_last_msg='I';
 
 	resetWarnings(rtOpts, ptpClock);
@@ -99,9 +105,11 @@ initClock(const RunTimeOpts * rtOpts, PtpClock * ptpClock)
 }
 
 void
-updateDelay(one_way_delay_filter * mpdIirFilter, const RunTimeOpts * rtOpts, PtpClock * ptpClock, TimeInternal * correctionField)
+updateDelay(one_way_delay_filter * mpdIirFilter, const RunTimeOpts * rtOpts, PtpClock * ptpClock, ScaledNanoseconds correction)
 {
 
+	TimeInternal correctionField;
+
 	if(ptpClock->ignoreDelayUpdates > 0) {
 	    ptpClock->ignoreDelayUpdates--;
 	    DBG("updateDelay: Ignoring delay update: ptpClock->ignoreDelayUpdates\n");
@@ -126,6 +134,13 @@ updateDelay(one_way_delay_filter * mpdIirFilter, const RunTimeOpts * rtOpts, Ptp
 
 	Boolean maxDelayHit = FALSE;
 
+	//perform basic checks, using local variables only
+	ScaledNanoseconds slave_to_master_delay, delaySM, meanPathDelay;
+
+	/* calc 'slave_to_master_delay' - out of range means seconds apart anyway */
+	Boolean inRange = scaledTimeDiff(&slave_to_master_delay, &ptpClock->delay_req_receive_time,
+			&ptpClock->delay_req_send_time);
+
 	{
 
 		/* if maxDelayStableOnly configured, only check once servo is stable */
@@ -133,22 +148,14 @@ updateDelay(one_way_delay_filter * mpdIirFilter, const RunTimeOpts * rtOpts, Ptp
 		    ((ptpClock->clockDriver->state == CS_LOCKED) && rtOpts->maxDelay) :
 		    (rtOpts->maxDelay);
 
-		//perform basic checks, using local variables only
-		TimeInternal slave_to_master_delay;
-
-		/* calc 'slave_to_master_delay' */
-		subTime(&slave_to_master_delay, &ptpClock->delay_req_receive_time,
-			&ptpClock->delay_req_send_time);
-
 		if (checkThreshold && /* If maxDelay is 0 then it's OFF */
 		    ptpClock->offsetFirstUpdated) {
 
-			if ((slave_to_master_delay.nanoseconds < 0) &&
-			    (abs(slave_to_master_delay.nanoseconds) > rtOpts->maxDelay)) {
+			if ((slave_to_master_delay < 0) &&
+			    (-scaledToNs(slave_to_master_delay) > rtOpts->maxDelay)) {
 				INFO("updateDelay aborted, "
-				     "delay (sec: %d ns: %d) is negative\n",
-				     slave_to_master_delay.seconds,
-				     slave_to_master_delay.nanoseconds);
+				     "delay (%lld ns) is negative\n",
+				     (long long)scaledToNs(slave_to_master_delay));
 				INFO("send (sec: %d ns: %d)\n",
 				     ptpClock->delay_req_send_time.seconds,
 				     ptpClock->delay_req_send_time.nanoseconds);
@@ -158,27 +165,26 @@ updateDelay(one_way_delay_filter * mpdIirFilter, const RunTimeOpts * rtOpts, Ptp
 				goto finish;
 			}
 
-			if (slave_to_master_delay.seconds && checkThreshold) {
-				INFO("updateDelay aborted, slave to master delay %d.%d greater than 1 second\n",
-				     slave_to_master_delay.seconds,
-				     slave_to_master_delay.nanoseconds);
+			if ((llabs(slave_to_master_delay) >= SCALED_NS_SECOND) && checkThreshold) {
+				INFO("updateDelay aborted, slave to master delay %lld ns greater than 1 second\n",
+				     (long long)scaledToNs(slave_to_master_delay));
 				if (rtOpts->displayPackets)
 					msgDump(ptpClock);
 				goto finish;
 			}
 
-			if (slave_to_master_delay.nanoseconds > rtOpts->maxDelay) {
+			if (scaledToNs(slave_to_master_delay) > rtOpts->maxDelay) {
 				ptpClock->counters.maxDelayDrops++;
 				DBG("updateDelay aborted, slave to master delay %d greater than "
 				     "administratively set maximum %d\n",
-				     slave_to_master_delay.nanoseconds,
+				     (int)scaledToNs(slave_to_master_delay),
 				     rtOpts->maxDelay);
 				if(rtOpts->maxDelayMaxRejected) {
                                     maxDelayHit = TRUE;
 				    /* if we blocked maxDelayMaxRejected samples, reset the slave to unblock the filter */
 				    if(++ptpClock->maxDelayRejected > rtOpts->maxDelayMaxRejected) {
 					    WARNING("%d consecutive measurements above %d threshold - resetting slave\n",
-							rtOpts->maxDelayMaxRejected, slave_to_master_delay.nanoseconds);
+							rtOpts->maxDelayMaxRejected, (int)scaledToNs(slave_to_master_delay));
 					    toState(PTP_LISTENING, rtOpts, ptpClock);
 				    }
 				}
@@ -198,7 +204,6 @@ updateDelay(one_way_delay_filter * mpdIirFilter, const RunTimeOpts * rtOpts, Ptp
 	 *   - calculate a new filtered MPD
 	 */
 	if (ptpClock->offsetFirstUpdated) {
-		Integer16 s;
 
 		/*
 		 * calc 'slave_to_master_delay' (Master to Slave delay is
@@ -209,27 +214,22 @@ updateDelay(one_way_delay_filter * mpdIirFilter, const RunTimeOpts * rtOpts, Ptp
 			dump_TimeInternal2("Req_RECV:", &ptpClock->delay_req_receive_time,
 			"Req_SENT:", &ptpClock->delay_req_send_time));
 
-	/* raw value before filtering */
-	subTime(&ptpClock->rawDelaySM, &ptpClock->delay_req_receive_time,
-		&ptpClock->delay_req_send_time);
-
-
-/* testing only: step detection */
-#if 0
-	TimeInternal bob;
-	bob.nanoseconds = -1000000;
-	bob.seconds = 0;
-	if(ptpClock->addOffset) {
-	    	addTime(&ptpClock->rawDelaySM, &ptpClock->rawDelaySM, &bob);
+	if (!inRange) {
+		DBG("Servo: Ignoring delayResp because of large OFM\n");
+		mpdIirFilter->s_exp = mpdIirFilter->nsec_prev = 0;
+		goto finish;
 	}
-#endif
+
+	/* raw value before filtering */
+	scaledToTimeInternal(slave_to_master_delay, &ptpClock->rawDelaySM);
 
 	/* run the delayMS stats filter */
 	if(rtOpts->filterSMOpts.enabled) {
-	    if(!feedDoubleMovingStatFilter(ptpClock->filterSM, timeInternalToDouble(&ptpClock->rawDelaySM))) {
+	    if(!feedDoubleMovingStatFilter(ptpClock->filterSM, scaledToDouble(slave_to_master_delay))) {
 		    return;
 	    }
-	    ptpClock->rawDelaySM = doubleToTimeInternal(ptpClock->filterSM->output);
+	    slave_to_master_delay = doubleToScaled(ptpClock->filterSM->output);
+	    scaledToTimeInternal(slave_to_master_delay, &ptpClock->rawDelaySM);
 	}
 
 	/* don't update if MS had an outlier */
@@ -238,8 +238,8 @@ updateDelay(one_way_delay_filter * mpdIirFilter, const RunTimeOpts * rtOpts, Ptp
 	}
 	/* run the delaySM outlier filter */
 	if(!rtOpts->noAdjust && ptpClock->oFilterSM.config.enabled && (ptpClock->oFilterSM.config.alwaysFilter || !ptpClock->clockDriver->servo.runningMaxOutput) ) {
-		if(ptpClock->oFilterSM.filter(&ptpClock->oFilterSM, timeInternalToDouble(&ptpClock->rawDelaySM))) {
-			ptpClock->delaySM = doubleToTimeInternal(ptpClock->oFilterSM.output);
+		if(ptpClock->oFilterSM.filter(&ptpClock->oFilterSM, scaledToDouble(slave_to_master_delay))) {
+			delaySM = doubleToScaled(ptpClock->oFilterSM.output);
 //INFO("SM: NOUTL %.09f\n", timeInternalToDouble(&ptpClock->rawDelaySM));
 		} else {
 			ptpClock->counters.delaySMOutliersFound++;
@@ -252,21 +252,18 @@ updateDelay(one_way_delay_filter * mpdIirFilter, const RunTimeOpts * rtOpts, Ptp
 			goto finish;
 		}
 	} else {
-		ptpClock->delaySM = ptpClock->rawDelaySM;
+		delaySM = slave_to_master_delay;
 	}
 
-		/* update MeanPathDelay */
-		addTime(&ptpClock->currentDS.meanPathDelay, &ptpClock->delaySM,
-			&ptpClock->delayMS);
+		scaledToTimeInternal(delaySM, &ptpClock->delaySM);
 
-		/* Subtract correctionField */
-		subTime(&ptpClock->currentDS.meanPathDelay, &ptpClock->currentDS.meanPathDelay,
-			correctionField);
+		/*
+		 * update MeanPathDelay: delayMS as updateOffset() left it, fractional
+		 * nanoseconds of both correctionFields included, rounded once
+		 */
+		meanPathDelay = calcMeanPathDelay(ptpClock->delayMSScaled, delaySM, correction);
 
-		/* Compute one-way delay */
-		div2Time(&ptpClock->currentDS.meanPathDelay);
-		
-		if (ptpClock->currentDS.meanPathDelay.seconds) {
+		if (llabs(meanPathDelay) >= SCALED_NS_SECOND) {
 			DBG("update delay: cannot filter with large OFM, "
 				"clearing filter\n");
 			DBG("Servo: Ignoring delayResp because of large OFM\n");
@@ -277,6 +274,8 @@ updateDelay(one_way_delay_filter * mpdIirFilter, const RunTimeOpts * rtOpts, Ptp
 			goto finish;
 		}
 
+		scaledToTimeInternal(meanPathDelay, &ptpClock->currentDS.meanPathDelay);
+
 		if(ptpClock->currentDS.meanPathDelay.nanoseconds < 0){
 			DBG("update delay: found negative value for OWD, "
 			    "so ignoring this value: %d\n",
@@ -286,31 +285,10 @@ updateDelay(one_way_delay_filter * mpdIirFilter, const RunTimeOpts * rtOpts, Ptp
 			goto finish;
 		}
 
-		/* avoid overflowing filter */
-		s = rtOpts->s;
-		while (abs(mpdIirFilter->y) >> (31 - s))
-			--s;
-
-		/* crank down filter cutoff by increasing 's_exp' */
-		if (mpdIirFilter->s_exp < 1)
-			mpdIirFilter->s_exp = 1;
-		else if (mpdIirFilter->s_exp < 1 << s)
-			++mpdIirFilter->s_exp;
-		else if (mpdIirFilter->s_exp > 1 << s)
-			mpdIirFilter->s_exp = 1 << s;
-
 		/* filter 'meanPathDelay' */
-		double fy =
-			(double)((mpdIirFilter->s_exp - 1.0) *
-			mpdIirFilter->y / (mpdIirFilter->s_exp + 0.0) +
-			(ptpClock->currentDS.meanPathDelay.nanoseconds / 2.0 +
-			 mpdIirFilter->nsec_prev / 2.0) / (mpdIirFilter->s_exp + 0.0));
-
-		mpdIirFilter->nsec_prev = ptpClock->currentDS.meanPathDelay.nanoseconds;
-
-		mpdIirFilter->y = round(fy);
-
-		ptpClock->currentDS.meanPathDelay.nanoseconds = mpdIirFilter->y;
+		ptpClock->currentDS.meanPathDelay.nanoseconds =
+			filterMeanPathDelay(mpdIirFilter,
+			ptpClock->currentDS.meanPathDelay.nanoseconds, rtOpts->s);
 
 		DBGV("delay filter %d, %d\n", mpdIirFilter->y, mpdIirFilter->s_exp);
 	} else {
@@ -325,7 +303,7 @@ DBG("UpdateDelay: Max delay hit: %d\n", maxDelayHit);
 	/* don't churn on stats containers with the old value if we've discarded an outlier */
 	if(!(ptpClock->oFilterSM.config.enabled && ptpClock->oFilterSM.config.discard && ptpClock->oFilterSM.lastOutlier)) {
 		feedDoublePermanentStdDev(&ptpClock->slaveStats.mpdStats, timeInternalToDouble(&ptpClock->currentDS.meanPathDelay));
-		feedDoublePermanentMedian(&ptpClock->slaveStats.mpdMedianContainer, timeInternalToDouble(&ptpClock->currentDS.meanPathDelay));
+		feedDoublePermanentPercentiles(&ptpClock->slaveStats.mpdPercentiles, timeInternalToDouble(&ptpClock->currentDS.meanPathDelay));
 		if(!ptpClock->slaveStats.mpdStatsUpdated) {
 			if(timeInternalToDouble(&ptpClock->currentDS.meanPathDelay) != 0.0){
 			ptpClock->slaveStats.mpdMax = timeInternalToDouble(&ptpClock->currentDS.meanPathDelay);
@@ -338,14 +316,22 @@ DBG("UpdateDelay: Max delay hit: %d\n", maxDelayHit);
 		}
 	}
 
+	scaledToTimeInternal(correction, &correctionField);
+	writeTelemetry(&rtOpts->telemetry, TELEMETRY_DELAY, ptpClock->sentDelayReqSequenceId - 1,
+		&ptpClock->lastOriginTimestamp, &ptpClock->sync_receive_time,
+		&ptpClock->delay_req_send_time, &ptpClock->delay_req_receive_time,
+		&correctionField, ptpClock);
+
 	logStatistics(ptpClock);
 
 }
 
 void
-updatePeerDelay(one_way_delay_filter * mpdIirFilter, const RunTimeOpts * rtOpts, PtpClock * ptpClock, TimeInternal * correctionField, Boolean twoStep)
+updatePeerDelay(one_way_delay_filter * mpdIirFilter, const RunTimeOpts * rtOpts, PtpClock * ptpClock, ScaledNanoseconds correction, Boolean twoStep)
 {
-	Integer16 s;
+	ScaledNanoseconds pdelayMS, pdelaySM, peerMeanPathDelay;
+	TimeInternal correctionField;
+	Boolean inRange;
 
 	/* updates paused, leap second pending - do nothing */
 	if(ptpClock->leapSecondInProgress)
@@ -358,6 +344,12 @@ updatePeerDelay(one_way_delay_filter * mpdIirFilter, const RunTimeOpts * rtOpts,
 
 	if (twoStep) {
 		/* calc 'slave_to_master_delay' */
+		inRange = scaledTimeDiff(&pdelayMS,
+			&ptpClock->pdelay_resp_receive_time,
+			&ptpClock->pdelay_resp_send_time);
+		inRange &= scaledTimeDiff(&pdelaySM,
+			&ptpClock->pdelay_req_receive_time,
+			&ptpClock->pdelay_req_send_time);
 		subTime(&ptpClock->pdelayMS,
 			&ptpClock->pdelay_resp_receive_time,
 			&ptpClock->pdelay_resp_send_time);
@@ -365,61 +357,39 @@ updatePeerDelay(one_way_delay_filter * mpdIirFilter, const RunTimeOpts * rtOpts,
 			&ptpClock->pdelay_req_receive_time,
 			&ptpClock->pdelay_req_send_time);
 
-		/* update 'one_way_delay' */
-		addTime(&ptpClock->portDS.peerMeanPathDelay,
-			&ptpClock->pdelayMS,
-			&ptpClock->pdelaySM);
-
-		/* Subtract correctionField */
-		subTime(&ptpClock->portDS.peerMeanPathDelay,
-			&ptpClock->portDS.peerMeanPathDelay, correctionField);
-
-		/* Compute one-way delay */
-		div2Time(&ptpClock->portDS.peerMeanPathDelay);
+		/* update 'one_way_delay', subtract correctionField */
+		peerMeanPathDelay = calcMeanPathDelay(pdelayMS, pdelaySM, correction);
 	} else {
 		/* One step clock */
 
-		subTime(&ptpClock->portDS.peerMeanPathDelay,
+		inRange = scaledTimeDiff(&pdelayMS,
 			&ptpClock->pdelay_resp_receive_time,
 			&ptpClock->pdelay_req_send_time);
 
 		/* Subtract correctionField */
-		subTime(&ptpClock->portDS.peerMeanPathDelay,
-			&ptpClock->portDS.peerMeanPathDelay, correctionField);
-
-		/* Compute one-way delay */
-		div2Time(&ptpClock->portDS.peerMeanPathDelay);
+		peerMeanPathDelay = calcMeanPathDelay(pdelayMS, 0, correction);
 	}
 
-	if (ptpClock->portDS.peerMeanPathDelay.seconds) {
+	if (!inRange || llabs(peerMeanPathDelay) >= SCALED_NS_SECOND) {
 		/* cannot filter with secs, clear filter */
 		mpdIirFilter->s_exp = mpdIirFilter->nsec_prev = 0;
 		return;
 	}
-	/* avoid overflowing filter */
-	s = rtOpts->s;
-	while (abs(mpdIirFilter->y) >> (31 - s))
-		--s;
 
-	/* crank down filter cutoff by increasing 's_exp' */
-	if (mpdIirFilter->s_exp < 1)
-		mpdIirFilter->s_exp = 1;
-	else if (mpdIirFilter->s_exp < 1 << s)
-		++mpdIirFilter->s_exp;
-	else if (mpdIirFilter->s_exp > 1 << s)
-		mpdIirFilter->s_exp = 1 << s;
+	scaledToTimeInternal(peerMeanPathDelay, &ptpClock->portDS.peerMeanPathDelay);
 
 	/* filter 'meanPathDelay' */
-	mpdIirFilter->y = (mpdIirFilter->s_exp - 1) *
-		mpdIirFilter->y / mpdIirFilter->s_exp +
-		(ptpClock->portDS.peerMeanPathDelay.nanoseconds / 2 +
-		 mpdIirFilter->nsec_prev / 2) / mpdIirFilter->s_exp;
-
-	mpdIirFilter->nsec_prev = ptpClock->portDS.peerMeanPathDelay.nanoseconds;
-	ptpClock->portDS.peerMeanPathDelay.nanoseconds = mpdIirFilter->y;
+	ptpClock->portDS.peerMeanPathDelay.nanoseconds =
+		filterPeerMeanPathDelay(mpdIirFilter,
+		ptpClock->portDS.peerMeanPathDelay.nanoseconds, rtOpts->s);
 
 	DBGV("delay filter %d, %d\n", mpdIirFilter->y, mpdIirFilter->s_exp);
 
+	scaledToTimeInternal(correction, &correctionField);
+	writeTelemetry(&rtOpts->telemetry, TELEMETRY_PDELAY, ptpClock->recvPdelayRespSequenceId,
+		&ptpClock->pdelay_req_send_time, &ptpClock->pdelay_req_receive_time,
+		&ptpClock->pdelay_resp_send_time, &ptpClock->pdelay_resp_receive_time,
+		&correctionField, ptpClock);
 
 	if(ptpClock->portDS.portState == PTP_SLAVE)
 	logStatistics(ptpClock);
@@ -427,9 +397,12 @@ updatePeerDelay(one_way_delay_filter * mpdIirFilter, const RunTimeOpts * rtOpts,
 
 void
 updateOffset(TimeInternal * send_time, TimeInternal * recv_time,
-    offset_from_master_filter * ofm_filt, const RunTimeOpts * rtOpts, PtpClock * ptpClock, TimeInternal * correctionField)
+    offset_from_master_filter * ofm_filt, const RunTimeOpts * rtOpts, PtpClock * ptpClock, ScaledNanoseconds correction)
 {
 
+	ScaledNanoseconds master_to_slave_delay, delayMS, offset;
+	TimeInternal correctionField;
+
 	if(ptpClock->ignoreOffsetUpdates > 0) {
 	    ptpClock->ignoreOffsetUpdates--;
 	    DBG("updateOffset: Ignoring offset update\n");
@@ -478,32 +451,47 @@ updateOffset(TimeInternal * send_time, TimeInternal * recv_time,
 		    (rtOpts->maxDelay));
 
 	//perform basic checks, using only local variables
-	TimeInternal master_to_slave_delay;
-
 
 	/* calc 'master_to_slave_delay' */
-	subTime(&master_to_slave_delay, recv_time, send_time);
+	if(!scaledTimeDiff(&master_to_slave_delay, recv_time, send_time)) {
+		if (checkThreshold) {
+			INFO("updateOffset aborted, master to slave delay greater than 1"
+			     " second.\n");
+			return;
+		}
+		/* days apart: no filtering, straight to the step path with the plain difference */
+		subTime(&ptpClock->rawDelayMS, recv_time, send_time);
+		ptpClock->delayMS = ptpClock->rawDelayMS;
+		ptpClock->delayMSScaled = master_to_slave_delay;
+		ptpClock->currentDS.offsetFromMaster = ptpClock->rawDelayMS;
+		ofm_filt->nsec_prev = 0;
+		ptpClock->offsetFirstUpdated = TRUE;
+		ptpClock->clockControl.offsetOK = TRUE;
+		SET_ALARM(ALRM_OFM_SECONDS, TRUE);
+		scaledToTimeInternal(correction, &correctionField);
+		goto finish;
+	}
 
 	if (checkThreshold) { /* If maxDelay is 0 then it's OFF */
-		if (master_to_slave_delay.seconds && checkThreshold) {
+		if (llabs(master_to_slave_delay) >= SCALED_NS_SECOND && checkThreshold) {
 			INFO("updateOffset aborted, master to slave delay greater than 1"
 			     " second.\n");
 			/* msgDump(ptpClock); */
 			return;
 		}
 
-		if (abs(master_to_slave_delay.nanoseconds) > rtOpts->maxDelay) {
+		if (llabs(scaledToNs(master_to_slave_delay)) > rtOpts->maxDelay) {
 			ptpClock->counters.maxDelayDrops++;
 			DBG("updateOffset aborted, master to slave delay %d greater than "
 			     "administratively set maximum %d\n",
-			     master_to_slave_delay.nanoseconds,
+			     (int)scaledToNs(master_to_slave_delay),
 			     rtOpts->maxDelay);
 				if(rtOpts->maxDelayMaxRejected) {
 				    maxDelayHit = TRUE;
 				    /* if we blocked maxDelayMaxRejected samples, reset the slave to unblock the filter */
 				    if(++ptpClock->maxDelayRejected > rtOpts->maxDelayMaxRejected) {
 					    WARNING("%d consecutive delay measurements above %d threshold - resetting slave\n",
-							rtOpts->maxDelayMaxRejected, master_to_slave_delay.nanoseconds);
+							rtOpts->maxDelayMaxRejected, (int)scaledToNs(master_to_slave_delay));
 					    toState(PTP_LISTENING, rtOpts, ptpClock);
 				    }
 			    } else {
@@ -525,24 +513,28 @@ updateOffset(TimeInternal * send_time, TimeInternal * recv_time,
 	 *   - calculate the new filtered OFM
 	 */
 
+	/* correction for telemetry - only rounded for the record */
+	scaledToTimeInternal(correction, &correctionField);
+
 	/* raw value before filtering */
-	subTime(&ptpClock->rawDelayMS, recv_time, send_time);
+	scaledToTimeInternal(master_to_slave_delay, &ptpClock->rawDelayMS);
 
 	DBG("UpdateOffset: max delay hit: %d\n", maxDelayHit);
 
 	/* run the delayMS stats filter */
 	if(rtOpts->filterMSOpts.enabled) {
 	    /* FALSE if filter wants to skip the update */
-	    if(!feedDoubleMovingStatFilter(ptpClock->filterMS, timeInternalToDouble(&ptpClock->rawDelayMS))) {
+	    if(!feedDoubleMovingStatFilter(ptpClock->filterMS, scaledToDouble(master_to_slave_delay))) {
 		goto finish;
 	    }
-	    ptpClock->rawDelayMS = doubleToTimeInternal(ptpClock->filterMS->output);
+	    master_to_slave_delay = doubleToScaled(ptpClock->filterMS->output);
+	    scaledToTimeInternal(master_to_slave_delay, &ptpClock->rawDelayMS);
 	}
 
 	/* run the delayMS outlier filter */
 	if(!rtOpts->noAdjust && ptpClock->oFilterMS.config.enabled && (ptpClock->oFilterMS.config.alwaysFilter || !ptpClock->clockDriver->servo.runningMaxOutput)) {
-		if(ptpClock->oFilterMS.filter(&ptpClock->oFilterMS, timeInternalToDouble(&ptpClock->rawDelayMS))) {
-			ptpClock->delayMS = doubleToTimeInternal(ptpClock->oFilterMS.output);
+		if(ptpClock->oFilterMS.filter(&ptpClock->oFilterMS, scaledToDouble(master_to_slave_delay))) {
+			delayMS = doubleToScaled(ptpClock->oFilterMS.output);
 //INFO("MS: NOUTL %.09f\n", timeInternalToDouble(&ptpClock->rawDelayMS));
 		} else {
 			ptpClock->counters.delayMSOutliersFound++;
@@ -554,26 +546,30 @@ updateOffset(TimeInternal * send_time, TimeInternal * recv_time,
 			goto finish;
 		}
 	} else {
-		ptpClock->delayMS = ptpClock->rawDelayMS;
+		delayMS = master_to_slave_delay;
 	}
 
-	/* Take care of correctionField */
-	subTime(&ptpClock->delayMS,
-		&ptpClock->delayMS, correctionField);
+	/* Take care of correctionField - fractional nanoseconds kept for updateDelay() */
+	delayMS = correctedDelay(delayMS, correction);
+
+	if (llabs(delayMS) == INT64_MAX) {
+		DBG("updateOffset: correctionField out of range, ignoring sync\n");
+		ptpClock->counters.discardedMessages++;
+		goto finish;
+	}
+	ptpClock->delayMSScaled = delayMS;
+	scaledToTimeInternal(delayMS, &ptpClock->delayMS);
 
 	/* update 'offsetFromMaster' */
+	offset = delayMS;
 	if (ptpClock->portDS.delayMechanism == P2P) {
-		subTime(&ptpClock->currentDS.offsetFromMaster,
-			&ptpClock->delayMS,
-			&ptpClock->portDS.peerMeanPathDelay);
+		offset = scaledSub(offset, timeInternalToScaled(&ptpClock->portDS.peerMeanPathDelay));
 	/* (End to End mode or disabled - if disabled, meanpath delay is zero) */
 	} else if (ptpClock->portDS.delayMechanism == E2E ||
 	    ptpClock->portDS.delayMechanism == DELAY_DISABLED ) {
-
-		subTime(&ptpClock->currentDS.offsetFromMaster,
-			&ptpClock->delayMS,
-			&ptpClock->currentDS.meanPathDelay);
+		offset = scaledSub(offset, timeInternalToScaled(&ptpClock->currentDS.meanPathDelay));
 	}
+	scaledToTimeInternal(offset, &ptpClock->currentDS.offsetFromMaster);
 
 	if (ptpClock->currentDS.offsetFromMaster.seconds) {
 		/* cannot filter with secs, clear filter */
@@ -595,10 +591,8 @@ updateOffset(TimeInternal * send_time, TimeInternal * recv_time,
 	}
 
 	/* filter 'offsetFromMaster' */
-	ofm_filt->y = ptpClock->currentDS.offsetFromMaster.nanoseconds / 2 +
-		ofm_filt->nsec_prev / 2;
-	ofm_filt->nsec_prev = ptpClock->currentDS.offsetFromMaster.nanoseconds;
-	ptpClock->currentDS.offsetFromMaster.nanoseconds = ofm_filt->y;
+	ptpClock->currentDS.offsetFromMaster.nanoseconds =
+		filterOffsetFromMaster(ofm_filt, ptpClock->currentDS.offsetFromMaster.nanoseconds);
 
 	/* Apply the offset shift */
 	addTime(&ptpClock->currentDS.offsetFromMaster, &ptpClock->currentDS.offsetFromMaster,
@@ -615,7 +609,7 @@ updateOffset(TimeInternal * send_time, TimeInternal * recv_time,
 
 	if(!ptpClock->oFilterMS.lastOutlier) {
             feedDoublePermanentStdDev(&ptpClock->slaveStats.ofmStats, timeInternalToDouble(&ptpClock->currentDS.offsetFromMaster));
-            feedDoublePermanentMedian(&ptpClock->slaveStats.ofmMedianContainer, timeInternalToDouble(&ptpClock->currentDS.offsetFromMaster));
+            feedDoublePermanentPercentiles(&ptpClock->slaveStats.ofmPercentiles, timeInternalToDouble(&ptpClock->currentDS.offsetFromMaster));
 		if(!ptpClock->slaveStats.ofmStatsUpdated) {
 			if(timeInternalToDouble(&ptpClock->currentDS.offsetFromMaster) != 0.0){
 			ptpClock->slaveStats.ofmMax = timeInternalToDouble(&ptpClock->currentDS.offsetFromMaster);
@@ -626,8 +620,21 @@ updateOffset(TimeInternal * send_time, TimeInternal * recv_time,
 		    ptpClock->slaveStats.ofmMax = max(ptpClock->slaveStats.ofmMax, timeInternalToDouble(&ptpClock->currentDS.offsetFromMaster));
 		    ptpClock->slaveStats.ofmMin = min(ptpClock->slaveStats.ofmMin, timeInternalToDouble(&ptpClock->currentDS.offsetFromMaster));
 		}
+		/* stability only means something once the servo has converged */
+		if(ptpClock->stability != NULL &&
+		    (rtOpts->noAdjust || ptpClock->clockDriver->state == CS_LOCKED)) {
+			if(ptpClock->stability->tau0 != ptpClock->dT) {
+			    resetPhaseStability(ptpClock->stability, ptpClock->dT);
+			}
+			feedPhaseStability(ptpClock->stability, timeInternalToDouble(&ptpClock->currentDS.offsetFromMaster));
+		}
 	}
 finish:
+	writeTelemetry(&rtOpts->telemetry, TELEMETRY_OFFSET, ptpClock->recvSyncSequenceId,
+		send_time, recv_time,
+		&ptpClock->delay_req_send_time, &ptpClock->delay_req_receive_time,
+		&correctionField, ptpClock);
+
 	logStatistics(ptpClock);
 
 	DBGV("\n--Offset Correction-- \n");
@@ -800,37 +807,46 @@ void
 updatePtpEngineStats (PtpClock* ptpClock, const RunTimeOpts* rtOpts)
 {
 
+	int i;
+
 	DBG("Refreshing slave engine stats counters\n");
 	
 		DBG("samples used: %d/%d = %.03f\n", ptpClock->acceptedUpdates, ptpClock->offsetUpdates, (ptpClock->acceptedUpdates + 0.0) / (ptpClock->offsetUpdates + 0.0));
 
 	ptpClock->slaveStats.mpdMean = ptpClock->slaveStats.mpdStats.meanContainer.mean;
 	ptpClock->slaveStats.mpdStdDev = ptpClock->slaveStats.mpdStats.stdDev;
-	ptpClock->slaveStats.mpdMedian = ptpClock->slaveStats.mpdMedianContainer.median;
 	ptpClock->slaveStats.mpdMinFinal = ptpClock->slaveStats.mpdMin;
 	ptpClock->slaveStats.mpdMaxFinal = ptpClock->slaveStats.mpdMax;
 	ptpClock->slaveStats.ofmMean = ptpClock->slaveStats.ofmStats.meanContainer.mean;
 	ptpClock->slaveStats.ofmStdDev = ptpClock->slaveStats.ofmStats.stdDev;
-	ptpClock->slaveStats.ofmMedian = ptpClock->slaveStats.ofmMedianContainer.median;
 	ptpClock->slaveStats.ofmMinFinal = ptpClock->slaveStats.ofmMin;
 	ptpClock->slaveStats.ofmMaxFinal = ptpClock->slaveStats.ofmMax;
 
+	for(i = 0; i < STAT_PERCENTILE_COUNT; i++) {
+		ptpClock->slaveStats.mpdPercentile[i] = getDoublePermanentPercentile(&ptpClock->slaveStats.mpdPercentiles, i);
+		ptpClock->slaveStats.ofmPercentile[i] = getDoublePermanentPercentile(&ptpClock->slaveStats.ofmPercentiles, i);
+	}
+	ptpClock->slaveStats.mpdMedian = ptpClock->slaveStats.mpdPercentile[0];
+	ptpClock->slaveStats.ofmMedian = ptpClock->slaveStats.ofmPercentile[0];
+
 	ptpClock->slaveStats.statsCalculated = TRUE;
 	ptpClock->slaveStats.windowNumber++;
 
+	statPhaseStability(ptpClock->stability);
+
 	resetDoublePermanentMean(&ptpClock->oFilterMS.acceptedStats);
 	resetDoublePermanentMean(&ptpClock->oFilterSM.acceptedStats);
 
 	if(ptpClock->slaveStats.mpdStats.meanContainer.count >= 10.0) {
 		resetDoublePermanentStdDev(&ptpClock->slaveStats.mpdStats);
-		resetDoublePermanentMedian(&ptpClock->slaveStats.mpdMedianContainer);
+		resetDoublePermanentPercentiles(&ptpClock->slaveStats.mpdPercentiles);
 		ptpClock->slaveStats.ofmStatsUpdated = FALSE;
 		ptpClock->slaveStats.mpdStatsUpdated = FALSE;
 	}
 
 	if(ptpClock->slaveStats.ofmStats.meanContainer.count >= 10.0) {
 		resetDoublePermanentStdDev(&ptpClock->slaveStats.ofmStats);
-		resetDoublePermanentMedian(&ptpClock->slaveStats.ofmMedianContainer);
+		resetDoublePermanentPercentiles(&ptpClock->slaveStats.ofmPercentiles);
 	}
 
 	ptpClock->offsetUpdates = 0;
@@ -0,0 +1,155 @@
+/*-
+ * Copyright (c) 2026      PTPd contributors,
+ * Copyright (c) 2012-2015 Wojciech Owczarek,
+ * Copyright (c) 2011-2012 George V. Neville-Neil,
+ *                         Steven Kreuzer,
+ *                         Martin Burnicki,
+ *                         Jan Breuer,
+ *                         Gael Mace,
+ *                         Alexandre Van Kempen,
+ *                         Inaqui Delgado,
+ *                         Rick Ratzel,
+ *                         National Instruments.
+ * Copyright (c) 2009-2010 George V. Neville-Neil,
+ *                         Steven Kreuzer,
+ *                         Martin Burnicki,
+ *                         Jan Breuer,
+ *                         Gael Mace,
+ *                         Alexandre Van Kempen
+ *
+ * Copyright (c) 2005-2008 Kendall Correll, Aidan Williams
+ *
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file   servoarith.c
+ * @date   Sun Oct 18 09:16:19 2026
+ *
+ * @brief  Offset and delay arithmetic of the clock servo
+ *
+ * The parts of servo.c which only do arithmetic: the mean path delay
+ * and the offset and delay filters. They take no PtpClock or RunTimeOpts,
+ * so ptpd-sim links this file and runs the same code as the daemon.
+ * The code was moved here from servo.c, hence its copyright holders.
+ */
+
+#include "../ptpd.h"
+
+/* crank down the delay filter cutoff by increasing s_exp, keeping y from overflowing */
+static void
+stiffenDelayFilter(one_way_delay_filter *mpdIirFilter, Integer16 s)
+{
+
+	/* avoid overflowing filter */
+	while (abs(mpdIirFilter->y) >> (31 - s))
+		--s;
+
+	/* crank down filter cutoff by increasing 's_exp' */
+	if (mpdIirFilter->s_exp < 1)
+		mpdIirFilter->s_exp = 1;
+	else if (mpdIirFilter->s_exp < 1 << s)
+		++mpdIirFilter->s_exp;
+	else if (mpdIirFilter->s_exp > 1 << s)
+		mpdIirFilter->s_exp = 1 << s;
+
+}
+
+/**
+ * \brief Mean path delay: half the round trip, correctionField taken out.
+ * E2E: delayMS and delaySM, P2P two-step: the Pdelay_Resp and Pdelay_Req
+ * delays, P2P one-step: the turnaround time and zero. A correctionField
+ * big enough to overflow saturates, and the result is then rejected as
+ * over a second
+ */
+ScaledNanoseconds
+calcMeanPathDelay(ScaledNanoseconds delayMS, ScaledNanoseconds delaySM, ScaledNanoseconds correction)
+{
+	return scaledSub(scaledAdd(delayMS, delaySM), correction) / 2;
+}
+
+/**
+ * \brief Master to slave delay with the correctionField taken out, saturated
+ */
+ScaledNanoseconds
+correctedDelay(ScaledNanoseconds delay, ScaledNanoseconds correction)
+{
+	return scaledSub(delay, correction);
+}
+
+/**
+ * \brief Two-sample average of the offset from master, in nanoseconds
+ */
+Integer32
+filterOffsetFromMaster(offset_from_master_filter *ofm_filt, Integer32 offset)
+{
+
+	ofm_filt->y = offset / 2 + ofm_filt->nsec_prev / 2;
+	ofm_filt->nsec_prev = offset;
+
+	return ofm_filt->y;
+
+}
+
+/**
+ * \brief E2E mean path delay filter, rounded to the nearest nanosecond
+ */
+Integer32
+filterMeanPathDelay(one_way_delay_filter *mpdIirFilter, Integer32 delay, Integer16 s)
+{
+
+	double fy;
+
+	stiffenDelayFilter(mpdIirFilter, s);
+
+	fy = (double)((mpdIirFilter->s_exp - 1.0) *
+		mpdIirFilter->y / (mpdIirFilter->s_exp + 0.0) +
+		(delay / 2.0 + mpdIirFilter->nsec_prev / 2.0) /
+		(mpdIirFilter->s_exp + 0.0));
+
+	mpdIirFilter->nsec_prev = delay;
+	mpdIirFilter->y = round(fy);
+
+	return mpdIirFilter->y;
+
+}
+
+/**
+ * \brief P2P mean path delay filter, in integer arithmetic
+ */
+Integer32
+filterPeerMeanPathDelay(one_way_delay_filter *mpdIirFilter, Integer32 delay, Integer16 s)
+{
+
+	stiffenDelayFilter(mpdIirFilter, s);
+
+	mpdIirFilter->y = (mpdIirFilter->s_exp - 1) *
+		mpdIirFilter->y / mpdIirFilter->s_exp +
+		(delay / 2 + mpdIirFilter->nsec_prev / 2) / mpdIirFilter->s_exp;
+
+	mpdIirFilter->nsec_prev = delay;
+
+	return mpdIirFilter->y;
+
+}
@@ -200,6 +200,12 @@ enum {
     PTPBASE_SLAVE_OFM_STATS_MEAN_STRING,
     PTPBASE_SLAVE_OFM_STATS_STDDEV_STRING,
     PTPBASE_SLAVE_OFM_STATS_MEDIAN_STRING,
+    PTPBASE_SLAVE_OFM_STATS_P90,
+    PTPBASE_SLAVE_OFM_STATS_P99,
+    PTPBASE_SLAVE_OFM_STATS_P999,
+    PTPBASE_SLAVE_OFM_STATS_P90_STRING,
+    PTPBASE_SLAVE_OFM_STATS_P99_STRING,
+    PTPBASE_SLAVE_OFM_STATS_P999_STRING,
     /* ptpBaseSlaveMpdStatistics */
     PTPBASE_SLAVE_MPD_STATS_CURRENT_VALUE,
     PTPBASE_SLAVE_MPD_STATS_CURRENT_VALUE_STRING,
@@ -215,6 +221,12 @@ enum {
     PTPBASE_SLAVE_MPD_STATS_MEAN_STRING,
     PTPBASE_SLAVE_MPD_STATS_STDDEV_STRING,
     PTPBASE_SLAVE_MPD_STATS_MEDIAN_STRING,
+    PTPBASE_SLAVE_MPD_STATS_P90,
+    PTPBASE_SLAVE_MPD_STATS_P99,
+    PTPBASE_SLAVE_MPD_STATS_P999,
+    PTPBASE_SLAVE_MPD_STATS_P90_STRING,
+    PTPBASE_SLAVE_MPD_STATS_P99_STRING,
+    PTPBASE_SLAVE_MPD_STATS_P999_STRING,
     /* ptpBaseSlaveFreqAdjStatistics */
     PTPBASE_SLAVE_FREQADJ_STATS_CURRENT_VALUE,
     PTPBASE_SLAVE_FREQADJ_STATS_PERIOD_SECONDS,
@@ -235,7 +247,14 @@ enum {
     PTPBASE_PTPD_SPECIFIC_DATA_RAW_DELAYMS,
     PTPBASE_PTPD_SPECIFIC_DATA_RAW_DELAYMS_STRING,
     PTPBASE_PTPD_SPECIFIC_DATA_RAW_DELAYSM,
-    PTPBASE_PTPD_SPECIFIC_DATA_RAW_DELAYSM_STRING
+    PTPBASE_PTPD_SPECIFIC_DATA_RAW_DELAYSM_STRING,
+    /* ptpBaseSlaveStability */
+    PTPBASE_SLAVE_STABILITY_VALID,
+    PTPBASE_SLAVE_STABILITY_MTIE,
+    PTPBASE_SLAVE_STABILITY_MTIE_STRING,
+    PTPBASE_SLAVE_STABILITY_TDEV,
+    PTPBASE_SLAVE_STABILITY_TDEV_STRING,
+    PTPBASE_SLAVE_STABILITY_ADEV_STRING
 };
 
 /* trap / notification definitions */
@@ -1192,6 +1211,21 @@ snmpSlaveOfmStatsTable(SNMP_SIGNATURE) {
 	case PTPBASE_SLAVE_OFM_STATS_MEDIAN_STRING:
 		snprintf(tmpStr, 64, "%.09f", snmpPtpClock->slaveStats.ofmMedian);
 		return SNMP_OCTETSTR(&tmpStr, strlen(tmpStr));
+	case PTPBASE_SLAVE_OFM_STATS_P90:
+		return SNMP_TIMEINTERNAL(doubleToTimeInternal(snmpPtpClock->slaveStats.ofmPercentile[1]));
+	case PTPBASE_SLAVE_OFM_STATS_P99:
+		return SNMP_TIMEINTERNAL(doubleToTimeInternal(snmpPtpClock->slaveStats.ofmPercentile[2]));
+	case PTPBASE_SLAVE_OFM_STATS_P999:
+		return SNMP_TIMEINTERNAL(doubleToTimeInternal(snmpPtpClock->slaveStats.ofmPercentile[3]));
+	case PTPBASE_SLAVE_OFM_STATS_P90_STRING:
+		snprintf(tmpStr, 64, "%.09f", snmpPtpClock->slaveStats.ofmPercentile[1]);
+		return SNMP_OCTETSTR(&tmpStr, strlen(tmpStr));
+	case PTPBASE_SLAVE_OFM_STATS_P99_STRING:
+		snprintf(tmpStr, 64, "%.09f", snmpPtpClock->slaveStats.ofmPercentile[2]);
+		return SNMP_OCTETSTR(&tmpStr, strlen(tmpStr));
+	case PTPBASE_SLAVE_OFM_STATS_P999_STRING:
+		snprintf(tmpStr, 64, "%.09f", snmpPtpClock->slaveStats.ofmPercentile[3]);
+		return SNMP_OCTETSTR(&tmpStr, strlen(tmpStr));
 	}
 
 	return NULL;
@@ -1251,6 +1285,21 @@ snmpSlaveMpdStatsTable(SNMP_SIGNATURE) {
 	case PTPBASE_SLAVE_MPD_STATS_MEDIAN_STRING:
 		snprintf(tmpStr, 64, "%.09f", snmpPtpClock->slaveStats.mpdMedian);
 		return SNMP_OCTETSTR(&tmpStr, strlen(tmpStr));
+	case PTPBASE_SLAVE_MPD_STATS_P90:
+		return SNMP_TIMEINTERNAL(doubleToTimeInternal(snmpPtpClock->slaveStats.mpdPercentile[1]));
+	case PTPBASE_SLAVE_MPD_STATS_P99:
+		return SNMP_TIMEINTERNAL(doubleToTimeInternal(snmpPtpClock->slaveStats.mpdPercentile[2]));
+	case PTPBASE_SLAVE_MPD_STATS_P999:
+		return SNMP_TIMEINTERNAL(doubleToTimeInternal(snmpPtpClock->slaveStats.mpdPercentile[3]));
+	case PTPBASE_SLAVE_MPD_STATS_P90_STRING:
+		snprintf(tmpStr, 64, "%.09f", snmpPtpClock->slaveStats.mpdPercentile[1]);
+		return SNMP_OCTETSTR(&tmpStr, strlen(tmpStr));
+	case PTPBASE_SLAVE_MPD_STATS_P99_STRING:
+		snprintf(tmpStr, 64, "%.09f", snmpPtpClock->slaveStats.mpdPercentile[2]);
+		return SNMP_OCTETSTR(&tmpStr, strlen(tmpStr));
+	case PTPBASE_SLAVE_MPD_STATS_P999_STRING:
+		snprintf(tmpStr, 64, "%.09f", snmpPtpClock->slaveStats.mpdPercentile[3]);
+		return SNMP_OCTETSTR(&tmpStr, strlen(tmpStr));
 	}
 
 	return NULL;
@@ -1373,6 +1422,57 @@ snmpPtpdSpecificDataTable(SNMP_SIGNATURE) {
 	return NULL;
 }
 
+/**
+ * Handle ptpBaseSlaveStability
+ */
+static u_char*
+snmpSlaveStabilityTable(SNMP_SIGNATURE) {
+	oid index[4];
+	int i;
+	PhaseStabilityInterval *interval;
+	TimeInternal tmpTime;
+	SNMP_LOCAL_VARIABLES;
+	SNMP_INDEXED_TABLE;
+
+	if(snmpPtpClock->stability == NULL) return NULL;
+
+	memset(tmpStr, 0, sizeof(tmpStr));
+
+	/* One entry per observation interval */
+	index[0] = snmpPtpClock->defaultDS.domainNumber;
+	index[1] = SNMP_PTP_ORDINARY_CLOCK;
+	index[2] = SNMP_PTP_CLOCK_INSTANCE;
+	for(i = 0; i < snmpPtpClock->stability->intervalCount; i++) {
+		index[3] = snmpPtpClock->stability->interval[i].tau;
+		SNMP_ADD_INDEX(index, 4, &snmpPtpClock->stability->interval[i]);
+	}
+
+	interval = SNMP_BEST_MATCH;
+	if (interval == NULL) return NULL;
+
+	switch (vp->magic) {
+	    case PTPBASE_SLAVE_STABILITY_VALID:
+		return SNMP_BOOLEAN(interval->valid);
+	    case PTPBASE_SLAVE_STABILITY_MTIE:
+		tmpTime = doubleToTimeInternal(interval->mtie);
+		return SNMP_TIMEINTERNAL(tmpTime);
+	    case PTPBASE_SLAVE_STABILITY_MTIE_STRING:
+		snprintf(tmpStr, 64, "%.09f", interval->mtie);
+		return SNMP_OCTETSTR(&tmpStr, strlen(tmpStr));
+	    case PTPBASE_SLAVE_STABILITY_TDEV:
+		tmpTime = doubleToTimeInternal(interval->tdev);
+		return SNMP_TIMEINTERNAL(tmpTime);
+	    case PTPBASE_SLAVE_STABILITY_TDEV_STRING:
+		snprintf(tmpStr, 64, "%.09f", interval->tdev);
+		return SNMP_OCTETSTR(&tmpStr, strlen(tmpStr));
+	    case PTPBASE_SLAVE_STABILITY_ADEV_STRING:
+		snprintf(tmpStr, 64, "%.03e", interval->adev);
+		return SNMP_OCTETSTR(&tmpStr, strlen(tmpStr));
+	}
+
+	return NULL;
+}
+
 
 
 /**
@@ -1677,6 +1777,18 @@ static struct variable7 snmpVariables[] = {
 	  snmpSlaveOfmStatsTable, 5, {1, 2, 18, 1, 16}},
 	{ PTPBASE_SLAVE_OFM_STATS_MEDIAN_STRING, ASN_OCTET_STR, HANDLER_CAN_RONLY,
 	  snmpSlaveOfmStatsTable, 5, {1, 2, 18, 1, 17}},
+	{ PTPBASE_SLAVE_OFM_STATS_P90, ASN_OCTET_STR, HANDLER_CAN_RONLY,
+	  snmpSlaveOfmStatsTable, 5, {1, 2, 18, 1, 18}},
+	{ PTPBASE_SLAVE_OFM_STATS_P99, ASN_OCTET_STR, HANDLER_CAN_RONLY,
+	  snmpSlaveOfmStatsTable, 5, {1, 2, 18, 1, 19}},
+	{ PTPBASE_SLAVE_OFM_STATS_P999, ASN_OCTET_STR, HANDLER_CAN_RONLY,
+	  snmpSlaveOfmStatsTable, 5, {1, 2, 18, 1, 20}},
+	{ PTPBASE_SLAVE_OFM_STATS_P90_STRING, ASN_OCTET_STR, HANDLER_CAN_RONLY,
+	  snmpSlaveOfmStatsTable, 5, {1, 2, 18, 1, 21}},
+	{ PTPBASE_SLAVE_OFM_STATS_P99_STRING, ASN_OCTET_STR, HANDLER_CAN_RONLY,
+	  snmpSlaveOfmStatsTable, 5, {1, 2, 18, 1, 22}},
+	{ PTPBASE_SLAVE_OFM_STATS_P999_STRING, ASN_OCTET_STR, HANDLER_CAN_RONLY,
+	  snmpSlaveOfmStatsTable, 5, {1, 2, 18, 1, 23}},
 	/* ptpBaseSlaveMpdStatistics */
 	{ PTPBASE_SLAVE_MPD_STATS_CURRENT_VALUE, ASN_OCTET_STR, HANDLER_CAN_RONLY,
 	  snmpSlaveMpdStatsTable, 5, {1, 2, 19, 1, 4}},
@@ -1706,6 +1818,18 @@ static struct variable7 snmpVariables[] = {
 	  snmpSlaveMpdStatsTable, 5, {1, 2, 19, 1, 16}},
 	{ PTPBASE_SLAVE_MPD_STATS_MEDIAN_STRING, ASN_OCTET_STR, HANDLER_CAN_RONLY,
 	  snmpSlaveMpdStatsTable, 5, {1, 2, 19, 1, 17}},
+	{ PTPBASE_SLAVE_MPD_STATS_P90, ASN_OCTET_STR, HANDLER_CAN_RONLY,
+	  snmpSlaveMpdStatsTable, 5, {1, 2, 19, 1, 18}},
+	{ PTPBASE_SLAVE_MPD_STATS_P99, ASN_OCTET_STR, HANDLER_CAN_RONLY,
+	  snmpSlaveMpdStatsTable, 5, {1, 2, 19, 1, 19}},
+	{ PTPBASE_SLAVE_MPD_STATS_P999, ASN_OCTET_STR, HANDLER_CAN_RONLY,
+	  snmpSlaveMpdStatsTable, 5, {1, 2, 19, 1, 20}},
+	{ PTPBASE_SLAVE_MPD_STATS_P90_STRING, ASN_OCTET_STR, HANDLER_CAN_RONLY,
+	  snmpSlaveMpdStatsTable, 5, {1, 2, 19, 1, 21}},
+	{ PTPBASE_SLAVE_MPD_STATS_P99_STRING, ASN_OCTET_STR, HANDLER_CAN_RONLY,
+	  snmpSlaveMpdStatsTable, 5, {1, 2, 19, 1, 22}},
+	{ PTPBASE_SLAVE_MPD_STATS_P999_STRING, ASN_OCTET_STR, HANDLER_CAN_RONLY,
+	  snmpSlaveMpdStatsTable, 5, {1, 2, 19, 1, 23}},
 	/* ptpBaseSlaveFreqAdjStatistics */
 	{ PTPBASE_SLAVE_FREQADJ_STATS_CURRENT_VALUE, ASN_INTEGER, HANDLER_CAN_RONLY,
 	  snmpSlaveFreqAdjStatsTable, 5, {1, 2, 20, 1, 4}},
@@ -1744,7 +1868,20 @@ static struct variable7 snmpVariables[] = {
 	{ PTPBASE_PTPD_SPECIFIC_DATA_RAW_DELAYSM, ASN_OCTET_STR, HANDLER_CAN_RONLY,
 	  snmpPtpdSpecificDataTable, 5, {1, 2, 22, 1, 6}},
 	{ PTPBASE_PTPD_SPECIFIC_DATA_RAW_DELAYSM_STRING, ASN_OCTET_STR, HANDLER_CAN_RONLY,
-	  snmpPtpdSpecificDataTable, 5, {1, 2, 22, 1, 7}}
+	  snmpPtpdSpecificDataTable, 5, {1, 2, 22, 1, 7}},
+	/* ptpBaseSlaveStability */
+	{ PTPBASE_SLAVE_STABILITY_VALID, ASN_INTEGER, HANDLER_CAN_RONLY,
+	  snmpSlaveStabilityTable, 5, {1, 2, 23, 1, 5}},
+	{ PTPBASE_SLAVE_STABILITY_MTIE, ASN_OCTET_STR, HANDLER_CAN_RONLY,
+	  snmpSlaveStabilityTable, 5, {1, 2, 23, 1, 6}},
+	{ PTPBASE_SLAVE_STABILITY_MTIE_STRING, ASN_OCTET_STR, HANDLER_CAN_RONLY,
+	  snmpSlaveStabilityTable, 5, {1, 2, 23, 1, 7}},
+	{ PTPBASE_SLAVE_STABILITY_TDEV, ASN_OCTET_STR, HANDLER_CAN_RONLY,
+	  snmpSlaveStabilityTable, 5, {1, 2, 23, 1, 8}},
+	{ PTPBASE_SLAVE_STABILITY_TDEV_STRING, ASN_OCTET_STR, HANDLER_CAN_RONLY,
+	  snmpSlaveStabilityTable, 5, {1, 2, 23, 1, 9}},
+	{ PTPBASE_SLAVE_STABILITY_ADEV_STRING, ASN_OCTET_STR, HANDLER_CAN_RONLY,
+	  snmpSlaveStabilityTable, 5, {1, 2, 23, 1, 10}}
 };
 
 /**
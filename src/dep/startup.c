@@ -293,6 +293,7 @@ do_signal_sighup(RunTimeOpts * rtOpts, PtpClock * ptpClock)
 
 	if(rtOpts->recordLog.logEnabled ||
 	    rtOpts->eventLog.logEnabled ||
+	    rtOpts->captureLog.logEnabled ||
 	    (rtOpts->statisticsLog.logEnabled))
 		INFO("Reopening log files\n");
 
@@ -301,6 +302,9 @@ do_signal_sighup(RunTimeOpts * rtOpts, PtpClock * ptpClock)
 	if(rtOpts->statisticsLog.logEnabled)
 		ptpClock->resetStatisticsLog = TRUE;
 
+	if(rtOpts->captureLog.logEnabled)
+		ptpClock->resetCaptureLog = TRUE;
+
 
 }
 
@@ -389,6 +393,9 @@ restartSubsystems(RunTimeOpts *rtOpts, PtpClock *ptpClock)
 					ptpClock->filterSM = createDoubleMovingStatFilter(&rtOpts->filterSMOpts, "delaySM");
 				}
 
+				freePhaseStability(&ptpClock->stability);
+				ptpClock->stability = createPhaseStability(rtOpts->stabilityIntervals);
+
 		    }
 
 	    ptpClock->timingService.reloadRequested = TRUE;
@@ -588,6 +595,8 @@ ptpdShutdown(PtpClock * ptpClock)
 	netShutdown(&ptpClock->netPath, ptpClock);
 	shutdownClockDrivers();
 	free(ptpClock->foreign);
+	free(ptpClock->foreignIndex);
+	freeUnicastGrants(ptpClock);
 
 	/* free management and signaling messages, they can have dynamic memory allocated */
 	if(ptpClock->msgTmpHeader.messageType == MANAGEMENT)
@@ -605,6 +614,7 @@ ptpdShutdown(PtpClock * ptpClock)
 	ptpClock->oFilterSM.shutdown(&ptpClock->oFilterSM);
         freeDoubleMovingStatFilter(&ptpClock->filterMS);
         freeDoubleMovingStatFilter(&ptpClock->filterSM);
+	freePhaseStability(&ptpClock->stability);
 
 	if (rtOpts.currentConfig != NULL)
 		dictionary_del(&rtOpts.currentConfig);
@@ -626,6 +636,9 @@ ptpdShutdown(PtpClock * ptpClock)
 	}
 	unlink(rtOpts.lockFile);
 
+	/* write out everything still queued and stop the housekeeping thread */
+	stopHousekeeping();
+
 	if(rtOpts.statusLog.logEnabled) {
 		/* close and remove the status file */
 		if(rtOpts.statusLog.logFP != NULL) {
@@ -835,11 +848,23 @@ configcheck:
 			    (int)(rtOpts->max_foreign_records *
 				  sizeof(ForeignMasterRecord)));
 		}
+
+		if (!allocUnicastGrants(rtOpts, ptpClock)) {
+			PERROR("failed to allocate memory for unicast "
+			       "grant table");
+			*ret = 2;
+			free(ptpClock->foreign);
+			free(ptpClock);
+			goto fail;
+		}
 	}
 
 	if(rtOpts->statisticsLog.logEnabled)
 		ptpClock->resetStatisticsLog = TRUE;
 
+	if(rtOpts->captureLog.logEnabled)
+		ptpClock->resetCaptureLog = TRUE;
+
 	/* Init to 0 net buffer */
 	memset(ptpClock->msgIbuf, 0, PACKET_SIZE);
 	memset(ptpClock->msgObuf, 0, PACKET_SIZE);
@@ -890,6 +915,17 @@ configcheck:
 		}
 	}
 
+	/*
+	 * Start the housekeeping thread before binding to a CPU core and raising
+	 * our priority, so that it inherits neither: it is the protocol thread
+	 * that gets the core and the real-time priority.
+	 */
+	if(rtOpts->housekeepingThread) {
+		if(!startHousekeeping()) {
+			WARNING("Could not start housekeeping thread - log and status output will be written synchronously\n");
+		}
+	}
+
 #if (defined(linux) && defined(HAVE_SCHED_H)) || defined(HAVE_SYS_CPUSET_H) || defined(__QNXNTO__)
 	/* Try binding to a single CPU core if configured to do so */
 	if(rtOpts->cpuNumber > -1) {
@@ -901,6 +937,14 @@ configcheck:
 	}
 #endif
 
+	if(rtOpts->rtPriority > 0) {
+		if(setRealtimePriority(rtOpts->rtPriority) < 0) {
+		    PERROR("Could not set real-time priority %d", rtOpts->rtPriority);
+		} else {
+		    INFO("Running with SCHED_FIFO real-time priority %d\n", rtOpts->rtPriority);
+		}
+	}
+
 	/* set up timers */
 	if(!timerSetup(ptpClock->timers)) {
 		PERROR("failed to set up event timers");
@@ -940,6 +984,7 @@ configcheck:
 			    (getPtpPreset(rtOpts->selectedPreset,rtOpts)).presetName,
 			    getpid());
 	ptpClock->resetStatisticsLog = TRUE;
+	ptpClock->resetCaptureLog = TRUE;
 
 	outlierFilterSetup(&ptpClock->oFilterMS);
 	outlierFilterSetup(&ptpClock->oFilterSM);
@@ -955,6 +1000,8 @@ configcheck:
 		ptpClock->filterSM = createDoubleMovingStatFilter(&rtOpts->filterSMOpts, "delaySM");
 	}
 
+	ptpClock->stability = createPhaseStability(rtOpts->stabilityIntervals);
+
 #ifdef PTPD_PCAP
 		ptpClock->netPath.pcapEventSock = -1;
 		ptpClock->netPath.pcapGeneralSock = -1;
@@ -962,6 +1009,7 @@ configcheck:
 
 		ptpClock->netPath.generalSock = -1;
 		ptpClock->netPath.eventSock = -1;
+		ptpClock->netPath.linkSock = -1;
 
 	*ret = 0;
 	return ptpClock;
@@ -43,30 +43,6 @@ static int cmpInt32 (const void *vA, const void *vB) {
 	return ((a < b) ? -1 : (a > b) ? 1 : 0);
 }
 
-static int cmpDouble (const void *vA, const void *vB) {
-
-	double a = *(double*)vA;
-	double b = *(double*)vB;
-
-	return ((a < b) ? -1 : (a > b) ? 1 : 0);
-}
-
-static int cmpAbsInt32 (const void *vA, const void *vB) {
-
-	int32_t a = labs(*(int32_t*)vA);
-	int32_t b = labs(*(int32_t*)vB);
-
-	return ((a < b) ? -1 : (a > b) ? 1 : 0);
-}
-
-static int cmpAbsDouble (const void *vA, const void *vB) {
-
-	double a = fabs(*(double*)vA);
-	double b = fabs(*(double*)vB);
-
-	return ((a < b) ? -1 : (a > b) ? 1 : 0);
-}
-
 static int32_t median3Int(int32_t *bucket, int count)
 {
 
@@ -338,6 +314,336 @@ feedDoublePermanentMedian(DoublePermanentMedian* container, double sample)
 
 }
 
+static const double statPercentiles[STAT_PERCENTILE_COUNT] = STAT_PERCENTILES;
+
+void
+resetDoublePermanentPercentiles(DoublePermanentPercentiles* container)
+{
+
+	memset(container, 0, sizeof(DoublePermanentPercentiles));
+
+}
+
+/* P-square: markers start at the sorted initial samples, spaced as the quantile wants */
+static void
+initDoublePermanentQuantile(DoublePermanentQuantile *q, double p, const double *initial, int count)
+{
+
+	const double spacing[5] = { 0.0, p / 2.0, p, (1.0 + p) / 2.0, 1.0 };
+	int i;
+
+	for(i = 0; i < 5; i++) {
+	    q->desired[i] = (count - 1) * spacing[i];
+	    /* strictly increasing, leaving room for the markers above */
+	    q->position[i] = max((i > 0) ? q->position[i - 1] + 1 : 0,
+				 min((int)lround(q->desired[i]), count - 5 + i));
+	    q->height[i] = initial[q->position[i]];
+	}
+
+}
+
+/* P-square: sample already bracketed into cell k, adjust the three middle markers */
+static void
+updateDoublePermanentQuantile(DoublePermanentQuantile *q, double p, int k)
+{
+
+	const double increment[5] = { 0.0, p / 2.0, p, (1.0 + p) / 2.0, 1.0 };
+	double *h = q->height;
+	int *n = q->position;
+	double d, hp;
+	int i, s;
+
+	for(i = k + 1; i < 5; i++) {
+	    n[i]++;
+	}
+
+	for(i = 0; i < 5; i++) {
+	    q->desired[i] += increment[i];
+	}
+
+	for(i = 1; i < 4; i++) {
+
+	    d = q->desired[i] - n[i];
+
+	    if((d >= 1.0 && n[i + 1] - n[i] > 1) || (d <= -1.0 && n[i - 1] - n[i] < -1)) {
+
+		s = (d > 0.0) ? 1 : -1;
+
+		/* piecewise-parabolic prediction, linear if it would break the ordering */
+		hp = h[i] + (double)s / (n[i + 1] - n[i - 1]) *
+			((n[i] - n[i - 1] + s) * (h[i + 1] - h[i]) / (n[i + 1] - n[i]) +
+			 (n[i + 1] - n[i] - s) * (h[i] - h[i - 1]) / (n[i] - n[i - 1]));
+
+		if(hp <= h[i - 1] || hp >= h[i + 1]) {
+		    hp = h[i] + s * (h[i + s] - h[i]) / (n[i + s] - n[i]);
+		}
+
+		h[i] = hp;
+		n[i] += s;
+
+	    }
+
+	}
+
+}
+
+void
+feedDoublePermanentPercentiles(DoublePermanentPercentiles* container, double sample)
+{
+
+	DoublePermanentQuantile *q;
+	int i, k;
+
+	/* insertion into the sorted initial samples */
+	if(container->count < STAT_PERCENTILE_EXACT) {
+	    for(i = container->count; i > 0 && container->initial[i - 1] > sample; i--) {
+		container->initial[i] = container->initial[i - 1];
+	    }
+	    container->initial[i] = sample;
+	    container->count++;
+	    if(container->count == STAT_PERCENTILE_EXACT) {
+		for(i = 0; i < STAT_PERCENTILE_COUNT; i++) {
+		    initDoublePermanentQuantile(&container->quantile[i], statPercentiles[i],
+			container->initial, container->count);
+		}
+	    }
+	    return;
+	}
+
+	container->count++;
+
+	for(i = 0; i < STAT_PERCENTILE_COUNT; i++) {
+
+	    q = &container->quantile[i];
+
+	    /* find the cell the sample falls into, extending the extremes */
+	    if(sample < q->height[0]) {
+		q->height[0] = sample;
+		k = 0;
+	    } else if(sample >= q->height[4]) {
+		q->height[4] = sample;
+		k = 3;
+	    } else {
+		for(k = 0; k < 3 && sample >= q->height[k + 1]; k++);
+	    }
+
+	    updateDoublePermanentQuantile(q, statPercentiles[i], k);
+
+	}
+
+}
+
+double
+getDoublePermanentPercentile(const DoublePermanentPercentiles* container, int index)
+{
+
+	int rank;
+
+	if(index < 0 || index >= STAT_PERCENTILE_COUNT || container->count == 0) {
+	    return 0.0;
+	}
+
+	if(container->count > STAT_PERCENTILE_EXACT) {
+	    return container->quantile[index].height[2];
+	}
+
+	/* still holding all samples - nearest rank */
+	rank = ceil(statPercentiles[index] * container->count) - 1;
+	return container->initial[max(0, min(rank, (int)container->count - 1))];
+
+}
+
+
+/*
+ * Sorted copies of the sliding window, maintained on every sample so that order
+ * statistics do not need a sort: the evicted sample is found by binary search and
+ * removed, the new sample is inserted at its binary-searched position.
+ */
+
+/* first position in sorted[] holding a value not less than value */
+static int
+intLowerBound(const int32_t *sorted, int count, int32_t value)
+{
+
+	int low = 0, high = count, mid;
+
+	while(low < high) {
+		mid = low + (high - low) / 2;
+		if(sorted[mid] < value) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+
+	return low;
+
+}
+
+static int
+doubleLowerBound(const double *sorted, int count, double value)
+{
+
+	int low = 0, high = count, mid;
+
+	while(low < high) {
+		mid = low + (high - low) / 2;
+		if(sorted[mid] < value) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+
+	return low;
+
+}
+
+/* drop evicted (if evict is set) and add sample - count is the number of samples before the update */
+static void
+updateSortedInt(int32_t *sorted, int count, Boolean evict, int32_t evicted, int32_t sample)
+{
+
+	int pos;
+
+	if(evict) {
+		pos = intLowerBound(sorted, count, evicted);
+		memmove(sorted + pos, sorted + pos + 1, (count - pos - 1) * sizeof(int32_t));
+		count--;
+	}
+
+	pos = intLowerBound(sorted, count, sample);
+	memmove(sorted + pos + 1, sorted + pos, (count - pos) * sizeof(int32_t));
+	sorted[pos] = sample;
+
+}
+
+static void
+updateSortedDouble(double *sorted, int count, Boolean evict, double evicted, double sample)
+{
+
+	int pos;
+
+	if(evict) {
+		pos = doubleLowerBound(sorted, count, evicted);
+		memmove(sorted + pos, sorted + pos + 1, (count - pos - 1) * sizeof(double));
+		count--;
+	}
+
+	pos = doubleLowerBound(sorted, count, sample);
+	memmove(sorted + pos + 1, sorted + pos, (count - pos) * sizeof(double));
+	sorted[pos] = sample;
+
+}
+
+/*
+ * k-th smallest (from 0) absolute deviation from median in a sorted window: the deviations
+ * below and above the median are two sorted runs walking outwards from it, so they are merged
+ * without building and sorting a deviation array.
+ */
+static int32_t
+intSortedDeviation(const int32_t *sorted, int count, int32_t median, int k)
+{
+
+	int below = intLowerBound(sorted, count, median) - 1;
+	int above = below + 1;
+	int32_t dev = 0;
+
+	for(; k >= 0; k--) {
+		if(above >= count || (below >= 0 &&
+		    labs(sorted[below] - median) <= labs(sorted[above] - median))) {
+			dev = labs(sorted[below--] - median);
+		} else {
+			dev = labs(sorted[above++] - median);
+		}
+	}
+
+	return dev;
+
+}
+
+static double
+doubleSortedDeviation(const double *sorted, int count, double median, int k)
+{
+
+	int below = doubleLowerBound(sorted, count, median) - 1;
+	int above = below + 1;
+	double dev = 0;
+
+	for(; k >= 0; k--) {
+		if(above >= count || (below >= 0 &&
+		    fabs(sorted[below] - median) <= fabs(sorted[above] - median))) {
+			dev = fabs(sorted[below--] - median);
+		} else {
+			dev = fabs(sorted[above++] - median);
+		}
+	}
+
+	return dev;
+
+}
+
+/* sample closest to zero in a sorted window - ties go to the negative one */
+static int32_t
+intSortedAbsMin(const int32_t *sorted, int count)
+{
+
+	int pos = intLowerBound(sorted, count, 0);
+
+	if(pos == count) {
+		return sorted[count - 1];
+	}
+
+	if(pos > 0 && labs(sorted[pos - 1]) <= labs(sorted[pos])) {
+		return sorted[pos - 1];
+	}
+
+	return sorted[pos];
+
+}
+
+static double
+doubleSortedAbsMin(const double *sorted, int count)
+{
+
+	int pos = doubleLowerBound(sorted, count, 0.0);
+
+	if(pos == count) {
+		return sorted[count - 1];
+	}
+
+	if(pos > 0 && fabs(sorted[pos - 1]) <= fabs(sorted[pos])) {
+		return sorted[pos - 1];
+	}
+
+	return sorted[pos];
+
+}
+
+static int32_t
+intSortedMedian(const int32_t *sorted, int count)
+{
+
+	if((count % 2) == 1) {
+		return sorted[count / 2];
+	}
+
+	return (sorted[(count / 2) - 1] + sorted[count / 2]) / 2;
+
+}
+
+static double
+doubleSortedMedian(const double *sorted, int count)
+{
+
+	if((count % 2) == 1) {
+		return sorted[count / 2];
+	}
+
+	return (sorted[(count / 2) - 1] + sorted[count / 2]) / 2;
+
+}
+
 
 /* Moving statistics - up to last n samples */
 
@@ -649,6 +955,13 @@ IntMovingStatFilter* createIntMovingStatFilter(StatFilterOptions *config, const
 		return NULL;
 	}
 
+	if((container->sortedSamples = calloc(container->meanContainer->capacity, sizeof(int32_t)))
+		== NULL) {
+		freeIntMovingMean(&container->meanContainer);
+		free(container);
+		return NULL;
+	}
+
 	container->config = *config;
 
 	if(config->windowSize < 2) container->config.windowType = WINDOW_SLIDING;
@@ -664,6 +977,7 @@ freeIntMovingStatFilter(IntMovingStatFilter** container)
 {
 
 	freeIntMovingMean(&((*container)->meanContainer));
+	free((*container)->sortedSamples);
 	free(*container);
 	*container = NULL;
 
@@ -688,6 +1002,8 @@ feedIntMovingStatFilter(IntMovingStatFilter* container, int32_t sample)
 		return 0;
 
 	int interval = container->meanContainer->capacity;
+	int count;
+	int32_t *sorted;
 
 	if(container->config.samplingInterval > 0) {
 	    interval = container->config.samplingInterval;
@@ -699,6 +1015,10 @@ feedIntMovingStatFilter(IntMovingStatFilter* container, int32_t sample)
 	    return TRUE;
 
 	} else {
+	    /* keep the sorted copy in step with the window: the oldest sample goes if it is full */
+	    updateSortedInt(container->sortedSamples, container->meanContainer->count,
+		container->meanContainer->count == container->meanContainer->capacity,
+		container->meanContainer->samples[0], sample);
 	    /* cheat - the mean container is used as a general purpose sliding window */
 	    feedIntMovingMean(container->meanContainer, sample);
 
@@ -708,6 +1028,9 @@ feedIntMovingStatFilter(IntMovingStatFilter* container, int32_t sample)
 
 	container->counter %= interval;
 
+	sorted = container->sortedSamples;
+	count = container->meanContainer->count;
+
 	switch(container->config.filterType) {
 
 	    case FILTER_MEAN:
@@ -716,70 +1039,23 @@ feedIntMovingStatFilter(IntMovingStatFilter* container, int32_t sample)
 		break;
 
 	    case FILTER_MEDIAN:
-		{
-		    int count = container->meanContainer->count;
-		    int32_t sortedSamples[count];
-
-		    Boolean odd = ((count %2 ) == 1);
-	
-		    memcpy(sortedSamples, container->meanContainer->samples, count * sizeof(sample));
-
-		    qsort(sortedSamples, count, sizeof(sample), cmpInt32);
-
-		    if(odd) {
-
-			    container->output = sortedSamples[(count / 2)];
-
-		    } else {
 
-			    container->output = (sortedSamples[(count / 2) -1] + sortedSamples[(count / 2)]) / 2;
-
-		    }
-
-		}
+		container->output = intSortedMedian(sorted, count);
 		break;
 
 	    case FILTER_MAD:
 		{
-		    int count = container->meanContainer->count;
-		    int32_t sortedSamples[count];
-		    int32_t median;
-		    int i;
-
-		    Boolean odd = ((count %2 ) == 1);
-	
-		    memcpy(sortedSamples, container->meanContainer->samples, count * sizeof(sample));
-
-		    qsort(sortedSamples, count, sizeof(sample), cmpInt32);
-
-		    /* compute median */
-
-		    if(odd) {
-
-			    median = sortedSamples[(count / 2)];
-
-		    } else {
-
-			    median = (sortedSamples[(count / 2) -1] + sortedSamples[(count / 2)]) / 2;
+		    int32_t median = intSortedMedian(sorted, count);
 
-		    }
-
-		    /* compute absolute deviations from median */
-		    for(i = 0; i < count; i++) {
-			sortedSamples[i] = labs(sortedSamples[i] - median);
-		    }
-
-		    /* compute median of the deviations */
-
-		    qsort(sortedSamples, count, sizeof(sample), cmpInt32);
-
-		    if(odd) {
+		    /* median of the absolute deviations from median */
+		    if((count % 2) == 1) {
 
-			    container->output = sortedSamples[(count / 2)] / 0.6745;
+			    container->output = intSortedDeviation(sorted, count, median, count / 2) / 0.6745;
 
 		    } else {
 
-			    container->output = ((sortedSamples[(count / 2) -1] + sortedSamples[(count / 2)]) / 2) / 0.6745;
+			    container->output = ((intSortedDeviation(sorted, count, median, (count / 2) - 1) +
+						intSortedDeviation(sorted, count, median, count / 2)) / 2) / 0.6745;
 
 		    }
 
@@ -787,48 +1063,26 @@ feedIntMovingStatFilter(IntMovingStatFilter* container, int32_t sample)
 		break;
 
 	    case FILTER_MIN:
-		{
-		    int count = container->meanContainer->count;
-		    int32_t sortedSamples[count];
-		    memcpy(sortedSamples, container->meanContainer->samples, count * sizeof(sample));
-		    qsort(sortedSamples, count, sizeof(sample), cmpInt32);
-		    container->output = sortedSamples[0];
 
-		}
+		container->output = sorted[0];
 		break;
 
 	    case FILTER_MAX:
-		{
-		    int count = container->meanContainer->count;
-		    int32_t sortedSamples[count];
-		    memcpy(sortedSamples, container->meanContainer->samples, count * sizeof(sample));
-		    qsort(sortedSamples, count, sizeof(sample), cmpInt32);
-		    container->output = sortedSamples[count - 1];
 
-		}
+		container->output = sorted[count - 1];
 		break;
 
 	    case FILTER_ABSMIN:
-		{
-		    int count = container->meanContainer->count;
-		    int32_t sortedSamples[count];
-		    memcpy(sortedSamples, container->meanContainer->samples, count * sizeof(sample));
-		    qsort(sortedSamples, count, sizeof(sample), cmpAbsInt32);
-		    container->output = sortedSamples[0];
 
-		}
+		container->output = intSortedAbsMin(sorted, count);
 		break;
 
 	    case FILTER_ABSMAX:
-		{
-		    int count = container->meanContainer->count;
-		    int32_t sortedSamples[count];
-		    memcpy(sortedSamples, container->meanContainer->samples, count * sizeof(sample));
-		    qsort(sortedSamples, count, sizeof(sample), cmpAbsInt32);
-		    container->output = sortedSamples[count - 1];
 
-		}
+		container->output = (labs(sorted[0]) > labs(sorted[count - 1])) ?
+					sorted[0] : sorted[count - 1];
 		break;
+
 	    default:
 		container->output = sample;
 		return TRUE;
@@ -862,6 +1116,13 @@ DoubleMovingStatFilter* createDoubleMovingStatFilter(StatFilterOptions *config,
 		return NULL;
 	}
 
+	if((container->sortedSamples = calloc(container->meanContainer->capacity, sizeof(double)))
+		== NULL) {
+		freeDoubleMovingMean(&container->meanContainer);
+		free(container);
+		return NULL;
+	}
+
 	container->config = *config;
 
 	if(config->windowSize < 2) container->config.windowType = WINDOW_SLIDING;
@@ -880,6 +1141,7 @@ freeDoubleMovingStatFilter(DoubleMovingStatFilter** container)
 	    return;
 	}
 	freeDoubleMovingMean(&((*container)->meanContainer));
+	free((*container)->sortedSamples);
 	free(*container);
 	*container = NULL;
 
@@ -904,6 +1166,8 @@ feedDoubleMovingStatFilter(DoubleMovingStatFilter* container, double sample)
 		return 0;
 
 	int interval = container->meanContainer->capacity;
+	int count;
+	double *sorted;
 
 	if(container->config.samplingInterval > 0) {
 	    interval = container->config.samplingInterval;
@@ -916,13 +1180,29 @@ feedDoubleMovingStatFilter(DoubleMovingStatFilter* container, double sample)
 	    return TRUE;
 
 	} else {
+	    DoubleMovingMean *window = container->meanContainer;
+	    /* track how many of the latest samples keep rising or falling */
+	    if(window->count > 0) {
+		double previous = window->samples[window->count - 1];
+		container->rising = (sample > previous) ? container->rising + 1 : 1;
+		container->falling = (sample < previous) ? container->falling + 1 : 1;
+	    } else {
+		container->rising = 1;
+		container->falling = 1;
+	    }
+	    /* keep the sorted copy in step with the window: the oldest sample goes if it is full */
+	    updateSortedDouble(container->sortedSamples, window->count,
+		window->count == window->capacity, window->samples[0], sample);
 	    /* cheat - the mean container is used as a general purpose sliding window */
-	    feedDoubleMovingMean(container->meanContainer, sample);
+	    feedDoubleMovingMean(window, sample);
 	}
 
 	container->counter++;
 	container->counter %= interval;
 
+	sorted = container->sortedSamples;
+	count = container->meanContainer->count;
+
 	switch(container->config.filterType) {
 
 	    case FILTER_MEAN:
@@ -931,89 +1211,30 @@ feedDoubleMovingStatFilter(DoubleMovingStatFilter* container, double sample)
 		break;
 
 	    case FILTER_MEDIAN:
-		{
-
-		    int count = container->meanContainer->count;
-		    double sortedSamples[count];
 
-		    Boolean odd = ((count % 2 ) == 1);
-	
-		    memcpy(sortedSamples, container->meanContainer->samples, count * sizeof(sample));
+		container->output = doubleSortedMedian(sorted, count);
 
-		    qsort(sortedSamples, count, sizeof(sample), cmpDouble);
-
-		    if(odd) {
-
-			    container->output = sortedSamples[(count / 2)];
-
-		    } else {
-
-			    container->output = (sortedSamples[(count / 2) -1] + sortedSamples[(count / 2)]) / 2;
-
-		    }
-
-		    /* check if samples are all increasing or decreasing */
-		    Boolean incr = TRUE;
-		    Boolean decr = TRUE;
-
-		    double *samples = container->meanContainer->samples;
-
-		    for(int i = 1; i < count; i++) {
-			incr &= (samples[i] > samples [i-1]);
-			decr &= (samples[i] < samples [i-1]);
-		    }
-
-		    /* don't filter if all going in the same direction:
-		     * this is usually because we are shifting the clock.
-		     */
-		    if(incr || decr) {
+		/* don't filter if all samples are going in the same direction:
+		 * this is usually because we are shifting the clock.
+		 */
+		if(container->rising >= count || container->falling >= count) {
 			container->output = sample;
-		    }
-
 		}
 		break;
 
 	    case FILTER_MAD:
 		{
-		    int count = container->meanContainer->count;
-		    double sortedSamples[count];
-		    double median;
-		    int i;
-
-		    Boolean odd = ((count %2 ) == 1);
-	
-		    memcpy(sortedSamples, container->meanContainer->samples, count * sizeof(sample));
-
-		    qsort(sortedSamples, count, sizeof(sample), cmpDouble);
-
-		    /* compute median */
+		    double median = doubleSortedMedian(sorted, count);
 
-		    if(odd) {
+		    /* median of the absolute deviations from median */
+		    if((count % 2) == 1) {
 
-			    median = sortedSamples[(count / 2)];
+			    container->output = doubleSortedDeviation(sorted, count, median, count / 2) / 0.6745;
 
 		    } else {
 
-			    median = (sortedSamples[(count / 2) -1] + sortedSamples[(count / 2)]) / 2;
-
-		    }
-
-		    /* compute absolute deviations from median */
-		    for(i = 0; i < count; i++) {
-			sortedSamples[i] = fabs(sortedSamples[i] - median);
-		    }
-
-		    /* compute median of the deviations */
-
-		    qsort(sortedSamples, count, sizeof(sample), cmpDouble);
-
-		    if(odd) {
-
-			    container->output = sortedSamples[(count / 2)] / 0.6745;
-
-		    } else {
-
-			    container->output = ((sortedSamples[(count / 2) -1] + sortedSamples[(count / 2)]) / 2) / 0.6745;
+			    container->output = ((doubleSortedDeviation(sorted, count, median, (count / 2) - 1) +
+						doubleSortedDeviation(sorted, count, median, count / 2)) / 2) / 0.6745;
 
 		    }
 
@@ -1021,48 +1242,26 @@ feedDoubleMovingStatFilter(DoubleMovingStatFilter* container, double sample)
 		break;
 
 	    case FILTER_MIN:
-		{
-		    int count = container->meanContainer->count;
-		    double sortedSamples[count];
-		    memcpy(sortedSamples, container->meanContainer->samples, count * sizeof(sample));
-		    qsort(sortedSamples, count, sizeof(sample), cmpDouble);
-		    container->output = sortedSamples[0];
 
-		}
+		container->output = sorted[0];
 		break;
 
 	    case FILTER_MAX:
-		{
-		    int count = container->meanContainer->count;
-		    double sortedSamples[count];
-		    memcpy(sortedSamples, container->meanContainer->samples, count * sizeof(sample));
-		    qsort(sortedSamples, count, sizeof(sample), cmpDouble);
-		    container->output = sortedSamples[count - 1];
 
-		}
+		container->output = sorted[count - 1];
 		break;
 
 	    case FILTER_ABSMIN:
-		{
-		    int count = container->meanContainer->count;
-		    double sortedSamples[count];
-		    memcpy(sortedSamples, container->meanContainer->samples, count * sizeof(sample));
-		    qsort(sortedSamples, count, sizeof(sample), cmpAbsDouble);
-		    container->output = sortedSamples[0];
 
-		}
+		container->output = doubleSortedAbsMin(sorted, count);
 		break;
 
 	    case FILTER_ABSMAX:
-		{
-		    int count = container->meanContainer->count;
-		    double sortedSamples[count];
-		    memcpy(sortedSamples, container->meanContainer->samples, count * sizeof(sample));
-		    qsort(sortedSamples, count, sizeof(sample), cmpAbsDouble);
-		    container->output = sortedSamples[count - 1];
 
-		}
+		container->output = (fabs(sorted[0]) > fabs(sorted[count - 1])) ?
+					sorted[0] : sorted[count - 1];
 		break;
+
 	    default:
 		container->output = sample;
 		return TRUE;
@@ -1219,6 +1418,260 @@ Boolean isDoublePeircesOutlier(DoubleMovingStdDev *container, double sample, dou
 
 }
 
+/* parse a list of observation intervals (s), return their number or -1 on error */
+int
+parseStabilityIntervals(const char* list, int *intervals, int max)
+{
+
+	int count = 0;
+	int ret = 0;
+	char *end;
+	long tau;
+
+	foreach_token_begin(stability, list, token, DEFAULT_TOKEN_DELIM);
+
+		tau = strtol(token, &end, 10);
+		if(*end != '\0' || tau < 1 || tau > STABILITY_MAX_TAU || count >= max) {
+		    ret = -1;
+		    break;
+		}
+		if(intervals != NULL) {
+		    intervals[count] = tau;
+		}
+		count++;
+
+	foreach_token_end(stability);
+
+	return (ret < 0) ? ret : count;
+
+}
+
+PhaseStability*
+createPhaseStability(const char* intervals)
+{
+
+	PhaseStability* container;
+	int tau[STABILITY_MAX_INTERVALS];
+	int i, count;
+
+	count = parseStabilityIntervals(intervals, tau, STABILITY_MAX_INTERVALS);
+
+	if(count <= 0) {
+	    return NULL;
+	}
+
+	if ( !(container = calloc (1, sizeof(PhaseStability))) ) {
+	    return NULL;
+	}
+
+	container->intervalCount = count;
+	for(i = 0; i < count; i++) {
+	    container->interval[i].tau = tau[i];
+	}
+
+	return container;
+
+}
+
+void
+freePhaseStability(PhaseStability** container)
+{
+
+	if(*container == NULL) {
+	    return;
+	}
+	free((*container)->levels);
+	free(*container);
+	*container = NULL;
+
+}
+
+/* clear all data; a new sample period also moves intervals between levels */
+void
+resetPhaseStability(PhaseStability* container, double tau0)
+{
+
+	PhaseStabilityInterval *interval;
+	double period;
+	int i, levelCount = 1;
+
+	if(container == NULL)
+	    return;
+
+	for(i = 0; i < container->intervalCount; i++) {
+	    interval = &container->interval[i];
+	    memset(&interval->level, 0, sizeof(PhaseStabilityInterval) -
+		    offsetof(PhaseStabilityInterval, level));
+	    if(tau0 <= 0.0 || interval->tau < tau0) {
+		continue;
+	    }
+	    for(period = tau0; interval->tau / period > STABILITY_MAX_SPAN; period *= 2) {
+		interval->level++;
+	    }
+	    interval->span = max(1, lround(interval->tau / period));
+	    interval->actualTau = interval->span * period;
+	    levelCount = max(levelCount, interval->level + 1);
+	}
+
+	if(levelCount != container->levelCount || container->levels == NULL) {
+	    free(container->levels);
+	    container->levels = calloc(levelCount, sizeof(PhaseStabilityLevel));
+	    container->levelCount = (container->levels == NULL) ? 0 : levelCount;
+	} else {
+	    memset(container->levels, 0, levelCount * sizeof(PhaseStabilityLevel));
+	}
+
+	container->tau0 = tau0;
+	container->samples = 0;
+
+}
+
+/* new sample k at an interval's level: MTIE window, second differences */
+static void
+updateStabilityInterval(PhaseStabilityInterval *interval, PhaseStabilityLevel *level)
+{
+
+	uint64_t k = level->count - 1;
+	int n = interval->span;
+	/* points at level 0, blocks above: n blocks already span the interval */
+	int window = n + (interval->level == 0);
+	double s, d;
+
+#define RING(array, index) (level->array[(index) & (STABILITY_RING_SIZE - 1)])
+#define QUEUE(index) ((index) & (STABILITY_QUEUE_SIZE - 1))
+
+	/* drop samples which left the window, then the ones the new sample dominates */
+	while(interval->maxHead != interval->maxTail &&
+	    interval->maxQueue[interval->maxHead] + window <= k) {
+		interval->maxHead = QUEUE(interval->maxHead + 1);
+	}
+	while(interval->maxTail != interval->maxHead &&
+	    RING(max, interval->maxQueue[QUEUE(interval->maxTail - 1)]) <= RING(max, k)) {
+		interval->maxTail = QUEUE(interval->maxTail - 1);
+	}
+	interval->maxQueue[interval->maxTail] = k;
+	interval->maxTail = QUEUE(interval->maxTail + 1);
+
+	while(interval->minHead != interval->minTail &&
+	    interval->minQueue[interval->minHead] + window <= k) {
+		interval->minHead = QUEUE(interval->minHead + 1);
+	}
+	while(interval->minTail != interval->minHead &&
+	    RING(min, interval->minQueue[QUEUE(interval->minTail - 1)]) >= RING(min, k)) {
+		interval->minTail = QUEUE(interval->minTail - 1);
+	}
+	interval->minQueue[interval->minTail] = k;
+	interval->minTail = QUEUE(interval->minTail + 1);
+
+	if(k + 1 >= window) {
+	    interval->mtie = max(interval->mtie, RING(max, interval->maxQueue[interval->maxHead]) -
+			    RING(min, interval->minQueue[interval->minHead]));
+	}
+
+	/* overlapping ADEV: second difference of phase n samples apart */
+	if(k >= 2 * n) {
+	    d = RING(phase, k) - 2 * RING(phase, k - n) + RING(phase, k - 2 * n);
+	    interval->avarSum += d * d;
+	    interval->avarCount++;
+	}
+
+	/* TDEV: second difference of n-sample sums of mean phase - the sum before the first sample is 0 */
+	if(k + 1 >= 3 * n) {
+	    d = (k + 1 == 3 * n) ? 0.0 : RING(sum, k - 3 * n);
+	    s = (RING(sum, k) - RING(sum, k - n)) - 2 * (RING(sum, k - n) - RING(sum, k - 2 * n)) +
+		(RING(sum, k - 2 * n) - d);
+	    interval->tvarSum += s * s;
+	    interval->tvarCount++;
+	}
+
+#undef RING
+#undef QUEUE
+
+}
+
+static void
+feedStabilityLevel(PhaseStability* container, int index, double phase, double mean, double low, double high)
+{
+
+	PhaseStabilityLevel *level = &container->levels[index];
+	int slot = level->count & (STABILITY_RING_SIZE - 1);
+	int i;
+
+	level->phase[slot] = phase;
+	level->min[slot] = low;
+	level->max[slot] = high;
+	level->runningSum += mean;
+	level->sum[slot] = level->runningSum;
+	level->count++;
+
+	/* keep the running sum small: rebase the ring every time it wraps */
+	if(slot == STABILITY_RING_SIZE - 1) {
+	    for(i = 0; i < STABILITY_RING_SIZE; i++) {
+		level->sum[i] -= level->runningSum;
+	    }
+	    level->runningSum = 0.0;
+	}
+
+	for(i = 0; i < container->intervalCount; i++) {
+	    if(container->interval[i].span > 0 && container->interval[i].level == index) {
+		updateStabilityInterval(&container->interval[i], level);
+	    }
+	}
+
+	if(index + 1 >= container->levelCount) {
+	    return;
+	}
+
+	if(level->fill == 0) {
+	    level->blockSum = mean;
+	    level->blockMin = low;
+	    level->blockMax = high;
+	    level->fill = 1;
+	    return;
+	}
+
+	level->fill = 0;
+	feedStabilityLevel(container, index + 1, phase, (level->blockSum + mean) / 2,
+			    min(level->blockMin, low), max(level->blockMax, high));
+
+}
+
+void
+feedPhaseStability(PhaseStability* container, double sample)
+{
+
+	if(container == NULL || container->levelCount == 0)
+	    return;
+
+	container->samples++;
+	feedStabilityLevel(container, 0, sample, sample, sample, sample);
+
+}
+
+/* refresh ADEV and TDEV from the accumulated second differences */
+void
+statPhaseStability(PhaseStability* container)
+{
+
+	PhaseStabilityInterval *interval;
+	int i;
+
+	if(container == NULL)
+	    return;
+
+	for(i = 0; i < container->intervalCount; i++) {
+	    interval = &container->interval[i];
+	    interval->valid = (interval->tvarCount > 0);
+	    if(interval->avarCount > 0) {
+		interval->adev = sqrt(interval->avarSum / (2.0 * interval->avarCount)) / interval->actualTau;
+	    }
+	    if(interval->tvarCount > 0) {
+		interval->tdev = sqrt(interval->tvarSum / (6.0 * interval->tvarCount)) / interval->span;
+	    }
+	}
+
+}
+
 void
 clearPtpEngineSlaveStats(PtpEngineSlaveStats* stats)
 {
@@ -1230,8 +1683,8 @@ resetPtpEngineSlaveStats(PtpEngineSlaveStats* stats) {
 
 	resetDoublePermanentStdDev(&stats->ofmStats);
 	resetDoublePermanentStdDev(&stats->mpdStats);
-	resetDoublePermanentMedian(&stats->ofmMedianContainer);
-	resetDoublePermanentMedian(&stats->mpdMedianContainer);
+	resetDoublePermanentPercentiles(&stats->ofmPercentiles);
+	resetDoublePermanentPercentiles(&stats->mpdPercentiles);
 	stats->ofmStatsUpdated = FALSE;
 	stats->mpdStatsUpdated = FALSE;
 }
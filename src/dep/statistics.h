@@ -78,6 +78,32 @@ typedef struct {
 	uint8_t count;
 } DoublePermanentMedian;
 
+/*
+ * Percentiles estimated with the P-square algorithm (Jain & Chlamtac, 1985):
+ * five markers per percentile are moved towards their desired positions with
+ * piecewise-parabolic interpolation - constant memory and cost per sample.
+ * The first STAT_PERCENTILE_EXACT samples are kept sorted and give exact
+ * (nearest rank) percentiles, then seed the markers: short windows are exact
+ * and the tail markers do not start from five samples.
+ */
+#define STAT_PERCENTILE_COUNT 4
+#define STAT_PERCENTILE_EXACT 64
+/* p50, p90, p99, p99.9 - the first one is the median */
+#define STAT_PERCENTILES { 0.5, 0.9, 0.99, 0.999 }
+#define STAT_PERCENTILE_NAMES { "p50", "p90", "p99", "p99.9" }
+
+typedef struct {
+	double height[5];	/* marker heights, height[2] is the estimate */
+	int position[5];	/* actual marker positions */
+	double desired[5];	/* desired marker positions */
+} DoublePermanentQuantile;
+
+typedef struct {
+	DoublePermanentQuantile quantile[STAT_PERCENTILE_COUNT];
+	double initial[STAT_PERCENTILE_EXACT];	/* first samples, sorted */
+	uint32_t count;
+} DoublePermanentPercentiles;
+
 void 	resetIntPermanentMean(IntPermanentMean* container);
 int32_t feedIntPermanentMean(IntPermanentMean* container, int32_t sample);
 void 	resetIntPermanentStdDev(IntPermanentStdDev* container);
@@ -99,6 +125,10 @@ double 	feedDoublePermanentMedian(DoublePermanentMedian* container, double sampl
 void 	resetDoublePermanentAdev(DoublePermanentAdev* container);
 double feedDoublePermanentAdev(DoublePermanentAdev* container, double sample);
 
+void	resetDoublePermanentPercentiles(DoublePermanentPercentiles* container);
+void	feedDoublePermanentPercentiles(DoublePermanentPercentiles* container, double sample);
+double	getDoublePermanentPercentile(const DoublePermanentPercentiles* container, int index);
+
 
 /* Moving statistics - up to last n samples */
 
@@ -173,6 +203,8 @@ typedef struct {
 	DoubleMovingMean* meanContainer;
 	double output;
 	double* sortedSamples;
+	int rising;		/* number of latest samples rising - median is not filtered if all are */
+	int falling;		/* number of latest samples falling */
 	char identifier[10];
 	int counter;
 	int lastBlocked;
@@ -221,6 +253,72 @@ double getPeircesCriterion(int numObservations, int numDoubtful);
 Boolean isIntPeircesOutlier(IntMovingStdDev *container, int32_t sample, double threshold);
 Boolean isDoublePeircesOutlier(DoubleMovingStdDev *container, double sample, double threshold);
 
+/*
+ * Phase stability: MTIE, TDEV and overlapping ADEV of the offset from master
+ * (time error) at up to STABILITY_MAX_INTERVALS observation intervals.
+ * Samples are decimated by 2 in a cascade of levels, each holding block
+ * extremes (MTIE), block means (TDEV) and subsampled phase (ADEV). Every
+ * interval is computed at the lowest level where it spans at most
+ * STABILITY_MAX_SPAN samples, so long intervals are rounded to a multiple
+ * of that level's sample period. Updates are O(1) amortised per sample.
+ */
+#define STABILITY_MAX_INTERVALS		8
+#define STABILITY_MAX_SPAN		64
+/* power of 2, holding 3 * STABILITY_MAX_SPAN + 1 samples for TDEV */
+#define STABILITY_RING_SIZE		256
+/* power of 2, holding the STABILITY_MAX_SPAN + 1 samples of an MTIE window */
+#define STABILITY_QUEUE_SIZE		128
+#define STABILITY_MAX_TAU		100000
+#define STABILITY_DEFAULT_INTERVALS	"1 10 100 1000 10000"
+
+typedef struct {
+	int tau;			/* configured observation interval (s) */
+	int level;			/* decimation level it is computed at */
+	int span;			/* samples per interval at that level, 0 = shorter than sample period */
+	double actualTau;		/* span * level sample period */
+	/* monotonic deques of sample numbers for window max and min */
+	uint64_t maxQueue[STABILITY_QUEUE_SIZE];
+	uint64_t minQueue[STABILITY_QUEUE_SIZE];
+	int maxHead, maxTail, minHead, minTail;
+	double mtie;
+	double avarSum;
+	uint64_t avarCount;
+	double tvarSum;
+	uint64_t tvarCount;
+	/* refreshed by statPhaseStability() */
+	Boolean valid;
+	double adev;
+	double tdev;
+} PhaseStabilityInterval;
+
+typedef struct {
+	double phase[STABILITY_RING_SIZE];	/* phase at the end of each block */
+	double sum[STABILITY_RING_SIZE];	/* running sum of block means */
+	double min[STABILITY_RING_SIZE];
+	double max[STABILITY_RING_SIZE];
+	double runningSum;
+	uint64_t count;
+	/* block being built for the next level */
+	int fill;
+	double blockSum, blockMin, blockMax;
+} PhaseStabilityLevel;
+
+typedef struct {
+	double tau0;			/* sample period */
+	uint64_t samples;
+	int intervalCount;
+	PhaseStabilityInterval interval[STABILITY_MAX_INTERVALS];
+	int levelCount;
+	PhaseStabilityLevel *levels;
+} PhaseStability;
+
+int parseStabilityIntervals(const char* list, int *intervals, int max);
+PhaseStability* createPhaseStability(const char* intervals);
+void freePhaseStability(PhaseStability** container);
+void resetPhaseStability(PhaseStability* container, double tau0);
+void feedPhaseStability(PhaseStability* container, double sample);
+void statPhaseStability(PhaseStability* container);
+
 /**
  * \struct PtpEngineSlaveStats
  * \brief Ptpd clock statistics per port
@@ -233,6 +331,7 @@ typedef struct
     double ofmMean;
     double ofmStdDev;
     double ofmMedian;
+    double ofmPercentile[STAT_PERCENTILE_COUNT];
     double ofmMin;
     double ofmMinFinal;
     double ofmMax;
@@ -240,6 +339,7 @@ typedef struct
     double mpdMean;
     double mpdStdDev;
     double mpdMedian;
+    double mpdPercentile[STAT_PERCENTILE_COUNT];
     double mpdMin;
     double mpdMinFinal;
     double mpdMax;
@@ -250,8 +350,8 @@ typedef struct
     int mpdStabilityPeriod;
     DoublePermanentStdDev ofmStats;
     DoublePermanentStdDev mpdStats;
-    DoublePermanentMedian ofmMedianContainer;
-    DoublePermanentMedian mpdMedianContainer;
+    DoublePermanentPercentiles ofmPercentiles;
+    DoublePermanentPercentiles mpdPercentiles;
 } PtpEngineSlaveStats;
 
 void clearPtpEngineSlaveStats(PtpEngineSlaveStats* stats);
@@ -0,0 +1,118 @@
+/*-
+ * Copyright (c) 2026 PTPd contributors,
+ *
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file   statslog.h
+ * @date   Sun Oct 18 07:10:21 2026
+ *
+ * @brief  Binary statistics log (global:statistics_file_format = binary)
+ *
+ * The file is a sequence of entries, each starting with a tag and the
+ * entry length, so readers can skip what they do not understand. A header
+ * entry is written whenever the CSV log would print its "# Timestamp, ..."
+ * line (file opened, truncated or rotated), so appending to an existing
+ * file or concatenating files is fine. Every header is followed by fixed
+ * size records, one per line of the CSV log. Values are stored in host
+ * byte order; a reader can tell the byte order from the header magic.
+ *
+ * ptpd-stats2csv converts the file back into the CSV statistics log.
+ * This header is shared with the converter and must not depend on ptpd.h.
+ */
+
+#ifndef PTPD_STATSLOG_H_
+#define PTPD_STATSLOG_H_
+
+#include <stdint.h>
+
+#define STATSLOG_MAGIC		0x5054504453544154ULL	/* "PTPDSTAT" */
+#define STATSLOG_VERSION	1
+
+#define STATSLOG_TAG_HEADER	0x48534c50		/* "PLSH" */
+#define STATSLOG_TAG_RECORD	0x52534c50		/* "PLSR" */
+
+/* stdio buffer used for the binary log: written out when full or once per second */
+#define STATSLOG_BUFFER_SIZE	65536
+
+/* delay mechanism as stored in records */
+enum {
+	STATSLOG_E2E = 1,
+	STATSLOG_P2P = 2
+};
+
+typedef struct {
+	int32_t seconds;
+	int32_t nanoseconds;
+} StatisticsLogTime;
+
+typedef struct {
+	uint32_t tag;				/* STATSLOG_TAG_HEADER */
+	uint32_t length;			/* whole entry, including the field description */
+	uint64_t magic;
+	uint16_t version;
+	uint16_t recordSize;
+	uint8_t timestampFormat;		/* statistics_timestamp_format when written: 0 datetime, 1 unix, 2 both */
+	uint8_t pad[3];
+	/* followed by STATSLOG_FIELDS, NUL-padded to a multiple of 8 bytes */
+} StatisticsLogHeader;
+
+typedef struct {
+	uint32_t tag;				/* STATSLOG_TAG_RECORD */
+	uint32_t length;			/* sizeof(StatisticsLogRecord) */
+	int64_t seconds;			/* time the entry was logged */
+	int32_t nanoseconds;
+	int32_t resetCount;
+	uint8_t portState;			/* PtpPortState */
+	uint8_t lastMessage;			/* 'S', 'D', 'P' ... - "Last packet Received" */
+	uint16_t sequenceId;
+	uint16_t parentPortNumber;
+	uint8_t delayMechanism;			/* STATSLOG_E2E / STATSLOG_P2P */
+	uint8_t pad;
+	uint8_t parentClockIdentity[8];
+	uint8_t grandmasterIdentity[8];
+	StatisticsLogTime meanPathDelay;
+	StatisticsLogTime offsetFromMaster;
+	StatisticsLogTime delaySM;
+	StatisticsLogTime delayMS;
+	StatisticsLogTime rawDelayMS;
+	StatisticsLogTime rawDelaySM;
+	double observedDrift;
+	double mpdMean;
+	double mpdStdDev;
+	double ofmMean;
+	double ofmStdDev;
+} StatisticsLogRecord;
+
+/* record layout as name:type:offset, stored in every header for third party readers */
+#define STATSLOG_FIELDS \
+	"tag:u32:0,length:u32:4,seconds:i64:8,nanoseconds:i32:16,resetCount:i32:20," \
+	"portState:u8:24,lastMessage:char:25,sequenceId:u16:26,parentPortNumber:u16:28," \
+	"delayMechanism:u8:30,parentClockIdentity:u8[8]:32,grandmasterIdentity:u8[8]:40," \
+	"meanPathDelay:time:48,offsetFromMaster:time:56,delaySM:time:64,delayMS:time:72," \
+	"rawDelayMS:time:80,rawDelaySM:time:88,observedDrift:f64:96,mpdMean:f64:104," \
+	"mpdStdDev:f64:112,ofmMean:f64:120,ofmStdDev:f64:128;time=i32 seconds+i32 nanoseconds"
+
+#endif /* PTPD_STATSLOG_H_ */
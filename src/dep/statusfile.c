@@ -0,0 +1,1222 @@
+/*-
+ * Copyright (c) 2026 PTPd contributors,
+ *
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file   statusfile.c
+ * @date   Sun Oct 18 08:34:38 2026
+ *
+ * @brief  Status file: change-driven rendering, atomic replacement
+ *
+ * The status file is made of sections, each rendered into its own buffer.
+ * Every update, each section collects the data it displays into a key;
+ * a section is only rendered again when its key differs from the one it
+ * was last rendered with. When no section has changed, nothing is written.
+ * Otherwise the sections are concatenated and handed to logWrite() as a
+ * LOGJOB_REPLACE job, which writes a new file and rename()s it over the
+ * old one, so readers always see a complete file.
+ *
+ * global:status_file_format selects the human-readable text or JSON, with
+ * the same information, for monitoring agents.
+ */
+
+#include "../ptpd.h"
+
+#define STATUS_SECTION_SIZE	4096
+#define STATUS_KEY_SIZE		1024
+#define STATUS_FILE_SIZE	16384
+
+typedef struct {
+	char data[STATUS_KEY_SIZE];
+	int length;			/* -1: key overflow, always render */
+} StatusKey;
+
+typedef struct {
+	/* collect the data the section displays */
+	void (*key) (StatusKey *key, PtpClock *ptpClock, const RunTimeOpts *rtOpts);
+	void (*text) (FILE *out, PtpClock *ptpClock, const RunTimeOpts *rtOpts);
+	/* JSON members, each followed by ",\n" */
+	void (*json) (FILE *out, PtpClock *ptpClock, const RunTimeOpts *rtOpts);
+} StatusSectionHandler;
+
+typedef struct {
+	Boolean valid;
+	StatusKey key;
+	char text[STATUS_SECTION_SIZE];
+	int length;
+} StatusSection;
+
+#define STATUSPREFIX "%-19s:"
+
+static void
+addKey(StatusKey *key, const void *data, size_t length)
+{
+
+	if(key->length < 0) {
+		return;
+	}
+
+	if(key->length + length > sizeof(key->data)) {
+		key->length = -1;
+		return;
+	}
+
+	memcpy(key->data + key->length, data, length);
+	key->length += length;
+
+}
+
+#define STATUS_KEY(key, var) addKey((key), &(var), sizeof(var))
+
+/* JSON string, quoted and escaped */
+static void
+jsonString(FILE *out, const char *s)
+{
+
+	fputc('"', out);
+
+	for(; s != NULL && *s; s++) {
+		if(*s == '"' || *s == '\\') {
+			fprintf(out, "\\%c", *s);
+		} else if((unsigned char)*s < 0x20) {
+			fprintf(out, "\\u%04x", (unsigned char)*s);
+		} else {
+			fputc(*s, out);
+		}
+	}
+
+	fputc('"', out);
+
+}
+
+static void
+jsonMember(FILE *out, const char *name, const char *value)
+{
+	fprintf(out, "\t\"%s\": ", name);
+	jsonString(out, value);
+	fprintf(out, ",\n");
+}
+
+static const char*
+jsonBool(Boolean value)
+{
+	return value ? "true" : "false";
+}
+
+/* host name and PID */
+
+static void
+keyHost(StatusKey *key, PtpClock *ptpClock, const RunTimeOpts *rtOpts)
+{
+	/* rendered once - until invalidateStatusFile() */
+}
+
+static void
+getHostName(char *hostName)
+{
+	memset(hostName, 0, MAXHOSTNAMELEN);
+	gethostname(hostName, MAXHOSTNAMELEN - 1);
+}
+
+static void
+textHost(FILE *out, PtpClock *ptpClock, const RunTimeOpts *rtOpts)
+{
+
+	char hostName[MAXHOSTNAMELEN];
+
+	getHostName(hostName);
+	fprintf(out, 		STATUSPREFIX"  %s, PID %d\n","Host info", hostName, (int)getpid());
+
+}
+
+static void
+jsonHost(FILE *out, PtpClock *ptpClock, const RunTimeOpts *rtOpts)
+{
+
+	char hostName[MAXHOSTNAMELEN];
+
+	getHostName(hostName);
+	jsonMember(out, "host", hostName);
+	fprintf(out, "\t\"pid\": %d,\n", (int)getpid());
+
+}
+
+/* local and kernel time: the time of the last update, rendered once per second */
+
+static struct timeval statusTime;
+
+static void
+keyTime(StatusKey *key, PtpClock *ptpClock, const RunTimeOpts *rtOpts)
+{
+	time_t seconds;
+
+	gettimeofday(&statusTime, 0);
+	seconds = statusTime.tv_sec;
+	STATUS_KEY(key, seconds);
+}
+
+static void
+textTime(FILE *out, PtpClock *ptpClock, const RunTimeOpts *rtOpts)
+{
+
+	char timeStr[MAXTIMESTR];
+	struct tm tm;
+
+	strftime(timeStr, MAXTIMESTR, "%a %b %d %X %Z %Y", localtime_r((time_t*)&statusTime.tv_sec, &tm));
+	fprintf(out, 		STATUSPREFIX"  %s\n","Local time", timeStr);
+	strftime(timeStr, MAXTIMESTR, "%a %b %d %X %Z %Y", gmtime_r((time_t*)&statusTime.tv_sec, &tm));
+	fprintf(out, 		STATUSPREFIX"  %s\n","Kernel time", timeStr);
+
+}
+
+static void
+jsonTime(FILE *out, PtpClock *ptpClock, const RunTimeOpts *rtOpts)
+{
+	fprintf(out, "\t\"time\": %ld,\n", (long)statusTime.tv_sec);
+}
+
+/* interface, transport, domain and port state */
+
+static void
+keyPort(StatusKey *key, PtpClock *ptpClock, const RunTimeOpts *rtOpts)
+{
+
+	InterfaceInfo *ifInfo = &ptpClock->netPath.interfaceInfo;
+
+	STATUS_KEY(key, ptpClock->portDS.portState);
+	STATUS_KEY(key, ptpClock->defaultDS.domainNumber);
+	STATUS_KEY(key, ptpClock->defaultDS.twoStepFlag);
+	STATUS_KEY(key, ptpClock->runningBackupInterface);
+	STATUS_KEY(key, ptpClock->netPath.hwTimestamping);
+	STATUS_KEY(key, ifInfo->physicalDevice);
+	STATUS_KEY(key, ifInfo->bondInfo);
+	STATUS_KEY(key, ifInfo->vlanInfo);
+
+}
+
+static void
+textPort(FILE *out, PtpClock *ptpClock, const RunTimeOpts *rtOpts)
+{
+
+	InterfaceInfo *ifInfo = &ptpClock->netPath.interfaceInfo;
+
+	fprintf(out, 		STATUSPREFIX"  %s%s","Interface", rtOpts->ifaceName,
+		(rtOpts->backupIfaceEnabled && ptpClock->runningBackupInterface) ? " (backup)" : (rtOpts->backupIfaceEnabled)?
+		    " (primary)" : "");
+
+	if(ifInfo->vlanInfo.vlan) {
+	    fprintf(out, "%s", ", VLAN");
+	}
+	if(ifInfo->bondInfo.bonded) {
+	    fprintf(out, ", bonded");
+	    if(ifInfo->bondInfo.activeBackup) {
+		if(ifInfo->bondInfo.activeCount>0) {
+		    fprintf(out, ", active %s", ifInfo->physicalDevice);
+		} else {
+		    fprintf(out, ", no active slaves!");
+		}
+		
+	    }
+	} else if(ifInfo->vlanInfo.vlan) {
+		    fprintf(out, ", physical %s", ifInfo->physicalDevice);
+	}
+
+	fprintf(out, "\n");
+
+	fprintf(out, 		STATUSPREFIX"  %s\n","Preset", dictionary_get(rtOpts->currentConfig, "ptpengine:preset", ""));
+	fprintf(out, 		STATUSPREFIX"  %s%s","Transport", dictionary_get(rtOpts->currentConfig, "ptpengine:transport", ""),
+		(rtOpts->transport==UDP_IPV4 && rtOpts->pcap == TRUE)?" + libpcap":"");
+
+	if(rtOpts->transport != IEEE_802_3) {
+	    fprintf(out,", %s", dictionary_get(rtOpts->currentConfig, "ptpengine:ip_mode", ""));
+	    fprintf(out,"%s", rtOpts->unicastNegotiation ? " negotiation":"");
+	}
+
+	if(ptpClock->netPath.hwTimestamping) {
+	    fprintf(out,", HW PTP");
+	}
+
+	fprintf(out,"\n");
+
+	fprintf(out, 		STATUSPREFIX"  %s\n","Delay mechanism", dictionary_get(rtOpts->currentConfig, "ptpengine:delay_mechanism", ""));
+	if(ptpClock->portDS.portState >= PTP_MASTER) {
+	fprintf(out, 		STATUSPREFIX"  %s\n","Sync mode", ptpClock->defaultDS.twoStepFlag ? "TWO_STEP" : "ONE_STEP");
+	}
+	if(ptpClock->defaultDS.slaveOnly && rtOpts->anyDomain) {
+		fprintf(out, 		STATUSPREFIX"  %d, preferred %d\n","PTP domain",
+		ptpClock->defaultDS.domainNumber, rtOpts->domainNumber);
+	} else if(ptpClock->defaultDS.slaveOnly && rtOpts->unicastNegotiation) {
+		fprintf(out, 		STATUSPREFIX"  %d, default %d\n","PTP domain", ptpClock->defaultDS.domainNumber, rtOpts->domainNumber);
+	} else {
+		fprintf(out, 		STATUSPREFIX"  %d\n","PTP domain", ptpClock->defaultDS.domainNumber);
+	}
+	fprintf(out, 		STATUSPREFIX"  %s\n","Port state", portState_getName(ptpClock->portDS.portState));
+
+}
+
+static void
+jsonPort(FILE *out, PtpClock *ptpClock, const RunTimeOpts *rtOpts)
+{
+
+	InterfaceInfo *ifInfo = &ptpClock->netPath.interfaceInfo;
+
+	jsonMember(out, "interface", rtOpts->ifaceName);
+	if(rtOpts->backupIfaceEnabled) {
+	    jsonMember(out, "interface_role", ptpClock->runningBackupInterface ? "backup" : "primary");
+	}
+	fprintf(out, "\t\"vlan\": %s,\n", jsonBool(ifInfo->vlanInfo.vlan));
+	fprintf(out, "\t\"bonded\": %s,\n", jsonBool(ifInfo->bondInfo.bonded));
+	if(ifInfo->bondInfo.bonded || ifInfo->vlanInfo.vlan) {
+	    jsonMember(out, "physical_device", ifInfo->physicalDevice);
+	}
+	jsonMember(out, "preset", dictionary_get(rtOpts->currentConfig, "ptpengine:preset", ""));
+	jsonMember(out, "transport", dictionary_get(rtOpts->currentConfig, "ptpengine:transport", ""));
+	if(rtOpts->transport != IEEE_802_3) {
+	    jsonMember(out, "ip_mode", dictionary_get(rtOpts->currentConfig, "ptpengine:ip_mode", ""));
+	    fprintf(out, "\t\"unicast_negotiation\": %s,\n", jsonBool(rtOpts->unicastNegotiation));
+	}
+	fprintf(out, "\t\"hw_timestamping\": %s,\n", jsonBool(ptpClock->netPath.hwTimestamping));
+	jsonMember(out, "delay_mechanism", dictionary_get(rtOpts->currentConfig, "ptpengine:delay_mechanism", ""));
+	fprintf(out, "\t\"two_step\": %s,\n", jsonBool(ptpClock->defaultDS.twoStepFlag));
+	fprintf(out, "\t\"domain\": %d,\n", ptpClock->defaultDS.domainNumber);
+	jsonMember(out, "port_state", portState_getName(ptpClock->portDS.portState));
+
+}
+
+/* alarms */
+
+static void
+keyAlarms(StatusKey *key, PtpClock *ptpClock, const RunTimeOpts *rtOpts)
+{
+
+	int i;
+
+	for(i = 0; i < ALRM_MAX; i++) {
+	    STATUS_KEY(key, ptpClock->alarms[i].state);
+	}
+
+}
+
+static void
+textAlarms(FILE *out, PtpClock *ptpClock, const RunTimeOpts *rtOpts)
+{
+
+	int n = getAlarmSummary(NULL, 0, ptpClock->alarms, ALRM_MAX);
+	char alarmBuf[n];
+
+	getAlarmSummary(alarmBuf, n, ptpClock->alarms, ALRM_MAX);
+
+	if(strlen(alarmBuf) > 0) {
+	    fprintf(out, 		STATUSPREFIX"  %s\n","Alarms", alarmBuf);
+	}
+
+}
+
+static void
+jsonAlarms(FILE *out, PtpClock *ptpClock, const RunTimeOpts *rtOpts)
+{
+
+	int i;
+	Boolean first = TRUE;
+	AlarmEntry *alarm;
+
+	fprintf(out, "\t\"alarms\": [");
+
+	for(i = 0; i < ALRM_MAX; i++) {
+	    alarm = &ptpClock->alarms[i];
+	    if(alarm->state == ALARM_UNSET) {
+		continue;
+	    }
+	    fprintf(out, "%s{ \"name\": ", first ? " " : ", ");
+	    jsonString(out, alarm->name);
+	    fprintf(out, ", \"state\": \"%s\" }", alarm->state == ALARM_SET ? "set" : "cleared");
+	    first = FALSE;
+	}
+
+	fprintf(out, "%s],\n", first ? "" : " ");
+
+}
+
+/* port identities, best master, time properties */
+
+static void
+keyParent(StatusKey *key, PtpClock *ptpClock, const RunTimeOpts *rtOpts)
+{
+
+	STATUS_KEY(key, ptpClock->portDS.portState);
+	STATUS_KEY(key, ptpClock->portDS.portIdentity);
+	STATUS_KEY(key, ptpClock->parentDS);
+	STATUS_KEY(key, ptpClock->timePropertiesDS);
+	STATUS_KEY(key, ptpClock->defaultDS.clockQuality.clockClass);
+	STATUS_KEY(key, ptpClock->bestMaster);
+
+	if(ptpClock->bestMaster != NULL) {
+	    STATUS_KEY(key, ptpClock->bestMaster->sourceAddr);
+	    STATUS_KEY(key, ptpClock->bestMaster->disqualified);
+	}
+
+	if(ptpClock->parentGrants != NULL) {
+	    STATUS_KEY(key, ptpClock->parentGrants->localPreference);
+	}
+
+}
+
+static void
+textParent(FILE *out, PtpClock *ptpClock, const RunTimeOpts *rtOpts)
+{
+
+	char tmpBuf[200];
+
+	    memset(tmpBuf, 0, sizeof(tmpBuf));
+	    snprint_PortIdentity(tmpBuf, sizeof(tmpBuf),
+	    &ptpClock->portDS.portIdentity);
+	fprintf(out, 		STATUSPREFIX"  %s\n","Local port ID", tmpBuf);
+
+
+	if(ptpClock->portDS.portState >= PTP_MASTER) {
+	    memset(tmpBuf, 0, sizeof(tmpBuf));
+	    snprint_PortIdentity(tmpBuf, sizeof(tmpBuf),
+	    &ptpClock->parentDS.parentPortIdentity);
+	fprintf(out, 		STATUSPREFIX"  %s","Best master ID", tmpBuf);
+	if(ptpClock->portDS.portState == PTP_MASTER)
+	    fprintf(out," (self)");
+	fprintf(out,"\n");
+	}
+	if(rtOpts->transport == UDP_IPV4 &&
+	    ptpClock->portDS.portState > PTP_MASTER &&
+	    ptpClock->bestMaster && ptpClock->bestMaster->sourceAddr) {
+	    {
+	    struct in_addr tmpAddr;
+	    tmpAddr.s_addr = ptpClock->bestMaster->sourceAddr;
+	    fprintf(out, 		STATUSPREFIX"  %s\n","Best master IP", inet_ntoa(tmpAddr));
+	    }
+	}
+	if(ptpClock->portDS.portState == PTP_SLAVE) {
+	fprintf(out, 		STATUSPREFIX"  Priority1 %d, Priority2 %d, clockClass %d","GM priority",
+	ptpClock->parentDS.grandmasterPriority1, ptpClock->parentDS.grandmasterPriority2, ptpClock->parentDS.grandmasterClockQuality.clockClass);
+	if(rtOpts->unicastNegotiation && ptpClock->parentGrants != NULL ) {
+	    	fprintf(out, ", localPref %d", ptpClock->parentGrants->localPreference);
+	}
+	fprintf(out, "%s\n", (ptpClock->bestMaster != NULL && ptpClock->bestMaster->disqualified) ? " (timeout)" : "");
+	}
+
+	if(ptpClock->defaultDS.clockQuality.clockClass < 128 ||
+		ptpClock->portDS.portState == PTP_SLAVE ||
+		ptpClock->portDS.portState == PTP_PASSIVE){
+	fprintf(out, 		STATUSPREFIX"  ","Time properties");
+	fprintf(out, "%s timescale, ",ptpClock->timePropertiesDS.ptpTimescale ? "PTP":"ARB");
+	fprintf(out, "tracbl: time %s, freq %s, src: %s(0x%02x)\n", ptpClock->timePropertiesDS.timeTraceable ? "Y" : "N",
+							ptpClock->timePropertiesDS.frequencyTraceable ? "Y" : "N",
+							getTimeSourceName(ptpClock->timePropertiesDS.timeSource),
+							ptpClock->timePropertiesDS.timeSource);
+	fprintf(out, 		STATUSPREFIX"  ","UTC properties");
+	fprintf(out, "UTC valid: %s", ptpClock->timePropertiesDS.currentUtcOffsetValid ? "Y" : "N");
+	fprintf(out, ", UTC offset: %d",ptpClock->timePropertiesDS.currentUtcOffset);
+	fprintf(out, "%s",ptpClock->timePropertiesDS.leap61 ?
+			", LEAP61 pending" : ptpClock->timePropertiesDS.leap59 ? ", LEAP59 pending" : "");
+	if (ptpClock->portDS.portState == PTP_SLAVE) {	
+	    fprintf(out, "%s", rtOpts->preferUtcValid ? ", prefer UTC" : "");
+	    fprintf(out, "%s", rtOpts->requireUtcValid ? ", require UTC" : "");
+	}
+	fprintf(out,"\n");
+	}
+
+}
+
+static void
+jsonParent(FILE *out, PtpClock *ptpClock, const RunTimeOpts *rtOpts)
+{
+
+	char tmpBuf[200];
+
+	memset(tmpBuf, 0, sizeof(tmpBuf));
+	snprint_PortIdentity(tmpBuf, sizeof(tmpBuf), &ptpClock->portDS.portIdentity);
+	jsonMember(out, "port_id", tmpBuf);
+
+	if(ptpClock->portDS.portState >= PTP_MASTER) {
+	    memset(tmpBuf, 0, sizeof(tmpBuf));
+	    snprint_PortIdentity(tmpBuf, sizeof(tmpBuf), &ptpClock->parentDS.parentPortIdentity);
+	    jsonMember(out, "master_id", tmpBuf);
+	}
+
+	if(rtOpts->transport == UDP_IPV4 &&
+	    ptpClock->portDS.portState > PTP_MASTER &&
+	    ptpClock->bestMaster && ptpClock->bestMaster->sourceAddr) {
+	    struct in_addr tmpAddr;
+	    tmpAddr.s_addr = ptpClock->bestMaster->sourceAddr;
+	    jsonMember(out, "master_ip", inet_ntoa(tmpAddr));
+	}
+
+	if(ptpClock->portDS.portState == PTP_SLAVE) {
+	    fprintf(out, "\t\"gm_priority1\": %d,\n", ptpClock->parentDS.grandmasterPriority1);
+	    fprintf(out, "\t\"gm_priority2\": %d,\n", ptpClock->parentDS.grandmasterPriority2);
+	    fprintf(out, "\t\"gm_clock_class\": %d,\n", ptpClock->parentDS.grandmasterClockQuality.clockClass);
+	    if(rtOpts->unicastNegotiation && ptpClock->parentGrants != NULL ) {
+		fprintf(out, "\t\"local_preference\": %d,\n", ptpClock->parentGrants->localPreference);
+	    }
+	    fprintf(out, "\t\"master_timeout\": %s,\n",
+		jsonBool(ptpClock->bestMaster != NULL && ptpClock->bestMaster->disqualified));
+	}
+
+	if(ptpClock->defaultDS.clockQuality.clockClass < 128 ||
+		ptpClock->portDS.portState == PTP_SLAVE ||
+		ptpClock->portDS.portState == PTP_PASSIVE){
+	    fprintf(out, "\t\"ptp_timescale\": %s,\n", jsonBool(ptpClock->timePropertiesDS.ptpTimescale));
+	    fprintf(out, "\t\"time_traceable\": %s,\n", jsonBool(ptpClock->timePropertiesDS.timeTraceable));
+	    fprintf(out, "\t\"frequency_traceable\": %s,\n", jsonBool(ptpClock->timePropertiesDS.frequencyTraceable));
+	    jsonMember(out, "time_source", getTimeSourceName(ptpClock->timePropertiesDS.timeSource));
+	    fprintf(out, "\t\"utc_offset_valid\": %s,\n", jsonBool(ptpClock->timePropertiesDS.currentUtcOffsetValid));
+	    fprintf(out, "\t\"utc_offset\": %d,\n", ptpClock->timePropertiesDS.currentUtcOffset);
+	    fprintf(out, "\t\"leap61\": %s,\n", jsonBool(ptpClock->timePropertiesDS.leap61));
+	    fprintf(out, "\t\"leap59\": %s,\n", jsonBool(ptpClock->timePropertiesDS.leap59));
+	}
+
+}
+
+/* offset, delay, stability, clock status - master: priorities */
+
+static void
+keyOffsets(StatusKey *key, PtpClock *ptpClock, const RunTimeOpts *rtOpts)
+{
+
+	int i;
+
+	STATUS_KEY(key, ptpClock->portDS.portState);
+	STATUS_KEY(key, ptpClock->portDS.delayMechanism);
+	STATUS_KEY(key, ptpClock->portDS.peerMeanPathDelay);
+	STATUS_KEY(key, ptpClock->defaultDS.priority1);
+	STATUS_KEY(key, ptpClock->defaultDS.priority2);
+	STATUS_KEY(key, ptpClock->defaultDS.clockQuality.clockClass);
+	STATUS_KEY(key, ptpClock->parentDS.grandmasterPriority1);
+	STATUS_KEY(key, ptpClock->parentDS.grandmasterPriority2);
+	STATUS_KEY(key, ptpClock->parentDS.grandmasterClockQuality.clockClass);
+
+	if(ptpClock->portDS.portState != PTP_SLAVE) {
+	    return;
+	}
+
+	STATUS_KEY(key, ptpClock->currentDS.offsetFromMaster);
+	STATUS_KEY(key, ptpClock->currentDS.meanPathDelay);
+	/* statistics change once per window */
+	STATUS_KEY(key, ptpClock->slaveStats.statsCalculated);
+	STATUS_KEY(key, ptpClock->slaveStats.windowNumber);
+	STATUS_KEY(key, ptpClock->clockDriver->state);
+	STATUS_KEY(key, ptpClock->clockControl);
+	STATUS_KEY(key, ptpClock->isCalibrated);
+
+	if(ptpClock->stability != NULL) {
+	    for(i = 0; i < ptpClock->stability->intervalCount; i++) {
+		STATUS_KEY(key, ptpClock->stability->interval[i].valid);
+		STATUS_KEY(key, ptpClock->stability->interval[i].mtie);
+		STATUS_KEY(key, ptpClock->stability->interval[i].tdev);
+		STATUS_KEY(key, ptpClock->stability->interval[i].adev);
+	    }
+	}
+
+}
+
+static void
+textOffsets(FILE *out, PtpClock *ptpClock, const RunTimeOpts *rtOpts)
+{
+
+	char tmpBuf[200];
+
+	if(ptpClock->portDS.portState == PTP_SLAVE) {
+	    memset(tmpBuf, 0, sizeof(tmpBuf));
+	    snprint_TimeInternal(tmpBuf, sizeof(tmpBuf),
+		&ptpClock->currentDS.offsetFromMaster);
+	fprintf(out, 		STATUSPREFIX" %s s","Offset from Master", tmpBuf);
+	if(ptpClock->slaveStats.statsCalculated)
+	fprintf(out, ", mean % .09f s, dev % .09f s",
+		ptpClock->slaveStats.ofmMean,
+		ptpClock->slaveStats.ofmStdDev
+	);
+	    fprintf(out,"\n");
+
+	if(ptpClock->slaveStats.statsCalculated) {
+	    memset(tmpBuf, 0, sizeof(tmpBuf));
+	    snprint_Percentiles(tmpBuf, sizeof(tmpBuf), "", ptpClock->slaveStats.ofmPercentile, ", ");
+	    fprintf(out, 	STATUSPREFIX" %s\n","Offset percentiles", tmpBuf);
+	}
+
+	if(ptpClock->portDS.delayMechanism == E2E) {
+	    memset(tmpBuf, 0, sizeof(tmpBuf));
+	    snprint_TimeInternal(tmpBuf, sizeof(tmpBuf),
+		&ptpClock->currentDS.meanPathDelay);
+	fprintf(out, 		STATUSPREFIX" %s s","Mean Path Delay", tmpBuf);
+
+	if(ptpClock->slaveStats.statsCalculated)
+	fprintf(out, ", mean % .09f s, dev % .09f s",
+		ptpClock->slaveStats.mpdMean,
+		ptpClock->slaveStats.mpdStdDev
+	);
+	fprintf(out,"\n");
+
+	if(ptpClock->slaveStats.statsCalculated) {
+	    memset(tmpBuf, 0, sizeof(tmpBuf));
+	    snprint_Percentiles(tmpBuf, sizeof(tmpBuf), "", ptpClock->slaveStats.mpdPercentile, ", ");
+	    fprintf(out, 	STATUSPREFIX" %s\n","Delay percentiles", tmpBuf);
+	}
+	}
+	if(ptpClock->portDS.delayMechanism == P2P) {
+	    memset(tmpBuf, 0, sizeof(tmpBuf));
+	    snprint_TimeInternal(tmpBuf, sizeof(tmpBuf),
+		&ptpClock->portDS.peerMeanPathDelay);
+	fprintf(out, 		STATUSPREFIX" %s s","Mean Path (p)Delay", tmpBuf);
+	fprintf(out,"\n");
+	}
+
+	if(ptpClock->stability != NULL) {
+	    int i;
+	    PhaseStabilityInterval *interval;
+	    for(i = 0; i < ptpClock->stability->intervalCount; i++) {
+		interval = &ptpClock->stability->interval[i];
+		if(!interval->valid) {
+		    continue;
+		}
+		memset(tmpBuf, 0, sizeof(tmpBuf));
+		snprintf(tmpBuf, sizeof(tmpBuf), "Stability %d s", interval->tau);
+		fprintf(out, 	STATUSPREFIX"  MTIE %.09f s, TDEV %.09f s, ADEV %.03e\n",
+		    tmpBuf, interval->mtie, interval->tdev, interval->adev);
+	    }
+	}
+
+	fprintf(out, 		STATUSPREFIX"  ","PTP Clock status");
+	    if(ptpClock->clockDriver->state == CS_STEP) {
+		fprintf(out,"panic mode,");
+	    }
+	    if(ptpClock->clockDriver->state == CS_NEGSTEP) {
+		fprintf(out,"negative step,");
+	    }
+
+	if(rtOpts->calibrationDelay) {
+	    fprintf(out, "%s, ",
+		ptpClock->isCalibrated ? "calibrated" : "not calibrated");
+	}
+	fprintf(out, "%s",
+		ptpClock->clockControl.granted ? "in control" : "no control");
+	fprintf(out, "%s%s", ptpClock->clockControl.stepRequired ? ", STEP" : "",
+		ptpClock->clockControl.stepFailed ? " FAILED!" : "");
+	if(rtOpts->noAdjust) {
+	    fprintf(out, ", read-only");
+	} else {
+		fprintf(out, ", %s",
+		    (ptpClock->clockDriver->state == CS_LOCKED) ? "stabilised" : "not stabilised");
+	}
+	fprintf(out,"\n");
+
+	}
+
+
+	if(ptpClock->portDS.portState == PTP_MASTER || ptpClock->portDS.portState == PTP_PASSIVE) {
+
+	fprintf(out, 		STATUSPREFIX"  %d","Priority1 ", ptpClock->defaultDS.priority1);
+	if(ptpClock->portDS.portState == PTP_PASSIVE)
+		fprintf(out, " (best master: %d)", ptpClock->parentDS.grandmasterPriority1);
+	fprintf(out,"\n");
+	fprintf(out, 		STATUSPREFIX"  %d","Priority2 ", ptpClock->defaultDS.priority2);
+	if(ptpClock->portDS.portState == PTP_PASSIVE)
+		fprintf(out, " (best master: %d)", ptpClock->parentDS.grandmasterPriority2);
+	fprintf(out,"\n");
+	fprintf(out, 		STATUSPREFIX"  %d","ClockClass ", ptpClock->defaultDS.clockQuality.clockClass);
+	if(ptpClock->portDS.portState == PTP_PASSIVE)
+		fprintf(out, " (best master: %d)", ptpClock->parentDS.grandmasterClockQuality.clockClass);
+	fprintf(out,"\n");
+	if(ptpClock->portDS.delayMechanism == P2P) {
+	    memset(tmpBuf, 0, sizeof(tmpBuf));
+	    snprint_TimeInternal(tmpBuf, sizeof(tmpBuf),
+		&ptpClock->portDS.peerMeanPathDelay);
+	fprintf(out, 		STATUSPREFIX" %s s","Mean Path (p)Delay", tmpBuf);
+	fprintf(out,"\n");
+	}
+
+	}
+
+}
+
+static void
+jsonPercentiles(FILE *out, const char *name, const double *values)
+{
+
+	static const char* names[STAT_PERCENTILE_COUNT] = STAT_PERCENTILE_NAMES;
+	int i;
+
+	fprintf(out, "\t\"%s\": {", name);
+	for(i = 0; i < STAT_PERCENTILE_COUNT; i++) {
+	    fprintf(out, "%s\"%s\": %.09f", i ? ", " : " ", names[i], values[i]);
+	}
+	fprintf(out, " },\n");
+
+}
+
+static void
+jsonOffsets(FILE *out, PtpClock *ptpClock, const RunTimeOpts *rtOpts)
+{
+
+	int i;
+	Boolean first = TRUE;
+	PhaseStabilityInterval *interval;
+	PtpEngineSlaveStats *stats = &ptpClock->slaveStats;
+
+	if(ptpClock->portDS.portState == PTP_SLAVE) {
+
+	    fprintf(out, "\t\"offset_from_master\": %.09f,\n",
+		timeInternalToDouble(&ptpClock->currentDS.offsetFromMaster));
+	    if(stats->statsCalculated) {
+		fprintf(out, "\t\"offset_mean\": %.09f,\n", stats->ofmMean);
+		fprintf(out, "\t\"offset_stddev\": %.09f,\n", stats->ofmStdDev);
+		jsonPercentiles(out, "offset_percentiles", stats->ofmPercentile);
+	    }
+
+	    if(ptpClock->portDS.delayMechanism == E2E) {
+		fprintf(out, "\t\"mean_path_delay\": %.09f,\n",
+		    timeInternalToDouble(&ptpClock->currentDS.meanPathDelay));
+		if(stats->statsCalculated) {
+		    fprintf(out, "\t\"delay_mean\": %.09f,\n", stats->mpdMean);
+		    fprintf(out, "\t\"delay_stddev\": %.09f,\n", stats->mpdStdDev);
+		    jsonPercentiles(out, "delay_percentiles", stats->mpdPercentile);
+		}
+	    }
+
+	    if(ptpClock->stability != NULL) {
+		fprintf(out, "\t\"stability\": [");
+		for(i = 0; i < ptpClock->stability->intervalCount; i++) {
+		    interval = &ptpClock->stability->interval[i];
+		    if(!interval->valid) {
+			continue;
+		    }
+		    fprintf(out, "%s{ \"tau\": %d, \"mtie\": %.09f, \"tdev\": %.09f, \"adev\": %.03e }",
+			first ? " " : ", ", interval->tau, interval->mtie, interval->tdev, interval->adev);
+		    first = FALSE;
+		}
+		fprintf(out, "%s],\n", first ? "" : " ");
+	    }
+
+	    jsonMember(out, "clock_state", getClockStateName(ptpClock->clockDriver->state));
+	    if(rtOpts->calibrationDelay) {
+		fprintf(out, "\t\"calibrated\": %s,\n", jsonBool(ptpClock->isCalibrated));
+	    }
+	    fprintf(out, "\t\"clock_control\": %s,\n", jsonBool(ptpClock->clockControl.granted));
+	    fprintf(out, "\t\"step_required\": %s,\n", jsonBool(ptpClock->clockControl.stepRequired));
+	    fprintf(out, "\t\"step_failed\": %s,\n", jsonBool(ptpClock->clockControl.stepFailed));
+	    fprintf(out, "\t\"read_only\": %s,\n", jsonBool(rtOpts->noAdjust));
+
+	}
+
+	if(ptpClock->portDS.portState == PTP_MASTER || ptpClock->portDS.portState == PTP_PASSIVE) {
+	    fprintf(out, "\t\"priority1\": %d,\n", ptpClock->defaultDS.priority1);
+	    fprintf(out, "\t\"priority2\": %d,\n", ptpClock->defaultDS.priority2);
+	    fprintf(out, "\t\"clock_class\": %d,\n", ptpClock->defaultDS.clockQuality.clockClass);
+	}
+
+	if(ptpClock->portDS.delayMechanism == P2P && ptpClock->portDS.portState >= PTP_MASTER) {
+	    fprintf(out, "\t\"peer_mean_path_delay\": %.09f,\n",
+		timeInternalToDouble(&ptpClock->portDS.peerMeanPathDelay));
+	}
+
+}
+
+/* message rates, timing services, performance */
+
+static void
+keyRates(StatusKey *key, PtpClock *ptpClock, const RunTimeOpts *rtOpts)
+{
+
+	STATUS_KEY(key, ptpClock->portDS.portState);
+	STATUS_KEY(key, ptpClock->portDS.delayMechanism);
+	STATUS_KEY(key, ptpClock->portDS.logSyncInterval);
+	STATUS_KEY(key, ptpClock->portDS.logMinDelayReqInterval);
+	STATUS_KEY(key, ptpClock->portDS.logMinPdelayReqInterval);
+	STATUS_KEY(key, ptpClock->portDS.logAnnounceInterval);
+	STATUS_KEY(key, timingDomain.current);
+	STATUS_KEY(key, timingDomain.best);
+	STATUS_KEY(key, timingDomain.preferred);
+	STATUS_KEY(key, timingDomain.electionLeft);
+	STATUS_KEY(key, timingDomain.serviceCount);
+	STATUS_KEY(key, timingDomain.availableCount);
+	STATUS_KEY(key, timingDomain.operationalCount);
+	STATUS_KEY(key, timingDomain.idleCount);
+	STATUS_KEY(key, timingDomain.controlCount);
+	if(timingDomain.current != NULL) {
+	    STATUS_KEY(key, timingDomain.current->holdTimeLeft);
+	}
+	STATUS_KEY(key, ptpClock->counters.messageReceiveRate);
+	STATUS_KEY(key, ptpClock->counters.messageSendRate);
+	STATUS_KEY(key, ptpClock->slaveCount);
+	STATUS_KEY(key, ptpClock->unicastDestinationCount);
+
+}
+
+static void
+textRates(FILE *out, PtpClock *ptpClock, const RunTimeOpts *rtOpts)
+{
+
+	if(ptpClock->portDS.portState == PTP_MASTER || ptpClock->portDS.portState == PTP_PASSIVE ||
+	    ptpClock->portDS.portState == PTP_SLAVE) {
+
+	fprintf(out,		STATUSPREFIX"  ","Message rates");
+
+	if (ptpClock->portDS.logSyncInterval == UNICAST_MESSAGEINTERVAL)
+	    fprintf(out,"[UC-unknown]");
+	else if (ptpClock->portDS.logSyncInterval <= 0)
+	    fprintf(out,"%.0f/s",pow(2,-ptpClock->portDS.logSyncInterval));
+	else
+	    fprintf(out,"1/%.0fs",pow(2,ptpClock->portDS.logSyncInterval));
+	fprintf(out, " sync");
+
+
+	if(ptpClock->portDS.delayMechanism == E2E) {
+		if (ptpClock->portDS.logMinDelayReqInterval == UNICAST_MESSAGEINTERVAL)
+		    fprintf(out,", [UC-unknown]");
+		else if (ptpClock->portDS.logMinDelayReqInterval <= 0)
+		    fprintf(out,", %.0f/s",pow(2,-ptpClock->portDS.logMinDelayReqInterval));
+		else
+		    fprintf(out,", 1/%.0fs",pow(2,ptpClock->portDS.logMinDelayReqInterval));
+		fprintf(out, " delay");
+	}
+
+	if(ptpClock->portDS.delayMechanism == P2P) {
+		if (ptpClock->portDS.logMinPdelayReqInterval == UNICAST_MESSAGEINTERVAL)
+		    fprintf(out,", [UC-unknown]");
+		else if (ptpClock->portDS.logMinPdelayReqInterval <= 0)
+		    fprintf(out,", %.0f/s",pow(2,-ptpClock->portDS.logMinPdelayReqInterval));
+		else
+		    fprintf(out,", 1/%.0fs",pow(2,ptpClock->portDS.logMinPdelayReqInterval));
+		fprintf(out, " pdelay");
+	}
+
+	if (ptpClock->portDS.logAnnounceInterval == UNICAST_MESSAGEINTERVAL)
+	    fprintf(out,", [UC-unknown]");
+	else if (ptpClock->portDS.logAnnounceInterval <= 0)
+	    fprintf(out,", %.0f/s",pow(2,-ptpClock->portDS.logAnnounceInterval));
+	else
+	    fprintf(out,", 1/%.0fs",pow(2,ptpClock->portDS.logAnnounceInterval));
+	fprintf(out, " announce");
+
+	    fprintf(out,"\n");
+
+	}
+
+	fprintf(out, 		STATUSPREFIX"  ","TimingService");
+
+	fprintf(out, "current %s, best %s, pref %s", (timingDomain.current != NULL) ? timingDomain.current->id : "none",
+						(timingDomain.best != NULL) ? timingDomain.best->id : "none",
+		    				(timingDomain.preferred != NULL) ? timingDomain.preferred->id : "none");
+
+	if((timingDomain.current != NULL) &&
+	    (timingDomain.current->holdTimeLeft > 0)) {
+		fprintf(out, ", hold %d sec", timingDomain.current->holdTimeLeft);
+	} else	if(timingDomain.electionLeft) {
+		fprintf(out, ", elec %d sec", timingDomain.electionLeft);
+	}
+
+	fprintf(out, "\n");
+
+	fprintf(out, 		STATUSPREFIX"  ","TimingServices");
+
+	fprintf(out, "total %d, avail %d, oper %d, idle %d, in_ctrl %d%s\n",
+				    timingDomain.serviceCount,
+				    timingDomain.availableCount,
+				    timingDomain.operationalCount,
+				    timingDomain.idleCount,
+				    timingDomain.controlCount,
+				    timingDomain.controlCount > 1 ? " (!)":"");
+
+	fprintf(out, 		STATUSPREFIX"  ","Performance");
+	fprintf(out,"Message RX %d/s, TX %d/s", ptpClock->counters.messageReceiveRate,
+						  ptpClock->counters.messageSendRate);
+	if(ptpClock->portDS.portState == PTP_MASTER) {
+		if(rtOpts->unicastNegotiation) {
+		    fprintf(out,", slaves %d", ptpClock->slaveCount);
+		} else if (rtOpts->ipMode == IPMODE_UNICAST) {
+		    fprintf(out,", slaves %d", ptpClock->unicastDestinationCount);
+		}
+	}
+
+	fprintf(out,"\n");
+
+}
+
+static void
+jsonRates(FILE *out, PtpClock *ptpClock, const RunTimeOpts *rtOpts)
+{
+
+	if(ptpClock->portDS.portState == PTP_MASTER || ptpClock->portDS.portState == PTP_PASSIVE ||
+	    ptpClock->portDS.portState == PTP_SLAVE) {
+	    /* log2 of the interval, UNICAST_MESSAGEINTERVAL (0x7F) when not known yet */
+	    fprintf(out, "\t\"log_sync_interval\": %d,\n", ptpClock->portDS.logSyncInterval);
+	    if(ptpClock->portDS.delayMechanism == E2E) {
+		fprintf(out, "\t\"log_delay_req_interval\": %d,\n", ptpClock->portDS.logMinDelayReqInterval);
+	    }
+	    if(ptpClock->portDS.delayMechanism == P2P) {
+		fprintf(out, "\t\"log_pdelay_req_interval\": %d,\n", ptpClock->portDS.logMinPdelayReqInterval);
+	    }
+	    fprintf(out, "\t\"log_announce_interval\": %d,\n", ptpClock->portDS.logAnnounceInterval);
+	}
+
+	jsonMember(out, "timing_service_current", (timingDomain.current != NULL) ? timingDomain.current->id : "none");
+	jsonMember(out, "timing_service_best", (timingDomain.best != NULL) ? timingDomain.best->id : "none");
+	jsonMember(out, "timing_service_preferred", (timingDomain.preferred != NULL) ? timingDomain.preferred->id : "none");
+	fprintf(out, "\t\"timing_service_hold\": %d,\n",
+	    (timingDomain.current != NULL) ? timingDomain.current->holdTimeLeft : 0);
+	fprintf(out, "\t\"timing_service_election\": %d,\n", timingDomain.electionLeft);
+	fprintf(out, "\t\"timing_services\": { \"total\": %d, \"available\": %d, \"operational\": %d, \"idle\": %d, \"in_control\": %d },\n",
+				    timingDomain.serviceCount,
+				    timingDomain.availableCount,
+				    timingDomain.operationalCount,
+				    timingDomain.idleCount,
+				    timingDomain.controlCount);
+
+	fprintf(out, "\t\"message_rx_rate\": %d,\n", ptpClock->counters.messageReceiveRate);
+	fprintf(out, "\t\"message_tx_rate\": %d,\n", ptpClock->counters.messageSendRate);
+	if(ptpClock->portDS.portState == PTP_MASTER) {
+		if(rtOpts->unicastNegotiation) {
+		    fprintf(out, "\t\"slaves\": %d,\n", ptpClock->slaveCount);
+		} else if (rtOpts->ipMode == IPMODE_UNICAST) {
+		    fprintf(out, "\t\"slaves\": %d,\n", ptpClock->unicastDestinationCount);
+		}
+	}
+
+}
+
+/* message counters */
+
+static void
+keyCounters(StatusKey *key, PtpClock *ptpClock, const RunTimeOpts *rtOpts)
+{
+
+	STATUS_KEY(key, ptpClock->portDS.portState);
+	STATUS_KEY(key, ptpClock->portDS.delayMechanism);
+	STATUS_KEY(key, ptpClock->defaultDS.clockQuality.clockClass);
+	STATUS_KEY(key, ptpClock->defaultDS.twoStepFlag);
+	STATUS_KEY(key, ptpClock->counters);
+	STATUS_KEY(key, ptpClock->resetCount);
+
+}
+
+static void
+textCounters(FILE *out, PtpClock *ptpClock, const RunTimeOpts *rtOpts)
+{
+
+	if ( ptpClock->portDS.portState == PTP_SLAVE ||
+	    ptpClock->defaultDS.clockQuality.clockClass == 255 ) {
+
+	fprintf(out, 		STATUSPREFIX"  %lu\n","Announce received",
+	    (unsigned long)ptpClock->counters.announceMessagesReceived);
+	fprintf(out, 		STATUSPREFIX"  %lu\n","Sync received",
+	    (unsigned long)ptpClock->counters.syncMessagesReceived);
+	if(ptpClock->defaultDS.twoStepFlag)
+	fprintf(out, 		STATUSPREFIX"  %lu\n","Follow-up received",
+	    (unsigned long)ptpClock->counters.followUpMessagesReceived);
+	if(ptpClock->portDS.delayMechanism == E2E) {
+		fprintf(out, 		STATUSPREFIX"  %lu\n","DelayReq sent",
+		    (unsigned long)ptpClock->counters.delayReqMessagesSent);
+		fprintf(out, 		STATUSPREFIX"  %lu\n","DelayResp received",
+		    (unsigned long)ptpClock->counters.delayRespMessagesReceived);
+	}
+	}
+
+	if( ptpClock->portDS.portState == PTP_MASTER ||
+	    ptpClock->defaultDS.clockQuality.clockClass < 128 ) {
+	fprintf(out, 		STATUSPREFIX"  %lu received, %lu sent \n","Announce",
+	    (unsigned long)ptpClock->counters.announceMessagesReceived,
+	    (unsigned long)ptpClock->counters.announceMessagesSent);
+	fprintf(out, 		STATUSPREFIX"  %lu\n","Sync sent",
+	    (unsigned long)ptpClock->counters.syncMessagesSent);
+	if(ptpClock->defaultDS.twoStepFlag)
+	fprintf(out, 		STATUSPREFIX"  %lu\n","Follow-up sent",
+	    (unsigned long)ptpClock->counters.followUpMessagesSent);
+
+	if(ptpClock->portDS.delayMechanism == E2E) {
+		fprintf(out, 		STATUSPREFIX"  %lu\n","DelayReq received",
+		    (unsigned long)ptpClock->counters.delayReqMessagesReceived);
+		fprintf(out, 		STATUSPREFIX"  %lu\n","DelayResp sent",
+		    (unsigned long)ptpClock->counters.delayRespMessagesSent);
+	}
+
+	}
+
+	if(ptpClock->portDS.delayMechanism == P2P) {
+
+		fprintf(out, 		STATUSPREFIX"  %lu received, %lu sent\n","PdelayReq",
+		    (unsigned long)ptpClock->counters.pdelayReqMessagesReceived,
+		    (unsigned long)ptpClock->counters.pdelayReqMessagesSent);
+		fprintf(out, 		STATUSPREFIX"  %lu received, %lu sent\n","PdelayResp",
+		    (unsigned long)ptpClock->counters.pdelayRespMessagesReceived,
+		    (unsigned long)ptpClock->counters.pdelayRespMessagesSent);
+		fprintf(out, 		STATUSPREFIX"  %lu received, %lu sent\n","PdelayRespFollowUp",
+		    (unsigned long)ptpClock->counters.pdelayRespFollowUpMessagesReceived,
+		    (unsigned long)ptpClock->counters.pdelayRespFollowUpMessagesSent);
+
+	}
+
+	if(ptpClock->counters.domainMismatchErrors)
+	fprintf(out, 		STATUSPREFIX"  %lu\n","Domain Mismatches",
+		    (unsigned long)ptpClock->counters.domainMismatchErrors);
+
+	if(ptpClock->counters.ignoredAnnounce)
+	fprintf(out, 		STATUSPREFIX"  %lu\n","Ignored Announce",
+		    (unsigned long)ptpClock->counters.ignoredAnnounce);
+
+	if(ptpClock->counters.unicastGrantsDenied)
+	fprintf(out, 		STATUSPREFIX"  %lu\n","Denied Unicast",
+		    (unsigned long)ptpClock->counters.unicastGrantsDenied);
+
+	fprintf(out, 		STATUSPREFIX"  %lu\n","State transitions",
+		    (unsigned long)ptpClock->counters.stateTransitions);
+	fprintf(out, 		STATUSPREFIX"  %lu\n","PTP Engine resets",
+		    (unsigned long)ptpClock->resetCount);
+	fprintf(out,"                                   \n");
+
+}
+
+static void
+jsonCounters(FILE *out, PtpClock *ptpClock, const RunTimeOpts *rtOpts)
+{
+
+	PtpdCounters *counters = &ptpClock->counters;
+
+	fprintf(out, "\t\"counters\": {\n");
+	fprintf(out, "\t\t\"announce_received\": %lu,\n", (unsigned long)counters->announceMessagesReceived);
+	fprintf(out, "\t\t\"announce_sent\": %lu,\n", (unsigned long)counters->announceMessagesSent);
+	fprintf(out, "\t\t\"sync_received\": %lu,\n", (unsigned long)counters->syncMessagesReceived);
+	fprintf(out, "\t\t\"sync_sent\": %lu,\n", (unsigned long)counters->syncMessagesSent);
+	fprintf(out, "\t\t\"followup_received\": %lu,\n", (unsigned long)counters->followUpMessagesReceived);
+	fprintf(out, "\t\t\"followup_sent\": %lu,\n", (unsigned long)counters->followUpMessagesSent);
+	fprintf(out, "\t\t\"delayreq_received\": %lu,\n", (unsigned long)counters->delayReqMessagesReceived);
+	fprintf(out, "\t\t\"delayreq_sent\": %lu,\n", (unsigned long)counters->delayReqMessagesSent);
+	fprintf(out, "\t\t\"delayresp_received\": %lu,\n", (unsigned long)counters->delayRespMessagesReceived);
+	fprintf(out, "\t\t\"delayresp_sent\": %lu,\n", (unsigned long)counters->delayRespMessagesSent);
+	fprintf(out, "\t\t\"pdelayreq_received\": %lu,\n", (unsigned long)counters->pdelayReqMessagesReceived);
+	fprintf(out, "\t\t\"pdelayreq_sent\": %lu,\n", (unsigned long)counters->pdelayReqMessagesSent);
+	fprintf(out, "\t\t\"pdelayresp_received\": %lu,\n", (unsigned long)counters->pdelayRespMessagesReceived);
+	fprintf(out, "\t\t\"pdelayresp_sent\": %lu,\n", (unsigned long)counters->pdelayRespMessagesSent);
+	fprintf(out, "\t\t\"pdelayrespfollowup_received\": %lu,\n", (unsigned long)counters->pdelayRespFollowUpMessagesReceived);
+	fprintf(out, "\t\t\"pdelayrespfollowup_sent\": %lu,\n", (unsigned long)counters->pdelayRespFollowUpMessagesSent);
+	fprintf(out, "\t\t\"domain_mismatches\": %lu,\n", (unsigned long)counters->domainMismatchErrors);
+	fprintf(out, "\t\t\"ignored_announce\": %lu,\n", (unsigned long)counters->ignoredAnnounce);
+	fprintf(out, "\t\t\"unicast_grants_denied\": %lu,\n", (unsigned long)counters->unicastGrantsDenied);
+	fprintf(out, "\t\t\"state_transitions\": %lu,\n", (unsigned long)counters->stateTransitions);
+	fprintf(out, "\t\t\"engine_resets\": %lu\n", (unsigned long)ptpClock->resetCount);
+	fprintf(out, "\t},\n");
+
+}
+
+/* clock drivers: their info lines are their own, so always rendered */
+
+static void
+keyClocks(StatusKey *key, PtpClock *ptpClock, const RunTimeOpts *rtOpts)
+{
+	key->length = -1;
+}
+
+static void
+textClocks(FILE *out, PtpClock *ptpClock, const RunTimeOpts *rtOpts)
+{
+
+	if(ptpClock->clockDriver != NULL) {
+	    char buf[100];
+	    int i = 1;
+	    for(ClockDriver *cd = ptpClock->clockDriver->_first; cd != NULL; cd=cd->_next) {
+		    cd->putInfoLine(cd, buf, 100);
+		    fprintf(out, "Clock %d: %-9s : %s\n", i++, cd->name, buf);
+	    }
+	    i = 1;
+	    for(ClockDriver *cd = ptpClock->clockDriver->_first; cd != NULL; cd=cd->_next) {
+		    cd->putStatsLine(cd, buf, 100);
+		    fprintf(out, "Clock %d: %-9s : %s\n",i++, cd->name, buf);
+	    }
+	    i = 1;
+	    for(ClockDriver *cd = ptpClock->clockDriver->_first; cd != NULL; cd=cd->_next, i++) {
+		    if(cd->estimator.measurements == 0) {
+			continue;
+		    }
+		    cd->estimator.putInfoLine(&cd->estimator, buf, 100);
+		    fprintf(out, "Clock %d: %-9s : %s\n", i, cd->name, buf);
+	    }
+
+	}
+
+}
+
+static void
+jsonClocks(FILE *out, PtpClock *ptpClock, const RunTimeOpts *rtOpts)
+{
+
+	char buf[100];
+	Boolean first = TRUE;
+
+	if(ptpClock->clockDriver == NULL) {
+	    return;
+	}
+
+	fprintf(out, "\t\"clocks\": [");
+
+	for(ClockDriver *cd = ptpClock->clockDriver->_first; cd != NULL; cd=cd->_next) {
+	    fprintf(out, "%s\n\t\t{ \"name\": ", first ? "" : ",");
+	    jsonString(out, cd->name);
+	    fprintf(out, ", \"state\": \"%s\"", getClockStateName(cd->state));
+	    cd->putInfoLine(cd, buf, 100);
+	    fprintf(out, ", \"info\": ");
+	    jsonString(out, buf);
+	    cd->putStatsLine(cd, buf, 100);
+	    fprintf(out, ", \"stats\": ");
+	    jsonString(out, buf);
+	    if(cd->estimator.measurements > 0) {
+		cd->estimator.putInfoLine(&cd->estimator, buf, 100);
+		fprintf(out, ", \"estimator\": ");
+		jsonString(out, buf);
+	    }
+	    fprintf(out, " }");
+	    first = FALSE;
+	}
+
+	fprintf(out, "\n\t],\n");
+
+}
+
+/* in the order they appear in the file */
+static const StatusSectionHandler sectionHandlers[] = {
+	{ keyHost,	textHost,	jsonHost },
+	{ keyTime,	textTime,	jsonTime },
+	{ keyPort,	textPort,	jsonPort },
+	{ keyAlarms,	textAlarms,	jsonAlarms },
+	{ keyParent,	textParent,	jsonParent },
+	{ keyOffsets,	textOffsets,	jsonOffsets },
+	{ keyRates,	textRates,	jsonRates },
+	{ keyCounters,	textCounters,	jsonCounters },
+	{ keyClocks,	textClocks,	jsonClocks }
+};
+
+#define STATUS_SECTION_COUNT (sizeof(sectionHandlers) / sizeof(sectionHandlers[0]))
+
+static StatusSection sections[STATUS_SECTION_COUNT];
+
+/* render everything on the next update: format or file changed */
+void
+invalidateStatusFile()
+{
+
+	int i;
+
+	for(i = 0; i < STATUS_SECTION_COUNT; i++) {
+	    sections[i].valid = FALSE;
+	}
+
+}
+
+/* render the section if its key has changed, return TRUE if it was rendered */
+static Boolean
+updateSection(int index, PtpClock *ptpClock, const RunTimeOpts *rtOpts)
+{
+
+	const StatusSectionHandler *handler = &sectionHandlers[index];
+	StatusSection *section = &sections[index];
+	StatusKey key;
+	FILE *out;
+
+	key.length = 0;
+	handler->key(&key, ptpClock, rtOpts);
+
+	if(section->valid && key.length >= 0 && key.length == section->key.length &&
+	    !memcmp(key.data, section->key.data, key.length)) {
+		return FALSE;
+	}
+
+	section->key = key;
+	section->length = 0;
+	section->valid = FALSE;
+
+	if((out = fmemopen(section->text, sizeof(section->text), "w")) == NULL) {
+	    DBG("writeStatusFile: could not open memory stream: %s\n", strerror(errno));
+	    return TRUE;
+	}
+
+	if(rtOpts->statusFileFormat == STATUSFILE_JSON) {
+	    handler->json(out, ptpClock, rtOpts);
+	} else {
+	    handler->text(out, ptpClock, rtOpts);
+	}
+
+	fflush(out);
+	section->length = ftell(out);
+	fclose(out);
+
+	/* truncated output: the stream keeps the last byte for the terminator */
+	if(section->length >= sizeof(section->text) - 1) {
+	    DBG("writeStatusFile: section %d truncated\n", index);
+	    section->length = strlen(section->text);
+	}
+
+	section->valid = TRUE;
+
+	return TRUE;
+
+}
+
+void
+writeStatusFile(PtpClock *ptpClock,const RunTimeOpts *rtOpts, Boolean quiet)
+{
+
+	static char outBuf[STATUS_FILE_SIZE];
+	Boolean changed = FALSE;
+	int len = 0;
+	int i;
+
+	if(rtOpts->statusLog.logFP == NULL)
+	    return;
+
+	for(i = 0; i < STATUS_SECTION_COUNT; i++) {
+	    changed |= updateSection(i, ptpClock, rtOpts);
+	}
+
+	if(!changed) {
+	    return;
+	}
+
+	if(rtOpts->statusFileFormat == STATUSFILE_JSON) {
+	    len += snprintf(outBuf, sizeof(outBuf), "{\n");
+	}
+
+	for(i = 0; i < STATUS_SECTION_COUNT; i++) {
+	    if(len + sections[i].length >= sizeof(outBuf) - 4) {
+		break;
+	    }
+	    memcpy(outBuf + len, sections[i].text, sections[i].length);
+	    len += sections[i].length;
+	}
+
+	if(rtOpts->statusFileFormat == STATUSFILE_JSON) {
+	    /* the last member has no comma */
+	    if(len > 2 && outBuf[len - 2] == ',') {
+		len -= 2;
+	    }
+	    len += snprintf(outBuf + len, sizeof(outBuf) - len, "\n}\n");
+	}
+
+	logWrite(LOGJOB_REPLACE, 0, 0, (LogFileHandler*)&rtOpts->statusLog, NULL, outBuf, len);
+
+}
@@ -335,16 +335,39 @@ snprint_PortIdentity(char *s, int max_len, const PortIdentity *id)
 	return len;
 }
 
-/* Write a formatted string to file pointer */
-int writeMessage(FILE* destination, uint32_t *lastHash, int priority, const char * format, va_list ap) {
+/* percentiles from a stats window: "<prefix>p50 <value> s<separator><prefix>p90 ..." */
+int
+snprint_Percentiles(char *s, int max_len, const char *prefix, const double *values, const char *separator)
+{
+	static const char *names[STAT_PERCENTILE_COUNT] = STAT_PERCENTILE_NAMES;
+	int len = 0;
+	int i;
+
+	for(i = 0; i < STAT_PERCENTILE_COUNT && len < max_len; i++) {
+		len += snprintf(&s[len], max_len - len, "%s%s%s % .09f s", (i > 0) ? separator : "",
+			prefix, names[i], values[i]);
+	}
+
+	return len;
+}
+
+/*
+ * Format a log message and write it to a log file handler or, if handler is
+ * NULL, to destination. The line is built in full first and handed to
+ * logWrite() in one piece, so it can be queued to the housekeeping thread.
+ */
+int writeMessage(LogFileHandler *handler, FILE* destination, uint32_t *lastHash, int priority, const char * format, va_list ap) {
 
 
 	extern RunTimeOpts rtOpts;
 	extern Boolean startupInProgress;
 
 	int written;
+	int len = 0;
 	char time_str[MAXTIMESTR];
+	char line[PATH_MAX + 256];
 	struct timeval now;
+	struct tm tm;
 #ifndef RUNTIME_DEBUG
 	char buf[PATH_MAX +1];
 	uint32_t hash;
@@ -354,6 +377,10 @@ int writeMessage(FILE* destination, uint32_t *lastHash, int priority, const char
 	extern char *translatePortState(PtpClock *ptpClock);
 	extern PtpClock *G_ptpClock;
 
+	if(handler != NULL) {
+		destination = handler->logFP;
+	}
+
 	if(destination == NULL)
 		return -1;
 
@@ -369,6 +396,7 @@ int writeMessage(FILE* destination, uint32_t *lastHash, int priority, const char
 	memset(buf, 0, sizeof(buf));
 	va_copy(ap1, ap);
 	vsnprintf(buf, PATH_MAX, format, ap1);
+	va_end(ap1);
 	hash = fnvHash(buf, sizeof(buf), 0);
 	if(lastHash != NULL) {
 	    if(format[0] != '\n' && lastHash != NULL) {
@@ -390,9 +418,9 @@ int writeMessage(FILE* destination, uint32_t *lastHash, int priority, const char
 		 *  handling synchronous, and not calling this function inside asycnhronous signal processing)
 		 */
 		gettimeofday(&now, 0);
-		strftime(time_str, MAXTIMESTR, "%F %X", localtime((time_t*)&now.tv_sec));
-		fprintf(destination, "%s.%06d ", time_str, (int)now.tv_usec  );
-		fprintf(destination,PTPD_PROGNAME"[%d].%s (%-9s ",
+		strftime(time_str, MAXTIMESTR, "%F %X", localtime_r((time_t*)&now.tv_sec, &tm));
+		len += snprintf(line + len, sizeof(line) - len, "%s.%06d ", time_str, (int)now.tv_usec  );
+		len += snprintf(line + len, sizeof(line) - len, PTPD_PROGNAME"[%d].%s (%-9s ",
 		(int)getpid(), startupInProgress ? "startup" : rtOpts.ifaceName,
 		priority == LOG_EMERG   ? "emergency)" :
 		priority == LOG_ALERT   ? "alert)" :
@@ -407,10 +435,30 @@ int writeMessage(FILE* destination, uint32_t *lastHash, int priority, const char
 		"unk)");
 
 
-		fprintf(destination, " (%s) ", G_ptpClock ?
+		len += snprintf(line + len, sizeof(line) - len, " (%s) ", G_ptpClock ?
 		       translatePortState(G_ptpClock) : "___");
 	}
-	written = vfprintf(destination, format, ap);
+
+	if(len >= sizeof(line)) {
+		len = sizeof(line) - 1;
+	}
+
+	written = vsnprintf(line + len, sizeof(line) - len, format, ap);
+
+	if(written < 0) {
+		return written;
+	}
+
+	len += written;
+	if(len >= sizeof(line)) {
+		len = sizeof(line) - 1;
+	}
+
+	if(!logWrite(LOGJOB_WRITE, (handler != NULL) ? LOGWRITE_MAINTAIN : 0, priority,
+		    handler, destination, line, len)) {
+		return -1;
+	}
+
 	return written;
 
 }
@@ -461,8 +509,7 @@ logMessage(int priority, const char * format, ...)
 	}
 	/* If we're using a log file and the message has been written OK, we're done*/
 	if(rtOpts.eventLog.logEnabled && rtOpts.eventLog.logFP != NULL) {
-	    if(writeMessage(rtOpts.eventLog.logFP, &rtOpts.eventLog.lastHash, priority, format, ap) > 0) {
-		maintainLogSize(&rtOpts.eventLog);
+	    if(writeMessage(&rtOpts.eventLog, NULL, &rtOpts.eventLog.lastHash, priority, format, ap) > 0) {
 		if(!startupInProgress)
 		    goto end;
 		else {
@@ -480,6 +527,7 @@ logMessage(int priority, const char * format, ...)
 	if (rtOpts.useSysLog ||
 	    (!rtOpts.nonDaemon && startupInProgress)) {
 		static Boolean syslogOpened;
+		char sysBuf[PATH_MAX + 1];
 #ifdef RUNTIME_DEBUG
 		/*
 		 *  Syslog only has 8 message levels (3 bits)
@@ -494,7 +542,8 @@ logMessage(int priority, const char * format, ...)
 			openlog(PTPD_PROGNAME, LOG_PID, LOG_DAEMON);
 			syslogOpened = TRUE;
 		}
-		vsyslog(priority, format, ap);
+		vsnprintf(sysBuf, sizeof(sysBuf), format, ap);
+		logWrite(LOGJOB_SYSLOG, 0, priority, NULL, NULL, sysBuf, strlen(sysBuf) + 1);
 		if (!startupInProgress) {
 			goto end;
 		}
@@ -506,7 +555,7 @@ logMessage(int priority, const char * format, ...)
 std_err:
 
 	/* Either all else failed or we're running in foreground - or we also log to stderr */
-	writeMessage(stderr, &rtOpts.eventLog.lastHash, priority, format, ap1);
+	writeMessage(NULL, stderr, &rtOpts.eventLog.lastHash, priority, format, ap1);
 
 end:
 	va_end(ap1);
@@ -515,6 +564,35 @@ end:
 }
 
 
+/* Open a file log target, NULL if it could not be opened */
+static FILE*
+openLogFile(LogFileHandler* handler, Boolean quiet)
+{
+
+	FILE *fp;
+
+	if ( (fp = fopen(handler->logPath, handler->openMode)) == NULL) {
+		if(!quiet) PERROR("Could not open %s file", handler->logID);
+		return NULL;
+	}
+
+	if(handler->truncateOnReopen) {
+		if(!ftruncate(fileno(fp), 0)) {
+			if(!quiet) INFO("Truncated %s file\n", handler->logID);
+		} else
+			DBG("Could not truncate % file: %s\n", handler->logID, handler->logPath);
+	}
+	/* \n flushes output for us, no need for fflush() - unless the handler wants a full buffer */
+	if(handler->bufferSize) {
+		setvbuf(fp, NULL, _IOFBF, handler->bufferSize);
+	} else {
+		setlinebuf(fp);
+	}
+
+	return fp;
+
+}
+
 /* Restart a file log target based on its settings  */
 int
 restartLog(LogFileHandler* handler, Boolean quiet)
@@ -531,6 +609,8 @@ restartLog(LogFileHandler* handler, Boolean quiet)
 		handler->logFP=NULL;
                 /* If we're not logging to file (any more), call it quits */
                 if (!handler->logEnabled) {
+		    SAFE_FREE(handler->header);
+		    handler->headerLength = 0;
                     if(!quiet) INFO("Logging to %s file disabled. Closing file.\n", handler->logID);
 		    if(handler->unlinkOnClose)
 			unlink(handler->logPath);
@@ -541,20 +621,8 @@ restartLog(LogFileHandler* handler, Boolean quiet)
         if (!handler->logEnabled)
                 return 1;
 
-	/* Open the file */
-        if ( (handler->logFP = fopen(handler->logPath, handler->openMode)) == NULL) {
-                if(!quiet) PERROR("Could not open %s file", handler->logID);
-        } else {
-		if(handler->truncateOnReopen) {
-			if(!ftruncate(fileno(handler->logFP), 0)) {
-				if(!quiet) INFO("Truncated %s file\n", handler->logID);
-			} else
-				DBG("Could not truncate % file: %s\n", handler->logID, handler->logPath);
-		}
-		/* \n flushes output for us, no need for fflush() - if you want something different, set it later */
-                setlinebuf(handler->logFP);
+	handler->logFP = openLogFile(handler, quiet);
 
-	}
         return (handler->logFP != NULL);
 }
 
@@ -562,6 +630,9 @@ restartLog(LogFileHandler* handler, Boolean quiet)
 static int
 closeLog(LogFileHandler* handler)
 {
+	SAFE_FREE(handler->header);
+	handler->headerLength = 0;
+
         if(handler->logFP != NULL) {
                 fclose(handler->logFP);
 		handler->logFP=NULL;
@@ -572,8 +643,17 @@ closeLog(LogFileHandler* handler)
 }
 
 
-/* Return TRUE only if the log file had to be rotated / truncated - FALSE does not mean error */
-/* Mini-logrotate: truncate file if exceeds preset size, also rotate up to n number of files if configured */
+/*
+ * Mini-logrotate: truncate file if exceeds preset size, also rotate up to n number of files if configured.
+ *
+ * Runs in whichever thread writes the file - with the housekeeping thread
+ * enabled, that is not the protocol thread. So this does not log: it
+ * counts rotations and failures in the handler and reportHousekeeping()
+ * logs them from the protocol thread. The new file is opened before the
+ * old one is closed, so logFP is never NULL or stale while the protocol
+ * thread looks at it. Returns TRUE only if the file was rotated / truncated
+ * - FALSE does not mean error.
+ */
 Boolean
 maintainLogSize(LogFileHandler* handler)
 {
@@ -582,10 +662,6 @@ maintainLogSize(LogFileHandler* handler)
 		if(handler->logFP == NULL)
 		    return FALSE;
 		updateLogSize(handler);
-#ifdef RUNTIME_DEBUG
-/* 2.3.1: do not print to stderr or log file */
-//		fprintf(stderr, "%s logsize: %d\n", handler->logID, handler->fileSize);
-#endif /* RUNTIME_DEBUG */
 		if(handler->fileSize > (handler->maxSize * 1024)) {
 
 		    /* Rotate the log file */
@@ -595,6 +671,8 @@ maintainLogSize(LogFileHandler* handler)
 			time_t maxMtime = 0;
 			struct stat st;
 			char fname[PATH_MAX];
+			FILE *oldFP = handler->logFP;
+			FILE *newFP;
 			/* Find the last modified file of the series */
 			while(++i <= handler->maxFiles) {
 				memset(fname, 0, PATH_MAX);
@@ -613,28 +691,32 @@ maintainLogSize(LogFileHandler* handler)
 			snprintf(fname, PATH_MAX,"%s.%d", handler->logPath, logFileNumber);
 			/* Move current file to new location */
 			rename(handler->logPath, fname);
-			/* Reopen to reactivate the original path */
-			if(restartLog(handler,TRUE)) {
-				INFO("Rotating %s file - size above %dkB\n",
-					handler->logID, handler->maxSize);
-			} else {
-				DBG("Could not rotate %s file\n", handler->logPath);
+			/* Reopen to reactivate the original path - keep writing to the old file if we can't */
+			if((newFP = openLogFile(handler, TRUE)) == NULL) {
+				__sync_fetch_and_add(&handler->rotateErrors, 1);
+				return FALSE;
 			}
-			return TRUE;
+			__sync_synchronize();
+			handler->logFP = newFP;
+			__sync_synchronize();
+			fclose(oldFP);
 		    /* Just truncate - maxSize given but no maxFiles */
 		    } else {
-
-			if(!ftruncate(fileno(handler->logFP),0)) {
-			INFO("Truncating %s file - size above %dkB\n",
-				handler->logID, handler->maxSize);
-			} else {
-#ifdef RUNTIME_DEBUG
-/* 2.3.1: do not print to stderr or log file */
-//				fprintf(stderr, "Could not truncate %s file\n", handler->logPath);
-#endif
+			fflush(handler->logFP);
+			if(ftruncate(fileno(handler->logFP),0) < 0) {
+				__sync_fetch_and_add(&handler->rotateErrors, 1);
+				return FALSE;
 			}
-			return TRUE;
 		    }
+
+		    /* the new file starts with the header, before anything queued behind it */
+		    if(handler->header != NULL) {
+			fwrite(handler->header, handler->headerLength, 1, handler->logFP);
+			fflush(handler->logFP);
+		    }
+		    __sync_fetch_and_add(&handler->rotations, 1);
+		    return TRUE;
+
 		}
 	}
 
@@ -646,6 +728,9 @@ void
 restartLogging(RunTimeOpts* rtOpts)
 {
 
+	/* nothing must be writing to the files while we reopen them */
+	syncHousekeeping();
+
 	if(!restartLog(&rtOpts->statisticsLog, TRUE))
 		NOTIFY("Failed logging to %s file\n", rtOpts->statisticsLog.logID);
 
@@ -657,16 +742,115 @@ restartLogging(RunTimeOpts* rtOpts)
 
 	if(!restartLog(&rtOpts->statusLog, TRUE))
 		NOTIFY("Failed logging to %s file\n", rtOpts->statusLog.logID);
+	/* new file, possibly new format or settings: render it all */
+	invalidateStatusFile();
+
+	if(!restartLog(&rtOpts->captureLog, TRUE))
+		NOTIFY("Failed logging to %s file\n", rtOpts->captureLog.logID);
+
+	if(!restartTelemetry(rtOpts))
+		NOTIFY("Failed writing telemetry to %s\n", rtOpts->telemetryFile);
 
 }
 
 void
 stopLogging(RunTimeOpts* rtOpts)
 {
+	syncHousekeeping();
 	closeLog(&rtOpts->statisticsLog);
 	closeLog(&rtOpts->recordLog);
 	closeLog(&rtOpts->eventLog);
 	closeLog(&rtOpts->statusLog);
+	closeLog(&rtOpts->captureLog);
+	stopTelemetry(rtOpts);
+}
+
+static void
+writeStatisticsLogHeader(LogFileHandler *handler, Enumeration8 timestampFormat)
+{
+	char buf[sizeof(StatisticsLogHeader) + sizeof(STATSLOG_FIELDS) + 8];
+	StatisticsLogHeader *header = (StatisticsLogHeader*)buf;
+	/* description NUL-padded to keep records 8-byte aligned */
+	size_t length = sizeof(StatisticsLogHeader) + ((sizeof(STATSLOG_FIELDS) + 7) & ~7);
+
+	memset(buf, 0, sizeof(buf));
+	header->tag = STATSLOG_TAG_HEADER;
+	header->length = length;
+	header->magic = STATSLOG_MAGIC;
+	header->version = STATSLOG_VERSION;
+	header->recordSize = sizeof(StatisticsLogRecord);
+	header->timestampFormat = timestampFormat;
+	memcpy(buf + sizeof(StatisticsLogHeader), STATSLOG_FIELDS, sizeof(STATSLOG_FIELDS));
+
+	logWrite(LOGJOB_WRITE, LOGWRITE_HEADER, 0, handler, NULL, buf, length);
+}
+
+static void
+statisticsLogTime(StatisticsLogTime *dst, const TimeInternal *src)
+{
+	dst->seconds = src->seconds;
+	dst->nanoseconds = src->nanoseconds;
+}
+
+/*
+ * Binary counterpart of the CSV line: the raw values only, formatting is
+ * left to ptpd-stats2csv. stdio buffers the records and we push them out
+ * once per second, which is also when the file size limit is checked.
+ */
+static void
+logStatisticsBinary(LogFileHandler *handler, PtpClock *ptpClock, const TimeInternal *now)
+{
+	extern RunTimeOpts rtOpts;
+	static int errorMsg = 0;
+	static Integer32 lastFlush = 0;
+	StatisticsLogRecord record;
+	int flags = 0;
+	Boolean e2e = (rtOpts.delayMechanism == E2E);
+
+	memset(&record, 0, sizeof(record));
+
+	record.tag = STATSLOG_TAG_RECORD;
+	record.length = sizeof(record);
+	record.seconds = now->seconds;
+	record.nanoseconds = now->nanoseconds;
+	record.resetCount = ptpClock->resetCount;
+	record.portState = ptpClock->portDS.portState;
+	record.lastMessage = ptpClock->char_last_msg;
+	record.sequenceId = ptpClock->msgTmpHeader.sequenceId;
+	record.delayMechanism = e2e ? STATSLOG_E2E : STATSLOG_P2P;
+
+	memcpy(record.parentClockIdentity, ptpClock->parentDS.parentPortIdentity.clockIdentity, CLOCK_IDENTITY_LENGTH);
+	record.parentPortNumber = ptpClock->parentDS.parentPortIdentity.portNumber;
+	memcpy(record.grandmasterIdentity, ptpClock->parentDS.grandmasterIdentity, CLOCK_IDENTITY_LENGTH);
+
+	statisticsLogTime(&record.meanPathDelay, e2e ? &ptpClock->currentDS.meanPathDelay :
+						    &ptpClock->portDS.peerMeanPathDelay);
+	statisticsLogTime(&record.offsetFromMaster, &ptpClock->currentDS.offsetFromMaster);
+	statisticsLogTime(&record.delaySM, e2e ? &ptpClock->delaySM : &ptpClock->pdelaySM);
+	statisticsLogTime(&record.delayMS, &ptpClock->delayMS);
+	statisticsLogTime(&record.rawDelayMS, &ptpClock->rawDelayMS);
+	statisticsLogTime(&record.rawDelaySM, &ptpClock->rawDelaySM);
+
+	if(ptpClock->clockDriver != NULL) {
+		record.observedDrift = ptpClock->clockDriver->servo.integral;
+	}
+	record.mpdMean = ptpClock->slaveStats.mpdMean;
+	record.mpdStdDev = ptpClock->slaveStats.mpdStdDev;
+	record.ofmMean = ptpClock->slaveStats.ofmMean;
+	record.ofmStdDev = ptpClock->slaveStats.ofmStdDev;
+
+	if(now->seconds != lastFlush) {
+		lastFlush = now->seconds;
+		flags = LOGWRITE_FLUSH | LOGWRITE_MAINTAIN;
+	}
+
+	if(!logWrite(LOGJOB_WRITE, flags, 0, handler, NULL, &record, sizeof(record))) {
+		if(!errorMsg) {
+		    WARNING("Could not queue statistics log entry\n");
+		}
+		errorMsg = TRUE;
+	}
+
 }
 
 void
@@ -679,25 +863,38 @@ logStatistics(PtpClock * ptpClock)
 	TimeInternal now;
 	time_t time_s;
 	FILE* destination;
+	LogFileHandler *handler = NULL;
 	static TimeInternal prev_now_sync, prev_now_delay;
 	char time_str[MAXTIMESTR];
+	struct tm tm;
+	Boolean binary = FALSE;
 
 	if (!rtOpts.logStatistics) {
 		return;
 	}
 
-	if(rtOpts.statisticsLog.logEnabled && rtOpts.statisticsLog.logFP != NULL)
-	    destination = rtOpts.statisticsLog.logFP;
-	else
+	if(rtOpts.statisticsLog.logEnabled && rtOpts.statisticsLog.logFP != NULL) {
+	    handler = &rtOpts.statisticsLog;
+	    destination = NULL;
+	    binary = (rtOpts.statisticsFileFormat == STATSFILE_BINARY);
+	} else {
 	    destination = stdout;
+	}
+
+	if (ptpClock->resetStatisticsLog && binary) {
+		ptpClock->resetStatisticsLog = FALSE;
+		writeStatisticsLogHeader(handler, rtOpts.statisticsTimestamp);
+	}
 
 	if (ptpClock->resetStatisticsLog) {
 		ptpClock->resetStatisticsLog = FALSE;
-		fprintf(destination,"# %s, State, Clock ID, One Way Delay, "
+		len = snprintf(sbuf, sizeof(sbuf), "# %s, State, Clock ID, One Way Delay, "
 		       "Offset From Master, Slave to Master, "
 		       "Master to Slave, Observed Drift, Last packet Received, Sequence ID"
 			", One Way Delay Mean, One Way Delay Std Dev, Offset From Master Mean, Offset From Master Std Dev, Observed Drift Mean, Observed Drift Std Dev, raw delayMS, raw delaySM"
 			"\n", (rtOpts.statisticsTimestamp == TIMESTAMP_BOTH) ? "Timestamp, Unix timestamp" : "Timestamp");
+		logWrite(LOGJOB_WRITE, LOGWRITE_HEADER, 0, handler, destination, sbuf, len);
+		len = 0;
 	}
 
 	memset(sbuf, 0, sizeof(sbuf));
@@ -730,12 +927,17 @@ logStatistics(PtpClock * ptpClock)
 		}
 	}
 
+	if (binary) {
+		logStatisticsBinary(handler, ptpClock, &now);
+		return;
+	}
+
 	time_s = now.seconds;
 
 	/* output date-time timestamp if configured */
 	if (rtOpts.statisticsTimestamp == TIMESTAMP_DATETIME ||
 	    rtOpts.statisticsTimestamp == TIMESTAMP_BOTH) {
-	    strftime(time_str, MAXTIMESTR, "%Y-%m-%d %X", localtime(&time_s));
+	    strftime(time_str, MAXTIMESTR, "%Y-%m-%d %X", localtime_r(&time_s, &tm));
 	    len += snprintf(sbuf + len, sizeof(sbuf) - len, "%s.%06d, %s, ",
 		       time_str, (int)now.nanoseconds/1000, /* Timestamp */
 		       translatePortState(ptpClock)); /* State */
@@ -839,19 +1041,16 @@ logStatistics(PtpClock * ptpClock)
 	/* add final \n in normal status lines */
 	len += snprintf(sbuf + len, sizeof(sbuf) - len, "\n");
 
-	/* fprintf may get interrupted by a signal - silently retry once */
-	if (fprintf(destination, "%s", sbuf) < len) {
-	    if (fprintf(destination, "%s", sbuf) < len) {
+	if (len >= sizeof(sbuf)) {
+		len = sizeof(sbuf) - 1;
+	}
+
+	/* the size check is done after writing, rotation is picked up on the next entry */
+	if (!logWrite(LOGJOB_WRITE, LOGWRITE_MAINTAIN, 0, handler, destination, sbuf, len)) {
 		if(!errorMsg) {
-		    PERROR("Error while writing statistics");
+		    WARNING("Could not queue statistics log entry\n");
 		}
 		errorMsg = TRUE;
-	    }
-	}
-
-	if(destination == rtOpts.statisticsLog.logFP) {
-		if (maintainLogSize(&rtOpts.statisticsLog))
-			ptpClock->resetStatisticsLog = TRUE;
 	}
 
 }
@@ -863,10 +1062,12 @@ periodicUpdate(const RunTimeOpts *rtOpts, PtpClock *ptpClock)
 
     char tmpBuf[200];
     char masterIdBuf[150];
+    char percentileBuf[160];
     int len = 0;
 
     memset(tmpBuf, 0, sizeof(tmpBuf));
     memset(masterIdBuf, 0, sizeof(masterIdBuf));
+    memset(percentileBuf, 0, sizeof(percentileBuf));
 
     TimeInternal *mpd = &ptpClock->currentDS.meanPathDelay;
 
@@ -888,20 +1089,26 @@ periodicUpdate(const RunTimeOpts *rtOpts, PtpClock *ptpClock)
 	snprint_TimeInternal(tmpBuf, sizeof(tmpBuf), &ptpClock->currentDS.offsetFromMaster);
 
 	if(ptpClock->slaveStats.statsCalculated) {
-	    INFO("Status update: state %s, best master %s, ofm %s s, ofm_mean % .09f s, ofm_dev % .09f s\n",
+	    snprint_Percentiles(percentileBuf, sizeof(percentileBuf), "ofm_",
+		ptpClock->slaveStats.ofmPercentile, ", ");
+	    INFO("Status update: state %s, best master %s, ofm %s s, ofm_mean % .09f s, ofm_dev % .09f s, %s\n",
 		portState_getName(ptpClock->portDS.portState),
 		masterIdBuf,
 		tmpBuf,
 		ptpClock->slaveStats.ofmMean,
-		ptpClock->slaveStats.ofmStdDev);
+		ptpClock->slaveStats.ofmStdDev,
+		percentileBuf);
 	    snprint_TimeInternal(tmpBuf, sizeof(tmpBuf), mpd);
 	    if (ptpClock->portDS.delayMechanism == E2E) {
-		INFO("Status update: state %s, best master %s, mpd %s s, mpd_mean % .09f s, mpd_dev % .09f s\n",
+		snprint_Percentiles(percentileBuf, sizeof(percentileBuf), "mpd_",
+		    ptpClock->slaveStats.mpdPercentile, ", ");
+		INFO("Status update: state %s, best master %s, mpd %s s, mpd_mean % .09f s, mpd_dev % .09f s, %s\n",
 		    portState_getName(ptpClock->portDS.portState),
 		    masterIdBuf,
 		    tmpBuf,
 		    ptpClock->slaveStats.mpdMean,
-		    ptpClock->slaveStats.mpdStdDev);
+		    ptpClock->slaveStats.mpdStdDev,
+		    percentileBuf);
 	    } else if(ptpClock->portDS.delayMechanism == P2P) {
 		INFO("Status update: state %s, best master %s, mpd %s s\n", portState_getName(ptpClock->portDS.portState), masterIdBuf, tmpBuf);
 	    }
@@ -956,412 +1163,6 @@ displayStatus(PtpClock *ptpClock, const char *prefixMessage)
         NOTICE("%s",sbuf);
 }
 
-#define STATUSPREFIX "%-19s:"
-void
-writeStatusFile(PtpClock *ptpClock,const RunTimeOpts *rtOpts, Boolean quiet)
-{
-
-	char outBuf[3072];
-	char tmpBuf[200];
-
-	int n = getAlarmSummary(NULL, 0, ptpClock->alarms, ALRM_MAX);
-	char alarmBuf[n];
-
-	InterfaceInfo *ifInfo = &ptpClock->netPath.interfaceInfo;
-
-	getAlarmSummary(alarmBuf, n, ptpClock->alarms, ALRM_MAX);
-
-	if(rtOpts->statusLog.logFP == NULL)
-	    return;
-	
-	char timeStr[MAXTIMESTR];
-	char hostName[MAXHOSTNAMELEN];
-
-	struct timeval now;
-	memset(hostName, 0, MAXHOSTNAMELEN);
-
-	gethostname(hostName, MAXHOSTNAMELEN);
-	gettimeofday(&now, 0);
-	strftime(timeStr, MAXTIMESTR, "%a %b %d %X %Z %Y", localtime((time_t*)&now.tv_sec));
-	
-	FILE* out = rtOpts->statusLog.logFP;
-	memset(outBuf, 0, sizeof(outBuf));
-
-	setbuf(out, outBuf);
-	if(ftruncate(fileno(out), 0) < 0) {
-	    DBG("writeStatusFile: ftruncate() failed\n");
-	}
-	rewind(out);
-
-	fprintf(out, 		STATUSPREFIX"  %s, PID %d\n","Host info", hostName, (int)getpid());
-	fprintf(out, 		STATUSPREFIX"  %s\n","Local time", timeStr);
-	strftime(timeStr, MAXTIMESTR, "%a %b %d %X %Z %Y", gmtime((time_t*)&now.tv_sec));
-	fprintf(out, 		STATUSPREFIX"  %s\n","Kernel time", timeStr);
-	fprintf(out, 		STATUSPREFIX"  %s%s","Interface", rtOpts->ifaceName,
-		(rtOpts->backupIfaceEnabled && ptpClock->runningBackupInterface) ? " (backup)" : (rtOpts->backupIfaceEnabled)?
-		    " (primary)" : "");
-
-	if(ifInfo->vlanInfo.vlan) {
-	    fprintf(out, "%s", ", VLAN");
-	}
-	if(ifInfo->bondInfo.bonded) {
-	    fprintf(out, ", bonded");
-	    if(ifInfo->bondInfo.activeBackup) {
-		if(ifInfo->bondInfo.activeCount>0) {
-		    fprintf(out, ", active %s", ifInfo->physicalDevice);
-		} else {
-		    fprintf(out, ", no active slaves!");
-		}
-		
-	    }
-	} else if(ifInfo->vlanInfo.vlan) {
-		    fprintf(out, ", physical %s", ifInfo->physicalDevice);
-	}
-
-	fprintf(out, "\n");
-
-	fprintf(out, 		STATUSPREFIX"  %s\n","Preset", dictionary_get(rtOpts->currentConfig, "ptpengine:preset", ""));
-	fprintf(out, 		STATUSPREFIX"  %s%s","Transport", dictionary_get(rtOpts->currentConfig, "ptpengine:transport", ""),
-		(rtOpts->transport==UDP_IPV4 && rtOpts->pcap == TRUE)?" + libpcap":"");
-
-	if(rtOpts->transport != IEEE_802_3) {
-	    fprintf(out,", %s", dictionary_get(rtOpts->currentConfig, "ptpengine:ip_mode", ""));
-	    fprintf(out,"%s", rtOpts->unicastNegotiation ? " negotiation":"");
-	}
-
-	if(ptpClock->netPath.hwTimestamping) {
-	    fprintf(out,", HW PTP");
-	}
-
-	fprintf(out,"\n");
-
-	fprintf(out, 		STATUSPREFIX"  %s\n","Delay mechanism", dictionary_get(rtOpts->currentConfig, "ptpengine:delay_mechanism", ""));
-	if(ptpClock->portDS.portState >= PTP_MASTER) {
-	fprintf(out, 		STATUSPREFIX"  %s\n","Sync mode", ptpClock->defaultDS.twoStepFlag ? "TWO_STEP" : "ONE_STEP");
-	}
-	if(ptpClock->defaultDS.slaveOnly && rtOpts->anyDomain) {
-		fprintf(out, 		STATUSPREFIX"  %d, preferred %d\n","PTP domain",
-		ptpClock->defaultDS.domainNumber, rtOpts->domainNumber);
-	} else if(ptpClock->defaultDS.slaveOnly && rtOpts->unicastNegotiation) {
-		fprintf(out, 		STATUSPREFIX"  %d, default %d\n","PTP domain", ptpClock->defaultDS.domainNumber, rtOpts->domainNumber);
-	} else {
-		fprintf(out, 		STATUSPREFIX"  %d\n","PTP domain", ptpClock->defaultDS.domainNumber);
-	}
-	fprintf(out, 		STATUSPREFIX"  %s\n","Port state", portState_getName(ptpClock->portDS.portState));
-	if(strlen(alarmBuf) > 0) {
-	    fprintf(out, 		STATUSPREFIX"  %s\n","Alarms", alarmBuf);
-	}
-	    memset(tmpBuf, 0, sizeof(tmpBuf));
-	    snprint_PortIdentity(tmpBuf, sizeof(tmpBuf),
-	    &ptpClock->portDS.portIdentity);
-	fprintf(out, 		STATUSPREFIX"  %s\n","Local port ID", tmpBuf);
-
-
-	if(ptpClock->portDS.portState >= PTP_MASTER) {
-	    memset(tmpBuf, 0, sizeof(tmpBuf));
-	    snprint_PortIdentity(tmpBuf, sizeof(tmpBuf),
-	    &ptpClock->parentDS.parentPortIdentity);
-	fprintf(out, 		STATUSPREFIX"  %s","Best master ID", tmpBuf);
-	if(ptpClock->portDS.portState == PTP_MASTER)
-	    fprintf(out," (self)");
-	    fprintf(out,"\n");
-	}
-	if(rtOpts->transport == UDP_IPV4 &&
-	    ptpClock->portDS.portState > PTP_MASTER &&
-	    ptpClock->bestMaster && ptpClock->bestMaster->sourceAddr) {
-	    {
-	    struct in_addr tmpAddr;
-	    tmpAddr.s_addr = ptpClock->bestMaster->sourceAddr;
-	    fprintf(out, 		STATUSPREFIX"  %s\n","Best master IP", inet_ntoa(tmpAddr));
-	    }
-	}
-	if(ptpClock->portDS.portState == PTP_SLAVE) {
-	fprintf(out, 		STATUSPREFIX"  Priority1 %d, Priority2 %d, clockClass %d","GM priority",
-	ptpClock->parentDS.grandmasterPriority1, ptpClock->parentDS.grandmasterPriority2, ptpClock->parentDS.grandmasterClockQuality.clockClass);
-	if(rtOpts->unicastNegotiation && ptpClock->parentGrants != NULL ) {
-	    	fprintf(out, ", localPref %d", ptpClock->parentGrants->localPreference);
-	}
-	fprintf(out, "%s\n", (ptpClock->bestMaster != NULL && ptpClock->bestMaster->disqualified) ? " (timeout)" : "");
-	}
-
-	if(ptpClock->defaultDS.clockQuality.clockClass < 128 ||
-		ptpClock->portDS.portState == PTP_SLAVE ||
-		ptpClock->portDS.portState == PTP_PASSIVE){
-	fprintf(out, 		STATUSPREFIX"  ","Time properties");
-	fprintf(out, "%s timescale, ",ptpClock->timePropertiesDS.ptpTimescale ? "PTP":"ARB");
-	fprintf(out, "tracbl: time %s, freq %s, src: %s(0x%02x)\n", ptpClock->timePropertiesDS.timeTraceable ? "Y" : "N",
-							ptpClock->timePropertiesDS.frequencyTraceable ? "Y" : "N",
-							getTimeSourceName(ptpClock->timePropertiesDS.timeSource),
-							ptpClock->timePropertiesDS.timeSource);
-	fprintf(out, 		STATUSPREFIX"  ","UTC properties");
-	fprintf(out, "UTC valid: %s", ptpClock->timePropertiesDS.currentUtcOffsetValid ? "Y" : "N");
-	fprintf(out, ", UTC offset: %d",ptpClock->timePropertiesDS.currentUtcOffset);
-	fprintf(out, "%s",ptpClock->timePropertiesDS.leap61 ?
-			", LEAP61 pending" : ptpClock->timePropertiesDS.leap59 ? ", LEAP59 pending" : "");
-	if (ptpClock->portDS.portState == PTP_SLAVE) {	
-	    fprintf(out, "%s", rtOpts->preferUtcValid ? ", prefer UTC" : "");
-	    fprintf(out, "%s", rtOpts->requireUtcValid ? ", require UTC" : "");
-	}
-	fprintf(out,"\n");
-	}
-
-	if(ptpClock->portDS.portState == PTP_SLAVE) {
-	    memset(tmpBuf, 0, sizeof(tmpBuf));
-	    snprint_TimeInternal(tmpBuf, sizeof(tmpBuf),
-		&ptpClock->currentDS.offsetFromMaster);
-	fprintf(out, 		STATUSPREFIX" %s s","Offset from Master", tmpBuf);
-	if(ptpClock->slaveStats.statsCalculated)
-	fprintf(out, ", mean % .09f s, dev % .09f s",
-		ptpClock->slaveStats.ofmMean,
-		ptpClock->slaveStats.ofmStdDev
-	);
-	    fprintf(out,"\n");
-
-	if(ptpClock->portDS.delayMechanism == E2E) {
-	    memset(tmpBuf, 0, sizeof(tmpBuf));
-	    snprint_TimeInternal(tmpBuf, sizeof(tmpBuf),
-		&ptpClock->currentDS.meanPathDelay);
-	fprintf(out, 		STATUSPREFIX" %s s","Mean Path Delay", tmpBuf);
-
-	if(ptpClock->slaveStats.statsCalculated)
-	fprintf(out, ", mean % .09f s, dev % .09f s",
-		ptpClock->slaveStats.mpdMean,
-		ptpClock->slaveStats.mpdStdDev
-	);
-	fprintf(out,"\n");
-	}
-	if(ptpClock->portDS.delayMechanism == P2P) {
-	    memset(tmpBuf, 0, sizeof(tmpBuf));
-	    snprint_TimeInternal(tmpBuf, sizeof(tmpBuf),
-		&ptpClock->portDS.peerMeanPathDelay);
-	fprintf(out, 		STATUSPREFIX" %s s","Mean Path (p)Delay", tmpBuf);
-	fprintf(out,"\n");
-	}
-
-	fprintf(out, 		STATUSPREFIX"  ","PTP Clock status");
-	    if(ptpClock->clockDriver->state == CS_STEP) {
-		fprintf(out,"panic mode,");
-	    }
-	    if(ptpClock->clockDriver->state == CS_NEGSTEP) {
-		fprintf(out,"negative step,");
-	    }
-
-	if(rtOpts->calibrationDelay) {
-	    fprintf(out, "%s, ",
-		ptpClock->isCalibrated ? "calibrated" : "not calibrated");
-	}
-	fprintf(out, "%s",
-		ptpClock->clockControl.granted ? "in control" : "no control");
-	fprintf(out, "%s%s", ptpClock->clockControl.stepRequired ? ", STEP" : "",
-		ptpClock->clockControl.stepFailed ? " FAILED!" : "");
-	if(rtOpts->noAdjust) {
-	    fprintf(out, ", read-only");
-	} else {
-		fprintf(out, ", %s",
-		    (ptpClock->clockDriver->state == CS_LOCKED) ? "stabilised" : "not stabilised");
-	}
-	fprintf(out,"\n");
-
-	}
-
-
-	if(ptpClock->portDS.portState == PTP_MASTER || ptpClock->portDS.portState == PTP_PASSIVE) {
-
-	fprintf(out, 		STATUSPREFIX"  %d","Priority1 ", ptpClock->defaultDS.priority1);
-	if(ptpClock->portDS.portState == PTP_PASSIVE)
-		fprintf(out, " (best master: %d)", ptpClock->parentDS.grandmasterPriority1);
-	fprintf(out,"\n");
-	fprintf(out, 		STATUSPREFIX"  %d","Priority2 ", ptpClock->defaultDS.priority2);
-	if(ptpClock->portDS.portState == PTP_PASSIVE)
-		fprintf(out, " (best master: %d)", ptpClock->parentDS.grandmasterPriority2);
-	fprintf(out,"\n");
-	fprintf(out, 		STATUSPREFIX"  %d","ClockClass ", ptpClock->defaultDS.clockQuality.clockClass);
-	if(ptpClock->portDS.portState == PTP_PASSIVE)
-		fprintf(out, " (best master: %d)", ptpClock->parentDS.grandmasterClockQuality.clockClass);
-	fprintf(out,"\n");
-	if(ptpClock->portDS.delayMechanism == P2P) {
-	    memset(tmpBuf, 0, sizeof(tmpBuf));
-	    snprint_TimeInternal(tmpBuf, sizeof(tmpBuf),
-		&ptpClock->portDS.peerMeanPathDelay);
-	fprintf(out, 		STATUSPREFIX" %s s","Mean Path (p)Delay", tmpBuf);
-	fprintf(out,"\n");
-	}
-
-	}
-
-	if(ptpClock->portDS.portState == PTP_MASTER || ptpClock->portDS.portState == PTP_PASSIVE ||
-	    ptpClock->portDS.portState == PTP_SLAVE) {
-
-	fprintf(out,		STATUSPREFIX"  ","Message rates");
-
-	if (ptpClock->portDS.logSyncInterval == UNICAST_MESSAGEINTERVAL)
-	    fprintf(out,"[UC-unknown]");
-	else if (ptpClock->portDS.logSyncInterval <= 0)
-	    fprintf(out,"%.0f/s",pow(2,-ptpClock->portDS.logSyncInterval));
-	else
-	    fprintf(out,"1/%.0fs",pow(2,ptpClock->portDS.logSyncInterval));
-	fprintf(out, " sync");
-
-
-	if(ptpClock->portDS.delayMechanism == E2E) {
-		if (ptpClock->portDS.logMinDelayReqInterval == UNICAST_MESSAGEINTERVAL)
-		    fprintf(out,", [UC-unknown]");
-		else if (ptpClock->portDS.logMinDelayReqInterval <= 0)
-		    fprintf(out,", %.0f/s",pow(2,-ptpClock->portDS.logMinDelayReqInterval));
-		else
-		    fprintf(out,", 1/%.0fs",pow(2,ptpClock->portDS.logMinDelayReqInterval));
-		fprintf(out, " delay");
-	}
-
-	if(ptpClock->portDS.delayMechanism == P2P) {
-		if (ptpClock->portDS.logMinPdelayReqInterval == UNICAST_MESSAGEINTERVAL)
-		    fprintf(out,", [UC-unknown]");
-		else if (ptpClock->portDS.logMinPdelayReqInterval <= 0)
-		    fprintf(out,", %.0f/s",pow(2,-ptpClock->portDS.logMinPdelayReqInterval));
-		else
-		    fprintf(out,", 1/%.0fs",pow(2,ptpClock->portDS.logMinPdelayReqInterval));
-		fprintf(out, " pdelay");
-	}
-
-	if (ptpClock->portDS.logAnnounceInterval == UNICAST_MESSAGEINTERVAL)
-	    fprintf(out,", [UC-unknown]");
-	else if (ptpClock->portDS.logAnnounceInterval <= 0)
-	    fprintf(out,", %.0f/s",pow(2,-ptpClock->portDS.logAnnounceInterval));
-	else
-	    fprintf(out,", 1/%.0fs",pow(2,ptpClock->portDS.logAnnounceInterval));
-	fprintf(out, " announce");
-
-	    fprintf(out,"\n");
-
-	}
-
-	fprintf(out, 		STATUSPREFIX"  ","TimingService");
-
-	fprintf(out, "current %s, best %s, pref %s", (timingDomain.current != NULL) ? timingDomain.current->id : "none",
-						(timingDomain.best != NULL) ? timingDomain.best->id : "none",
-		    				(timingDomain.preferred != NULL) ? timingDomain.preferred->id : "none");
-
-	if((timingDomain.current != NULL) &&
-	    (timingDomain.current->holdTimeLeft > 0)) {
-		fprintf(out, ", hold %d sec", timingDomain.current->holdTimeLeft);
-	} else	if(timingDomain.electionLeft) {
-		fprintf(out, ", elec %d sec", timingDomain.electionLeft);
-	}
-
-	fprintf(out, "\n");
-
-	fprintf(out, 		STATUSPREFIX"  ","TimingServices");
-
-	fprintf(out, "total %d, avail %d, oper %d, idle %d, in_ctrl %d%s\n",
-				    timingDomain.serviceCount,
-				    timingDomain.availableCount,
-				    timingDomain.operationalCount,
-				    timingDomain.idleCount,
-				    timingDomain.controlCount,
-				    timingDomain.controlCount > 1 ? " (!)":"");
-
-	fprintf(out, 		STATUSPREFIX"  ","Performance");
-	fprintf(out,"Message RX %d/s, TX %d/s", ptpClock->counters.messageReceiveRate,
-						  ptpClock->counters.messageSendRate);
-	if(ptpClock->portDS.portState == PTP_MASTER) {
-		if(rtOpts->unicastNegotiation) {
-		    fprintf(out,", slaves %d", ptpClock->slaveCount);
-		} else if (rtOpts->ipMode == IPMODE_UNICAST) {
-		    fprintf(out,", slaves %d", ptpClock->unicastDestinationCount);
-		}
-	}
-
-	fprintf(out,"\n");
-
-	if ( ptpClock->portDS.portState == PTP_SLAVE ||
-	    ptpClock->defaultDS.clockQuality.clockClass == 255 ) {
-
-	fprintf(out, 		STATUSPREFIX"  %lu\n","Announce received",
-	    (unsigned long)ptpClock->counters.announceMessagesReceived);
-	fprintf(out, 		STATUSPREFIX"  %lu\n","Sync received",
-	    (unsigned long)ptpClock->counters.syncMessagesReceived);
-	if(ptpClock->defaultDS.twoStepFlag)
-	fprintf(out, 		STATUSPREFIX"  %lu\n","Follow-up received",
-	    (unsigned long)ptpClock->counters.followUpMessagesReceived);
-	if(ptpClock->portDS.delayMechanism == E2E) {
-		fprintf(out, 		STATUSPREFIX"  %lu\n","DelayReq sent",
-		    (unsigned long)ptpClock->counters.delayReqMessagesSent);
-		fprintf(out, 		STATUSPREFIX"  %lu\n","DelayResp received",
-		    (unsigned long)ptpClock->counters.delayRespMessagesReceived);
-	}
-	}
-
-	if( ptpClock->portDS.portState == PTP_MASTER ||
-	    ptpClock->defaultDS.clockQuality.clockClass < 128 ) {
-	fprintf(out, 		STATUSPREFIX"  %lu received, %lu sent \n","Announce",
-	    (unsigned long)ptpClock->counters.announceMessagesReceived,
-	    (unsigned long)ptpClock->counters.announceMessagesSent);
-	fprintf(out, 		STATUSPREFIX"  %lu\n","Sync sent",
-	    (unsigned long)ptpClock->counters.syncMessagesSent);
-	if(ptpClock->defaultDS.twoStepFlag)
-	fprintf(out, 		STATUSPREFIX"  %lu\n","Follow-up sent",
-	    (unsigned long)ptpClock->counters.followUpMessagesSent);
-
-	if(ptpClock->portDS.delayMechanism == E2E) {
-		fprintf(out, 		STATUSPREFIX"  %lu\n","DelayReq received",
-		    (unsigned long)ptpClock->counters.delayReqMessagesReceived);
-		fprintf(out, 		STATUSPREFIX"  %lu\n","DelayResp sent",
-		    (unsigned long)ptpClock->counters.delayRespMessagesSent);
-	}
-
-	}
-
-	if(ptpClock->portDS.delayMechanism == P2P) {
-
-		fprintf(out, 		STATUSPREFIX"  %lu received, %lu sent\n","PdelayReq",
-		    (unsigned long)ptpClock->counters.pdelayReqMessagesReceived,
-		    (unsigned long)ptpClock->counters.pdelayReqMessagesSent);
-		fprintf(out, 		STATUSPREFIX"  %lu received, %lu sent\n","PdelayResp",
-		    (unsigned long)ptpClock->counters.pdelayRespMessagesReceived,
-		    (unsigned long)ptpClock->counters.pdelayRespMessagesSent);
-		fprintf(out, 		STATUSPREFIX"  %lu received, %lu sent\n","PdelayRespFollowUp",
-		    (unsigned long)ptpClock->counters.pdelayRespFollowUpMessagesReceived,
-		    (unsigned long)ptpClock->counters.pdelayRespFollowUpMessagesSent);
-
-	}
-
-	if(ptpClock->counters.domainMismatchErrors)
-	fprintf(out, 		STATUSPREFIX"  %lu\n","Domain Mismatches",
-		    (unsigned long)ptpClock->counters.domainMismatchErrors);
-
-	if(ptpClock->counters.ignoredAnnounce)
-	fprintf(out, 		STATUSPREFIX"  %lu\n","Ignored Announce",
-		    (unsigned long)ptpClock->counters.ignoredAnnounce);
-
-	if(ptpClock->counters.unicastGrantsDenied)
-	fprintf(out, 		STATUSPREFIX"  %lu\n","Denied Unicast",
-		    (unsigned long)ptpClock->counters.unicastGrantsDenied);
-
-	fprintf(out, 		STATUSPREFIX"  %lu\n","State transitions",
-		    (unsigned long)ptpClock->counters.stateTransitions);
-	fprintf(out, 		STATUSPREFIX"  %lu\n","PTP Engine resets",
-		    (unsigned long)ptpClock->resetCount);
-	fprintf(out,"                                   \n");
-	if(ptpClock->clockDriver != NULL) {
-	    char buf[100];
-	    int i = 1;
-	    for(ClockDriver *cd = ptpClock->clockDriver->_first; cd != NULL; cd=cd->_next) {
-		    cd->putInfoLine(cd, buf, 100);
-		    fprintf(out, "Clock %d: %-9s : %s\n", i++, cd->name, buf);
-	    }
-	    i = 1;
-	    for(ClockDriver *cd = ptpClock->clockDriver->_first; cd != NULL; cd=cd->_next) {
-		    cd->putStatsLine(cd, buf, 100);
-		    fprintf(out, "Clock %d: %-9s : %s\n",i++, cd->name, buf);
-	    }
-
-	}
-
-
-
-	fflush(out);
-}
-
 void
 displayPortIdentity(PortIdentity *port, const char *prefixMessage)
 {
@@ -1380,11 +1181,13 @@ void
 recordSync(UInteger16 sequenceId, TimeInternal * time)
 {
 	extern RunTimeOpts rtOpts;
+	char buf[40];
+	int len;
 	if (rtOpts.recordLog.logEnabled && rtOpts.recordLog.logFP != NULL) {
-		fprintf(rtOpts.recordLog.logFP, "%d %llu\n", sequenceId,
+		len = snprintf(buf, sizeof(buf), "%d %llu\n", sequenceId,
 		  ((time->seconds * 1000000000ULL) + time->nanoseconds)
 		);
-		maintainLogSize(&rtOpts.recordLog);
+		logWrite(LOGJOB_WRITE, LOGWRITE_MAINTAIN, 0, &rtOpts.recordLog, NULL, buf, len);
 	}
 }
 
@@ -1976,6 +1779,22 @@ return -1;
 
 }
 
+/* Run the calling thread with SCHED_FIFO at given priority, 0 = back to SCHED_OTHER */
+int setRealtimePriority(int priority) {
+
+#if defined(HAVE_SCHED_H) && defined(SCHED_FIFO)
+	struct sched_param param;
+
+	memset(&param, 0, sizeof(param));
+	param.sched_priority = priority;
+
+	return sched_setscheduler(0, priority ? SCHED_FIFO : SCHED_OTHER, &param);
+#endif /* HAVE_SCHED_H && SCHED_FIFO */
+
+return -1;
+
+}
+
 Boolean
 doubleToFile(const char *filename, double input)
 {
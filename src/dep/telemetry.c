@@ -0,0 +1,224 @@
+/*-
+ * Copyright (c) 2026 PTPd contributors,
+ *
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file   telemetry.c
+ * @date   Sun Oct 18 07:06:27 2026
+ *
+ * @brief  Memory-mapped servo telemetry ring: writer side
+ *
+ * The ring is (re)created when logging is (re)started and only if its
+ * path or size changed, so that SIGHUP does not disturb running readers.
+ * All the file work is done up front: the mapping is pre-faulted, so
+ * adding a record is a handful of stores.
+ */
+
+#include "../ptpd.h"
+
+#include <sys/mman.h>
+
+static void
+telemetryTime(TelemetryTime *dst, const TimeInternal *src)
+{
+	dst->seconds = src->seconds;
+	dst->nanoseconds = src->nanoseconds;
+}
+
+static void
+closeTelemetryRing(TelemetryRing *ring, Boolean quiet)
+{
+
+	if(ring->header == NULL) {
+		return;
+	}
+
+	munmap(ring->header, ring->size);
+	unlink(ring->path);
+
+	if(!quiet) {
+		INFO("Telemetry ring %s closed\n", ring->path);
+	}
+
+	ring->header = NULL;
+	ring->size = 0;
+	ring->capacity = 0;
+
+}
+
+static Boolean
+openTelemetryRing(TelemetryRing *ring, const char *path, int capacity)
+{
+
+	int fd;
+	size_t size = TELEMETRY_SIZE(capacity);
+	TelemetryHeader *header;
+
+	/*
+	 * Never truncate a file someone may have mapped (they would get SIGBUS):
+	 * remove it and start with a new inode, readers notice the change.
+	 */
+	unlink(path);
+
+	if((fd = open(path, O_RDWR | O_CREAT | O_EXCL, DEFAULT_FILE_PERMS)) < 0) {
+		PERROR("Could not create telemetry file %s", path);
+		return FALSE;
+	}
+
+	if(ftruncate(fd, size) < 0) {
+		PERROR("Could not size telemetry file %s", path);
+		close(fd);
+		unlink(path);
+		return FALSE;
+	}
+
+	header = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if(header == MAP_FAILED) {
+		PERROR("Could not map telemetry file %s", path);
+		unlink(path);
+		return FALSE;
+	}
+
+	/* touch every page now so the servo never takes a page fault */
+	memset(header, 0, size);
+
+	header->version = TELEMETRY_VERSION;
+	header->recordSize = sizeof(TelemetryRecord);
+	header->capacity = capacity;
+	header->pid = getpid();
+	header->head = 0;
+	/* magic last: a reader seeing it sees a complete header */
+	__sync_synchronize();
+	header->magic = TELEMETRY_MAGIC;
+
+	ring->header = header;
+	ring->size = size;
+	ring->capacity = capacity;
+	snprintf(ring->path, sizeof(ring->path), "%s", path);
+
+	INFO("Writing servo telemetry to %s (%d records)\n", path, capacity);
+
+	return TRUE;
+
+}
+
+/* (re)create, keep or close the ring depending on the current configuration */
+Boolean
+restartTelemetry(RunTimeOpts *rtOpts)
+{
+
+	TelemetryRing *ring = &rtOpts->telemetry;
+
+	if(ring->header != NULL) {
+		if(rtOpts->telemetryEnabled && ring->capacity == rtOpts->telemetryCapacity &&
+		    !strncmp(ring->path, rtOpts->telemetryFile, PATH_MAX)) {
+			return TRUE;
+		}
+		closeTelemetryRing(ring, FALSE);
+	}
+
+	if(!rtOpts->telemetryEnabled) {
+		return TRUE;
+	}
+
+	return openTelemetryRing(ring, rtOpts->telemetryFile, rtOpts->telemetryCapacity);
+
+}
+
+void
+stopTelemetry(RunTimeOpts *rtOpts)
+{
+	closeTelemetryRing(&rtOpts->telemetry, TRUE);
+}
+
+/*
+ * Add one sample to the ring. Called from the servo for every offset and
+ * delay update. No system calls: clock_gettime() is served by the vDSO.
+ */
+void
+writeTelemetry(const TelemetryRing *ring, uint8_t type, UInteger16 sequenceId,
+	const TimeInternal *t1, const TimeInternal *t2,
+	const TimeInternal *t3, const TimeInternal *t4,
+	const TimeInternal *correction, const PtpClock *ptpClock)
+{
+
+	TelemetryHeader *header = ring->header;
+	TelemetryRecord *record;
+	uint64_t n;
+	struct timespec now;
+
+	if(header == NULL) {
+		return;
+	}
+
+	n = header->head;
+	record = TELEMETRY_RECORD(header, n);
+
+	record->sequence = 2 * n + 1;
+	__sync_synchronize();
+
+	clock_gettime(CLOCK_REALTIME, &now);
+	record->timestamp.seconds = now.tv_sec;
+	record->timestamp.nanoseconds = now.tv_nsec;
+
+	telemetryTime(&record->t1, t1);
+	telemetryTime(&record->t2, t2);
+	telemetryTime(&record->t3, t3);
+	telemetryTime(&record->t4, t4);
+	telemetryTime(&record->correction, correction);
+
+	if(type == TELEMETRY_PDELAY) {
+		telemetryTime(&record->rawDelayMS, &ptpClock->pdelayMS);
+		telemetryTime(&record->rawDelaySM, &ptpClock->pdelaySM);
+		telemetryTime(&record->meanPathDelay, &ptpClock->portDS.peerMeanPathDelay);
+	} else {
+		telemetryTime(&record->rawDelayMS, &ptpClock->delayMS);
+		telemetryTime(&record->rawDelaySM, &ptpClock->delaySM);
+		telemetryTime(&record->meanPathDelay, &ptpClock->currentDS.meanPathDelay);
+	}
+	telemetryTime(&record->offsetFromMaster, &ptpClock->currentDS.offsetFromMaster);
+
+	if(ptpClock->clockDriver != NULL) {
+		record->servoOutput = ptpClock->clockDriver->servo.output;
+		record->servoIntegral = ptpClock->clockDriver->servo.integral;
+		record->clockState = ptpClock->clockDriver->state;
+	} else {
+		record->servoOutput = 0.0;
+		record->servoIntegral = 0.0;
+		record->clockState = 0xff;
+	}
+
+	record->ptpSequenceId = sequenceId;
+	record->type = type;
+	record->portState = ptpClock->portDS.portState;
+
+	__sync_synchronize();
+	record->sequence = 2 * n + 2;
+	header->head = n + 1;
+
+}
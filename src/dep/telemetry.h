@@ -0,0 +1,119 @@
+/*-
+ * Copyright (c) 2026 PTPd contributors,
+ *
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file   telemetry.h
+ * @date   Sun Oct 18 07:06:27 2026
+ *
+ * @brief  Memory-mapped servo telemetry ring: shared file layout
+ *
+ * The ring is a plain file (normally on tmpfs) holding a header followed
+ * by a power of two number of fixed size records. ptpd is the only writer
+ * and never blocks or makes system calls when adding a record; readers
+ * map the file read-only and may come and go at any time.
+ *
+ * Every record carries a sequence number used as a seqlock: while record
+ * number n is being written its sequence is 2n+1, once complete it is 2n+2.
+ * A reader copies a record, then checks that the sequence was even and
+ * unchanged across the copy - otherwise the record was overwritten and
+ * the reader has fallen more than a full ring behind.
+ *
+ * This header is shared with the reader tool and must not depend on ptpd.h.
+ */
+
+#ifndef PTPD_TELEMETRY_H_
+#define PTPD_TELEMETRY_H_
+
+#include <stdint.h>
+#include <limits.h>
+
+#define TELEMETRY_MAGIC		0x5054504454454c4dULL	/* "PTPDTELM" */
+#define TELEMETRY_VERSION	1
+
+#define TELEMETRY_MIN_CAPACITY	64
+#define TELEMETRY_MAX_CAPACITY	1048576
+
+/* record types */
+enum {
+	TELEMETRY_NONE = 0,
+	TELEMETRY_OFFSET,	/* Sync / Follow_Up processed: T1, T2 valid */
+	TELEMETRY_DELAY,	/* Delay_Resp processed: T1-T4 valid */
+	TELEMETRY_PDELAY	/* Pdelay_Resp processed: T1-T4 are the peer delay timestamps */
+};
+
+typedef struct {
+	int64_t seconds;
+	int32_t nanoseconds;
+	int32_t pad;
+} TelemetryTime;
+
+typedef struct {
+	volatile uint64_t sequence;		/* seqlock, see above */
+	TelemetryTime timestamp;		/* local time the record was written */
+	TelemetryTime t1;
+	TelemetryTime t2;
+	TelemetryTime t3;
+	TelemetryTime t4;
+	TelemetryTime correction;		/* correctionField of the message completing the sample */
+	TelemetryTime rawDelayMS;		/* unfiltered master to slave delay */
+	TelemetryTime rawDelaySM;		/* unfiltered slave to master delay */
+	TelemetryTime offsetFromMaster;		/* filtered offset */
+	TelemetryTime meanPathDelay;		/* filtered (peer) mean path delay */
+	double servoOutput;			/* last servo output (ppb), from the previous clock update */
+	double servoIntegral;			/* observed drift (ppb) */
+	uint16_t ptpSequenceId;
+	uint8_t type;				/* TELEMETRY_OFFSET / _DELAY / _PDELAY */
+	uint8_t portState;			/* PtpPortState */
+	uint8_t clockState;			/* ClockState of the clock driver, 0xff if none */
+	uint8_t pad[3];
+} TelemetryRecord;
+
+typedef struct {
+	uint64_t magic;
+	uint32_t version;
+	uint32_t recordSize;			/* sizeof(TelemetryRecord) of the writer */
+	uint32_t capacity;			/* number of records, power of 2 */
+	uint32_t pid;				/* writer's pid */
+	volatile uint64_t head;			/* number of records written since the ring was created */
+	uint8_t pad[32];			/* keep records cache line aligned */
+} TelemetryHeader;
+
+#define TELEMETRY_RECORD(header, n) \
+	(((TelemetryRecord*)((char*)(header) + sizeof(TelemetryHeader))) + ((n) & ((header)->capacity - 1)))
+
+#define TELEMETRY_SIZE(capacity) \
+	(sizeof(TelemetryHeader) + (size_t)(capacity) * sizeof(TelemetryRecord))
+
+/* writer handle, private to ptpd */
+typedef struct {
+	TelemetryHeader *header;		/* NULL when telemetry is not running */
+	size_t size;
+	int capacity;
+	char path[PATH_MAX+1];
+} TelemetryRing;
+
+#endif /* PTPD_TELEMETRY_H_ */
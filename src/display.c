@@ -804,6 +804,14 @@ displayCounters(const PtpClock * ptpClock)
 		(unsigned long)ptpClock->counters.bestMasterChanges);
 	INFO("                  announceTimeouts : %lu\n",
 		(unsigned long)ptpClock->counters.announceTimeouts);
+	INFO("                           bmcRuns : %lu\n",
+		(unsigned long)ptpClock->counters.bmcRuns);
+	INFO("             bmcComparisonsSkipped : %lu\n",
+		(unsigned long)ptpClock->counters.bmcComparisonsSkipped);
+	INFO("               bmcDecisionsSkipped : %lu\n",
+		(unsigned long)ptpClock->counters.bmcDecisionsSkipped);
+	INFO("           delayRespTemplateBuilds : %lu\n",
+		(unsigned long)ptpClock->counters.delayRespTemplateBuilds);
 
 	INFO("Discarded / unknown message counters:\n");
 	INFO("                 discardedMessages : %lu\n",
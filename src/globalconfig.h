@@ -106,6 +106,7 @@ typedef struct {
 	Integer16 s;
 	TimeInternal inboundLatency, outboundLatency, ofmCorrection;
 	Integer16 max_foreign_records;
+	Integer16 foreignRecordCapacityMax; /* foreign master record may grow up to this size */
 	Enumeration8 delayMechanism;
 
 	Boolean portDisabled;
@@ -115,6 +116,8 @@ typedef struct {
 #if (defined(linux) && defined(HAVE_SCHED_H)) || defined(HAVE_SYS_CPUSET_H) || defined (__QNXNTO__)
 	int cpuNumber;
 #endif /* linux && HAVE_SCHED_H || HAVE_SYS_CPUSET_H*/
+	int rtPriority;			/* SCHED_FIFO priority of the protocol thread, 0 = not real-time */
+	Boolean housekeepingThread;	/* write logs, statistics and status from a separate thread */
 
 	Boolean alwaysRespectUtcOffset;
 	Boolean preferUtcValid;
@@ -129,6 +132,8 @@ typedef struct {
 	LogFileHandler recordLog;
 	LogFileHandler eventLog;
 	LogFileHandler statusLog;
+	LogFileHandler captureLog;
+	TelemetryRing telemetry;
 
 	int leapSecondPausePeriod;
 	Enumeration8 leapSecondHandling;
@@ -138,12 +143,18 @@ typedef struct {
 	Boolean periodicUpdates;
 	Boolean logStatistics;
 	Enumeration8 statisticsTimestamp;
+	Enumeration8 statisticsFileFormat;
+	Enumeration8 statusFileFormat;
 
 	Enumeration8 logLevel;
 	int statisticsLogInterval;
 
 	int statusFileUpdateInterval;
 
+	Boolean telemetryEnabled;		/* write servo samples into a memory-mapped ring */
+	char telemetryFile[PATH_MAX+1];
+	int telemetryCapacity;			/* ring size in records */
+
 	Boolean ignoreLock;
 	Boolean refreshIgmp;
 	Boolean  nonDaemon;
@@ -218,6 +229,11 @@ typedef struct {
 	 * transmit signaling using one port ID, and rest of messages with another
 	 */
 	UInteger16  unicastPortMask; /* port mask to apply to portNumber when using negotiation */
+	int unicastGrantCapacity; /* Master: number of unicast negotiation nodes (slaves) we can serve */
+	int unicastTxSpread; /* Master: spread unicast transmission over this many slots per message interval */
+	Boolean unicastSyncPipelining; /* Master: send all unicast Syncs first, then collect TX timestamps */
+	Boolean unicastBatchTransmit; /* Master: send unicast Sync/FollowUp/Announce fan-out with one syscall */
+	Boolean batchReceive; /* use epoll and drain sockets with recvmmsg() instead of select() */
 
 #ifdef RUNTIME_DEBUG
 	int debug_level;
@@ -282,6 +298,10 @@ typedef struct {
 	double clockOutlierFilterCutoff;
 	int clockOutlierFilterBlockTimeout;
 
+	/* inter-clock offset measurement */
+	int clockOffsetSamples;		/* samples per offset measurement, 0 = adaptive */
+	int clockOffsetRejectPercentile;	/* reject samples slower than this read latency percentile, 0 = fastest only */
+
 	/**
 	 *  When enabled, ptpd ensures that Sync message sequence numbers
 	 *  are increasing (consecutive sync is not lower than last).
@@ -308,6 +328,9 @@ typedef struct {
 	/* also used by the periodic message ticker */
 	int statsUpdateInterval;
 
+	/* MTIE / TDEV / ADEV observation intervals, empty = disabled */
+	char stabilityIntervals[PATH_MAX];
+
 	int calibrationDelay;
 	Boolean enablePanicMode;
 	Boolean panicModeReleaseClock;
@@ -399,7 +399,7 @@ PtpText createPtpTextLen(const char *text, size_t len) {
     PtpText t;
 
     t.lengthField = len;
-    t.textField = calloc(1, len +1);
+    t.textField = ptpCalloc(len +1);
 
     memcpy(t.textField, text, len);
 
@@ -412,7 +412,8 @@ PtpText createPtpText(const char *text) {
     PtpText t;
 
     t.lengthField = strlen(text);
-    t.textField = strdup(text);
+    t.textField = ptpCalloc(t.lengthField + 1);
+    memcpy(t.textField, text, t.lengthField);
 
     return t;
 
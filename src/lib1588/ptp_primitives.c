@@ -275,7 +275,7 @@ void packPtpDynamicOctetBuf(char *buf, PtpDynamicOctetBuf *data, size_t len ) {
 void unpackPtpDynamicOctetBuf(PtpDynamicOctetBuf *to, char *from, size_t len ) {
 
     /* allocate an extra byte for string types to have a trailing zero */
-    *to = calloc(1, len + 1);
+    *to = ptpCalloc(len + 1);
 
     if(*to == NULL) {
 	return;
@@ -291,7 +291,7 @@ void displayPtpDynamicOctetBuf(PtpDynamicOctetBuf var, const char *name, size_t
 void freePtpDynamicOctetBuf(PtpDynamicOctetBuf *var) {
 
     if(*var != NULL) {
-	free(*var);
+	ptpFree(*var);
     }
     *var = NULL;
 }
@@ -312,3 +312,59 @@ void displayPtpSharedOctetBuf(PtpSharedOctetBuf var, const char *name, size_t le
 
 void freePtpSharedOctetBuf(PtpSharedOctetBuf *var) {
 }
+
+static PtpArena *currentArena = NULL;
+
+void initPtpArena(PtpArena *arena, void *buf, size_t size) {
+
+    arena->buf = buf;
+    arena->size = size;
+    arena->used = 0;
+    arena->fallbacks = 0;
+
+}
+
+void resetPtpArena(PtpArena *arena) {
+
+    arena->used = 0;
+
+}
+
+PtpArena* usePtpArena(PtpArena *arena) {
+
+    PtpArena *previous = currentArena;
+    currentArena = arena;
+    return previous;
+
+}
+
+void* ptpCalloc(size_t size) {
+
+    char *ret;
+    size_t need = (size + PTP_ARENA_ALIGN - 1) & ~(PTP_ARENA_ALIGN - 1);
+
+    if(currentArena != NULL) {
+	if(need <= currentArena->size - currentArena->used) {
+	    ret = currentArena->buf + currentArena->used;
+	    currentArena->used += need;
+	    memset(ret, 0, size);
+	    return ret;
+	}
+	currentArena->fallbacks++;
+    }
+
+    return calloc(1, size);
+
+}
+
+void ptpFree(void *ptr) {
+
+    /* arena memory is only ever returned by resetPtpArena() */
+    if(currentArena != NULL && (char*)ptr >= currentArena->buf &&
+	(char*)ptr < currentArena->buf + currentArena->size) {
+	return;
+    }
+
+    free(ptr);
+
+}
@@ -67,6 +67,31 @@ typedef struct {
 	int32_t high;
 } PtpInteger64;
 
+/*
+ * Message arena: while an arena is in use (usePtpArena()), everything lib1588
+ * allocates - TLVs, value fields, text fields - is carved out of the arena's
+ * buffer instead of the heap, freeing it is a no-op, and resetPtpArena()
+ * returns all of it at once. Allocations that do not fit go to the heap and
+ * are counted, so a small arena is slower, never wrong.
+ */
+typedef struct {
+	char *buf;
+	size_t size;
+	size_t used;
+	unsigned int fallbacks;	/* allocations which did not fit */
+} PtpArena;
+
+#define PTP_ARENA_ALIGN 16
+
+void initPtpArena(PtpArena *arena, void *buf, size_t size);
+void resetPtpArena(PtpArena *arena);
+/* use arena for allocations from now on (NULL: heap), returns the one used so far */
+PtpArena* usePtpArena(PtpArena *arena);
+/* zeroed memory from the arena in use or from the heap */
+void* ptpCalloc(size_t size);
+/* free memory from ptpCalloc() - does nothing for arena memory */
+void ptpFree(void *ptr);
+
 #define PTP_TYPE_FUNCDEFS( type ) \
 void pack##type (char *to, type *from, size_t len); \
 void unpack##type (type *to, char *from, size_t len); \
@@ -225,7 +225,7 @@ void freePtpTlvData(PtpTlv *tlv) {
 }
 
 PtpTlv* createPtpTlv() {
-    PtpTlv *tlv = calloc(1, sizeof(PtpTlv));
+    PtpTlv *tlv = ptpCalloc(sizeof(PtpTlv));
     return tlv;
 }
 
@@ -268,7 +268,7 @@ int packPtpTlv(char *buf, PtpTlv *data, char *boundary) {
 	pad = 1;
     }
 
-    data->valueField = calloc(1, data->lengthField + pad);
+    data->valueField = ptpCalloc(data->lengthField + pad);
 
     if(data->valueField == NULL) {
 	return PTP_MESSAGE_OTHER_ERROR;
@@ -310,6 +310,6 @@ void freePtpTlv(PtpTlv *data) {
         free##type (&data->name);
     #include "def/derivedData/tlv.def"
 
-	free(data);
+	ptpFree(data);
     }
 }
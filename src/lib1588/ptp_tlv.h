@@ -67,6 +67,9 @@ enum {
 #define PTP_TLVLEN_CANCEL_UNICAST_TRANSMISSION			2
 #define PTP_TLVLEN_ACKNOWLEDGE_CANCEL_UNICAST_TRANSMISSION	2
 
+/* PTPMon MTIE response stability record: tau (UInteger32), MTIE and TDEV (TimeInterval), ADEV * 1E18 (Integer64) */
+#define PTP_PTPMON_STABILITY_RECORD_LENGTH			28
+
 /* Table 38: Management TLV action types */
 enum {
 	PTP_MTLVACTION_GET = 0x00,
@@ -1353,7 +1353,7 @@ int packPtpManagementTlvData(char *buf, PtpTlv *tlv, char* boundary) {
 	    ret = 0;
 	} else {
 	    if(!((buf == NULL) && (boundary == NULL))) {
-		tlv->body.management.dataField = calloc(1, tlv->lengthField - PTP_MTLV_DATAFIELD_OFFSET);
+		tlv->body.management.dataField = ptpCalloc(tlv->lengthField - PTP_MTLV_DATAFIELD_OFFSET);
 		if(tlv->body.management.dataField == NULL) {
 		    return PTP_MESSAGE_OTHER_ERROR;
 		}
@@ -44,6 +44,8 @@ static ClockDriver* _systemClock = NULL;
 static ClockDriver* _bestClock = NULL;
 static int _updateInterval = CLOCKDRIVER_UPDATE_INTERVAL;
 static int _syncInterval = 1.0 / (CLOCK_SYNC_RATE + 0.0);
+/* generation of cached system clock offsets: new one every sync tick and after every clock step */
+static uint32_t _offsetGeneration = 1;
 
 
 static const char *clockDriverNames[] = {
@@ -173,6 +175,7 @@ setupClockDriver(ClockDriver* clockDriver, int driverType, const char *name)
     clockDriver->state = CS_INIT;
     setupPIservo(&clockDriver->servo);
     clockDriver->servo.controller = clockDriver;
+    setupOffsetEstimator(&clockDriver->estimator);
 
     return found;
 
@@ -460,6 +463,76 @@ updateClockDrivers() {
 
 }
 
+/*
+ * Offset of a clock from the system clock, measured at most once per
+ * offset generation. Comparing any two clocks is then a subtraction of
+ * two cached values, instead of two fresh measurements per pair.
+ */
+Boolean
+getCachedSystemClockOffset(ClockDriver *driver, TimeInternal *output)
+{
+
+    if(driver->_sysOffsetGeneration != _offsetGeneration) {
+	if(!driver->getSystemClockOffset(driver, &driver->_sysOffset)) {
+	    driver->_sysOffsetGeneration = 0;
+	    return FALSE;
+	}
+	driver->_sysOffsetGeneration = _offsetGeneration;
+    }
+
+    if(output != NULL) {
+	*output = driver->_sysOffset;
+    }
+
+    return TRUE;
+
+}
+
+/* drop all cached offsets - a clock was stepped, or a new sync tick begins */
+void
+invalidateClockOffsets() {
+
+    /* 0 means "never sampled" */
+    if(++_offsetGeneration == 0) {
+	_offsetGeneration = 1;
+    }
+
+}
+
+/*
+ * Measure the offset of every clock taking part in internal sync back to
+ * back at the start of the tick, so all comparisons made during this tick
+ * refer to the same moment and each clock is read only once.
+ */
+static void
+sampleClockOffsets() {
+
+    ClockDriver *cd;
+
+    invalidateClockOffsets();
+
+    LINKED_LIST_FOREACH(cd) {
+
+	    if((cd->config.disabled) || (cd->state == CS_HWFAULT)) {
+		continue;
+	    }
+
+	    if(cd->externalReference || (cd->refClock == NULL)) {
+		continue;
+	    }
+
+	    if(!cd->systemClock) {
+		getCachedSystemClockOffset(cd, NULL);
+	    }
+
+	    if(!cd->refClock->systemClock && (cd->refClock->state != CS_HWFAULT)) {
+		getCachedSystemClockOffset(cd->refClock, NULL);
+	    }
+
+    }
+
+}
+
 void
 syncClocks(double tau) {
 
@@ -467,6 +540,8 @@ syncClocks(double tau) {
 
     ClockDriver *cd;
 
+    sampleClockOffsets();
+
     /* sync locked clocks first, in case if they are to unlock */
     LINKED_LIST_FOREACH(cd) {
 
@@ -1223,6 +1298,9 @@ compareAllClocks() {
     memset(lineBuf, 0, lineLen);
     count = 0;
 
+    /* fresh offsets for the whole matrix */
+    invalidateClockOffsets();
+
     LINKED_LIST_FOREACH(outer) {
 
 	memset(lineBuf, 0, lineLen);
@@ -1240,6 +1318,13 @@ compareAllClocks() {
 
     }
 
+    /* how the offsets were measured */
+    LINKED_LIST_FOREACH(cd) {
+	if(cd->estimator.measurements > 0) {
+	    cd->estimator.dump(&cd->estimator, cd->name);
+	}
+    }
+
 }
 
 
@@ -1310,6 +1395,13 @@ pushConfig(ClockDriver *driver, RunTimeOpts *global)
     config->madMax = global->clockOutlierFilterCutoff;
     config->outlierFilterBlockTimeout = global->clockOutlierFilterBlockTimeout;
 
+    if((driver->estimator.fixedSamples != global->clockOffsetSamples) ||
+	(driver->estimator.rejectPercentile != global->clockOffsetRejectPercentile)) {
+	driver->estimator.fixedSamples = global->clockOffsetSamples;
+	driver->estimator.rejectPercentile = global->clockOffsetRejectPercentile;
+	driver->estimator.reset(&driver->estimator);
+    }
+
     driver->servo.kP = global->servoKP;
     driver->servo.kI = global->servoKI;
 
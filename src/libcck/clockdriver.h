@@ -40,6 +40,7 @@
 #include "linkedlist.h"
 
 #include "piservo.h"
+#include "offsetestimator.h"
 
 #define CLOCKDRIVER_NAME_MAX 20
 #define CLOCKDRIVER_UPDATE_INTERVAL 1
@@ -206,6 +207,7 @@ struct ClockDriver {
     double maxAdevTotal;		/* maximum Allan deviation */
 
     PIservo servo;			/* PI servo used to sync the clock */
+    OffsetEstimator estimator;		/* turns offset samples from other clocks into one offset */
 
     double lastFrequency;		/* last known frequency offset */
     double storedFrequency;		/* stored (good) frequency offset */
@@ -232,6 +234,8 @@ struct ClockDriver {
     DoubleMovingStatFilter *_filter;	/* offset filter */
     DoubleMovingStatFilter *_madFilter;	/* MAD container */
     Boolean _skipSync;			/* skip next sync */
+    TimeInternal _sysOffset;		/* offset from the system clock, sampled once per sync tick */
+    uint32_t _sysOffsetGeneration;	/* offset generation _sysOffset was sampled in, 0 = none */
     int *_instanceCount;		/* instance counter for the whole clock driver */
     void *_privateData;			/* implementation-specific data */
     void *_privateConfig;		/* implementation-specific config */
@@ -319,6 +323,8 @@ ClockDriver*	findClockDriver(const char *);
 ClockDriver*	getClockDriverByName(const char *);
 
 void		syncClocks();
+Boolean		getCachedSystemClockOffset(ClockDriver *, TimeInternal *);
+void		invalidateClockOffsets();
 void		stepClocks(Boolean);
 void		reconfigureClockDrivers(RunTimeOpts *);
 Boolean createClockDriversFromString(const char*, RunTimeOpts *, Boolean);
@@ -59,12 +59,27 @@ struct ptp_sys_offset {
 
 #endif /* HAVE_DECL_PTP_SYS_OFFSET */
 
+#if defined(HAVE_DECL_PTP_SYS_OFFSET_EXTENDED) && HAVE_DECL_PTP_SYS_OFFSET_EXTENDED
+#define PHC_HAVE_SYSOFF_EXTENDED
+#endif
+
+#if defined(HAVE_DECL_PTP_SYS_OFFSET_PRECISE) && HAVE_DECL_PTP_SYS_OFFSET_PRECISE
+#define PHC_HAVE_SYSOFF_PRECISE
+#endif
+
 #define THIS_COMPONENT "clock.linuxphc: "
 
+static const char *sysOffsetMethodNames[] = {
+    [PHC_SYSOFF_BASIC] = "PTP_SYS_OFFSET",
+    [PHC_SYSOFF_EXTENDED] = "PTP_SYS_OFFSET_EXTENDED",
+    [PHC_SYSOFF_PRECISE] = "PTP_SYS_OFFSET_PRECISE"
+};
+
 /* tracking the number of instances */
 static int _instanceCount = 0;
 
 static Boolean getClockCapabilities(ClockDriver *self, struct ptp_clock_caps *caps);
+static void probeSysOffsetMethod(ClockDriver *self);
 
 #ifndef HAVE_CLOCK_ADJTIME
 static inline int clock_adjtime(clockid_t clkid, struct timex *timex)
@@ -161,6 +176,8 @@ clockdriver_init(ClockDriver* self, const void *userData) {
 	}
     }
 
+    probeSysOffsetMethod(self);
+
     /* run any vendor-specific initialisation code */
     self->_vendorInit(self);
 
@@ -289,6 +306,8 @@ setTime (ClockDriver *self, TimeInternal *time, Boolean force) {
 	}
 
 	self->_stepped = TRUE;
+	/* only this clock's cached offset is now stale */
+	self->_sysOffsetGeneration = 0;
 
 	struct timespec tmpTs = { time->seconds,0 };
 
@@ -369,6 +388,8 @@ stepTime (ClockDriver *self, TimeInternal *delta, Boolean force) {
 		    (delta->seconds <0 || delta->nanoseconds <0) ? "-":"", delta->seconds, delta->nanoseconds);
 
 	self->_stepped = TRUE;
+	/* only this clock's cached offset is now stale */
+	self->_sysOffsetGeneration = 0;
 
 	self->setState(self, CS_FREERUN);
 
@@ -460,6 +481,12 @@ getClockCapabilities(ClockDriver *self, struct ptp_clock_caps *caps) {
 
 }
 
+/*
+ * Offsets between PHCs and from the system clock are derived from the
+ * per-tick system clock offset cache (getCachedSystemClockOffset()),
+ * so every PHC is read once per clock sync tick, however many clocks
+ * it is compared against.
+ */
 static Boolean
 getOffsetFrom (ClockDriver *self, ClockDriver *from, TimeInternal *delta)
 {
@@ -479,10 +506,10 @@ getOffsetFrom (ClockDriver *self, ClockDriver *from, TimeInternal *delta)
 		delta->nanoseconds = 0;
 		return TRUE;
 	    } else {
-		if(!self->getSystemClockOffset(self, &deltaA)) {
+		if(!getCachedSystemClockOffset(self, &deltaA)) {
 		    return FALSE;
 		}
-		if(!self->getSystemClockOffset(from, &deltaB)) {
+		if(!getCachedSystemClockOffset(from, &deltaB)) {
 		    return FALSE;
 		}
 		subTime(delta, &deltaA, &deltaB);
@@ -491,7 +518,7 @@ getOffsetFrom (ClockDriver *self, ClockDriver *from, TimeInternal *delta)
 	}
 
 	if((from->type == CLOCKDRIVER_UNIX) && from->systemClock) {
-	    if(!self->getSystemClockOffset(self, delta)) {
+	    if(!getCachedSystemClockOffset(self, delta)) {
 		return FALSE;
 	    }
 /*
@@ -505,76 +532,171 @@ getOffsetFrom (ClockDriver *self, ClockDriver *from, TimeInternal *delta)
 
 }
 
-static Boolean
-getSystemClockOffset(ClockDriver *self, TimeInternal *output)
+/* convert one system / PHC / system reading into an offset sample */
+static void
+putSysOffsetSample(ClockDriver *self, int i, const struct ptp_clock_time *before,
+		    const struct ptp_clock_time *phc, const struct ptp_clock_time *after,
+		    OffsetSample *sample)
 {
 
+    TimeInternal t1, t2, tptp, duration;
+
+    t1.seconds = before->sec;
+    t1.nanoseconds = before->nsec;
+    tptp.seconds = phc->sec;
+    tptp.nanoseconds = phc->nsec;
+    t2.seconds = after->sec;
+    t2.nanoseconds = after->nsec;
+
+    subTime(&duration, &t2, &t1);
+
+    timeDelta(&t1, &tptp, &t2, &sample->offset);
+
+    sample->duration = (duration.seconds != 0) ? INT32_MAX : duration.nanoseconds;
+
 #ifdef PTPD_CLOCK_SYNC_PROFILING
-    char isMin;
+    INFO(THIS_COMPONENT"prof ref meas\t clock %s\t seq %d\t dur %d.%09d\t delta %d.%09d\n",
+    self->name, i, duration.seconds, duration.nanoseconds,
+    sample->offset.seconds, sample->offset.nanoseconds);
+#else
+    DBGV(THIS_COMPONENT"prof ref meas\t clock %s\t seq %d\t dur %d.%09d\t delta %d.%09d\n",
+    self->name, i, duration.seconds, duration.nanoseconds,
+    sample->offset.seconds, sample->offset.nanoseconds);
 #endif
 
+}
+
+/*
+ * Take a batch of PHC to system clock offset samples using the given method.
+ * Returns the number of samples, 0 on error.
+ */
+static int
+readSysOffset(ClockDriver *self, int method, int count, OffsetSample *samples)
+{
+
     GET_DATA_CLOCKDRIVER(self, myData, linuxphc);
-    GET_CONFIG_CLOCKDRIVER(self, myConfig, linuxphc);
 
-    TimeInternal t1, t2, tptp, tmpDelta, duration, minDuration, delta;
+    if(count > OFFSETEST_MAX_SAMPLES) {
+	count = OFFSETEST_MAX_SAMPLES;
+    }
 
-    struct ptp_clock_time *samples;
-    struct ptp_sys_offset sof;
+    if(count < 1) {
+	count = 1;
+    }
 
-    sof.n_samples = OSCLOCK_OFFSET_SAMPLES;
+    switch(method) {
+
+#ifdef PHC_HAVE_SYSOFF_PRECISE
+	case PHC_SYSOFF_PRECISE: {
+	    struct ptp_sys_offset_precise sofp;
+	    TimeInternal tsys, tptp;
+
+	    memset(&sofp, 0, sizeof(sofp));
+	    if(ioctl(myData->clockFd, PTP_SYS_OFFSET_PRECISE, &sofp) < 0) {
+		return 0;
+	    }
+	    /* both timestamps were taken at the same instant: one sample, no latency */
+	    tsys.seconds = sofp.sys_realtime.sec;
+	    tsys.nanoseconds = sofp.sys_realtime.nsec;
+	    tptp.seconds = sofp.device.sec;
+	    tptp.nanoseconds = sofp.device.nsec;
+	    subTime(&samples[0].offset, &tsys, &tptp);
+	    samples[0].duration = -1;
+	    return 1;
+	}
+#endif /* PHC_HAVE_SYSOFF_PRECISE */
+
+#ifdef PHC_HAVE_SYSOFF_EXTENDED
+	case PHC_SYSOFF_EXTENDED: {
+	    struct ptp_sys_offset_extended sofx;
+
+	    memset(&sofx, 0, sizeof(sofx));
+	    sofx.n_samples = count;
+	    if(ioctl(myData->clockFd, PTP_SYS_OFFSET_EXTENDED, &sofx) < 0) {
+		return 0;
+	    }
+	    for(int i = 0; i < sofx.n_samples; i++) {
+		putSysOffsetSample(self, i, &sofx.ts[i][0], &sofx.ts[i][1], &sofx.ts[i][2],
+				    &samples[i]);
+	    }
+	    return sofx.n_samples;
+	}
+#endif /* PHC_HAVE_SYSOFF_EXTENDED */
+
+	default: {
+	    struct ptp_sys_offset sof;
+	    struct ptp_clock_time *ts;
+
+	    memset(&sof, 0, sizeof(sof));
+	    sof.n_samples = count;
+	    if(ioctl(myData->clockFd, PTP_SYS_OFFSET, &sof) < 0) {
+		return 0;
+	    }
+	    ts = sof.ts;
+	    for(int i = 0; i < sof.n_samples; i++) {
+		putSysOffsetSample(self, i, &ts[2*i], &ts[2*i+1], &ts[2*i+2],
+				    &samples[i]);
+	    }
+	    return sof.n_samples;
+	}
 
-    if((!self->_init) || (self->state == CS_HWFAULT)) {
-	return FALSE;
     }
 
+}
 
-    if(ioctl(myData->clockFd, PTP_SYS_OFFSET, &sof) < 0) {
-	PERROR(THIS_COMPONENT"Could not read OS clock offset for %s (%s)",
-		self->name, myConfig->characterDevice);
-	self->setState(self, CS_HWFAULT);
-	return FALSE;
+/* pick the most accurate offset measurement the kernel and the NIC driver support */
+static void
+probeSysOffsetMethod(ClockDriver *self)
+{
+
+    GET_DATA_CLOCKDRIVER(self, myData, linuxphc);
+
+    myData->sysOffsetMethod = PHC_SYSOFF_BASIC;
+
+    OffsetSample samples[OFFSETEST_MAX_SAMPLES];
+
+#ifdef PHC_HAVE_SYSOFF_EXTENDED
+    if(readSysOffset(self, PHC_SYSOFF_EXTENDED, OSCLOCK_OFFSET_SAMPLES, samples)) {
+	myData->sysOffsetMethod = PHC_SYSOFF_EXTENDED;
     }
+#endif /* PHC_HAVE_SYSOFF_EXTENDED */
 
-    samples = sof.ts;
+#ifdef PHC_HAVE_SYSOFF_PRECISE
+    if(readSysOffset(self, PHC_SYSOFF_PRECISE, 1, samples)) {
+	myData->sysOffsetMethod = PHC_SYSOFF_PRECISE;
+    }
+#endif /* PHC_HAVE_SYSOFF_PRECISE */
 
-    for(int i = 0; i < sof.n_samples; i++) {
+    INFO(THIS_COMPONENT"Linux PHC clock %s: using %s to measure offset from system clock\n",
+	    self->name, sysOffsetMethodNames[myData->sysOffsetMethod]);
 
-	t1.seconds = samples[2*i].sec;
-	t1.nanoseconds = samples[2*i].nsec;
-	tptp.seconds = samples[2*i+1].sec;
-	tptp.nanoseconds = samples[2*i+1].nsec;
-	t2.seconds = samples[2*i+2].sec;
-	t2.nanoseconds = samples[2*i+2].nsec;
+}
 
-	subTime(&duration, &t2, &t1);
+static Boolean
+getSystemClockOffset(ClockDriver *self, TimeInternal *output)
+{
 
-	timeDelta(&t1, &tptp, &t2, &tmpDelta);
-#ifdef PTPD_CLOCK_SYNC_PROFILING
-	isMin = ' ';
-#endif
-	if((i == 0) || !gtTime(&duration, &minDuration)) {
-	    minDuration = duration;
-	    delta = tmpDelta;
-#ifdef PTPD_CLOCK_SYNC_PROFILING
-	    isMin = '+';
-#endif
-	}
-#ifdef PTPD_CLOCK_SYNC_PROFILING
-	INFO(THIS_COMPONENT"prof ref meas %c\t clock %s\t seq %d\t dur %d.%09d\t delta %d.%09d\n",
-	isMin, self->name, i, duration.seconds, duration.nanoseconds,
-	tmpDelta.seconds, tmpDelta.nanoseconds);
-#else
-	DBG(THIS_COMPONENT"prof ref meas %c\t clock %s\t seq %d\t dur %d.%09d\t delta %d.%09d\n",
-	isMin, self->name, i, duration.seconds, duration.nanoseconds,
-	tmpDelta.seconds, tmpDelta.nanoseconds);
-#endif
+    GET_DATA_CLOCKDRIVER(self, myData, linuxphc);
+    GET_CONFIG_CLOCKDRIVER(self, myConfig, linuxphc);
+
+    if((!self->_init) || (self->state == CS_HWFAULT)) {
+	return FALSE;
     }
 
-    if(output != NULL) {
-	*output = delta;
+    OffsetSample samples[OFFSETEST_MAX_SAMPLES];
+    OffsetEstimator *est = &self->estimator;
+    int count;
+
+    count = readSysOffset(self, myData->sysOffsetMethod, est->getWindow(est), samples);
+
+    if(count == 0) {
+	PERROR(THIS_COMPONENT"Could not read OS clock offset for %s (%s)",
+		self->name, myConfig->characterDevice);
+	self->setState(self, CS_HWFAULT);
+	return FALSE;
     }
 
-    return TRUE;
+    return est->estimate(est, samples, count, output);
 }
 
 static Boolean
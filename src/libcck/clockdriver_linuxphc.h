@@ -39,11 +39,19 @@
 
 #define OSCLOCK_OFFSET_SAMPLES 9
 
+/* how the PHC to system clock offset is measured, best available picked at init */
+enum {
+    PHC_SYSOFF_BASIC = 0,	/* PTP_SYS_OFFSET: system time read around the PHC read */
+    PHC_SYSOFF_EXTENDED,	/* PTP_SYS_OFFSET_EXTENDED: system time taken by the driver, around the PHC register read */
+    PHC_SYSOFF_PRECISE		/* PTP_SYS_OFFSET_PRECISE: hardware cross-timestamp */
+};
+
 typedef struct {
     int clockFd;
     int helperFd;
     int phcIndex;
     clockid_t clockId;
+    int sysOffsetMethod;
 } ClockDriverData_linuxphc;
 
 typedef struct {
@@ -294,6 +294,8 @@ setTime (ClockDriver *self, TimeInternal *time, Boolean force) {
 	}
 
 	self->_stepped = TRUE;
+	/* every other clock's offset from the system clock has just changed */
+	invalidateClockOffsets();
 
 	struct timespec tmpTs = { time->seconds,0 };
 
@@ -373,6 +375,8 @@ stepTime (ClockDriver *self, TimeInternal *delta, Boolean force) {
 	addTime(&_stepAccumulator, &_stepAccumulator, delta);
 
 	self->_stepped = TRUE;
+	/* every other clock's offset from the system clock has just changed */
+	invalidateClockOffsets();
 
 	self->setState(self, CS_FREERUN);
 
@@ -80,6 +80,7 @@ getSystemClockOffset(ClockDriver *driver, TimeInternal *output)
 {
 
     int ret;
+    OffsetSample sample;
 
     GET_EXTDATA_CLOCKDRIVER(driver, sfData, solarflare);
 
@@ -93,18 +94,21 @@ getSystemClockOffset(ClockDriver *driver, TimeInternal *output)
 	return FALSE;
     }
 
-    output->seconds = sfData->sfioctl.u.ts_sync.ts.tv_sec;
-    output->nanoseconds = sfData->sfioctl.u.ts_sync.ts.tv_nsec;
+    sample.offset.seconds = sfData->sfioctl.u.ts_sync.ts.tv_sec;
+    sample.offset.nanoseconds = sfData->sfioctl.u.ts_sync.ts.tv_nsec;
 
-    if(output->seconds < 0) {
-	output->seconds += 1;
-	output->nanoseconds = output->nanoseconds - 1E9;
+    if(sample.offset.seconds < 0) {
+	sample.offset.seconds += 1;
+	sample.offset.nanoseconds = sample.offset.nanoseconds - 1E9;
     }
 
-    output->seconds = -output->seconds;
-    output->nanoseconds = -output->nanoseconds;
+    sample.offset.seconds = -sample.offset.seconds;
+    sample.offset.nanoseconds = -sample.offset.nanoseconds;
 
-    return TRUE;
+    /* the adapter does its own sampling: one result, no read latency to go by */
+    sample.duration = -1;
+
+    return driver->estimator.estimate(&driver->estimator, &sample, 1, output);
 }
 
 static int
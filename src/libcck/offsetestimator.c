@@ -0,0 +1,330 @@
+/* Copyright (c) 2026 PTPd contributors,
+ *
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file   offsetestimator.c
+ * @date   Sun Oct 18 07:22:25 2026
+ *
+ * @brief  Clock offset estimator: sample window, outlier rejection, latency statistics
+ *
+ * A clock offset measurement (PHC vs. system clock) is a batch of samples,
+ * each bracketed by two reads of the other clock. The shorter the bracket,
+ * the less the sample is affected by bus latency. The estimator keeps a
+ * histogram of read durations and uses it to:
+ *
+ * - reject samples slower than a configured latency percentile and average
+ *   the rest, or, with no percentile set, use only the fastest sample,
+ * - size the next batch so that it very likely contains a fast sample:
+ *   few samples on a quiet bus, more on a congested PCIe bus.
+ */
+
+#include "../ptpd.h"
+#include "offsetestimator.h"
+
+#define THIS_COMPONENT "clock.estimator: "
+
+static int getWindow (OffsetEstimator*);
+static Boolean estimate (OffsetEstimator*, const OffsetSample*, int, TimeInternal*);
+static void reset (OffsetEstimator*);
+static void putInfoLine (OffsetEstimator*, char*, int);
+static void dump (OffsetEstimator*, const char*);
+
+static int histogramBin(Integer32);
+static Integer32 histogramBinEdge(int);
+
+void
+setupOffsetEstimator(OffsetEstimator *self) {
+    memset(self, 0, sizeof(OffsetEstimator));
+    self->getWindow = getWindow;
+    self->estimate = estimate;
+    self->reset = reset;
+    self->putInfoLine = putInfoLine;
+    self->dump = dump;
+    self->reset(self);
+}
+
+static void
+reset (OffsetEstimator *self) {
+
+    memset(self->histogram, 0, sizeof(self->histogram));
+    self->histCount = 0;
+    self->measurements = 0;
+    self->samples = 0;
+    self->rejected = 0;
+    self->lastSamples = 0;
+    self->durationLimit = 0;
+    self->fastRatio = 0.5;
+    self->minDuration = 0;
+    self->window = (self->fixedSamples > 0) ? self->fixedSamples : OFFSETEST_DEFAULT_SAMPLES;
+
+}
+
+static int
+getWindow (OffsetEstimator *self) {
+
+    if(self->fixedSamples > 0) {
+	return self->fixedSamples;
+    }
+
+    return self->window;
+
+}
+
+/* upper edge (ns) of a histogram bin: OFFSETEST_HIST_BASE * 2^(bin/4) */
+static Integer32
+histogramBinEdge(int bin) {
+
+    return (Integer32)(OFFSETEST_HIST_BASE * pow(2.0, bin / 4.0));
+
+}
+
+static int
+histogramBin(Integer32 duration) {
+
+    int bin;
+
+    if(duration < OFFSETEST_HIST_BASE) {
+	return 0;
+    }
+
+    bin = (int)ceil(4.0 * log2((duration + 0.0) / OFFSETEST_HIST_BASE));
+
+    return (bin >= OFFSETEST_HIST_BINS) ? OFFSETEST_HIST_BINS - 1 : bin;
+
+}
+
+/* read latency at the given percentile (0..100), to histogram bin resolution */
+Integer32
+getOffsetEstimatorPercentile(OffsetEstimator *self, int percentile) {
+
+    uint32_t target, count = 0;
+
+    if(self->histCount == 0) {
+	return 0;
+    }
+
+    target = ((uint64_t)self->histCount * percentile + 99) / 100;
+
+    for(int i = 0; i < OFFSETEST_HIST_BINS; i++) {
+	count += self->histogram[i];
+	if(count >= target && count > 0) {
+	    return histogramBinEdge(i);
+	}
+    }
+
+    return histogramBinEdge(OFFSETEST_HIST_BINS - 1);
+
+}
+
+static Boolean
+estimate (OffsetEstimator *self, const OffsetSample *samples, int count, TimeInternal *output) {
+
+    const OffsetSample *fastest = NULL;
+    TimeInternal diff;
+    double sum = 0.0;
+    int accepted = 0, fast = 0;
+    Integer32 limit;
+    double p;
+
+    if(count < 1) {
+	return FALSE;
+    }
+
+    self->measurements++;
+    self->samples += count;
+    self->lastSamples = count;
+
+    for(int i = 0; i < count; i++) {
+
+	if(samples[i].duration < 0) {
+	    continue;
+	}
+
+	if(fastest == NULL || samples[i].duration <= fastest->duration) {
+	    fastest = &samples[i];
+	}
+
+	if(self->minDuration == 0 || samples[i].duration < self->minDuration) {
+	    self->minDuration = samples[i].duration;
+	}
+
+	self->histogram[histogramBin(samples[i].duration)]++;
+	self->histCount++;
+
+    }
+
+    /* no latency information: cross-timestamp or vendor method, nothing to choose from */
+    if(fastest == NULL) {
+	if(output != NULL) {
+	    *output = samples[count - 1].offset;
+	}
+	return TRUE;
+    }
+
+    /* let old samples fade out so the distribution follows the bus */
+    if(self->histCount >= OFFSETEST_HIST_DECAY) {
+	self->histCount = 0;
+	for(int i = 0; i < OFFSETEST_HIST_BINS; i++) {
+	    self->histogram[i] >>= 1;
+	    self->histCount += self->histogram[i];
+	}
+    }
+
+    if(self->histCount >= OFFSETEST_WARMUP) {
+	self->durationLimit = getOffsetEstimatorPercentile(self,
+				(self->rejectPercentile > 0) ? self->rejectPercentile : 50);
+    } else {
+	self->durationLimit = 0;
+    }
+
+    limit = (self->rejectPercentile > 0) ? self->durationLimit : 0;
+
+    /* average the samples within the limit, relative to the fastest one */
+    for(int i = 0; i < count; i++) {
+
+	if(samples[i].duration < 0) {
+	    continue;
+	}
+
+	if(self->durationLimit == 0 || samples[i].duration <= self->durationLimit) {
+	    fast++;
+	}
+
+	if(limit == 0) {
+	    continue;
+	}
+
+	subTime(&diff, &samples[i].offset, &fastest->offset);
+
+	if(samples[i].duration > limit || diff.seconds != 0) {
+	    self->rejected++;
+	    continue;
+	}
+
+	sum += diff.nanoseconds;
+	accepted++;
+
+    }
+
+    if(output != NULL) {
+	*output = fastest->offset;
+	if(accepted > 0) {
+	    diff.seconds = 0;
+	    diff.nanoseconds = round(sum / accepted);
+	    addTime(output, &fastest->offset, &diff);
+	}
+    }
+
+    DBGV(THIS_COMPONENT"%d samples, fastest %d ns, limit %d ns, accepted %d\n",
+	    count, fastest->duration, limit, accepted);
+
+    /*
+     * Size the next window: with a fraction p of samples being fast, the
+     * chance of n samples containing none is (1-p)^n. When averaging, we
+     * also want to expect at least OFFSETEST_MIN_SAMPLES accepted ones.
+     */
+    if(self->fixedSamples == 0 && self->durationLimit > 0) {
+
+	self->fastRatio = 0.9 * self->fastRatio + 0.1 * ((fast + 0.0) / count);
+	p = self->fastRatio;
+
+	if(p >= 0.999) {
+	    self->window = OFFSETEST_MIN_SAMPLES;
+	} else if (p <= 0.001) {
+	    self->window = OFFSETEST_MAX_SAMPLES;
+	} else {
+	    self->window = ceil(log(OFFSETEST_MISS_PROBABILITY) / log(1.0 - p));
+	    if(limit > 0 && self->window < ceil(OFFSETEST_MIN_SAMPLES / p)) {
+		self->window = ceil(OFFSETEST_MIN_SAMPLES / p);
+	    }
+	}
+
+	if(self->window < OFFSETEST_MIN_SAMPLES) {
+	    self->window = OFFSETEST_MIN_SAMPLES;
+	}
+	if(self->window > OFFSETEST_MAX_SAMPLES) {
+	    self->window = OFFSETEST_MAX_SAMPLES;
+	}
+
+    }
+
+    return TRUE;
+
+}
+
+static void
+putInfoLine(OffsetEstimator *self, char *buf, int len) {
+
+    if(self->histCount == 0) {
+	snprintf(buf, len, "reads %u, %d sample(s), no latency data",
+		self->measurements, self->lastSamples);
+	return;
+    }
+
+    snprintf(buf, len, "n %d%s, lat min %d p50 %d p90 %d p99 %d ns, rej %.01f%%",
+	    self->getWindow(self), (self->fixedSamples > 0) ? "" : " (auto)",
+	    self->minDuration,
+	    getOffsetEstimatorPercentile(self, 50),
+	    getOffsetEstimatorPercentile(self, 90),
+	    getOffsetEstimatorPercentile(self, 99),
+	    self->samples ? (100.0 * self->rejected) / self->samples : 0.0);
+
+}
+
+static void
+dump(OffsetEstimator *self, const char *name) {
+
+    char buf[100];
+    Integer32 lower = 0;
+    uint32_t max = 0;
+
+    self->putInfoLine(self, buf, sizeof(buf));
+    INFO(THIS_COMPONENT"%s: %s\n", name, buf);
+
+    if(self->histCount == 0) {
+	return;
+    }
+
+    for(int i = 0; i < OFFSETEST_HIST_BINS; i++) {
+	if(self->histogram[i] > max) {
+	    max = self->histogram[i];
+	}
+    }
+
+    INFO(THIS_COMPONENT"%s: read latency histogram (%u samples):\n", name, self->histCount);
+
+    for(int i = 0; i < OFFSETEST_HIST_BINS; i++) {
+	if(self->histogram[i] > 0) {
+	    memset(buf, 0, sizeof(buf));
+	    memset(buf, '#', (40 * self->histogram[i] + max - 1) / max);
+	    INFO(THIS_COMPONENT"%s: %7d - %7d ns %8u %s\n", name, lower,
+		    (i == OFFSETEST_HIST_BINS - 1) ? INT32_MAX : histogramBinEdge(i),
+		    self->histogram[i], buf);
+	}
+	lower = histogramBinEdge(i);
+    }
+
+}
@@ -0,0 +1,99 @@
+/* Copyright (c) 2026 PTPd contributors,
+ *
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file   offsetestimator.h
+ * @date   Sun Oct 18 07:22:25 2026
+ *
+ * @brief  structure definitions for the clock offset estimator
+ *
+ */
+
+
+#ifndef PTPD_OFFSETESTIMATOR_H_
+#define PTPD_OFFSETESTIMATOR_H_
+
+#include "../ptp_primitives.h"
+#include "../ptp_datatypes.h"
+
+#include <stdint.h>
+
+#define OFFSETEST_MAX_SAMPLES		25	/* PTP_MAX_SAMPLES in the kernel */
+#define OFFSETEST_MIN_SAMPLES		3	/* lower bound for the adaptive window */
+#define OFFSETEST_DEFAULT_SAMPLES	9	/* window used until the latency distribution is known */
+#define OFFSETEST_WARMUP		100	/* samples needed before the histogram is trusted */
+#define OFFSETEST_HIST_BINS		40	/* read latency histogram: quarter-octave bins... */
+#define OFFSETEST_HIST_BASE		128	/* ...the first one ending at 128 ns */
+#define OFFSETEST_HIST_DECAY		65536	/* halve the histogram when it holds this many samples */
+#define OFFSETEST_MISS_PROBABILITY	0.01	/* adaptive window: acceptable chance of no fast sample */
+
+/**
+ * \struct OffsetSample
+ * \brief One clock offset measurement and how long the read took
+ */
+typedef struct {
+    Integer32 duration;		/* read duration (ns), -1 if unknown: cross-timestamp, vendor method */
+    TimeInternal offset;	/* offset measured by this sample */
+} OffsetSample;
+
+/**
+ * \struct OffsetEstimator
+ * \brief Turns a batch of offset samples into one offset, tracking read latency
+ */
+
+typedef struct OffsetEstimator OffsetEstimator;
+
+struct OffsetEstimator {
+
+    /* config */
+    int fixedSamples;			/* samples per measurement, 0 = adaptive */
+    int rejectPercentile;		/* reject samples slower than this latency percentile, 0 = fastest sample only */
+
+    /* state */
+    int window;				/* samples to take in the next measurement */
+    int lastSamples;			/* samples used in the last measurement */
+    Integer32 durationLimit;		/* current rejection threshold (ns), 0 = none */
+    double fastRatio;			/* running fraction of samples within the threshold */
+    Integer32 minDuration;		/* fastest read seen */
+    uint32_t histogram[OFFSETEST_HIST_BINS];
+    uint32_t histCount;
+    uint32_t measurements;
+    uint32_t samples;
+    uint32_t rejected;
+
+    /* methods - vendor extensions may replace these */
+    int (*getWindow) (OffsetEstimator*);
+    Boolean (*estimate) (OffsetEstimator*, const OffsetSample*, int, TimeInternal*);
+    void (*reset) (OffsetEstimator*);
+    void (*putInfoLine) (OffsetEstimator*, char*, int);
+    void (*dump) (OffsetEstimator*, const char*);
+
+};
+
+void setupOffsetEstimator(OffsetEstimator*);
+Integer32 getOffsetEstimatorPercentile(OffsetEstimator*, int);
+
+#endif /*PTPD_OFFSETESTIMATOR_H_*/
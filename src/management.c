@@ -657,7 +657,7 @@ void handleMMSlaveOnly(MsgManagement* incoming, MsgManagement* outgoing, PtpCloc
 		data = (MMSlaveOnly*)incoming->tlv->dataField;
 		/* SET actions */
 		ptpClock->defaultDS.slaveOnly = data->so;
-		ptpClock->record_update = TRUE;
+		bmcRecordChanged(ptpClock, BMC_CHANGED_ALL);
 		setConfig(ptpClock->managementConfig, "ptpengine:slave_only", ptpClock->defaultDS.slaveOnly ? "Y" : "N");
 		/* intentionally fall through to GET case */
 	case GET:
@@ -1081,7 +1081,7 @@ void handleMMPriority1(MsgManagement* incoming, MsgManagement* outgoing, PtpCloc
 		ptpClock->defaultDS.priority1 = data->priority1;
 		tmpsnprintf(tmpStr, 4, "%d", data->priority1);
 		setConfig(ptpClock->managementConfig, "ptpengine:priority1", tmpStr);
-		ptpClock->record_update = TRUE;
+		bmcRecordChanged(ptpClock, BMC_CHANGED_ALL);
 		/* intentionally fall through to GET case */
 	case GET:
 		DBGV(" GET action\n");
@@ -1125,7 +1125,7 @@ void handleMMPriority2(MsgManagement* incoming, MsgManagement* outgoing, PtpCloc
 		ptpClock->defaultDS.priority2 = data->priority2;
 		tmpsnprintf(tmpStr, 4, "%d", data->priority2);
 		setConfig(ptpClock->managementConfig, "ptpengine:priority2", tmpStr);
-		ptpClock->record_update = TRUE;
+		bmcRecordChanged(ptpClock, BMC_CHANGED_ALL);
 		/* intentionally fall through to GET case */
 	case GET:
 		DBGV(" GET action\n");
@@ -1169,7 +1169,7 @@ void handleMMDomain(MsgManagement* incoming, MsgManagement* outgoing, PtpClock*
 		ptpClock->defaultDS.domainNumber = data->domainNumber;
 		tmpsnprintf(tmpStr, 4, "%d", data->domainNumber);
 		setConfig(ptpClock->managementConfig, "ptpengine:domain", tmpStr);
-		ptpClock->record_update = TRUE;
+		bmcRecordChanged(ptpClock, BMC_CHANGED_ALL);
 		/* intentionally fall through to GET case */
 	case GET:
 		DBGV(" GET action\n");
@@ -1213,7 +1213,7 @@ void handleMMLogAnnounceInterval(MsgManagement* incoming, MsgManagement* outgoin
 		ptpClock->portDS.logAnnounceInterval = data->logAnnounceInterval;
 		tmpsnprintf(tmpStr, 4, "%d", data->logAnnounceInterval);
 		setConfig(ptpClock->managementConfig, "ptpengine:log_announce_interval", tmpStr);
-		ptpClock->record_update = TRUE;
+		bmcRecordChanged(ptpClock, BMC_CHANGED_ALL);
 		/* intentionally fall through to GET case */
 	case GET:
 		DBGV(" GET action\n");
@@ -1257,7 +1257,7 @@ void handleMMAnnounceReceiptTimeout(MsgManagement* incoming, MsgManagement* outg
 		ptpClock->portDS.announceReceiptTimeout = data->announceReceiptTimeout;
 		tmpsnprintf(tmpStr, 4, "%d", data->announceReceiptTimeout);
 		setConfig(ptpClock->managementConfig, "ptpengine:announce_receipt_timeout", tmpStr);
-		ptpClock->record_update = TRUE;
+		bmcRecordChanged(ptpClock, BMC_CHANGED_ALL);
 		/* intentionally fall through to GET case */
 	case GET:
 		DBGV(" GET action\n");
@@ -1301,7 +1301,7 @@ void handleMMLogSyncInterval(MsgManagement* incoming, MsgManagement* outgoing, P
 		ptpClock->portDS.logSyncInterval = data->logSyncInterval;
 		tmpsnprintf(tmpStr, 4, "%d", data->logSyncInterval);
 		setConfig(ptpClock->managementConfig, "ptpengine:log_sync_interval", tmpStr);
-		ptpClock->record_update = TRUE;
+		bmcRecordChanged(ptpClock, BMC_CHANGED_ALL);
 		/* intentionally fall through to GET case */
 	case GET:
 		DBGV(" GET action\n");
@@ -1491,7 +1491,7 @@ void handleMMClockAccuracy(MsgManagement* incoming, MsgManagement* outgoing, Ptp
 		if(acc != NULL) {
 		    setConfig(ptpClock->managementConfig, "ptpengine:clock_accuracy", acc);
 		}
-		ptpClock->record_update = TRUE;
+		bmcRecordChanged(ptpClock, BMC_CHANGED_ALL);
 		/* intentionally fall through to GET case */
 	case GET:
 		DBGV(" GET action\n");
@@ -1541,7 +1541,7 @@ void handleMMUtcProperties(MsgManagement* incoming, MsgManagement* outgoing, Ptp
 		/* todo: setting leap flags can be handy when we remotely controll PTPd GMs */
 		setConfig(ptpClock->managementConfig, "ptpengine:utc_offset", tmpStr);
 		setConfig(ptpClock->managementConfig, "ptpengine:utc_offset_valid", IS_SET(data->utcv_li59_li61, UTCV) ? "Y" : "N");
-		ptpClock->record_update = TRUE;
+		bmcRecordChanged(ptpClock, BMC_CHANGED_ALL);
 		/* intentionally fall through to GET case */
 	case GET:
 		DBGV(" GET action\n");
@@ -1590,7 +1590,7 @@ void handleMMTraceabilityProperties(MsgManagement* incoming, MsgManagement* outg
 		ptpClock->timePropertiesDS.timeTraceable = IS_SET(data->ftra_ttra, TTRA);
 		setConfig(ptpClock->managementConfig, "ptpengine:frequency_traceable", IS_SET(data->ftra_ttra, FTRA) ? "Y" : "N");
 		setConfig(ptpClock->managementConfig, "ptpengine:time_traceable", IS_SET(data->ftra_ttra, TTRA) ? "Y" : "N");
-		ptpClock->record_update = TRUE;
+		bmcRecordChanged(ptpClock, BMC_CHANGED_ALL);
 		/* intentionally fall through to GET case */
 	case GET:
 		DBGV(" GET action\n");
@@ -1676,7 +1676,7 @@ void handleMMUnicastNegotiationEnable(MsgManagement* incoming, MsgManagement* ou
 		data = (MMUnicastNegotiationEnable*)incoming->tlv->dataField;
 		/* SET actions */
 		setConfig(ptpClock->managementConfig, "ptpengine:unicast_negotiation", data->en ? "Y" : "N");
-		ptpClock->record_update = TRUE;
+		bmcRecordChanged(ptpClock, BMC_CHANGED_ALL);
 		/* intentionally fall through to GET case */
 	case GET:
 		DBGV(" GET action\n");
@@ -1722,7 +1722,7 @@ void handleMMDelayMechanism(MsgManagement* incoming, MsgManagement* outgoing, Pt
 		if(mech != NULL) {
 		    setConfig(ptpClock->managementConfig, "ptpengine:delay_mechanism", mech);
 		}
-		ptpClock->record_update = TRUE;
+		bmcRecordChanged(ptpClock, BMC_CHANGED_ALL);
 		/* intentionally fall through to GET case */
 	case GET:
 		DBGV(" GET action\n");
@@ -1766,7 +1766,7 @@ void handleMMLogMinPdelayReqInterval(MsgManagement* incoming, MsgManagement* out
 		ptpClock->portDS.logMinPdelayReqInterval = data->logMinPdelayReqInterval;
 		tmpsnprintf(tmpStr, 4, "%d", data->logMinPdelayReqInterval);
 		setConfig(ptpClock->managementConfig, "ptpengine:log_peer_delayreq_interval", tmpStr);
-		ptpClock->record_update = TRUE;
+		bmcRecordChanged(ptpClock, BMC_CHANGED_ALL);
 		/* intentionally fall through to GET case */
 	case GET:
 		DBGV(" GET action\n");
@@ -60,6 +60,7 @@ Boolean doInit(RunTimeOpts*,PtpClock*);
 static void doState(RunTimeOpts*,PtpClock*);
 
 void handle(RunTimeOpts*,PtpClock*);
+static void handleBatch(RunTimeOpts*,PtpClock*);
 
 static void handleAnnounce(MsgHeader*, ssize_t,Boolean, const RunTimeOpts*,PtpClock*);
 static void handleSync(const MsgHeader*, ssize_t,TimeInternal*,Boolean,Integer32, Integer32, const RunTimeOpts*,PtpClock*);
@@ -75,18 +76,23 @@ static void handlePdelayRespFollowUp(const MsgHeader*, ssize_t, Boolean, const R
 
 #ifndef PTPD_SLAVE_ONLY /* does not get compiled when building slave only */
 static void issueAnnounce(const RunTimeOpts*,PtpClock*);
-static void issueAnnounceSingle(Integer32, UInteger16*, const RunTimeOpts*,PtpClock*);
+static void issueAnnounceSingle(Integer32, UInteger16*, Boolean, const RunTimeOpts*,PtpClock*);
 static void issueSync(const RunTimeOpts*,PtpClock*);
+static void collectSyncTimestamps(const RunTimeOpts*,PtpClock*);
+static Boolean finishSyncRound(UInteger16,const RunTimeOpts*,PtpClock*);
+static Boolean flushTxBatch(Boolean, uint32_t*, const RunTimeOpts*,PtpClock*);
+static void queueFollowup(const TimeInternal*,const RunTimeOpts*,PtpClock*, Integer32, const UInteger16);
 #endif /* PTPD_SLAVE_ONLY */
 
 /* enabled for slave-only to support PTPMon */
-static TimeInternal issueSyncSingle(Integer32, UInteger16*, const RunTimeOpts*,PtpClock*);
+static TimeInternal issueSyncSingle(Integer32, UInteger16*, Boolean, const RunTimeOpts*,PtpClock*);
 static void issueFollowup(const TimeInternal*,const RunTimeOpts*,PtpClock*, Integer32, const UInteger16);
 
 static void issuePdelayReq(const RunTimeOpts*,PtpClock*);
 static void issueDelayReq(const RunTimeOpts*,PtpClock*);
 static void issuePdelayResp(const TimeInternal*,MsgHeader*,Integer32,const RunTimeOpts*,PtpClock*);
 static void issueDelayResp(const TimeInternal*,MsgHeader*,Integer32,const RunTimeOpts*,PtpClock*);
+static DelayRespTemplate* getDelayRespTemplate(MsgHeader*,const RunTimeOpts*,PtpClock*);
 static void issuePdelayRespFollowUp(const TimeInternal*,MsgHeader*, Integer32, const RunTimeOpts*,PtpClock*, const UInteger16);
 
 static int populatePtpMon(char *buf, MsgHeader *header, PtpClock *ptpClock, const RunTimeOpts *rtOpts);
@@ -94,19 +100,110 @@ static int populatePtpMon(char *buf, MsgHeader *header, PtpClock *ptpClock, cons
 static void processMessage(RunTimeOpts* rtOpts, PtpClock* ptpClock, TimeInternal* timeStamp, ssize_t length);
 
 static void processSyncFromSelf(const TimeInternal * tint, const RunTimeOpts * rtOpts, PtpClock * ptpClock, Integer32 dst, const UInteger16 sequenceId);
-static void indexSync(TimeInternal *timeStamp, UInteger16 sequenceId, Integer32 transportAddress, SyncDestEntry *index);
+static void indexSync(TimeInternal *timeStamp, UInteger16 sequenceId, Integer32 transportAddress, SyncDestEntry *index, int size);
 
-static void processDelayReqFromSelf(const TimeInternal * tint, const RunTimeOpts * rtOpts, PtpClock * ptpClock);
+static void processDelayReqFromSelf(const Octet *buf, const TimeInternal * tint, const RunTimeOpts * rtOpts, PtpClock * ptpClock);
 static void processPdelayReqFromSelf(const TimeInternal * tint, const RunTimeOpts * rtOpts, PtpClock * ptpClock);
 static void processPdelayRespFromSelf(const TimeInternal * tint, const RunTimeOpts * rtOpts, PtpClock * ptpClock, Integer32 dst, const UInteger16 sequenceId);
 
 /* this shouldn't really be in protocol.c, it will be moved later */
 static void timestampCorrection(const RunTimeOpts * rtOpts, PtpClock *ptpClock, TimeInternal *timeStamp);
 
-static Integer32 lookupSyncIndex(TimeInternal *timeStamp, UInteger16 sequenceId, SyncDestEntry *index);
+static Integer32 lookupSyncIndex(TimeInternal *timeStamp, UInteger16 sequenceId, SyncDestEntry *index, int size);
 static Integer32 findSyncDestination(TimeInternal *timeStamp, const RunTimeOpts *rtOpts, PtpClock *ptpClock);
+static double txTimerInterval(Integer8 logInterval, const RunTimeOpts *rtOpts);
 
 
+/* lib1588 allocations on the packet path come from here: no heap use, one reset frees everything */
+static PtpArena*
+packetArena(void)
+{
+    static uint64_t buf[4096 / sizeof(uint64_t)];
+    static PtpArena arena;
+
+    if(arena.buf == NULL) {
+	initPtpArena(&arena, buf, sizeof(buf));
+    }
+
+    return &arena;
+}
+
+/*
+ * Phase stability records appended to the MTIE response, one per valid
+ * observation interval: tau, MTIE, TDEV, then ADEV scaled by 1E18.
+ */
+static Boolean packStabilityRecords(PtpTlvPtpMonMtieResponse *mtieresp, PhaseStability *stability) {
+
+    PhaseStabilityInterval *interval;
+    PtpUInteger32 tau;
+    PtpTimeInterval timeInterval;
+    PtpInteger64 adev;
+    int64_t scaledAdev;
+    TimeInternal tmpTime;
+    char *record;
+    int i, count = 0;
+
+    mtieresp->tauCount = 0;
+
+    if(stability == NULL) {
+	return TRUE;
+    }
+
+    for(i = 0; i < stability->intervalCount; i++) {
+	if(stability->interval[i].valid) {
+	    count++;
+	}
+    }
+
+    if(count == 0) {
+	return TRUE;
+    }
+
+    mtieresp->stabilityRecords = ptpCalloc(count * PTP_PTPMON_STABILITY_RECORD_LENGTH);
+
+    if(mtieresp->stabilityRecords == NULL) {
+	return FALSE;
+    }
+
+    record = mtieresp->stabilityRecords;
+
+    for(i = 0; i < stability->intervalCount; i++) {
+
+	interval = &stability->interval[i];
+
+	if(!interval->valid) {
+	    continue;
+	}
+
+	tau = interval->tau;
+	packPtpUInteger32(record, &tau, 4);
+
+	memset(&timeInterval, 0, sizeof(timeInterval));
+	tmpTime = doubleToTimeInternal(interval->mtie);
+	timeInterval.internalTime.seconds = tmpTime.seconds;
+	timeInterval.internalTime.nanoseconds = tmpTime.nanoseconds;
+	packPtpTimeInterval(record + 4, &timeInterval, PTP_TYPELEN_TIMEINTERVAL);
+
+	tmpTime = doubleToTimeInternal(interval->tdev);
+	timeInterval.internalTime.seconds = tmpTime.seconds;
+	timeInterval.internalTime.nanoseconds = tmpTime.nanoseconds;
+	packPtpTimeInterval(record + 12, &timeInterval, PTP_TYPELEN_TIMEINTERVAL);
+
+	scaledAdev = llround(interval->adev * 1E18);
+	adev.high = scaledAdev >> 32;
+	adev.low = scaledAdev & 0xFFFFFFFF;
+	packPtpInteger64(record + 20, &adev, 8);
+
+	record += PTP_PTPMON_STABILITY_RECORD_LENGTH;
+
+    }
+
+    mtieresp->tauCount = count;
+
+    return TRUE;
+
+}
+
 static int populatePtpMon(char *buf, MsgHeader *header, PtpClock *ptpClock, const RunTimeOpts *rtOpts) {
 
     PtpTlv *tlv;
@@ -114,6 +211,7 @@ static int populatePtpMon(char *buf, MsgHeader *header, PtpClock *ptpClock, cons
     PtpTlvPtpMonResponse *monresp;
     PtpTlvPtpMonMtieResponse *mtieresp;
     TimeInternal tmpTime;
+    PtpArena *previousArena = usePtpArena(packetArena());
     int ret = 0;
 
     memset(&message, 0, sizeof(PtpMessage));
@@ -121,7 +219,8 @@ static int populatePtpMon(char *buf, MsgHeader *header, PtpClock *ptpClock, cons
     ret = unpackPtpMessage(&message, buf, buf + DELAY_RESP_LENGTH);
 
     if(ret < DELAY_RESP_LENGTH) {
-	return 0;
+	ret = 0;
+	goto end;
     }
 
     if(header->ptpmon) {
@@ -129,8 +228,8 @@ static int populatePtpMon(char *buf, MsgHeader *header, PtpClock *ptpClock, cons
 	tlv = createPtpTlv();
 
 	if(tlv == NULL) {
-	    freePtpMessage(&message);
-	    return 0;
+	    ret = 0;
+	    goto end;
 	}
 
 	tlv->tlvType = PTP_TLVTYPE_PTPMON_RESPONSE;
@@ -141,8 +240,13 @@ static int populatePtpMon(char *buf, MsgHeader *header, PtpClock *ptpClock, cons
 		monresp->portState = ptpClock->portDS.portState;
                 monresp->parentPortAddress.addressLength = 4;
                 monresp->parentPortAddress.networkProtocol = 1;
-                XCALLOC(monresp->parentPortAddress.addressField,
-                        monresp->parentPortAddress.addressLength);
+                monresp->parentPortAddress.addressField =
+                        ptpCalloc(monresp->parentPortAddress.addressLength);
+
+		if(monresp->parentPortAddress.addressField == NULL) {
+		    ret = 0;
+		    goto end;
+		}
 
 		if(ptpClock->portDS.portState > PTP_MASTER &&
 		    ptpClock->bestMaster && ptpClock->bestMaster->sourceAddr) {
@@ -199,8 +303,8 @@ static int populatePtpMon(char *buf, MsgHeader *header, PtpClock *ptpClock, cons
 	tlv = createPtpTlv();
 
 	if(tlv == NULL) {
-	    freePtpMessage(&message);
-	    return 0;
+	    ret = 0;
+	    goto end;
 	}
 
 	tlv->tlvType = PTP_TLVTYPE_PTPMON_MTIE_RESPONSE;
@@ -219,25 +323,33 @@ static int populatePtpMon(char *buf, MsgHeader *header, PtpClock *ptpClock, cons
 		mtieresp->maxOffsetFromMaster.internalTime.seconds = tmpTime.seconds;
 		mtieresp->maxOffsetFromMaster.internalTime.nanoseconds = tmpTime.nanoseconds;
 	    }
+	    if(!packStabilityRecords(mtieresp, ptpClock->stability)) {
+		ret = 0;
+		goto end;
+	    }
 	}
 
     }
 
     ret = packPtpMessage(buf, &message, buf + PACKET_SIZE);
 
-    freePtpMessage(&message);
-
     if(ret < DELAY_RESP_LENGTH) {
-	return 0;
+	ret = 0;
     }
 
+end:
+    /* returns anything that did not fit in the arena, then the arena itself */
+    freePtpMessage(&message);
+    resetPtpArena(packetArena());
+    usePtpArena(previousArena);
+
     return ret;
 
 }
 
 /* store transportAddress in an index table */
 static void
-indexSync(TimeInternal *timeStamp, UInteger16 sequenceId, Integer32 transportAddress, SyncDestEntry *index)
+indexSync(TimeInternal *timeStamp, UInteger16 sequenceId, Integer32 transportAddress, SyncDestEntry *index, int size)
 {
 
     uint32_t hash = 0;
@@ -251,7 +363,7 @@ indexSync(TimeInternal *timeStamp, UInteger16 sequenceId, Integer32 transportAdd
 	return;
     }
 
-    hash = fnvHash(timeStamp, sizeof(TimeInternal), UNICAST_MAX_DESTINATIONS);
+    hash = fnvHash(timeStamp, sizeof(TimeInternal), size);
 
     if(index[hash].transportAddress) {
 	DBG("indexSync: hash collision - clearing entry %s:%04x\n", inet_ntoa(tmpAddr), hash);
@@ -265,7 +377,7 @@ indexSync(TimeInternal *timeStamp, UInteger16 sequenceId, Integer32 transportAdd
 
 /* sync destination index lookup */
 static Integer32
-lookupSyncIndex(TimeInternal *timeStamp, UInteger16 sequenceId, SyncDestEntry *index)
+lookupSyncIndex(TimeInternal *timeStamp, UInteger16 sequenceId, SyncDestEntry *index, int size)
 {
 
     uint32_t hash = 0;
@@ -275,7 +387,7 @@ lookupSyncIndex(TimeInternal *timeStamp, UInteger16 sequenceId, SyncDestEntry *i
 	return 0;
     }
 
-    hash = fnvHash(timeStamp, sizeof(TimeInternal), UNICAST_MAX_DESTINATIONS);
+    hash = fnvHash(timeStamp, sizeof(TimeInternal), size);
 
     if(index[hash].transportAddress == 0) {
 	DBG("lookupSyncIndex: cache miss\n");
@@ -289,22 +401,45 @@ lookupSyncIndex(TimeInternal *timeStamp, UInteger16 sequenceId, SyncDestEntry *i
 
 }
 
+/*
+ * Sync / Announce timer interval. A negotiating unicast master can run the timer
+ * ptpengine:unicast_tx_spread times per message interval: each expiry advances the
+ * timing wheel, so grantees are spread across the interval rather than sent to at once.
+ */
+static double
+txTimerInterval(Integer8 logInterval, const RunTimeOpts *rtOpts)
+{
+
+    if(rtOpts->unicastNegotiation && rtOpts->ipMode == IPMODE_UNICAST &&
+	rtOpts->transport != IEEE_802_3 && rtOpts->unicastTxSpread > 1) {
+	return pow(2, logInterval) / rtOpts->unicastTxSpread;
+    }
+
+    return pow(2, logInterval);
+
+}
+
 /* iterative search for Sync destination for the given cached timestamp */
 static Integer32
 findSyncDestination(TimeInternal *timeStamp, const RunTimeOpts *rtOpts, PtpClock *ptpClock)
 {
 
     int i = 0;
-
-    for(i = 0; i < UNICAST_MAX_DESTINATIONS; i++) {
-
-	if(rtOpts->unicastNegotiation) {
-		if( (timeStamp->seconds == ptpClock->unicastGrants[i].lastSyncTimestamp.seconds) &&
-		    (timeStamp->nanoseconds == ptpClock->unicastGrants[i].lastSyncTimestamp.nanoseconds)) {
-			clearTime(&ptpClock->unicastGrants[i].lastSyncTimestamp);
-			return ptpClock->unicastGrants[i].transportAddress;
+    UnicastGrantTable *node;
+    UnicastGrantList *list = &ptpClock->activeGrants[SYNC_INDEXED];
+
+    /* only nodes we are sending Sync to can have a timestamp */
+    if(rtOpts->unicastNegotiation) {
+	for(i = 0; i < list->count; i++) {
+		node = list->data[i]->parent;
+		if( (timeStamp->seconds == node->lastSyncTimestamp.seconds) &&
+		    (timeStamp->nanoseconds == node->lastSyncTimestamp.nanoseconds)) {
+			clearTime(&node->lastSyncTimestamp);
+			return node->transportAddress;
 		    }
-	} else {
+	}
+    } else {
+	for(i = 0; i < ptpClock->unicastDestinationCount; i++) {
 		if( (timeStamp->seconds == ptpClock->unicastDestinations[i].lastSyncTimestamp.seconds) &&
 		    (timeStamp->nanoseconds == ptpClock->unicastDestinations[i].lastSyncTimestamp.nanoseconds)) {
 			clearTime(&ptpClock->unicastDestinations[i].lastSyncTimestamp);
@@ -317,7 +452,9 @@ findSyncDestination(TimeInternal *timeStamp, const RunTimeOpts *rtOpts, PtpClock
 
 }
 
-void addForeign(Octet*,MsgHeader*,PtpClock*, UInteger8, UInteger32);
+Boolean addForeign(Octet*,MsgHeader*,const RunTimeOpts*,PtpClock*, UInteger8, UInteger32);
+static UInteger32 announceDataset(const Octet*, Octet*);
+static Boolean announceChanged(const ForeignMasterRecord*, UInteger32, const Octet*);
 
 /* loop forever. doState() has a switch for the actions and events to be
    checked for 'port_state'. the actions and events may or may not change
@@ -330,7 +467,6 @@ protocol(RunTimeOpts *rtOpts, PtpClock *ptpClock)
 
 	timerStart(&ptpClock->timers[TIMINGDOMAIN_UPDATE_TIMER],timingDomain.updateInterval);
 	timerStart(&ptpClock->timers[ALARM_UPDATE_TIMER],ALARM_UPDATE_INTERVAL);
-	timerStart(&ptpClock->timers[INTERFACE_CHECK_TIMER],1);
 	timerStart(&ptpClock->timers[CLOCK_SYNC_TIMER], 1.0 / (rtOpts->clockSyncRate + 0.0));
 	timerStart(&ptpClock->timers[CLOCKDRIVER_UPDATE_TIMER], rtOpts->clockUpdateInterval);
 
@@ -420,6 +556,19 @@ protocol(RunTimeOpts *rtOpts, PtpClock *ptpClock)
 		    timingDomain.update(&timingDomain);
 		}
 
+		/* NTP control responses are received in netSelect() or netRecvBatch(), timeouts are handled here */
+		if (timerExpired(&ptpClock->timers[NTPCONTROL_TIMER])) {
+		    ntpdControlTimeout();
+		}
+
+		if (ntpdControlFd() >= 0) {
+		    if (!timerRunning(&ptpClock->timers[NTPCONTROL_TIMER])) {
+			timerStart(&ptpClock->timers[NTPCONTROL_TIMER], NTP_CONTROL_TICK);
+		    }
+		} else if (timerRunning(&ptpClock->timers[NTPCONTROL_TIMER])) {
+		    timerStop(&ptpClock->timers[NTPCONTROL_TIMER]);
+		}
+
 		if(ptpClock->defaultDS.slaveOnly) {
 		    SET_ALARM(ALRM_PORT_STATE, ptpClock->portDS.portState != PTP_SLAVE);
 		}
@@ -457,17 +606,28 @@ protocol(RunTimeOpts *rtOpts, PtpClock *ptpClock)
 			}
 		}
 
-		if (timerExpired(&ptpClock->timers[INTERFACE_CHECK_TIMER])) {
+		/* interface, bond and VLAN changes: netlink notifications if available, polled otherwise */
+		if (ptpClock->netPath.linkChanged ||
+		    timerExpired(&ptpClock->timers[INTERFACE_CHECK_TIMER])) {
+		    ptpClock->netPath.linkChanged = FALSE;
 		    updateInterfaceInfo(&ptpClock->netPath, rtOpts, ptpClock);
 		}
 
+		if (ptpClock->netPath.linkSock >= 0) {
+		    if (timerRunning(&ptpClock->timers[INTERFACE_CHECK_TIMER])) {
+			timerStop(&ptpClock->timers[INTERFACE_CHECK_TIMER]);
+		    }
+		} else if (!timerRunning(&ptpClock->timers[INTERFACE_CHECK_TIMER])) {
+		    timerStart(&ptpClock->timers[INTERFACE_CHECK_TIMER], 1);
+		}
+
 		if (timerExpired(&ptpClock->timers[UNICAST_GRANT_TIMER])) {
 			if(rtOpts->unicastDestinationsSet) {
 			    refreshUnicastGrants(ptpClock->unicastGrants,
 				ptpClock->unicastDestinationCount, rtOpts, ptpClock);
 			} else {
 			    refreshUnicastGrants(ptpClock->unicastGrants,
-				UNICAST_MAX_DESTINATIONS, rtOpts, ptpClock);
+				ptpClock->grantIndex.used, rtOpts, ptpClock);
 			}
 			if(ptpClock->unicastPeerDestination.transportAddress) {
 			    refreshUnicastGrants(&ptpClock->peerGrants,
@@ -478,6 +638,8 @@ protocol(RunTimeOpts *rtOpts, PtpClock *ptpClock)
 
 		/* Perform the heavy signal processing synchronously */
 		checkSignals(rtOpts, ptpClock);
+		/* log what the housekeeping thread did to the files */
+		reportHousekeeping(rtOpts);
 	}
 }
 
@@ -535,7 +697,7 @@ toState(UInteger8 state, const RunTimeOpts *rtOpts, PtpClock *ptpClock)
 		timerStop(&ptpClock->timers[MASTER_NETREFRESH_TIMER]);
 
 		if(rtOpts->unicastNegotiation && rtOpts->ipMode==IPMODE_UNICAST) {
-		    cancelAllGrants(ptpClock->unicastGrants, UNICAST_MAX_DESTINATIONS,
+		    cancelAllGrants(ptpClock->unicastGrants, ptpClock->grantIndex.used,
 				rtOpts, ptpClock);
 		    if(ptpClock->portDS.delayMechanism == P2P) {
 			    cancelAllGrants(&ptpClock->peerGrants, 1,
@@ -597,7 +759,7 @@ toState(UInteger8 state, const RunTimeOpts *rtOpts, PtpClock *ptpClock)
 
 			initUnicastGrantTable(ptpClock->unicastGrants,
 				ptpClock->portDS.delayMechanism,
-				UNICAST_MAX_DESTINATIONS, NULL,
+				ptpClock->unicastGrantCapacity, NULL,
 				rtOpts, ptpClock);
 
 			if(rtOpts->unicastDestinationsSet) {
@@ -681,8 +843,7 @@ toState(UInteger8 state, const RunTimeOpts *rtOpts, PtpClock *ptpClock)
 		/* if we're ignoring announces (disable_bmca), go straight to master */
 		if(ptpClock->defaultDS.clockQuality.clockClass <= 127 && rtOpts->disableBMCA) {
 			DBG("unicast master only and ignoreAnnounce: going into MASTER state\n");
-			ptpClock->number_foreign_records = 0;
-			ptpClock->foreign_record_i = 0;
+			clearForeign(ptpClock);
 			m1(rtOpts,ptpClock);
 			toState(PTP_MASTER, rtOpts, ptpClock);
 			break;
@@ -744,11 +905,11 @@ toState(UInteger8 state, const RunTimeOpts *rtOpts, PtpClock *ptpClock)
 		    timerStart(&ptpClock->timers[UNICAST_GRANT_TIMER], 1);
 		}
 		timerStart(&ptpClock->timers[SYNC_INTERVAL_TIMER],
-			   pow(2,ptpClock->portDS.logSyncInterval));
+			   txTimerInterval(ptpClock->portDS.logSyncInterval, rtOpts));
 		DBG("SYNC INTERVAL TIMER : %f \n",
-		    pow(2,ptpClock->portDS.logSyncInterval));
+		    txTimerInterval(ptpClock->portDS.logSyncInterval, rtOpts));
 		timerStart(&ptpClock->timers[ANNOUNCE_INTERVAL_TIMER],
-			   pow(2,ptpClock->portDS.logAnnounceInterval));
+			   txTimerInterval(ptpClock->portDS.logAnnounceInterval, rtOpts));
 		timerStart(&ptpClock->timers[PDELAYREQ_INTERVAL_TIMER],
 			   pow(2,ptpClock->portDS.logMinPdelayReqInterval));
 		if(ptpClock->portDS.delayMechanism == P2P) {
@@ -944,10 +1105,16 @@ doState(RunTimeOpts *rtOpts, PtpClock *ptpClock)
 		 * changed an attribute in ptpClock,
 		 * then run the BMC algorithm
 		 */
+		/* our own datasets are BMC input too */
+		if(memcmp(&ptpClock->bmcDefaultDS, &ptpClock->defaultDS, sizeof(DefaultDS))) {
+			bmcRecordChanged(ptpClock, BMC_CHANGED_ALL);
+		}
+
 		if(ptpClock->record_update)
 		{
 			DBG2("event STATE_DECISION_EVENT\n");
 			ptpClock->record_update = FALSE;
+			ptpClock->bmcDefaultDS = ptpClock->defaultDS;
 			state = bmc(ptpClock->foreign, rtOpts, ptpClock);
 			if(state != ptpClock->portDS.portState)
 				toState(state, rtOpts, ptpClock);
@@ -984,8 +1151,7 @@ doState(RunTimeOpts *rtOpts, PtpClock *ptpClock)
 
 			if(!ptpClock->defaultDS.slaveOnly &&
 			   ptpClock->defaultDS.clockQuality.clockClass != SLAVE_ONLY_CLOCK_CLASS) {
-				ptpClock->number_foreign_records = 0;
-				ptpClock->foreign_record_i = 0;
+				clearForeign(ptpClock);
 				ptpClock->bestMaster = NULL;
 				m1(rtOpts,ptpClock);
 				toState(PTP_MASTER, rtOpts, ptpClock);
@@ -1003,6 +1169,8 @@ doState(RunTimeOpts *rtOpts, PtpClock *ptpClock)
 				*/
 				if (!ptpClock->bestMaster->disqualified) {
 					ptpClock->bestMaster->disqualified = TRUE;
+					/* another master may win now */
+					bmcRecordChanged(ptpClock, BMC_CHANGED_ALL);
 					WARNING("GM announce timeout, disqualified current best GM\n");
 					ptpClock->counters.announceTimeouts++;
 				}
@@ -1021,8 +1189,7 @@ doState(RunTimeOpts *rtOpts, PtpClock *ptpClock)
 					INFO("Waiting for new master, %d of %d attempts\n",ptpClock->announceTimeouts,rtOpts->announceTimeoutGracePeriod);
 				} else {
 					WARNING("No active masters present. Resetting port.\n");
-					ptpClock->number_foreign_records = 0;
-					ptpClock->foreign_record_i = 0;
+					clearForeign(ptpClock);
 					ptpClock->bestMaster = NULL;
 					/* if flipping between primary and backup interface, a full nework re-init is required */
 					if(rtOpts->backupIfaceEnabled) {
@@ -1226,9 +1393,9 @@ doState(RunTimeOpts *rtOpts, PtpClock *ptpClock)
 		if (timerExpired(&ptpClock->timers[ANNOUNCE_INTERVAL_TIMER])) {
 			DBGV("event ANNOUNCE_INTERVAL_TIMEOUT_EXPIRES\n");
 			/* restart the timer with current interval in case if it changed */
-			if(pow(2,ptpClock->portDS.logAnnounceInterval) != ptpClock->timers[ANNOUNCE_INTERVAL_TIMER].interval) {
+			if(txTimerInterval(ptpClock->portDS.logAnnounceInterval, rtOpts) != ptpClock->timers[ANNOUNCE_INTERVAL_TIMER].interval) {
 				timerStart(&ptpClock->timers[ANNOUNCE_INTERVAL_TIMER],
-					pow(2,ptpClock->portDS.logAnnounceInterval));
+					txTimerInterval(ptpClock->portDS.logAnnounceInterval, rtOpts));
 			}
 			issueAnnounce(rtOpts, ptpClock);
 
@@ -1263,18 +1430,19 @@ doState(RunTimeOpts *rtOpts, PtpClock *ptpClock)
 		if (timerExpired(&ptpClock->timers[SYNC_INTERVAL_TIMER])) {
 			DBGV("event SYNC_INTERVAL_TIMEOUT_EXPIRES\n");
 			/* re-arm timer if changed */
-			if(pow(2,ptpClock->portDS.logSyncInterval) != ptpClock->timers[SYNC_INTERVAL_TIMER].interval) {
+			if(txTimerInterval(ptpClock->portDS.logSyncInterval, rtOpts) != ptpClock->timers[SYNC_INTERVAL_TIMER].interval) {
 				timerStart(&ptpClock->timers[SYNC_INTERVAL_TIMER],
-					pow(2,ptpClock->portDS.logSyncInterval));
+					txTimerInterval(ptpClock->portDS.logSyncInterval, rtOpts));
 			}
 
 			issueSync(rtOpts, ptpClock);
 		}
 		if(!ptpClock->warnedUnicastCapacity) {
-		    if(ptpClock->slaveCount >= UNICAST_MAX_DESTINATIONS ||
-			ptpClock->unicastDestinationCount >= UNICAST_MAX_DESTINATIONS) {
+		    if(ptpClock->slaveCount >= ptpClock->unicastGrantCapacity ||
+			ptpClock->unicastDestinationCount >= ptpClock->unicastGrantCapacity) {
 			    if(rtOpts->ipMode == IPMODE_UNICAST) {
-				WARNING("Maximum unicast slave capacity reached: %d\n",UNICAST_MAX_DESTINATIONS);
+				WARNING("Maximum unicast slave capacity reached: %d\n",
+				    ptpClock->unicastGrantCapacity);
 				ptpClock->warnedUnicastCapacity = TRUE;
 			    }
 		    }
@@ -1367,6 +1535,7 @@ processMessage(RunTimeOpts* rtOpts, PtpClock* ptpClock, TimeInternal* timeStamp,
 
     PtpMessage m;
     PtpTlv *tlv;
+    PtpArena *previousArena;
     int ret;
 
     /*
@@ -1410,6 +1579,8 @@ processMessage(RunTimeOpts* rtOpts, PtpClock* ptpClock, TimeInternal* timeStamp,
     if(rtOpts->ptpMonEnabled && !isFromSelf && (header->messageType == DELAY_REQ) &&
     (header->messageLength > DELAY_REQ_LENGTH)) {
 
+	previousArena = usePtpArena(packetArena());
+
 	ret  = unpackPtpMessage(&m, ptpClock->msgIbuf, ptpClock->msgIbuf + length);
 
 	if (ret > 0) {
@@ -1427,9 +1598,13 @@ processMessage(RunTimeOpts* rtOpts, PtpClock* ptpClock, TimeInternal* timeStamp,
 			ptpClock->counters.ptpMonMtieReqReceived++;
 		    }
 		}
-	    freePtpMessage(&m);
 	}
 
+	/* also after a failed unpack, which may leave TLVs attached */
+	freePtpMessage(&m);
+	resetPtpArena(packetArena());
+	usePtpArena(previousArena);
+
     }
 
 #if 0
@@ -1583,6 +1758,10 @@ processMessage(RunTimeOpts* rtOpts, PtpClock* ptpClock, TimeInternal* timeStamp,
     if (!isFromSelf && timeStamp->seconds > 0)
 	subTime(timeStamp, timeStamp, &rtOpts->inboundLatency);
 
+    /* our own looped back Delay_Req is captured by processDelayReqFromSelf() */
+    if (rtOpts->captureLog.logEnabled && !isFromSelf)
+	captureMessage(ptpClock, ptpClock->msgIbuf, length, timeStamp, FALSE);
+
     DBG("      ==> %s message received, sequence %d\n", getMessageTypeName(header->messageType),
 							header->sequenceId);
 
@@ -1658,6 +1837,11 @@ handle(RunTimeOpts *rtOpts, PtpClock *ptpClock)
     TimeInternal timeStamp = { 0, 0 };
     fd_set readfds;
 
+    if (ptpClock->netPath.rxRing.capacity > 0) {
+	handleBatch(rtOpts, ptpClock);
+	return;
+    }
+
     FD_ZERO(&readfds);
     if (!ptpClock->message_activity) {
 	ret = netSelect(NULL, &ptpClock->netPath, &readfds);
@@ -1745,6 +1929,122 @@ handle(RunTimeOpts *rtOpts, PtpClock *ptpClock)
 
 }
 
+/* is the general message in slot gen the second step of the event message in slot ev */
+static Boolean
+isFollowUpOf(const NetRxSlot *ev, const NetRxSlot *gen)
+{
+    Enumeration4 evType = ev->buf[0] & 0x0F;
+    Enumeration4 genType = gen->buf[0] & 0x0F;
+
+    if (ev->length < HEADER_LENGTH || gen->length < HEADER_LENGTH) {
+	return FALSE;
+    }
+
+    if (!(evType == SYNC && genType == FOLLOW_UP) &&
+	!(evType == PDELAY_RESP && genType == PDELAY_RESP_FOLLOW_UP)) {
+	return FALSE;
+    }
+
+    /* sourcePortIdentity and sequenceId */
+    return !memcmp(ev->buf + 20, gen->buf + 20, 12);
+}
+
+/*
+ * The ring holds all the event packets of a wakeup, then all the general ones,
+ * so a burst of Sync n, Sync n+1, Follow_Up n, Follow_Up n+1 would reach the
+ * protocol with Sync n+1 waiting when Follow_Up n is handled. Restore the order
+ * that matters: each Follow_Up (or Pdelay_Resp_Follow_Up) right after its event
+ * message. General messages not completing an event message in this batch
+ * refer to earlier ones, or to none, and go first. Returns the slot count.
+ */
+static int
+orderBatch(const NetRxRing *ring, int *order)
+{
+    int i, j, n = 0;
+    int pairedWith[ring->count];
+
+    for (i = 0; i < ring->count; i++) {
+	pairedWith[i] = -1;
+    }
+
+    for (i = 0; i < ring->count; i++) {
+	if (ring->slots[i].event) {
+	    continue;
+	}
+	for (j = 0; j < ring->count; j++) {
+	    if (ring->slots[j].event && isFollowUpOf(&ring->slots[j], &ring->slots[i])) {
+		pairedWith[i] = j;
+		break;
+	    }
+	}
+	if (pairedWith[i] < 0) {
+	    order[n++] = i;
+	}
+    }
+
+    for (j = 0; j < ring->count; j++) {
+	if (!ring->slots[j].event) {
+	    continue;
+	}
+	order[n++] = j;
+	for (i = 0; i < ring->count; i++) {
+	    if (pairedWith[i] == j) {
+		order[n++] = i;
+	    }
+	}
+    }
+
+    return n;
+}
+
+/* batched variant of handle(): process every packet drained by netRecvBatch() */
+static void
+handleBatch(RunTimeOpts *rtOpts, PtpClock *ptpClock)
+{
+    int i, n, ret;
+    int order[NET_RX_BATCH_SIZE];
+    TimeInternal timeStamp;
+    TimeInternal noWait = { 0, 0 };
+    NetRxSlot *slot;
+
+    ret = netRecvBatch(ptpClock->message_activity ? &noWait : NULL, &ptpClock->netPath);
+    if (ret < 0) {
+	PERROR("failed to receive on the PTP sockets");
+	ptpClock->counters.messageRecvErrors++;
+	toState(PTP_FAULTY, rtOpts, ptpClock);
+	return;
+    } else if (!ret) {
+	return;
+    }
+
+    DBG("handleBatch: %d messages\n", ret);
+
+    n = orderBatch(&ptpClock->netPath.rxRing, order);
+
+    for (i = 0; i < n; i++) {
+	slot = &ptpClock->netPath.rxRing.slots[order[i]];
+	if (slot->length <= 0) {
+	    continue;
+	}
+	/* a message may have taken the port down - drop the rest */
+	if (ptpClock->portDS.portState == PTP_FAULTY ||
+	    ptpClock->portDS.portState == PTP_INITIALIZING) {
+	    break;
+	}
+	if (slot->event && ptpClock->leapSecondInProgress) {
+	    DBG("Leap second in progress - will not process event message\n");
+	    continue;
+	}
+	memcpy(ptpClock->msgIbuf, slot->buf, PACKET_SIZE);
+	ptpClock->netPath.lastSourceAddr = slot->sourceAddr;
+	ptpClock->netPath.lastDestAddr = slot->destAddr;
+	timeStamp = slot->timestamp;
+	processMessage(rtOpts, ptpClock, &timeStamp, slot->length);
+    }
+
+    ptpClock->netPath.rxRing.count = 0;
+}
+
 /*spec 9.5.3*/
 static void
 handleAnnounce(MsgHeader *header, ssize_t length,
@@ -1753,6 +2053,8 @@ handleAnnounce(MsgHeader *header, ssize_t length,
 
 	UnicastGrantTable *nodeTable = NULL;
 	UInteger8 localPreference = LOWEST_LOCALPREFERENCE;
+	UInteger32 announceHash;
+	Octet dataset[ANNOUNCE_LENGTH];
 
 	DBGV("HandleAnnounce : Announce message received : \n");
 
@@ -1772,7 +2074,7 @@ handleAnnounce(MsgHeader *header, ssize_t length,
 	if(rtOpts->unicastNegotiation && rtOpts->ipMode == IPMODE_UNICAST) {
 
 		nodeTable = findUnicastGrants(&header->sourcePortIdentity, 0,
-							ptpClock->unicastGrants, &ptpClock->grantIndex, UNICAST_MAX_DESTINATIONS,
+							ptpClock->unicastGrants, &ptpClock->grantIndex, ptpClock->unicastGrantCapacity,
 							FALSE);
 		if(nodeTable == NULL || !(nodeTable->grantData[ANNOUNCE_INDEXED].granted)) {
 			if(!rtOpts->unicastAcceptAny) {
@@ -1807,10 +2109,9 @@ handleAnnounce(MsgHeader *header, ssize_t length,
 		
 		/*
 		 * Valid announce message is received : BMC algorithm
-		 * will be executed
+		 * will be executed if anything it depends on has changed
 		 */
 		ptpClock->counters.announceMessagesReceived++;
-		ptpClock->record_update = TRUE;
 
 		switch (isFromCurrentParent(ptpClock, header)) {
 		case TRUE:
@@ -1826,6 +2127,14 @@ handleAnnounce(MsgHeader *header, ssize_t length,
 			memcpy(&ptpClock->bestMaster->announce,
 			       &ptpClock->msgTmp.announce,sizeof(MsgAnnounce));
 
+			announceHash = announceDataset(ptpClock->msgIbuf, dataset);
+			if(announceChanged(ptpClock->bestMaster, announceHash, dataset) ||
+			    ptpClock->bestMaster->disqualified) {
+				ptpClock->bestMaster->announceHash = announceHash;
+				memcpy(ptpClock->bestMaster->announceDataset, dataset, ANNOUNCE_LENGTH);
+				bmcRecordChanged(ptpClock, BMC_CHANGED_ALL);
+			}
+
 			if(ptpClock->leapSecondInProgress) {
 				/*
 				 * if leap second period is over
@@ -1899,7 +2208,7 @@ handleAnnounce(MsgHeader *header, ssize_t length,
 			 * the slave will  sit idle if current parent
 			 * is not announcing, but another GM is
 			 */
-			addForeign(ptpClock->msgIbuf,header,ptpClock,localPreference,ptpClock->netPath.lastSourceAddr);
+			addForeign(ptpClock->msgIbuf,header,rtOpts,ptpClock,localPreference,ptpClock->netPath.lastSourceAddr);
 			break;
 
 		default:
@@ -1931,7 +2240,7 @@ handleAnnounce(MsgHeader *header, ssize_t length,
 		 * will be executed
 		 */
 		ptpClock->counters.announceMessagesReceived++;
-		ptpClock->record_update = TRUE;
+		bmcRecordChanged(ptpClock, BMC_CHANGED_ALL);
 
 		if (isFromCurrentParent(ptpClock, header)) {
 			msgUnpackAnnounce(ptpClock->msgIbuf,
@@ -1960,7 +2269,7 @@ handleAnnounce(MsgHeader *header, ssize_t length,
 
 			DBG("___ Announce: received Announce from another master, will add to the list, as it might be better\n\n");
 			DBGV("this is to be decided immediatly by bmc())\n\n");
-			addForeign(ptpClock->msgIbuf,header,ptpClock,localPreference,ptpClock->netPath.lastSourceAddr);
+			addForeign(ptpClock->msgIbuf,header,rtOpts,ptpClock,localPreference,ptpClock->netPath.lastSourceAddr);
 		}
 		break;
 
@@ -1978,8 +2287,8 @@ handleAnnounce(MsgHeader *header, ssize_t length,
 		}
 		ptpClock->counters.announceMessagesReceived++;
 		DBGV("Announce message from another foreign master\n");
-		addForeign(ptpClock->msgIbuf,header,ptpClock, localPreference,ptpClock->netPath.lastSourceAddr);
-		ptpClock->record_update = TRUE;    /* run BMC() as soon as possible */
+		/* run BMC() as soon as possible - but only if this told us something new */
+		addForeign(ptpClock->msgIbuf,header,rtOpts,ptpClock, localPreference,ptpClock->netPath.lastSourceAddr);
 		break;
 
 	} /* switch on (port_state) */
@@ -1993,7 +2302,6 @@ handleSync(const MsgHeader *header, ssize_t length,
 {
 
 	TimeInternal OriginTimestamp;
-	TimeInternal correctionField;
 
 	Integer32 dst = 0;
 
@@ -2014,7 +2322,7 @@ handleSync(const MsgHeader *header, ssize_t length,
 	if(!isFromSelf && rtOpts->unicastNegotiation && rtOpts->ipMode == IPMODE_UNICAST) {
 	    UnicastGrantTable *nodeTable = NULL;
 	    nodeTable = findUnicastGrants(&header->sourcePortIdentity, 0,
-			ptpClock->unicastGrants, &ptpClock->grantIndex, UNICAST_MAX_DESTINATIONS,
+			ptpClock->unicastGrants, &ptpClock->grantIndex, ptpClock->unicastGrantCapacity,
 			FALSE);
 	    if(nodeTable != NULL) {
 		nodeTable->grantData[SYNC_INDEXED].receiving = header->sequenceId;
@@ -2113,13 +2421,8 @@ handleSync(const MsgHeader *header, ssize_t length,
 
 				ptpClock->waitingForFollow = TRUE;
 				/*Save correctionField of Sync message*/
-				integer64_to_internalTime(
-					header->correctionField,
-					&correctionField);
-				ptpClock->lastSyncCorrectionField.seconds =
-					correctionField.seconds;
-				ptpClock->lastSyncCorrectionField.nanoseconds =
-					correctionField.nanoseconds;
+				ptpClock->lastSyncCorrectionField =
+					integer64ToScaled(header->correctionField);
 				ptpClock->recvSyncSequenceId =
 					header->sequenceId;
 				break;
@@ -2132,10 +2435,6 @@ handleSync(const MsgHeader *header, ssize_t length,
 					header->sequenceId;
 				msgUnpackSync(ptpClock->msgIbuf,
 					      &ptpClock->msgTmp.sync);
-				integer64_to_internalTime(
-					ptpClock->msgTmpHeader.correctionField,
-					&correctionField);
-				timeInternal_display(&correctionField);
 				ptpClock->waitingForFollow = FALSE;
 				toInternalTime(&OriginTimestamp,
 					       &ptpClock->msgTmp.sync.originTimestamp);
@@ -2143,7 +2442,7 @@ handleSync(const MsgHeader *header, ssize_t length,
 				updateOffset(&OriginTimestamp,
 					     &ptpClock->sync_receive_time,
 					     &ptpClock->ofm_filt,rtOpts,
-					     ptpClock,&correctionField);
+					     ptpClock,integer64ToScaled(ptpClock->msgTmpHeader.correctionField));
 				checkOffset(rtOpts,ptpClock);
 				if (ptpClock->clockControl.updateOK) {
 					ptpClock->acceptedUpdates++;
@@ -2177,7 +2476,7 @@ handleSync(const MsgHeader *header, ssize_t length,
 				msgUnpackSync(ptpClock->msgIbuf,
 					      &ptpClock->msgTmp.sync);
 				toInternalTime(&OriginTimestamp, &ptpClock->msgTmp.sync.originTimestamp);
-			    dst = lookupSyncIndex(&OriginTimestamp, header->sequenceId, ptpClock->syncDestIndex);
+			    dst = lookupSyncIndex(&OriginTimestamp, header->sequenceId, ptpClock->syncDestIndex, ptpClock->unicastGrantCapacity);
 
 #ifdef RUNTIME_DEBUG
 			    {
@@ -2225,7 +2524,6 @@ handleFollowUp(const MsgHeader *header, ssize_t length,
 	       Boolean isFromSelf, const RunTimeOpts *rtOpts, PtpClock *ptpClock)
 {
 	TimeInternal preciseOriginTimestamp;
-	TimeInternal correctionField;
 
 	DBGV("Handlefollowup : Follow up message received \n");
 
@@ -2273,10 +2571,6 @@ handleFollowUp(const MsgHeader *header, ssize_t length,
 					toInternalTime(&preciseOriginTimestamp,
 						       &ptpClock->msgTmp.follow.preciseOriginTimestamp);
 					ptpClock->lastOriginTimestamp = preciseOriginTimestamp;
-					integer64_to_internalTime(ptpClock->msgTmpHeader.correctionField,
-								  &correctionField);
-					addTime(&correctionField,&correctionField,
-						&ptpClock->lastSyncCorrectionField);
 
 					/*
 					send_time = preciseOriginTimestamp (received inside followup)
@@ -2285,7 +2579,8 @@ handleFollowUp(const MsgHeader *header, ssize_t length,
 					updateOffset(&preciseOriginTimestamp,
 						     &ptpClock->sync_receive_time,&ptpClock->ofm_filt,
 						     rtOpts,ptpClock,
-						     &correctionField);
+						     scaledAdd(integer64ToScaled(ptpClock->msgTmpHeader.correctionField),
+						     ptpClock->lastSyncCorrectionField));
 					checkOffset(rtOpts,ptpClock);
 					if (ptpClock->clockControl.updateOK) {
 						ptpClock->acceptedUpdates++;
@@ -2357,7 +2652,7 @@ handleDelayReq(const MsgHeader *header, ssize_t length,
 
 		if(!isFromSelf && rtOpts->unicastNegotiation && rtOpts->ipMode == IPMODE_UNICAST) {
 		    nodeTable = findUnicastGrants(&header->sourcePortIdentity, 0,
-				ptpClock->unicastGrants, &ptpClock->grantIndex, UNICAST_MAX_DESTINATIONS,
+				ptpClock->unicastGrants, &ptpClock->grantIndex, ptpClock->unicastGrantCapacity,
 				FALSE);
 		    if(nodeTable == NULL || !(nodeTable->grantData[DELAY_RESP_INDEXED].granted)) {
 			DBG("Ignoring Delay Request from slave: unicast transmission not granted\n");
@@ -2418,7 +2713,7 @@ handleDelayReq(const MsgHeader *header, ssize_t length,
 				 *  (ptpClock->sentDelayReqSequenceId
 				 *  - 1), this is now made explicit
 				 */
-				processDelayReqFromSelf(tint, rtOpts, ptpClock);
+				processDelayReqFromSelf(ptpClock->msgIbuf, tint, rtOpts, ptpClock);
 
 				break;
 			} else {
@@ -2454,7 +2749,7 @@ handleDelayReq(const MsgHeader *header, ssize_t length,
 
 
 static void
-processDelayReqFromSelf(const TimeInternal * tint, const RunTimeOpts * rtOpts, PtpClock * ptpClock) {
+processDelayReqFromSelf(const Octet *buf, const TimeInternal * tint, const RunTimeOpts * rtOpts, PtpClock * ptpClock) {
 
 	ptpClock->waitingForDelayResp = TRUE;
 	ptpClock->delay_req_send_time.seconds = tint->seconds;
@@ -2468,6 +2763,11 @@ processDelayReqFromSelf(const TimeInternal * tint, const RunTimeOpts * rtOpts, P
 	DBGV("processDelayReqFromSelf: %s %d\n",
 	    dump_TimeInternal(&ptpClock->delay_req_send_time),
 	    rtOpts->outboundLatency);
+
+	/* buf holds the Delay_Req we sent, looped back or still in the output buffer */
+	if (rtOpts->captureLog.logEnabled)
+		captureMessage(ptpClock, buf, DELAY_REQ_LENGTH,
+			&ptpClock->delay_req_send_time, TRUE);
 	
 }
 
@@ -2480,12 +2780,11 @@ handleDelayResp(const MsgHeader *header, ssize_t length,
 
 
 		TimeInternal requestReceiptTimestamp;
-		TimeInternal correctionField;
 
 		if(rtOpts->unicastNegotiation && rtOpts->ipMode == IPMODE_UNICAST) {
 		    UnicastGrantTable *nodeTable = NULL;
 		    nodeTable = findUnicastGrants(&header->sourcePortIdentity, 0,
-				ptpClock->unicastGrants, &ptpClock->grantIndex, UNICAST_MAX_DESTINATIONS,
+				ptpClock->unicastGrants, &ptpClock->grantIndex, ptpClock->unicastGrantCapacity,
 				FALSE);
 		    if(nodeTable != NULL) {
 			nodeTable->grantData[DELAY_RESP_INDEXED].receiving = header->sequenceId;
@@ -2557,16 +2856,13 @@ handleDelayResp(const MsgHeader *header, ssize_t length,
 				ptpClock->delay_req_receive_time.nanoseconds =
 					requestReceiptTimestamp.nanoseconds;
 
-				integer64_to_internalTime(
-					header->correctionField,
-					&correctionField);
 				/*
 					send_time = delay_req_send_time (received as CMSG in handleEvent)
 					recv_time = requestReceiptTimestamp (received inside delayResp)
 				*/
 
 				updateDelay(&ptpClock->mpdIirFilter,
-					    rtOpts,ptpClock, &correctionField);
+					    rtOpts,ptpClock, integer64ToScaled(header->correctionField));
 				if (ptpClock->delayRespWaiting) {
 
 					NOTICE("Received first Delay Response from Master\n");
@@ -2653,7 +2949,7 @@ handlePdelayReq(MsgHeader *header, ssize_t length,
 
 		if(!isFromSelf && rtOpts->unicastNegotiation && rtOpts->ipMode == IPMODE_UNICAST) {
 		    nodeTable = findUnicastGrants(&header->sourcePortIdentity, 0,
-				ptpClock->unicastGrants, &ptpClock->grantIndex, UNICAST_MAX_DESTINATIONS,
+				ptpClock->unicastGrants, &ptpClock->grantIndex, ptpClock->unicastGrantCapacity,
 				FALSE);
 		    if(nodeTable == NULL || !(nodeTable->grantData[PDELAY_RESP_INDEXED].granted)) {
 			DBG("Ignoring Peer Delay Request from peer: unicast transmission not granted\n");
@@ -2749,7 +3045,6 @@ handlePdelayResp(const MsgHeader *header, TimeInternal *tint,
 
 		/* Boolean isFromCurrentParent = FALSE; NOTE: This is never used in this function */
 		TimeInternal requestReceiptTimestamp;
-		TimeInternal correctionField;
 	
 		DBG("PdelayResp message received : \n");
 
@@ -2801,17 +3096,15 @@ handlePdelayResp(const MsgHeader *header, TimeInternal *tint,
 					ptpClock->pdelay_req_receive_time.seconds = requestReceiptTimestamp.seconds;
 					ptpClock->pdelay_req_receive_time.nanoseconds = requestReceiptTimestamp.nanoseconds;
 					
-					integer64_to_internalTime(header->correctionField,&correctionField);
-					ptpClock->lastPdelayRespCorrectionField.seconds = correctionField.seconds;
-					ptpClock->lastPdelayRespCorrectionField.nanoseconds = correctionField.nanoseconds;
+					ptpClock->lastPdelayRespCorrectionField = integer64ToScaled(header->correctionField);
 				} else {
 				/* One step Clock */
 					/*Store t4 (Fig 35)*/
 					ptpClock->pdelay_resp_receive_time.seconds = tint->seconds;
 					ptpClock->pdelay_resp_receive_time.nanoseconds = tint->nanoseconds;
 					
-					integer64_to_internalTime(header->correctionField,&correctionField);
-					updatePeerDelay (&ptpClock->mpdIirFilter,rtOpts,ptpClock,&correctionField,FALSE);
+					updatePeerDelay (&ptpClock->mpdIirFilter,rtOpts,ptpClock,
+							 integer64ToScaled(header->correctionField),FALSE);
 				if (rtOpts->ignore_delayreq_interval_master == 0) {
 					DBGV("current pdelay_req: %d  new pdelay req: %d \n",
 						ptpClock->portDS.logMinPdelayReqInterval,
@@ -2906,7 +3199,6 @@ handlePdelayRespFollowUp(const MsgHeader *header, ssize_t length,
 
 	if (ptpClock->portDS.delayMechanism == P2P) {
 		TimeInternal responseOriginTimestamp;
-		TimeInternal correctionField;
 	
 		DBG("PdelayRespfollowup message received : \n");
 	
@@ -2944,14 +3236,10 @@ handlePdelayRespFollowUp(const MsgHeader *header, ssize_t length,
 					responseOriginTimestamp.seconds;
 				ptpClock->pdelay_resp_send_time.nanoseconds =
 					responseOriginTimestamp.nanoseconds;
-				integer64_to_internalTime(
-					ptpClock->msgTmpHeader.correctionField,
-					&correctionField);
-				addTime(&correctionField,&correctionField,
-					&ptpClock->lastPdelayRespCorrectionField);
 				updatePeerDelay (&ptpClock->mpdIirFilter,
 						 rtOpts, ptpClock,
-						 &correctionField,TRUE);
+						 scaledAdd(integer64ToScaled(ptpClock->msgTmpHeader.correctionField),
+						 ptpClock->lastPdelayRespCorrectionField),TRUE);
 
 /* pdelay interval handling begin */
 				if (rtOpts->ignore_delayreq_interval_master == 0) {
@@ -3074,49 +3362,61 @@ issueAnnounce(const RunTimeOpts *rtOpts,PtpClock *ptpClock)
 {
 	Integer32 dst = 0;
 	int i = 0;
+	int due = 0;
 	UnicastGrantData *grant = NULL;
-	Boolean okToSend = TRUE;
+	/* pack Announce once and send a patched copy to each destination */
+	Boolean batch = ptpClock->netPath.generalBatch.capacity > 0;
 
 	/* send Announce to Ethernet or multicast */
 	if(rtOpts->transport == IEEE_802_3 || (rtOpts->ipMode != IPMODE_UNICAST)) {
-		issueAnnounceSingle(dst, &ptpClock->sentAnnounceSequenceId, rtOpts, ptpClock);
+		issueAnnounceSingle(dst, &ptpClock->sentAnnounceSequenceId, FALSE, rtOpts, ptpClock);
 	/* send Announce to unicast destination(s) */
 	} else {
+	    if(batch) {
+		msgPackAnnounce(ptpClock->msgObuf, 0, ptpClock);
+	    }
 	    /* send to granted only */
 	    if(rtOpts->unicastNegotiation) {
-		for(i = 0; i < UNICAST_MAX_DESTINATIONS; i++) {
-		    grant = &(ptpClock->unicastGrants[i].grantData[ANNOUNCE_INDEXED]);
-		    okToSend = TRUE;
-		    if(grant->logInterval > ptpClock->portDS.logAnnounceInterval ) {
-			grant->intervalCounter %= (UInteger32)(pow(2,grant->logInterval - ptpClock->portDS.logAnnounceInterval));
-			if(grant->intervalCounter != 0) {
-			    okToSend = FALSE;
-			}
-			grant->intervalCounter++;
-		    }
-		    if(grant->granted) {
-			if(okToSend) {
-			    issueAnnounceSingle(ptpClock->unicastGrants[i].transportAddress,
-			    &grant->sentSeqId,rtOpts, ptpClock);
-			}
-		    }
+		/* the timing wheel knows who is due at which interval */
+		due = unicastWheelTick(&ptpClock->announceWheel, ptpClock->portDS.logAnnounceInterval);
+		for(i = 0; i < due; i++) {
+		    grant = ptpClock->announceWheel.due[i];
+		    issueAnnounceSingle(grant->parent->transportAddress,
+			    &grant->sentSeqId, batch, rtOpts, ptpClock);
 		}
 	    /* send to fixed unicast destinations */
 	    } else {
 		for(i = 0; i < ptpClock->unicastDestinationCount; i++) {
 			issueAnnounceSingle(ptpClock->unicastDestinations[i].transportAddress,
 			&(ptpClock->unicastGrants[i].grantData[ANNOUNCE_INDEXED].sentSeqId),
-						rtOpts, ptpClock);
+						batch, rtOpts, ptpClock);
 		    }
 		}
+
+	    if(batch) {
+		(void)flushTxBatch(FALSE, &ptpClock->counters.announceMessagesSent, rtOpts, ptpClock);
+	    }
 	}
 
 }
 
-/* send single announce to a single destination */
+/*
+ * send single announce to a single destination. If batch is set, queue a copy
+ * of the Announce already packed in msgObuf - issueAnnounce() sends the batch.
+ */
 static void
-issueAnnounceSingle(Integer32 dst, UInteger16 *sequenceId, const RunTimeOpts *rtOpts,PtpClock *ptpClock)
+issueAnnounceSingle(Integer32 dst, UInteger16 *sequenceId, Boolean batch, const RunTimeOpts *rtOpts,PtpClock *ptpClock)
 {
+	Octet *slot;
+
+	if(batch) {
+		slot = netBatchAdd(&ptpClock->netPath.generalBatch, ptpClock->msgObuf, ANNOUNCE_LENGTH, dst);
+		if(slot != NULL) {
+			msgPatchSequenceId(slot, *sequenceId);
+			(*sequenceId)++;
+			return;
+		}
+	}
 
 	msgPackAnnounce(ptpClock->msgObuf, *sequenceId,ptpClock);
 
@@ -3138,64 +3438,262 @@ issueSync(const RunTimeOpts *rtOpts,PtpClock *ptpClock)
 {
 	Integer32 dst = 0;
 	int i = 0;
+	int due = 0;
 	UnicastGrantData *grant = NULL;
-	Boolean okToSend = TRUE;
+	/* send all Syncs first and collect the TX timestamps afterwards */
+	Boolean pipeline = rtOpts->unicastSyncPipelining &&
+			    ptpClock->netPath.txTimestamping && !ptpClock->netPath.txLoop;
 
 	/* send Sync to Ethernet or multicast */
 	if(rtOpts->transport == IEEE_802_3 || (rtOpts->ipMode != IPMODE_UNICAST)) {
-		(void)issueSyncSingle(dst, &ptpClock->sentSyncSequenceId, rtOpts, ptpClock);
+		(void)issueSyncSingle(dst, &ptpClock->sentSyncSequenceId, FALSE, rtOpts, ptpClock);
 
 	/* send Sync to unicast destination(s) */
 	} else {
-	    for(i = 0; i < UNICAST_MAX_DESTINATIONS; i++) {
-		ptpClock->syncDestIndex[i].transportAddress = 0;
-		clearTime(&ptpClock->unicastGrants[i].lastSyncTimestamp);
-		clearTime(&ptpClock->unicastDestinations[i].lastSyncTimestamp);
-	    }
+	    /*
+	     * syncDestIndex is not cleared here: a stale entry only ever collides
+	     * with a new one, which clears it and falls back to findSyncDestination()
+	     */
+	    ptpClock->syncPendingCount = 0;
 	    /* send to granted only */
 	    if(rtOpts->unicastNegotiation) {
-		for(i = 0; i < UNICAST_MAX_DESTINATIONS; i++) {
-		    grant = &(ptpClock->unicastGrants[i].grantData[SYNC_INDEXED]);
-		    okToSend = TRUE;
-		    /* handle different intervals */
-		    if(grant->logInterval > ptpClock->portDS.logSyncInterval ) {
-			grant->intervalCounter %= (UInteger32)(pow(2,grant->logInterval - ptpClock->portDS.logSyncInterval));
-			if(grant->intervalCounter != 0) {
-			    okToSend = FALSE;
-			}
-			DBG("mixed interval to %d counter: %d\n", grant->parent->transportAddress,grant->intervalCounter);
-			grant->intervalCounter++;
-		    }
-
-		    if(grant->granted) {
-			if(okToSend) {
-			    ptpClock->unicastGrants[i].lastSyncTimestamp =
-				issueSyncSingle(ptpClock->unicastGrants[i].transportAddress,
-				&grant->sentSeqId,rtOpts, ptpClock);
-			}
+		/* the timing wheel knows who is due at which interval */
+		due = unicastWheelTick(&ptpClock->syncWheel, ptpClock->portDS.logSyncInterval);
+		for(i = 0; i < due; i++) {
+		    grant = ptpClock->syncWheel.due[i];
+		    if(pipeline && !finishSyncRound(grant->sentSeqId, rtOpts, ptpClock)) {
+			return;
 		    }
+		    grant->parent->lastSyncTimestamp =
+			issueSyncSingle(grant->parent->transportAddress,
+			&grant->sentSeqId, pipeline, rtOpts, ptpClock);
 		}
 	    /* send to fixed unicast destinations */
 	    } else {
 		for(i = 0; i < ptpClock->unicastDestinationCount; i++) {
+			if(pipeline && !finishSyncRound(ptpClock->unicastGrants[i].grantData[SYNC_INDEXED].sentSeqId,
+			    rtOpts, ptpClock)) {
+				return;
+			}
 			ptpClock->unicastDestinations[i].lastSyncTimestamp =
 			    issueSyncSingle(ptpClock->unicastDestinations[i].transportAddress,
 			    &(ptpClock->unicastGrants[i].grantData[SYNC_INDEXED].sentSeqId),
-						rtOpts, ptpClock);
+						pipeline, rtOpts, ptpClock);
 		    }
 		}
+
+	    if(pipeline) {
+		/* Syncs queued by issueSyncSingle() must go out before we wait for timestamps */
+		if(!flushTxBatch(TRUE, &ptpClock->counters.syncMessagesSent, rtOpts, ptpClock)) {
+		    ptpClock->syncPendingCount = 0;
+		    return;
+		}
+		collectSyncTimestamps(rtOpts, ptpClock);
+	    }
+	}
+
+}
+
+/*
+ * Unicast destinations have their own sequence counters, so two of them can be
+ * due the same sequence ID. TX timestamps returned without the destination
+ * address can only be matched by sequence ID: before a Sync with a sequence ID
+ * already in flight is queued, send what is queued and collect its timestamps.
+ * Same when the pending table is full. Returns FALSE if the Syncs could not be sent.
+ */
+static Boolean
+finishSyncRound(UInteger16 sequenceId, const RunTimeOpts *rtOpts, PtpClock *ptpClock)
+{
+	int i;
+
+	for(i = 0; i < ptpClock->syncPendingCount; i++) {
+		if(ptpClock->syncPending[i].sequenceId == sequenceId) {
+			break;
+		}
+	}
+
+	if(i == ptpClock->syncPendingCount &&
+	    ptpClock->syncPendingCount < ptpClock->unicastGrantCapacity) {
+		return TRUE;
 	}
 
+	DBGV("finishSyncRound: collecting %d timestamps before sequence %d\n",
+		ptpClock->syncPendingCount, sequenceId);
+
+	if(!flushTxBatch(TRUE, &ptpClock->counters.syncMessagesSent, rtOpts, ptpClock)) {
+		ptpClock->syncPendingCount = 0;
+		return FALSE;
+	}
+
+	collectSyncTimestamps(rtOpts, ptpClock);
+
+	return TRUE;
+}
+
+/*
+ * Collect TX timestamps for the Syncs sent by issueSync() in pipelined mode,
+ * matching them to destinations by sequence ID and destination address.
+ * FollowUp is sent as soon as each timestamp is received.
+ */
+static void
+collectSyncTimestamps(const RunTimeOpts *rtOpts, PtpClock *ptpClock)
+{
+	int i;
+	int outstanding = ptpClock->syncPendingCount;
+	int matches;
+	Boolean batch = ptpClock->netPath.generalBatch.capacity > 0;
+	SyncPendingEntry *entry;
+	TimeInternal timeStamp;
+	Enumeration4 messageType;
+	UInteger16 sequenceId;
+	Integer32 dst;
+
+	while(outstanding > 0) {
+
+		if(!netRecvTxTimestamp(&ptpClock->netPath, &timeStamp, &messageType,
+			    &sequenceId, &dst, TXTIMESTAMP_PIPELINE_WAIT_US)) {
+			break;
+		}
+
+		if(messageType != SYNC) {
+			DBG("collectSyncTimestamps: discarded TX timestamp for %s\n",
+			    getMessageTypeName(messageType));
+			continue;
+		}
+
+		/*
+		 * dst may be unknown if the driver returned the PTP payload only:
+		 * finishSyncRound() keeps sequence IDs unique, but never guess
+		 */
+		entry = NULL;
+		matches = 0;
+		for(i = 0; i < ptpClock->syncPendingCount; i++) {
+			if(!ptpClock->syncPending[i].done &&
+			    (ptpClock->syncPending[i].sequenceId == sequenceId) &&
+			    (!dst || (ptpClock->syncPending[i].transportAddress == dst))) {
+				if(entry == NULL) {
+					entry = &ptpClock->syncPending[i];
+				}
+				matches++;
+			}
+		}
+
+		if(entry == NULL) {
+			DBG("collectSyncTimestamps: no pending Sync for sequence %d\n", sequenceId);
+			continue;
+		}
+
+		if(matches > 1) {
+			DBG("collectSyncTimestamps: TX timestamp for sequence %d matches %d destinations - discarded\n",
+			    sequenceId, matches);
+			continue;
+		}
+
+		entry->done = TRUE;
+		outstanding--;
+
+		if(isTimeZero(&timeStamp)) {
+			ptpClock->counters.txTimestampFailures++;
+			continue;
+		}
+
+		if (respectUtcOffset(rtOpts, ptpClock) == TRUE) {
+			timeStamp.seconds += ptpClock->timePropertiesDS.currentUtcOffset;
+		}
+
+		if(batch) {
+			queueFollowup(&timeStamp, rtOpts, ptpClock, entry->transportAddress, entry->sequenceId);
+		} else {
+			processSyncFromSelf(&timeStamp, rtOpts, ptpClock, entry->transportAddress, entry->sequenceId);
+		}
+	}
+
+	if(batch) {
+		(void)flushTxBatch(FALSE, &ptpClock->counters.followUpMessagesSent, rtOpts, ptpClock);
+	}
+
+	if(outstanding > 0) {
+		DBG("collectSyncTimestamps: NIC failed to deliver %d TX timestamps in time\n", outstanding);
+		ptpClock->counters.txTimestampFailures += outstanding;
+		ptpClock->netPath.txDelayed = TRUE;
+	}
+
+	ptpClock->syncPendingCount = 0;
+
+}
+
+/*
+ * Queue a FollowUp for the general port batch. The first FollowUp of the batch
+ * is packed into msgObuf, the rest are copies with patched sequenceId and timestamp.
+ */
+static void
+queueFollowup(const TimeInternal *tint, const RunTimeOpts *rtOpts, PtpClock *ptpClock, Integer32 dst, const UInteger16 sequenceId)
+{
+	Octet *slot;
+	TimeInternal timestamp;
+	Timestamp preciseOriginTimestamp;
+
+	/*Add latency*/
+	addTime(&timestamp, tint, &rtOpts->outboundLatency);
+	fromInternalTime(&timestamp, &preciseOriginTimestamp);
+
+	if(ptpClock->netPath.generalBatch.count == 0) {
+		msgPackFollowUp(ptpClock->msgObuf, &preciseOriginTimestamp, ptpClock, sequenceId);
+	}
+
+	slot = netBatchAdd(&ptpClock->netPath.generalBatch, ptpClock->msgObuf, FOLLOW_UP_LENGTH, dst);
+
+	if(slot == NULL) {
+		issueFollowup(&timestamp, rtOpts, ptpClock, dst, sequenceId);
+		return;
+	}
+
+	msgPatchSequenceId(slot, sequenceId);
+	msgPatchTimestamp(slot, &preciseOriginTimestamp);
+}
+
+/*
+ * Send all messages queued in the event or general batch and add the number sent
+ * to the given counter. Returns FALSE and goes FAULTY if any message could not be sent.
+ */
+static Boolean
+flushTxBatch(Boolean event, uint32_t *sentCounter, const RunTimeOpts *rtOpts, PtpClock *ptpClock)
+{
+	NetTxBatch *batch = event ? &ptpClock->netPath.eventBatch : &ptpClock->netPath.generalBatch;
+	int queued = batch->count;
+	int sent;
+
+	if(queued == 0) {
+		return TRUE;
+	}
+
+	sent = event ? netBatchFlushEvent(&ptpClock->netPath) : netBatchFlushGeneral(&ptpClock->netPath);
+
+	*sentCounter += sent;
+
+	if(sent < queued) {
+		toState(PTP_FAULTY,rtOpts,ptpClock);
+		ptpClock->counters.messageSendErrors++;
+		DBGV("%d of %d batched messages can't be sent -> FAULTY state \n", queued - sent, queued);
+		return FALSE;
+	}
+
+	DBGV("%d batched messages sent ! \n", sent);
+	return TRUE;
 }
 
 #endif /* PTPD_SLAVE_ONLY */
 
-/*Pack and send a single Sync message, return the embedded timestamp*/
+/*
+ * Pack and send a single Sync message, return the embedded timestamp. If deferTxTimestamp
+ * is set, do not wait for the TX timestamp - queue the Sync for collectSyncTimestamps().
+ */
 static TimeInternal
-issueSyncSingle(Integer32 dst, UInteger16 *sequenceId, const RunTimeOpts *rtOpts,PtpClock *ptpClock)
+issueSyncSingle(Integer32 dst, UInteger16 *sequenceId, Boolean deferTxTimestamp, const RunTimeOpts *rtOpts,PtpClock *ptpClock)
 {
 	Timestamp originTimestamp;
 	TimeInternal internalTime, now;
+	Octet *slot;
 
 	getSystemClock()->getTime(getSystemClock(), &internalTime);
 
@@ -3226,10 +3724,33 @@ issueSyncSingle(Integer32 dst, UInteger16 *sequenceId, const RunTimeOpts *rtOpts
 
 	now = internalTime;
 
+	if(deferTxTimestamp && (ptpClock->syncPendingCount >= ptpClock->unicastGrantCapacity)) {
+		deferTxTimestamp = FALSE;
+	}
+
+	/* batched fan-out: copy the template and patch it, issueSync() sends the batch */
+	if(deferTxTimestamp && (ptpClock->netPath.eventBatch.capacity > 0)) {
+		if(ptpClock->netPath.eventBatch.count == 0) {
+			msgPackSync(ptpClock->msgObuf,*sequenceId,&originTimestamp,ptpClock);
+		}
+		slot = netBatchAdd(&ptpClock->netPath.eventBatch, ptpClock->msgObuf, SYNC_LENGTH, dst);
+		if(slot != NULL) {
+			msgPatchSequenceId(slot, *sequenceId);
+			msgPatchTimestamp(slot, &originTimestamp);
+			ptpClock->syncPending[ptpClock->syncPendingCount].transportAddress = dst;
+			ptpClock->syncPending[ptpClock->syncPendingCount].sequenceId = *sequenceId;
+			ptpClock->syncPending[ptpClock->syncPendingCount].done = FALSE;
+			ptpClock->syncPendingCount++;
+			ptpClock->lastSyncDst = dst;
+			(*sequenceId)++;
+			return now;
+		}
+	}
+
 	msgPackSync(ptpClock->msgObuf,*sequenceId,&originTimestamp,ptpClock);
 
 	if (!netSendEvent(ptpClock->msgObuf,SYNC_LENGTH,&ptpClock->netPath,
-		rtOpts, dst, &internalTime)) {
+		rtOpts, dst, deferTxTimestamp ? NULL : &internalTime)) {
 		toState(PTP_FAULTY,rtOpts,ptpClock);
 		ptpClock->counters.messageSendErrors++;
 		DBGV("Sync message can't be sent -> FAULTY state \n");
@@ -3237,6 +3758,17 @@ issueSyncSingle(Integer32 dst, UInteger16 *sequenceId, const RunTimeOpts *rtOpts
 
 		DBGV("Sync MSG sent ! \n");
 
+		if(deferTxTimestamp) {
+			ptpClock->syncPending[ptpClock->syncPendingCount].transportAddress = dst;
+			ptpClock->syncPending[ptpClock->syncPendingCount].sequenceId = *sequenceId;
+			ptpClock->syncPending[ptpClock->syncPendingCount].done = FALSE;
+			ptpClock->syncPendingCount++;
+			ptpClock->lastSyncDst = dst;
+			(*sequenceId)++;
+			ptpClock->counters.syncMessagesSent++;
+			return now;
+		}
+
 		if(ptpClock->netPath.txTimestamping && !ptpClock->netPath.txLoop && !isTimeZero(&internalTime)) {
 
 			    if (respectUtcOffset(rtOpts, ptpClock) == TRUE) {
@@ -3262,7 +3794,7 @@ issueSyncSingle(Integer32 dst, UInteger16 *sequenceId, const RunTimeOpts *rtOpts
 		}
 
 		/* index the Sync destination */
-		indexSync(&internalTime, *sequenceId, dst, ptpClock->syncDestIndex);
+		indexSync(&internalTime, *sequenceId, dst, ptpClock->syncDestIndex, ptpClock->unicastGrantCapacity);
 
 		(*sequenceId)++;
 		ptpClock->counters.syncMessagesSent++;
@@ -3346,7 +3878,7 @@ issueDelayReq(const RunTimeOpts *rtOpts,PtpClock *ptpClock)
 				internalTime.seconds += ptpClock->timePropertiesDS.currentUtcOffset;
 			}			
 			
-			processDelayReqFromSelf(&internalTime, rtOpts, ptpClock);
+			processDelayReqFromSelf(ptpClock->msgObuf, &internalTime, rtOpts, ptpClock);
 		}
 
 #if defined(__QNXNTO__) && defined(PTPD_EXPERIMENTAL)
@@ -3354,7 +3886,7 @@ issueDelayReq(const RunTimeOpts *rtOpts,PtpClock *ptpClock)
 				internalTime.seconds += ptpClock->timePropertiesDS.currentUtcOffset;
 			}			
 			
-			processDelayReqFromSelf(&internalTime, rtOpts, ptpClock);
+			processDelayReqFromSelf(ptpClock->msgObuf, &internalTime, rtOpts, ptpClock);
 #endif
 
 		ptpClock->sentDelayReqSequenceId++;
@@ -3482,22 +4014,36 @@ issueDelayResp(const TimeInternal *tint,MsgHeader *header,Integer32 sourceAddres
 	int len = DELAY_RESP_LENGTH;
 	Timestamp requestReceiptTimestamp;
 	Integer32 dst = 0;
+	DelayRespTemplate *template;
 
 	fromInternalTime(tint,&requestReceiptTimestamp);
 	/* rewrite domain number with our own */
 	header->domainNumber = ptpClock->defaultDS.domainNumber;
-	msgPackDelayResp(ptpClock->msgObuf,header,&requestReceiptTimestamp,
-			 ptpClock);
+
+	template = getDelayRespTemplate(header, rtOpts, ptpClock);
+
+	if(template != NULL) {
+		len = template->length;
+		memcpy(ptpClock->msgObuf, template->buf, len);
+		msgPatchDelayResp(ptpClock->msgObuf, header, &requestReceiptTimestamp,
+				 ptpClock);
+	} else {
+		msgPackDelayResp(ptpClock->msgObuf,header,&requestReceiptTimestamp,
+				 ptpClock);
+		if(header->ptpmon || header->mtie) {
+			DBG("Populating PTPMON response\n");
+			len = populatePtpMon(ptpClock->msgObuf, header, ptpClock, rtOpts);
+		}
+	}
+
+	if(len == 0) {
+		DBG("Could not populate PTPMON response!\n");
+		return;
+	}
 
 	/* if request was unicast and we're running unicast, reply to source */
 	if(header->ptpmon || header->mtie) {
-		DBG("Populating PTPMON response\n");
 		dst = sourceAddress;
-		len = populatePtpMon(ptpClock->msgObuf, header, ptpClock, rtOpts);
-		if(len == 0) {
-		    DBG("Could not populate PTPMON response!\n");
-		    return;
-		}
 	} else if ( (rtOpts->ipMode != IPMODE_MULTICAST) &&
 	     (header->flagField0 & PTP_UNICAST) == PTP_UNICAST) {
 		dst = sourceAddress;
@@ -3515,9 +4061,83 @@ issueDelayResp(const TimeInternal *tint,MsgHeader *header,Integer32 sourceAddres
 
 	if(header->ptpmon) {
 	    DBG("Issuing SYNC for PTPMON\n");
-	    (void)issueSyncSingle(dst, &header->sequenceId, rtOpts, ptpClock);
+	    (void)issueSyncSingle(dst, &header->sequenceId, FALSE, rtOpts, ptpClock);
+	}
+
+}
+
+/*
+ * Return the Delay_Resp template for this request, (re)building it if
+ * anything it was built from has changed since. Only the fields written by
+ * msgPatchDelayResp() differ between responses. Returns NULL when the
+ * response cannot be cached - PTPMON in SLAVE state carries the current
+ * offset and delay - or could not be built.
+ */
+static DelayRespTemplate*
+getDelayRespTemplate(MsgHeader *header, const RunTimeOpts *rtOpts, PtpClock *ptpClock)
+{
+
+	DelayRespTemplateKey key;
+	DelayRespTemplate *template = &ptpClock->delayRespTemplate;
+	Boolean ptpmon = header->ptpmon || header->mtie;
+	Timestamp zero;
+
+	if(header->ptpmon && ptpClock->portDS.portState == PTP_SLAVE) {
+		return NULL;
+	}
+
+	/* memset, so that padding compares equal too */
+	memset(&key, 0, sizeof(key));
+	key.transportSpecific = ptpClock->portDS.transportSpecific;
+	key.versionNumber = ptpClock->portDS.versionNumber;
+	key.domainNumber = ptpClock->defaultDS.domainNumber;
+	copyPortIdentity(&key.portIdentity, &ptpClock->portDS.portIdentity);
+	key.logMinDelayReqInterval = ptpClock->portDS.logMinDelayReqInterval;
+
+	if(ptpmon) {
+		template = &ptpClock->ptpMonTemplate;
+		key.ptpmon = header->ptpmon;
+		key.mtie = header->mtie;
+		key.portState = ptpClock->portDS.portState;
+		if(ptpClock->portDS.portState > PTP_MASTER && ptpClock->bestMaster) {
+			key.parentAddress = ptpClock->bestMaster->sourceAddr;
+		}
+		memcpy(&key.parentDS, &ptpClock->parentDS, sizeof(ParentDS));
+		key.stepsRemoved = ptpClock->currentDS.stepsRemoved;
+		memcpy(&key.timePropertiesDS, &ptpClock->timePropertiesDS, sizeof(TimePropertiesDS));
+		if(header->mtie && ptpClock->portDS.portState == PTP_SLAVE) {
+			key.statsCalculated = ptpClock->slaveStats.statsCalculated;
+			key.windowNumber = ptpClock->slaveStats.windowNumber;
+			key.statsUpdateInterval = rtOpts->statsUpdateInterval;
+			key.ofmMinFinal = ptpClock->slaveStats.ofmMinFinal;
+			key.ofmMaxFinal = ptpClock->slaveStats.ofmMaxFinal;
+		}
+	}
+
+	if(template->valid && !memcmp(&key, &template->key, sizeof(key))) {
+		return template;
 	}
 
+	memset(&zero, 0, sizeof(zero));
+	template->valid = FALSE;
+	msgPackDelayResp(template->buf, header, &zero, ptpClock);
+	template->length = DELAY_RESP_LENGTH;
+
+	if(ptpmon) {
+		template->length = populatePtpMon(template->buf, header, ptpClock, rtOpts);
+		if(template->length == 0) {
+			return NULL;
+		}
+	}
+
+	memcpy(&template->key, &key, sizeof(key));
+	template->valid = TRUE;
+	ptpClock->counters.delayRespTemplateBuilds++;
+
+	DBG("Rebuilt %s Delay_Resp template\n", ptpmon ? "PTPMON" : "plain");
+
+	return template;
+
 }
 
 static void
@@ -3541,74 +4161,137 @@ issuePdelayRespFollowUp(const TimeInternal *tint, MsgHeader *header, Integer32 d
 	}
 }
 
-void
-addForeign(Octet *buf,MsgHeader *header,PtpClock *ptpClock, UInteger8 localPreference, UInteger32 sourceAddr)
+/*
+ * Copy everything in an Announce that can affect BMC to dataset: the whole message
+ * except correctionField, sequenceId and originTimestamp, which are zeroed.
+ * Returns the hash of the copy.
+ */
+static UInteger32
+announceDataset(const Octet *buf, Octet *dataset)
+{
+	memcpy(dataset, buf, ANNOUNCE_LENGTH);
+	memset(dataset + 8, 0, 8);
+	memset(dataset + 30, 0, 2);
+	memset(dataset + 34, 0, 10);
+
+	return fnvHash(dataset, ANNOUNCE_LENGTH, 0);
+}
+
+/*
+ * TRUE if an Announce differs from the one stored in the record in anything BMC
+ * uses. The hash only rules out most repeats quickly - a match is confirmed on
+ * the masked message itself, so a collision cannot hide a change.
+ */
+static Boolean
+announceChanged(const ForeignMasterRecord *record, UInteger32 announceHash, const Octet *dataset)
+{
+	return (record->announceHash != announceHash) ||
+		memcmp(record->announceDataset, dataset, ANNOUNCE_LENGTH);
+}
+
+/*
+ * Add or refresh a foreign master record. Returns TRUE if the record is new or any
+ * of its BMC inputs changed, FALSE if the Announce repeats what we already have.
+ * A change also requests a bmc() run for the record.
+ */
+Boolean
+addForeign(Octet *buf,MsgHeader *header,const RunTimeOpts *rtOpts,PtpClock *ptpClock, UInteger8 localPreference, UInteger32 sourceAddr)
 {
-	int i,j;
-	Boolean found = FALSE;
+	int j;
+	Boolean overwrite = FALSE;
+	Octet dataset[ANNOUNCE_LENGTH];
+	UInteger32 announceHash = announceDataset(buf, dataset);
+	ForeignMasterRecord *record;
 
 	DBGV("addForeign localPref: %d\n", localPreference);
 
-	j = ptpClock->foreign_record_best;
-	
 	/*Check if Foreign master is already known*/
-	for (i=0;i<ptpClock->number_foreign_records;i++) {
-		if (!memcmp(header->sourcePortIdentity.clockIdentity,
-			    ptpClock->foreign[j].foreignMasterPortIdentity.clockIdentity,
-			    CLOCK_IDENTITY_LENGTH) &&
-		    (header->sourcePortIdentity.portNumber ==
-		     ptpClock->foreign[j].foreignMasterPortIdentity.portNumber))
-		{
-			/*Foreign Master is already in Foreignmaster data set*/
-			ptpClock->foreign[j].foreignMasterAnnounceMessages++;
-			found = TRUE;
-			DBGV("addForeign : AnnounceMessage incremented \n");
-			msgUnpackHeader(buf,&ptpClock->foreign[j].header);
-			msgUnpackAnnounce(buf,&ptpClock->foreign[j].announce);
-			ptpClock->foreign[j].disqualified = FALSE;
-			ptpClock->foreign[j].localPreference = localPreference;
-			break;
+	j = findForeign(&header->sourcePortIdentity, ptpClock);
+
+	if (j >= 0) {
+		/*Foreign Master is already in Foreignmaster data set*/
+		record = &ptpClock->foreign[j];
+		record->foreignMasterAnnounceMessages++;
+		DBGV("addForeign : AnnounceMessage incremented \n");
+
+		if (!announceChanged(record, announceHash, dataset) && !record->disqualified &&
+		    (record->localPreference == localPreference)) {
+			DBGV("addForeign : no change \n");
+			return FALSE;
 		}
-	
-		j = (j+1)%ptpClock->number_foreign_records;
+
+		msgUnpackHeader(buf,&record->header);
+		msgUnpackAnnounce(buf,&record->announce);
+		record->announceHash = announceHash;
+		memcpy(record->announceDataset, dataset, ANNOUNCE_LENGTH);
+		record->disqualified = FALSE;
+		record->localPreference = localPreference;
+		bmcRecordChanged(ptpClock, j);
+		return TRUE;
 	}
 
 	/*New Foreign Master*/
-	if (!found) {
-		if (ptpClock->number_foreign_records <
-		    ptpClock->max_foreign_records) {
-			ptpClock->number_foreign_records++;
-		}
-		
-		/* Preserve best master record from overwriting (sf FR #22) - use next slot */
-		if (ptpClock->foreign_record_i == ptpClock->foreign_record_best) {
-			ptpClock->foreign_record_i++;
-			ptpClock->foreign_record_i %= ptpClock->number_foreign_records;
+	if (ptpClock->number_foreign_records >= ptpClock->max_foreign_records) {
+		if (growForeign(rtOpts, ptpClock)) {
+			ptpClock->foreign_record_i = ptpClock->number_foreign_records;
+		} else {
+			/* an existing record is being replaced - its index entry has to go */
+			overwrite = TRUE;
+			ptpClock->counters.foreignOverflows++;
 		}
-		
-		j = ptpClock->foreign_record_i;
-		
-		/*Copy new foreign master data set from Announce message*/
-		copyClockIdentity(ptpClock->foreign[j].foreignMasterPortIdentity.clockIdentity,
-		       header->sourcePortIdentity.clockIdentity);
-		ptpClock->foreign[j].foreignMasterPortIdentity.portNumber =
-			header->sourcePortIdentity.portNumber;
-		ptpClock->foreign[j].foreignMasterAnnounceMessages = 0;
-		ptpClock->foreign[j].localPreference = localPreference;
-		ptpClock->foreign[j].sourceAddr = sourceAddr;
-		ptpClock->foreign[j].disqualified = FALSE;
-		/*
-		 * header and announce field of each Foreign Master are
-		 * usefull to run Best Master Clock Algorithm
-		 */
-		msgUnpackHeader(buf,&ptpClock->foreign[j].header);
-		msgUnpackAnnounce(buf,&ptpClock->foreign[j].announce);
-		DBGV("New foreign Master added \n");
-		
-		ptpClock->foreign_record_i =
-			(ptpClock->foreign_record_i+1) %
-			ptpClock->max_foreign_records;	
 	}
+
+	if (ptpClock->number_foreign_records <
+	    ptpClock->max_foreign_records) {
+		ptpClock->number_foreign_records++;
+	}
+	
+	/* Preserve best master record from overwriting (sf FR #22) - use next slot */
+	if (ptpClock->foreign_record_i == ptpClock->foreign_record_best) {
+		ptpClock->foreign_record_i++;
+		ptpClock->foreign_record_i %= ptpClock->number_foreign_records;
+	}
+	
+	j = ptpClock->foreign_record_i;
+	record = &ptpClock->foreign[j];
+	
+	/*Copy new foreign master data set from Announce message*/
+	copyClockIdentity(record->foreignMasterPortIdentity.clockIdentity,
+	       header->sourcePortIdentity.clockIdentity);
+	record->foreignMasterPortIdentity.portNumber =
+		header->sourcePortIdentity.portNumber;
+	record->foreignMasterAnnounceMessages = 0;
+	record->localPreference = localPreference;
+	record->sourceAddr = sourceAddr;
+	record->disqualified = FALSE;
+	record->announceHash = announceHash;
+	memcpy(record->announceDataset, dataset, ANNOUNCE_LENGTH);
+	/*
+	 * header and announce field of each Foreign Master are
+	 * usefull to run Best Master Clock Algorithm
+	 */
+	msgUnpackHeader(buf,&record->header);
+	msgUnpackAnnounce(buf,&record->announce);
+	DBGV("New foreign Master added \n");
+
+	if (overwrite) {
+		ptpClock->counters.foreignRemoved++;
+		rebuildForeignIndex(ptpClock);
+	} else {
+		indexForeign(j, ptpClock);
+	}
+
+	/* the best record is never overwritten, so losing the old one here cannot change the best */
+	bmcRecordChanged(ptpClock, j);
+
+	ptpClock->counters.foreignAdded++;
+	ptpClock->counters.foreignCount = ptpClock->number_foreign_records;
+	
+	ptpClock->foreign_record_i =
+		(ptpClock->foreign_record_i+1) %
+		ptpClock->max_foreign_records;
+
+	return TRUE;
 }
 
 /* Update dataset fields which are safe to change without going into INITIALIZING */
@@ -22,6 +22,13 @@ typedef struct {
 	Integer32 nanoseconds;
 } TimeInternal;
 
+/**
+* \brief Signed time interval in nanoseconds multiplied by 2^16 - the
+* correctionField format. Holds up to +/- 39 hours with sub-nanosecond
+* resolution: used for the offset and delay arithmetic.
+ */
+typedef int64_t ScaledNanoseconds;
+
 /**
 * \brief The TimeInterval type represents time intervals
  */
@@ -512,6 +519,8 @@ typedef struct
 	UInteger8    localPreference; /* local preference - only used by telecom profile */
 	UInteger32   sourceAddr; /* source address */
 	Boolean	     disqualified; /* if true, this one always loses */
+	UInteger32   announceHash; /* hash of the Announce fields used by BMC - change detection */
+	Octet        announceDataset[ANNOUNCE_LENGTH]; /* the Announce with the fields BMC ignores zeroed */
 } ForeignMasterRecord;
 
 typedef struct {
@@ -124,7 +124,8 @@ Boolean timerSetup(IntervalTimer *itimers)
   "TIMINGDOMAIN_UPDATE",
   "INTERFACE_CHECK",
   "CLOCK_SYNC",
-  "CLOCK_DRIVER_UPDATE"
+  "CLOCK_DRIVER_UPDATE",
+  "NTPCONTROL"
     };
 
     int i = 0;
@@ -31,12 +31,12 @@
  */
 
 
-#ifdef PTPD_PTIMERS
+#if defined(PTPD_PTIMERS) || defined(PTPD_TIMERFD)
 #define LOG_MIN_INTERVAL -7
 #else
 /* 62.5ms tick for interval timers = 16/sec max */
 #define LOG_MIN_INTERVAL -4
-#endif /* PTPD_PTIMERS */
+#endif /* PTPD_PTIMERS || PTPD_TIMERFD */
 
 /* safeguard: a week */
 #define PTPTIMER_MAX_INTERVAL 604800
@@ -81,6 +81,7 @@ enum {
   INTERFACE_CHECK_TIMER,
   CLOCK_SYNC_TIMER,
   CLOCKDRIVER_UPDATE_TIMER,
+  NTPCONTROL_TIMER, /* NTP control request timeouts, runs while requests are in flight */
   PTP_MAX_TIMER
 };
 
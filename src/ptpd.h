@@ -134,6 +134,10 @@
 #include <sys/cpuset.h>
 #endif /* HAVE_SYS_CPUSET_H */
 
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif /* HAVE_SYS_EPOLL_H */
+
 #include "constants.h"
 #include "limits.h"
 
@@ -152,6 +156,10 @@
 
 #include "dep/constants_dep.h"
 #include "dep/datatypes_dep.h"
+#include "dep/telemetry.h"
+#include "dep/statslog.h"
+#include "dep/pcapng.h"
+#include "dep/housekeeping.h"
 
 #include "ptp_timers.h"
 #include "dep/eventtimer.h"
@@ -273,6 +281,149 @@ void subTime(TimeInternal*,const TimeInternal*,const TimeInternal*);
  */
 void div2Time(TimeInternal *);
 
+/**
+ * \name Scaled nanoseconds
+ * Offset and delay arithmetic without normalisation: intervals are single
+ * 64-bit integers in 2^-16 ns, so correctionField keeps its fractional
+ * nanoseconds until the result is rounded back into a TimeInternal.
+ */
+ /**\{*/
+
+#define SCALED_NS_SHIFT		16
+#define SCALED_NS_ONE		(1LL << SCALED_NS_SHIFT)
+#define SCALED_NS_SECOND	(1000000000LL << SCALED_NS_SHIFT)
+/* largest interval in nanoseconds which can be scaled: about 39 hours */
+#define SCALED_NS_MAX_NS	(INT64_MAX >> SCALED_NS_SHIFT)
+
+/**
+ * \brief x - y. FALSE (and the result saturated) if it does not fit
+ */
+static inline Boolean
+scaledTimeDiff(ScaledNanoseconds *r, const TimeInternal *x, const TimeInternal *y)
+{
+	int64_t ns = (int64_t)(x->seconds - (int64_t)y->seconds) * 1000000000LL +
+			(x->nanoseconds - (int64_t)y->nanoseconds);
+	Boolean fits = (ns <= SCALED_NS_MAX_NS) & (ns >= -SCALED_NS_MAX_NS);
+
+	ns = (ns > SCALED_NS_MAX_NS) ? SCALED_NS_MAX_NS : ns;
+	ns = (ns < -SCALED_NS_MAX_NS) ? -SCALED_NS_MAX_NS : ns;
+	*r = ns * SCALED_NS_ONE;
+
+	return fits;
+}
+
+/**
+ * \brief Interval held in a TimeInternal, saturated
+ */
+static inline ScaledNanoseconds
+timeInternalToScaled(const TimeInternal *t)
+{
+	const TimeInternal zero = { 0, 0 };
+	ScaledNanoseconds r;
+
+	scaledTimeDiff(&r, t, &zero);
+	return r;
+}
+
+/**
+ * \brief correctionField as received: sign and fraction kept. The one
+ * value which cannot be negated, -2^63, becomes -INT64_MAX
+ */
+static inline ScaledNanoseconds
+integer64ToScaled(Integer64 bigint)
+{
+	ScaledNanoseconds r = (ScaledNanoseconds)(((uint64_t)(uint32_t)bigint.msb << 32) | bigint.lsb);
+
+	return (r == INT64_MIN) ? -INT64_MAX : r;
+}
+
+/**
+ * \brief x + y, saturated to +/-INT64_MAX. These stand for out of range,
+ * as 0x7FFFFFFFFFFFFFFF does in correctionField, and are kept: a saturated
+ * value never comes back into range
+ */
+static inline ScaledNanoseconds
+scaledAdd(ScaledNanoseconds x, ScaledNanoseconds y)
+{
+	if(x == INT64_MAX || x == -INT64_MAX) {
+		return x;
+	}
+	if(y == INT64_MAX || y == -INT64_MAX) {
+		return y;
+	}
+	if(y > 0 && x > INT64_MAX - y) {
+		return INT64_MAX;
+	}
+	if(y < 0 && x < -INT64_MAX - y) {
+		return -INT64_MAX;
+	}
+	return x + y;
+}
+
+/**
+ * \brief x - y, saturated as scaledAdd()
+ */
+static inline ScaledNanoseconds
+scaledSub(ScaledNanoseconds x, ScaledNanoseconds y)
+{
+	if(x == INT64_MAX || x == -INT64_MAX) {
+		return x;
+	}
+	if(y == INT64_MAX || y == -INT64_MAX) {
+		return -y;
+	}
+	if(y < 0 && x > INT64_MAX + y) {
+		return INT64_MAX;
+	}
+	if(y > 0 && x < -INT64_MAX + y) {
+		return -INT64_MAX;
+	}
+	return x - y;
+}
+
+/**
+ * \brief Round to the nearest nanosecond, halves away from zero
+ */
+static inline int64_t
+scaledToNs(ScaledNanoseconds s)
+{
+	int64_t sign = (s >> 63) | 1;
+
+	return sign * (int64_t)(((uint64_t)(sign * s) + (SCALED_NS_ONE / 2)) >> SCALED_NS_SHIFT);
+}
+
+/**
+ * \brief Rounded to the nearest nanosecond, normalised as subTime() would
+ */
+static inline void
+scaledToTimeInternal(ScaledNanoseconds s, TimeInternal *r)
+{
+	int64_t ns = scaledToNs(s);
+
+	r->seconds = ns / 1000000000LL;
+	r->nanoseconds = ns % 1000000000LL;
+}
+
+/**
+ * \brief In seconds, as timeInternalToDouble()
+ */
+static inline double
+scaledToDouble(ScaledNanoseconds s)
+{
+	return s / (double)SCALED_NS_SECOND;
+}
+
+/**
+ * \brief From seconds, rounded to 2^-16 ns
+ */
+static inline ScaledNanoseconds
+doubleToScaled(double d)
+{
+	return llround(d * (double)SCALED_NS_SECOND);
+}
+
+/** \}*/
+
 void timeDelta(TimeInternal *before, TimeInternal *meas, TimeInternal *after, TimeInternal *delta);
 
 TimeInternal negativeTime(TimeInternal *time);
@@ -289,9 +440,17 @@ Boolean isTimeZero(const TimeInternal *time);
  */
 
 UInteger8 bmc(ForeignMasterRecord*, const RunTimeOpts*,PtpClock*);
+/* request a bmc() run, telling it which foreign record changed */
+void bmcRecordChanged(PtpClock *ptpClock, int record);
 
 /* compare two portIdentTitties */
 int cmpPortIdentity(const PortIdentity *a, const PortIdentity *b);
+/* foreign master record index maintenance */
+Boolean rebuildForeignIndex(PtpClock *ptpClock);
+int findForeign(const PortIdentity *portIdentity, const PtpClock *ptpClock);
+void indexForeign(int record, PtpClock *ptpClock);
+void clearForeign(PtpClock *ptpClock);
+Boolean growForeign(const RunTimeOpts *rtOpts, PtpClock *ptpClock);
 /* check if portIdentity is all zero */
 Boolean portIdentityEmpty(PortIdentity *portIdentity);
 /* check if portIdentity is all ones */
@@ -351,6 +510,10 @@ void handleManagement(MsgHeader *header,
 /**
  * \brief Signaling message support
  */
+Boolean allocUnicastGrants(const RunTimeOpts *rtOpts, PtpClock *ptpClock);
+void 	freeUnicastGrants(PtpClock *ptpClock);
+void 	scheduleUnicastGrant(UnicastGrantData *grant, PtpClock *ptpClock);
+int 	unicastWheelTick(UnicastWheel *wheel, Integer8 portLogInterval);
 UnicastGrantTable* findUnicastGrants(const PortIdentity* portIdentity, Integer32 TransportAddress, UnicastGrantTable *grantTable, UnicastGrantIndex *index, int nodeCount, Boolean update);
 void 	initUnicastGrantTable(UnicastGrantTable *grantTable, Enumeration8 delayMechanism, int nodeCount, UnicastDestination *destinations, const RunTimeOpts *rtOpts, PtpClock *ptpClock);
 
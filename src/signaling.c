@@ -45,7 +45,10 @@
 #define GRANT_MAX_MISSED 10
 
 static void updateUnicastIndex(UnicastGrantTable *table, UnicastGrantIndex *index);
+static void rebuildUnicastIndex(UnicastGrantIndex *index);
 static UnicastGrantTable* lookupUnicastIndex(PortIdentity *portIdentity, Integer32 transportAddress, UnicastGrantIndex *index);
+static void listUnicastGrant(UnicastGrantData *grant, PtpClock *ptpClock);
+static void pruneUnicastGrantLists(PtpClock *ptpClock);
 static int msgIndex(Enumeration8 messageType);
 static Enumeration8 msgXedni(int messageIndex);
 static void initOutgoingMsgSignaling(PortIdentity* targetPortIdentity, MsgSignaling* outgoing, PtpClock *ptpClock);
@@ -103,55 +106,550 @@ msgXedni(int messageIndex)
 
 }
 
-/* update index table */
+/* port identity not (yet) known: all-ones or empty */
+static Boolean
+grantIdentityUnset(const PortIdentity *portIdentity)
+{
+    PortIdentity allOnes;
+
+    memset(&allOnes, 0xFF, sizeof(PortIdentity));
+
+    return (portIdentityEmpty((PortIdentity*)portIdentity) ||
+	    !cmpPortIdentity(portIdentity, &allOnes));
+}
+
+/* index slot for a port identity */
+static int
+grantIdentitySlot(const PortIdentity *portIdentity, const UnicastGrantIndex *index)
+{
+    return fnvHash((void*)portIdentity, sizeof(PortIdentity), 0) & (index->size - 1);
+}
+
+/* index slot for a transport address */
+static int
+grantAddressSlot(Integer32 transportAddress, const UnicastGrantIndex *index)
+{
+    return fnvHash(&transportAddress, sizeof(Integer32), 0) & (index->size - 1);
+}
+
+/* clear the index and add all entries in use again - this drops stale slots */
+static void
+rebuildUnicastIndex(UnicastGrantIndex *index)
+{
+
+    int i;
+
+    if(index->size == 0) {
+	return;
+    }
+
+    memset(index->data, 0, index->size * sizeof(UnicastGrantTable*));
+    memset(index->addr, 0, index->size * sizeof(UnicastGrantTable*));
+
+    for(i = 0; i < index->used; i++) {
+	updateUnicastIndex(&index->nodes[i], index);
+    }
+
+    DBG("rebuildUnicastIndex: %d entries re-indexed\n", index->used);
+
+}
+
+/*
+ * update index table: linear probing. Slots are never removed; entries whose
+ * identity or address changed are left behind as stale slots and skipped on
+ * lookup until the index is rebuilt.
+ */
 static void
 updateUnicastIndex(UnicastGrantTable *table, UnicastGrantIndex *index)
 {
-    uint32_t hash = fnvHash(&table->portIdentity, sizeof(PortIdentity), UNICAST_MAX_DESTINATIONS);
+
+    int i, slot;
+    Boolean indexed;
+    UnicastGrantTable *entry;
 
     /* peer table normally has one entry: if we got here, we might pollute the main index */
-    if(!table->isPeer && index != NULL) {
-	index->data[hash] = table;
+    if(table->isPeer || index == NULL || index->size == 0) {
+	return;
+    }
+
+    /* only index entries of the table this index was built for */
+    if(table < index->nodes || table >= index->nodes + index->capacity) {
+	return;
+    }
+
+    if(table - index->nodes >= index->used) {
+	index->used = table - index->nodes + 1;
+    }
+
+    if(!grantIdentityUnset(&table->portIdentity)) {
+	indexed = FALSE;
+	slot = grantIdentitySlot(&table->portIdentity, index);
+	for(i = 0; i < index->size; i++) {
+	    entry = index->data[slot];
+	    if(entry == NULL || entry == table ||
+		!cmpPortIdentity(&entry->portIdentity, &table->portIdentity)) {
+		index->data[slot] = table;
+		indexed = TRUE;
+		break;
+	    }
+	    slot = (slot + 1) & (index->size - 1);
+	}
+	/* full of stale slots - a rebuild always has room for every entry */
+	if(!indexed) {
+	    rebuildUnicastIndex(index);
+	    return;
+	}
+    }
+
+    if(table->transportAddress) {
+	indexed = FALSE;
+	slot = grantAddressSlot(table->transportAddress, index);
+	for(i = 0; i < index->size; i++) {
+	    entry = index->addr[slot];
+	    /* the first entry with this address wins, same as a table scan */
+	    if(entry == NULL || entry == table ||
+		entry->transportAddress == table->transportAddress) {
+		if(entry == NULL) {
+		    index->addr[slot] = table;
+		}
+		indexed = TRUE;
+		break;
+	    }
+	    slot = (slot + 1) & (index->size - 1);
+	}
+	if(!indexed) {
+	    rebuildUnicastIndex(index);
+	}
     }
 
 }
 
-/* return matching entry from index table */
+/* return matching entry from index table: port identity first, transport address second */
 static UnicastGrantTable*
 lookupUnicastIndex(PortIdentity *portIdentity, Integer32 transportAddress, UnicastGrantIndex *index)
 {
 
-    uint32_t hash = fnvHash((void*)portIdentity, sizeof(PortIdentity), UNICAST_MAX_DESTINATIONS);
-
+    int i, slot;
     UnicastGrantTable* table;
 
-    if(index == NULL) {
+    if(index == NULL || index->size == 0) {
 	return NULL;
     }
 
-    table  = index->data[hash];
+    slot = grantIdentitySlot(portIdentity, index);
+    for(i = 0; i < index->size; i++) {
+	table = index->data[slot];
+	if(table == NULL) {
+	    break;
+	}
+	if(!cmpPortIdentity(portIdentity, &table->portIdentity)) {
+	    DBG("lookupUnicastIndex: port identity hit after %d probes\n", i + 1);
+	    return table;
+	}
+	slot = (slot + 1) & (index->size - 1);
+    }
 
-    if(table == NULL) {
-	DBG("lookupUnicastIndex: empty hit\n");
+    if(!transportAddress) {
+	DBG("lookupUnicastIndex: miss\n");
 	return NULL;
     }
 
-    if(!cmpPortIdentity(portIdentity, &table->portIdentity)) {
-	DBG("lookupUnicastIndex: cache hit\n");
-	return table;
-    } else {
-	/* hash collision */
-	DBG("lookupUnicastIndex: hash collision\n");
-	return NULL;
+    slot = grantAddressSlot(transportAddress, index);
+    for(i = 0; i < index->size; i++) {
+	table = index->addr[slot];
+	if(table == NULL) {
+	    break;
+	}
+	if(table->transportAddress == transportAddress) {
+	    DBG("lookupUnicastIndex: transport address hit after %d probes\n", i + 1);
+	    return table;
+	}
+	slot = (slot + 1) & (index->size - 1);
+    }
+
+    DBG("lookupUnicastIndex: miss\n");
+    return NULL;
+
+}
+
+/* put a grant on the active list for its message type */
+static void
+listUnicastGrant(UnicastGrantData *grant, PtpClock *ptpClock)
+{
+
+    int i = msgIndex(grant->messageType);
+    UnicastGrantList *list;
+
+    if(grant->listed || i < 0) {
+	return;
+    }
+
+    list = &ptpClock->activeGrants[i];
+
+    if(list->data == NULL || list->count >= ptpClock->unicastGrantCapacity) {
+	return;
+    }
+
+    list->data[list->count++] = grant;
+    grant->listed = TRUE;
+
+}
+
+/* drop grants which are no longer granted from the active lists */
+static void
+pruneUnicastGrantLists(PtpClock *ptpClock)
+{
+
+    int i, j, k;
+    UnicastGrantList *list;
+
+    for(i = 0; i < PTP_MAX_MESSAGE_INDEXED; i++) {
+	list = &ptpClock->activeGrants[i];
+	for(j = 0, k = 0; j < list->count; j++) {
+	    if(list->data[j]->granted) {
+		list->data[k++] = list->data[j];
+	    } else {
+		list->data[j]->listed = FALSE;
+	    }
+	}
+	list->count = k;
+    }
+
+}
+
+/* wheel ticks between transmissions of a grant: the power of 2 is what the old modulo counter did */
+static UInteger32
+unicastWheelPeriod(const UnicastGrantData *grant, Integer8 portLogInterval, int subTicks)
+{
+
+    int shift = grant->logInterval - portLogInterval;
+
+    if(shift <= 0) {
+	return subTicks;
+    }
+
+    /* message intervals are limited to 2^-7..2^7 s anyway */
+    if(shift > 16) {
+	shift = 16;
+    }
+
+    return ((UInteger32)1 << shift) * subTicks;
+
+}
+
+/* add or remove the transmissions of a grant to the load of every slot it passes through */
+static void
+unicastWheelLoad(UnicastWheel *wheel, UInteger32 due, UInteger32 period, int delta)
+{
+
+    int slot;
+
+    if(period >= (UInteger32)wheel->size) {
+	wheel->load[due & (wheel->size - 1)] += delta;
+	return;
+    }
+
+    for(slot = due & (period - 1); slot < wheel->size; slot += period) {
+	wheel->load[slot] += delta;
+    }
+
+}
+
+/* take a grant off the wheel */
+static void
+unscheduleUnicastGrant(UnicastWheel *wheel, UnicastGrantData *grant)
+{
+
+    UnicastGrantData **link;
+
+    if(!grant->scheduled) {
+	return;
+    }
+
+    for(link = &wheel->slots[grant->wheelDue & (wheel->size - 1)]; *link != NULL; link = &(*link)->wheelNext) {
+	if(*link == grant) {
+	    *link = grant->wheelNext;
+	    break;
+	}
+    }
+
+    unicastWheelLoad(wheel, grant->wheelDue, grant->wheelPeriod, -1);
+    grant->wheelNext = NULL;
+    grant->scheduled = FALSE;
+
+}
+
+/* put a grant on the wheel in the slot with the given due tick */
+static void
+placeUnicastGrant(UnicastWheel *wheel, UnicastGrantData *grant, UInteger32 due, UInteger32 period)
+{
+
+    int slot = due & (wheel->size - 1);
+
+    grant->wheelDue = due;
+    grant->wheelPeriod = period;
+    grant->wheelNext = wheel->slots[slot];
+    wheel->slots[slot] = grant;
+    grant->scheduled = TRUE;
+
+}
+
+/*
+ * Schedule a new grant: the first transmission goes into the least loaded tick
+ * within one period, so grantees sharing a rate are spread evenly over the interval
+ * instead of all being sent to on the same tick.
+ */
+static void
+placeNewUnicastGrant(UnicastWheel *wheel, UnicastGrantData *grant, UInteger32 period)
+{
+
+    int i, slot;
+    int candidates = min(period, (UInteger32)wheel->size);
+    UInteger32 load, bestLoad = 0;
+    UInteger32 due, bestDue = wheel->tick + 1;
+
+    for(i = 1; i <= candidates; i++) {
+	due = wheel->tick + i;
+	if(period >= (UInteger32)wheel->size) {
+	    load = wheel->load[due & (wheel->size - 1)];
+	} else {
+	    load = 0;
+	    for(slot = due & (period - 1); slot < wheel->size; slot += period) {
+		load += wheel->load[slot];
+	    }
+	}
+	if(i == 1 || load < bestLoad) {
+	    bestLoad = load;
+	    bestDue = due;
+	}
+    }
+
+    placeUnicastGrant(wheel, grant, bestDue, period);
+    unicastWheelLoad(wheel, bestDue, period, 1);
+
+}
+
+/* allocate a timing wheel */
+static Boolean
+initUnicastWheel(UnicastWheel *wheel, int capacity)
+{
+
+    memset(wheel, 0, sizeof(UnicastWheel));
+
+    wheel->size = UNICAST_WHEEL_SLOTS;
+    wheel->capacity = capacity;
+    wheel->subTicks = 1;
+    wheel->slots = calloc(wheel->size, sizeof(UnicastGrantData*));
+    wheel->load = calloc(wheel->size, sizeof(UInteger32));
+    wheel->due = calloc(capacity, sizeof(UnicastGrantData*));
+
+    return (wheel->slots != NULL && wheel->load != NULL && wheel->due != NULL);
+
+}
+
+static void
+freeUnicastWheel(UnicastWheel *wheel)
+{
+
+    SAFE_FREE(wheel->slots);
+    SAFE_FREE(wheel->load);
+    SAFE_FREE(wheel->due);
+    memset(wheel, 0, sizeof(UnicastWheel));
+
+}
+
+/* empty a timing wheel - the grants it pointed to are being reset */
+static void
+resetUnicastWheel(UnicastWheel *wheel, int subTicks)
+{
+
+    if(wheel->slots == NULL) {
+	return;
     }
 
+    memset(wheel->slots, 0, wheel->size * sizeof(UnicastGrantData*));
+    memset(wheel->load, 0, wheel->size * sizeof(UInteger32));
+    wheel->tick = 0;
+    wheel->subTicks = subTicks;
+
+}
+
+/* (re)schedule Sync or Announce transmission for a grant we have just issued */
+void
+scheduleUnicastGrant(UnicastGrantData *grant, PtpClock *ptpClock)
+{
+
+    UnicastWheel *wheel;
+    Integer8 portLogInterval;
+
+    switch(grant->messageType) {
+	case SYNC:
+	    wheel = &ptpClock->syncWheel;
+	    portLogInterval = ptpClock->portDS.logSyncInterval;
+	    break;
+	case ANNOUNCE:
+	    wheel = &ptpClock->announceWheel;
+	    portLogInterval = ptpClock->portDS.logAnnounceInterval;
+	    break;
+	default:
+	    return;
+    }
+
+    if(wheel->slots == NULL) {
+	return;
+    }
+
+    unscheduleUnicastGrant(wheel, grant);
+    placeNewUnicastGrant(wheel, grant,
+	unicastWheelPeriod(grant, portLogInterval, wheel->subTicks));
+
+}
+
+/*
+ * Advance the wheel by one tick. Grants due now are returned in wheel->due and
+ * placed back on the wheel one period later; grants no longer granted are dropped.
+ * Returns the number of grants due.
+ */
+int
+unicastWheelTick(UnicastWheel *wheel, Integer8 portLogInterval)
+{
+
+    int i, count = 0;
+    UInteger32 period;
+    UnicastGrantData *grant, *next, **link;
+
+    if(wheel->slots == NULL) {
+	return 0;
+    }
+
+    wheel->tick++;
+
+    link = &wheel->slots[wheel->tick & (wheel->size - 1)];
+
+    for(grant = *link; grant != NULL; grant = next) {
+
+	next = grant->wheelNext;
+
+	/* due on a later revolution */
+	if(grant->wheelDue != wheel->tick) {
+	    link = &grant->wheelNext;
+	    continue;
+	}
+
+	*link = next;
+	grant->wheelNext = NULL;
+	grant->scheduled = FALSE;
+	unicastWheelLoad(wheel, grant->wheelDue, grant->wheelPeriod, -1);
+
+	if(grant->granted && count < wheel->capacity) {
+	    wheel->due[count++] = grant;
+	}
+
+    }
+
+    /* only put them back once the slot has been walked */
+    for(i = 0; i < count; i++) {
+	grant = wheel->due[i];
+	period = unicastWheelPeriod(grant, portLogInterval, wheel->subTicks);
+	if(period == grant->wheelPeriod) {
+	    placeUnicastGrant(wheel, grant, wheel->tick + period, period);
+	    unicastWheelLoad(wheel, grant->wheelDue, period, 1);
+	} else {
+	    /* interval changed - find a new place */
+	    placeNewUnicastGrant(wheel, grant, period);
+	}
+    }
+
+    return count;
+
+}
+
+/* allocate the unicast grant table, its index and the active grant lists */
+Boolean
+allocUnicastGrants(const RunTimeOpts *rtOpts, PtpClock *ptpClock)
+{
+
+    int i;
+    int capacity = max(rtOpts->unicastGrantCapacity, UNICAST_MAX_DESTINATIONS);
+    UnicastGrantIndex *index = &ptpClock->grantIndex;
+
+    memset(index, 0, sizeof(UnicastGrantIndex));
+
+    /* keep the index at most half full */
+    index->size = 1;
+    while(index->size < 2 * capacity) {
+	index->size <<= 1;
+    }
+
+    ptpClock->unicastGrants = calloc(capacity, sizeof(UnicastGrantTable));
+    ptpClock->syncDestIndex = calloc(capacity, sizeof(SyncDestEntry));
+    ptpClock->syncPending = calloc(capacity, sizeof(SyncPendingEntry));
+    ptpClock->unicastDestinations = calloc(capacity, sizeof(UnicastDestination));
+    index->data = calloc(index->size, sizeof(UnicastGrantTable*));
+    index->addr = calloc(index->size, sizeof(UnicastGrantTable*));
+
+    if(!ptpClock->unicastGrants || !ptpClock->syncDestIndex || !ptpClock->syncPending ||
+	!ptpClock->unicastDestinations || !index->data || !index->addr) {
+	freeUnicastGrants(ptpClock);
+	return FALSE;
+    }
+
+    for(i = 0; i < PTP_MAX_MESSAGE_INDEXED; i++) {
+	ptpClock->activeGrants[i].count = 0;
+	ptpClock->activeGrants[i].data = calloc(capacity, sizeof(UnicastGrantData*));
+	if(ptpClock->activeGrants[i].data == NULL) {
+	    freeUnicastGrants(ptpClock);
+	    return FALSE;
+	}
+    }
+
+    if(!initUnicastWheel(&ptpClock->syncWheel, capacity) ||
+	!initUnicastWheel(&ptpClock->announceWheel, capacity)) {
+	freeUnicastGrants(ptpClock);
+	return FALSE;
+    }
+
+    ptpClock->unicastGrantCapacity = capacity;
+    index->nodes = ptpClock->unicastGrants;
+    index->capacity = capacity;
+
+    DBG("allocated unicast grant table for %d nodes, index size %d\n", capacity, index->size);
+
+    return TRUE;
+
 }
 
+void
+freeUnicastGrants(PtpClock *ptpClock)
+{
+
+    int i;
+
+    SAFE_FREE(ptpClock->unicastGrants);
+    SAFE_FREE(ptpClock->syncDestIndex);
+    SAFE_FREE(ptpClock->syncPending);
+    SAFE_FREE(ptpClock->unicastDestinations);
+    SAFE_FREE(ptpClock->grantIndex.data);
+    SAFE_FREE(ptpClock->grantIndex.addr);
+
+    for(i = 0; i < PTP_MAX_MESSAGE_INDEXED; i++) {
+	SAFE_FREE(ptpClock->activeGrants[i].data);
+	ptpClock->activeGrants[i].count = 0;
+    }
+
+    freeUnicastWheel(&ptpClock->syncWheel);
+    freeUnicastWheel(&ptpClock->announceWheel);
+
+    memset(&ptpClock->grantIndex, 0, sizeof(UnicastGrantIndex));
+    ptpClock->unicastGrantCapacity = 0;
+    ptpClock->unicastDestinationCount = 0;
+
+}
 
 /* find which grant table entry the given port belongs to:
    - if not found, return first free entry, store portID and/or address
    - if found, find the entry it belongs to
-   - look up the index table, only iterate on miss
+   - look up the index table, only iterate when looking for a free entry
    - if update is FALSE, only a search is performed
 */
 UnicastGrantTable*
@@ -168,87 +666,70 @@ findUnicastGrants
 
 	PortIdentity tmpIdentity = *portIdentity;
 
+	/* the index only covers the main grant table */
+	if(index != NULL && (index->size == 0 || grantTable != index->nodes)) {
+	    index = NULL;
+	}
+
 	/* look up the index table*/
 	if(index != NULL) {
 	    tmpIdentity.portNumber |= index->portMask;
 	    found = lookupUnicastIndex(&tmpIdentity, transportAddress, index);
-	}
-	
-	if(found != NULL) {
-	    DBG("findUnicastGrants: cache hit\n");
-		/* do not overwrite address if zero given
-		 * (used by slave to preserve configured master addresses)
-		 */
-		if(update && transportAddress) {
-		    found->transportAddress = transportAddress;
-		}
-		if(update) {
-		    found->portIdentity = tmpIdentity;
-		}
-
-		if(update) {
-		    updateUnicastIndex(found, index);
-		}
-
+	    if(found != NULL && (found - grantTable) >= nodeCount) {
+		found = NULL;
+	    }
 	} else for(i=0; i < nodeCount; i++) {
 
 	    nodeTable = &grantTable[i];
 
-	    /* first free entry */
-	    if(firstFree == NULL) {
-		    if(portIdentityEmpty(&nodeTable->portIdentity) ||
-			(nodeTable->timeLeft == 0)) {
-			    firstFree = nodeTable;
-		    }
-	    }
-
 	    /* port identity matches */
 	    if(!cmpPortIdentity((const PortIdentity*)&tmpIdentity, &nodeTable->portIdentity)) {
+		found = nodeTable;
+		break;
+	    }
 
+	    /* no port identity match but we have a transport address match */
+	    if(nodeTable->transportAddress &&
+		(nodeTable->transportAddress==transportAddress)) {
 		found = nodeTable;
+		break;
+	    }
 
-		/* do not overwrite address if zero given
-		 * (used by slave to preserve configured master addresses)
-		 */
+	}
 
-		if(update && transportAddress) {
-		    found->transportAddress = transportAddress;
-		}
+	if(found != NULL) {
 
 		if(update) {
+		    /* do not overwrite address if zero given
+		     * (used by slave to preserve configured master addresses)
+		     */
+		    if(transportAddress) {
+			found->transportAddress = transportAddress;
+		    }
 		    found->portIdentity = tmpIdentity;
-		}
-
-		DBG("findUnicastGrants: cache miss - %d iterations %d\n", i);
-
-		if(update) {
 		    updateUnicastIndex(found, index);
 		}
 
-		break;
+		return found;
 
-	    }
+	}
 
-	    /* no port identity match but we have a transport address match */
-	    if(nodeTable->transportAddress &&
-		(nodeTable->transportAddress==transportAddress)) {
+	if(!update) {
+	    return NULL;
+	}
 
-		found = nodeTable;
-		if(update) {
-			found->portIdentity = tmpIdentity;
-			updateUnicastIndex(found, index);
-		}
-		break;
+	/* first free entry */
+	for(i=0; i < nodeCount; i++) {
+	    nodeTable = &grantTable[i];
+	    if(portIdentityEmpty(&nodeTable->portIdentity) ||
+		(nodeTable->timeLeft == 0)) {
+		    firstFree = nodeTable;
+		    break;
 	    }
-
 	}
 
-    if(found != NULL) {
-	return found;
-    }
-
     /* will return NULL if there are no free slots, otherwise the first free slot */
-    if(update && firstFree != NULL) {
+    if(firstFree != NULL) {
 	firstFree->portIdentity = tmpIdentity;
 	firstFree->transportAddress = transportAddress;
 	updateUnicastIndex(firstFree, index);
@@ -267,7 +748,6 @@ findUnicastGrants
 
 }
 
-
 /**\brief Initialise outgoing signaling message fields*/
 static void
 initOutgoingMsgSignaling(PortIdentity* targetPortIdentity, MsgSignaling* outgoing, PtpClock *ptpClock)
@@ -309,6 +789,7 @@ handleSMRequestUnicastTransmission(MsgSignaling* incoming, MsgSignaling* outgoin
 	UnicastGrantData *myGrant;
 	UnicastGrantTable *nodeTable;
 	Boolean granted = TRUE;
+	Boolean reschedule = FALSE;
 	SMRequestUnicastTransmission* requestData = (SMRequestUnicastTransmission*)incoming->tlv->valueField;
 	SMGrantUnicastTransmission* grantData = NULL;
 	Enumeration8 messageType = requestData->messageType;
@@ -331,10 +812,10 @@ handleSMRequestUnicastTransmission(MsgSignaling* incoming, MsgSignaling* outgoin
 			getMessageTypeName(messageType), portId, inet_ntoa(tmpAddr), requestData->durationField,
 			requestData->logInterMessagePeriod);
 
-	nodeTable = findUnicastGrants(&incoming->header.sourcePortIdentity, sourceAddress, ptpClock->unicastGrants, &ptpClock->grantIndex, UNICAST_MAX_DESTINATIONS, TRUE);
+	nodeTable = findUnicastGrants(&incoming->header.sourcePortIdentity, sourceAddress, ptpClock->unicastGrants, &ptpClock->grantIndex, ptpClock->unicastGrantCapacity, TRUE);
 
 	if(nodeTable == NULL) {
-		if(ptpClock->slaveCount >= UNICAST_MAX_DESTINATIONS) {
+		if(ptpClock->slaveCount >= ptpClock->unicastGrantCapacity) {
 			DBG("REQUEST_UNICAST_TRANSMISSION (%s): did not find node in slave table : %s (%s) - table full\n", getMessageTypeName(messageType),
 			inet_ntoa(tmpAddr),portId);
 		} else {
@@ -405,9 +886,9 @@ handleSMRequestUnicastTransmission(MsgSignaling* incoming, MsgSignaling* outgoin
 	    /* NEW! 5 seconds for free! Why 5? refreshUnicastGrants expires the grant when it's 5 */
 	    myGrant->timeLeft = grantData->durationField + 10;
 
-	    /* do not reset the counter if this is being re-requested */
+	    /* keep the transmission schedule if this is being re-requested */
 	    if(!myGrant->granted || (myGrant->logInterval != grantData->logInterMessagePeriod)) {
-		myGrant->intervalCounter = 0;
+		reschedule = TRUE;
 	    }
 
 	    ptpClock->counters.unicastGrantsGranted++;
@@ -416,6 +897,10 @@ handleSMRequestUnicastTransmission(MsgSignaling* incoming, MsgSignaling* outgoin
 	    myGrant->canceled = FALSE;
 	    myGrant->cancelCount = 0;
 	    myGrant->logInterval = grantData->logInterMessagePeriod;
+	    listUnicastGrant(myGrant, ptpClock);
+	    if(reschedule) {
+		scheduleUnicastGrant(myGrant, ptpClock);
+	    }
 
 	    /* this could be the very first grant for this node - update node's timeLeft so it's not seen as free anymore */
 	    if(nodeTable->timeLeft <= 0) {
@@ -558,7 +1043,7 @@ handleSMCancelUnicastTransmission(MsgSignaling* incoming, MsgSignaling* outgoing
 
 	ptpClock->counters.unicastGrantsCancelReceived++;
 
-	nodeTable = findUnicastGrants(&incoming->header.sourcePortIdentity, sourceAddress, ptpClock->unicastGrants, &ptpClock->grantIndex, UNICAST_MAX_DESTINATIONS, FALSE);
+	nodeTable = findUnicastGrants(&incoming->header.sourcePortIdentity, sourceAddress, ptpClock->unicastGrants, &ptpClock->grantIndex, ptpClock->unicastGrantCapacity, FALSE);
 
 	if(nodeTable == NULL) {
 		DBG("CANCEL_UNICAST_TRANSMISSION: did not find node in slave table: %s\n", portId);
@@ -633,7 +1118,7 @@ handleSMAcknowledgeCancelUnicastTransmission(MsgSignaling* incoming, Integer32 s
 	DBGV("Received ACKNOWLEDGE_CANCEL_UNICAST_TRANSMISSION message for message %s from %s(%s)\n",
 			getMessageTypeName(messageType), portId, inet_ntoa(tmpAddr));
 
-	nodeTable = findUnicastGrants(&incoming->header.sourcePortIdentity, sourceAddress, ptpClock->unicastGrants, &ptpClock->grantIndex, UNICAST_MAX_DESTINATIONS, FALSE);
+	nodeTable = findUnicastGrants(&incoming->header.sourcePortIdentity, sourceAddress, ptpClock->unicastGrants, &ptpClock->grantIndex, ptpClock->unicastGrantCapacity, FALSE);
 
 	if(nodeTable == NULL) {
 		DBG("ACKNOWLEDGE_CANCEL_UNICAST_TRANSMISSION: did not find node in slave table: %s\n", portId);
@@ -769,14 +1254,18 @@ initUnicastGrantTable(UnicastGrantTable *grantTable, Enumeration8 delayMechanism
     UnicastGrantData *grantData;
     UnicastGrantTable *nodeTable;
 
-    /* initialise the index table */
-    for(i=0; i < UNICAST_MAX_DESTINATIONS; i++) {
-	ptpClock->grantIndex.data[i] = NULL;
-	ptpClock->syncDestIndex[i].transportAddress = 0;
+    /* initialise the index table and the active grant lists when (re)initialising the main table */
+    if(grantTable == ptpClock->unicastGrants) {
+	memset(ptpClock->syncDestIndex, 0, ptpClock->unicastGrantCapacity * sizeof(SyncDestEntry));
+	for(i=0; i < PTP_MAX_MESSAGE_INDEXED; i++) {
+	    ptpClock->activeGrants[i].count = 0;
+	}
+	ptpClock->grantIndex.portMask = rtOpts->unicastPortMask;
+	ptpClock->grantIndex.used = (destinations != NULL) ? nodeCount : 0;
+	resetUnicastWheel(&ptpClock->syncWheel, rtOpts->unicastTxSpread);
+	resetUnicastWheel(&ptpClock->announceWheel, rtOpts->unicastTxSpread);
     }
 
-    ptpClock->grantIndex.portMask = rtOpts->unicastPortMask;
-
     for(j=0; j<nodeCount; j++) {   
 
 	nodeTable = &grantTable[j];
@@ -849,6 +1338,9 @@ initUnicastGrantTable(UnicastGrantTable *grantTable, Enumeration8 delayMechanism
 
     }
 
+    if(grantTable == ptpClock->unicastGrants) {
+	rebuildUnicastIndex(&ptpClock->grantIndex);
+    }
 
 }
 
@@ -1206,6 +1698,7 @@ refreshUnicastGrants(UnicastGrantTable *grantTable, int nodeCount, const RunTime
     UnicastGrantData *grantData = NULL;
     UnicastGrantTable *nodeTable = NULL;
     Boolean actionRequired;
+    Boolean nodesFreed = FALSE;
     int maxTime = 0;
 
     /* modulo N counter: used for requesting announce while other master is selected */
@@ -1317,12 +1810,23 @@ refreshUnicastGrants(UnicastGrantTable *grantTable, int nodeCount, const RunTime
 	    /* Reggae version:     Matic in dem way, chopper in dem hand, hey, some a dem have M16 'pon dem shoulder */
 	    /* Factual version:    Make sure the node is re-usable: reset PortIdentity to all-ones again */
 	    if(nodeTable->timeLeft == 0) {
+		if(!grantIdentityUnset(&nodeTable->portIdentity)) {
+		    nodesFreed = TRUE;
+		}
 		nodeTable->portIdentity.portNumber = 0xFFFF;
 		memset(&nodeTable->portIdentity.clockIdentity, 0xFF, CLOCK_IDENTITY_LENGTH);
 		DBG("Unicast node %d now free and reusable\n", j);
 	    }
 	}
 
+	if(grantTable == ptpClock->unicastGrants) {
+	    pruneUnicastGrantLists(ptpClock);
+	    /* freed nodes leave stale port identities behind in the index */
+	    if(nodesFreed) {
+		rebuildUnicastIndex(&ptpClock->grantIndex);
+	    }
+	}
+
 	if(nodeCount == 1 && nodeTable && nodeTable->isPeer) {
 		return;
 	}
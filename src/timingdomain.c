@@ -24,6 +24,7 @@ static int ntpServiceAcquire (TimingService* service);
 static int ntpServiceRelease (TimingService* service, int reason);
 static int ntpServiceUpdate (TimingService* service);
 static int ntpServiceClockUpdate (TimingService* service);
+static void ntpServiceResponse (NTPcontrol *controller, int reqcode, int result);
 
 
 static int timingDomainInit(TimingDomain *domain);
@@ -493,6 +494,7 @@ ntpServiceInit (TimingService* service)
 {
 	NTPoptions *config = (NTPoptions*) service->config;
 	NTPcontrol *controller = (NTPcontrol*) service->controller;
+	Boolean started;
 
 	INFO_LOCAL_ID(service,"NTP service init\n");
 
@@ -503,7 +505,10 @@ ntpServiceInit (TimingService* service)
 	    return 1;
 	}
 
-	if(ntpInit(config, controller)) {
+	started = ntpInit(config, controller);
+	controller->onResponse = ntpServiceResponse;
+
+	if(started) {
 	    FLAGS_SET(service->flags, TIMINGSERVICE_OPERATIONAL);
 	    INFO_LOCAL_ID(service,"NTP service started\n");
 	    return 1;
@@ -526,14 +531,20 @@ ntpServiceShutdown (TimingService* service)
 
 	if(controller->flagsCaptured) {
 	    INFO_LOCAL_ID(service,"Restoring original NTP state\n");
-	    ntpShutdown(config, controller);
 	}
 
+	/* restores the flags if captured, and closes the control socket */
+	ntpShutdown(config, controller);
+
 	FLAGS_UNSET(service->flags, TIMINGSERVICE_OPERATIONAL);
 	FLAGS_UNSET(service->flags, TIMINGSERVICE_AVAILABLE);
 	return 1;
 }
 
+/*
+ * Requests to ntpd do not block: acquire, release and update only send them,
+ * and the main loop hands the results to ntpServiceResponse() as they arrive.
+ */
 static int
 ntpServiceAcquire (TimingService* service)
 {
@@ -549,10 +560,7 @@ ntpServiceAcquire (TimingService* service)
 	}
 
 	switch(ntpdSetFlags(config, controller, SYS_FLAG_KERNEL | SYS_FLAG_NTP)) {
-		case INFO_OKAY:
-			FLAGS_SET(service->flags, TIMINGSERVICE_IN_CONTROL);
-			controller->requestFailed = FALSE;
-			INFO_LOCAL_ID(service, "acquired clock control\n");
+		case NTPCONTROL_PENDING:
 			return 1;
 		default:
 			if (!controller->requestFailed) {
@@ -580,14 +588,14 @@ ntpServiceRelease (TimingService* service, int reason)
 		return 1;
 	}
 
+	/* the domain marks the service released before the response arrives */
+	controller->releaseReason = reason;
+	controller->logRelease = !service->released;
+
 	res = ntpdClearFlags(config, controller, SYS_FLAG_KERNEL | SYS_FLAG_NTP);
 
 	switch(res) {
-		case INFO_OKAY:
-			controller->requestFailed = FALSE;
-			if(!service->released) INFO_LOCAL_ID(service, "released clock control, reason: %s\n",
-				reasonToString(reason));
-			FLAGS_UNSET(service->flags, TIMINGSERVICE_IN_CONTROL);
+		case NTPCONTROL_PENDING:
 			return 1;
 		default:
 			if(!controller->requestFailed) {
@@ -604,8 +612,6 @@ static int
 ntpServiceUpdate (TimingService* service)
 {
 
-	int res;
-
 	NTPoptions *config = (NTPoptions*) service->config;
 	NTPcontrol *controller = (NTPcontrol*) service->controller;
 
@@ -613,39 +619,99 @@ ntpServiceUpdate (TimingService* service)
 		return 0;
 	}
 
-	res = ntpdInControl(config, controller);
-
-	if (res != INFO_YES && res != INFO_NO) {
-		if(!controller->checkFailed) {
-		    WARNING_LOCAL_ID(service,"Could not verify NTP status  - will keep checking\n");
-		}
-		controller->checkFailed = TRUE;
-		FLAGS_UNSET(service->flags, TIMINGSERVICE_OPERATIONAL);
-		FLAGS_UNSET(service->flags, TIMINGSERVICE_AVAILABLE);
+	if (ntpdInControl(config, controller) != NTPCONTROL_PENDING) {
+		ntpServiceResponse(controller, REQ_SYS_INFO, -1);
 		return 0;
 	}
 
-	FLAGS_SET(service->flags, TIMINGSERVICE_OPERATIONAL);
+	return 1;
+}
+
+static void
+ntpServiceResponse (NTPcontrol *controller, int reqcode, int result)
+{
 
-	if(service->flags & TIMINGSERVICE_AVAILABLE) {
-	    service->activity = TRUE;
-	} else {
-	    controller->checkFailed = FALSE;
-	    INFO_LOCAL_ID(service,"now available\n");
-	    FLAGS_SET(service->flags, TIMINGSERVICE_AVAILABLE);
-        }
+	TimingService *service = &controller->timingService;
 
-	/*
-	 * notify the service that we are in control,
-	 * so that the watchdog can react if we are and it wasn't granted
-	 */
-	if (res == INFO_YES) {
-	    FLAGS_SET(service->flags, TIMINGSERVICE_IN_CONTROL);
-	}
+	switch(reqcode) {
 
-	controller->checkFailed = FALSE;
+	case REQ_SYS_INFO:
+
+		if (result != INFO_YES && result != INFO_NO) {
+			if(!controller->checkFailed) {
+			    WARNING_LOCAL_ID(service,"Could not verify NTP status  - will keep checking\n");
+			}
+			controller->checkFailed = TRUE;
+			FLAGS_UNSET(service->flags, TIMINGSERVICE_OPERATIONAL);
+			FLAGS_UNSET(service->flags, TIMINGSERVICE_AVAILABLE);
+			return;
+		}
+
+		FLAGS_SET(service->flags, TIMINGSERVICE_OPERATIONAL);
+
+		if(service->flags & TIMINGSERVICE_AVAILABLE) {
+		    service->activity = TRUE;
+		} else {
+		    controller->checkFailed = FALSE;
+		    INFO_LOCAL_ID(service,"now available\n");
+		    FLAGS_SET(service->flags, TIMINGSERVICE_AVAILABLE);
+		}
+
+		/*
+		 * notify the service that we are in control,
+		 * so that the watchdog can react if we are and it wasn't granted
+		 */
+		if (result == INFO_YES) {
+		    FLAGS_SET(service->flags, TIMINGSERVICE_IN_CONTROL);
+		}
+
+		controller->checkFailed = FALSE;
+		return;
+
+	case REQ_SET_SYS_FLAG:
+
+		/* released again while acquiring - the release was sent last and wins */
+		if(ntpdRequestPending(controller, REQ_CLR_SYS_FLAG)) {
+			return;
+		}
+
+		if(result == INFO_OKAY) {
+			FLAGS_SET(service->flags, TIMINGSERVICE_IN_CONTROL);
+			controller->requestFailed = FALSE;
+			INFO_LOCAL_ID(service, "acquired clock control\n");
+		} else {
+			if (!controller->requestFailed) {
+			    WARNING_LOCAL_ID(service,"failed to acquire clock control - clock may drift!\n");
+			}
+			controller->requestFailed = TRUE;
+		}
+		return;
+
+	case REQ_CLR_SYS_FLAG:
+
+		if(ntpdRequestPending(controller, REQ_SET_SYS_FLAG)) {
+			return;
+		}
+
+		if(result == INFO_OKAY) {
+			controller->requestFailed = FALSE;
+			if(controller->logRelease) INFO_LOCAL_ID(service, "released clock control, reason: %s\n",
+				reasonToString(controller->releaseReason));
+			FLAGS_UNSET(service->flags, TIMINGSERVICE_IN_CONTROL);
+		} else {
+			if(!controller->requestFailed) {
+			    WARNING_LOCAL_ID(service,"failed to release clock control, reason: %s - clock may be unstable!\n",
+				reasonToString(controller->releaseReason));
+			}
+			controller->requestFailed = TRUE;
+		}
+		return;
+
+	default:
+		return;
+
+	}
 
-	return 1;
 }
 
 static int
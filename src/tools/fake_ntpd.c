@@ -0,0 +1,253 @@
+/*-
+ * Copyright (c) 2026 PTPd contributors,
+ *
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file   fake_ntpd.c
+ * @date   Sun Oct 18 09:30:26 2026
+ *
+ * @brief  Minimal ntpd mode 7 responder for testing NTP control
+ *
+ * Answers the three requests ptpd's NTP control sends - REQ_SYS_INFO,
+ * REQ_SET_SYS_FLAG and REQ_CLR_SYS_FLAG - keeping the ntp and kernel
+ * system flags it is told to set and clear, and rejects anything else
+ * with INFO_ERR_REQ. Responses can be delayed and the first requests
+ * dropped, to exercise the asynchronous request, retransmission and
+ * timeout handling with both the select() and the epoll receive paths.
+ * Every request is printed. Requests are not authenticated.
+ *
+ * ptpd always talks to port 123, so this has to replace ntpd - run it
+ * in a network namespace, see test/testing.org.
+ */
+
+#include "../ptpd.h"
+
+#include <poll.h>
+
+/* the port ntpdcontrol.c sends to */
+#define NTP_PORT	123
+#define MAX_PENDING	64
+
+typedef struct {
+	struct timespec due;
+	struct sockaddr_in addr;
+	struct resp_pkt resp;
+	int length;
+} PendingResponse;
+
+static PendingResponse pending[MAX_PENDING];
+static int pendingCount = 0;
+
+static void
+usage(const char *name)
+{
+	fprintf(stderr,
+	"usage: %s [-d delay_ms] [-n drop_first] [-f flags]\n"
+	"  -d  delay every response by this many milliseconds (default 0)\n"
+	"  -n  drop the first n requests without answering (default 0)\n"
+	"  -f  initial system flags (default 0x0c: ntp and kernel)\n", name);
+}
+
+static void
+addMs(struct timespec *ts, long ms)
+{
+	ts->tv_sec += ms / 1000;
+	ts->tv_nsec += (ms % 1000) * 1000000;
+	if(ts->tv_nsec >= 1000000000) {
+		ts->tv_sec++;
+		ts->tv_nsec -= 1000000000;
+	}
+}
+
+/* milliseconds from now until ts, at least 0 */
+static int
+msUntil(const struct timespec *ts)
+{
+	struct timespec now;
+	long ms;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	ms = (ts->tv_sec - now.tv_sec) * 1000 + (ts->tv_nsec - now.tv_nsec) / 1000000;
+	return (ms > 0) ? (int)ms : 0;
+}
+
+/* build the response to a request, returns its length or 0 to ignore the request */
+static int
+buildResponse(const struct req_pkt *req, int length, struct resp_pkt *resp, uint8_t *flags)
+{
+
+	struct info_sys *is = (struct info_sys*)resp->data;
+	struct conf_sys_flags sys;
+	int items = 0, itemSize = 0, err = INFO_OKAY;
+
+	if(length < REQ_LEN_HDR || ISRESPONSE(req->rm_vn_mode) ||
+	    INFO_MODE(req->rm_vn_mode) != MODE_PRIVATE) {
+		return 0;
+	}
+
+	memset(resp, 0, sizeof(*resp));
+
+	switch(req->request) {
+	    case REQ_SYS_INFO:
+		items = 1;
+		itemSize = sizeof(struct info_sys);
+		is->stratum = 2;
+		is->flags = *flags;
+		break;
+	    case REQ_SET_SYS_FLAG:
+	    case REQ_CLR_SYS_FLAG:
+		if(length < REQ_LEN_HDR + sizeof(sys)) {
+			err = INFO_ERR_FMT;
+			break;
+		}
+		memcpy(&sys, req->data, sizeof(sys));
+		sys.flags = ntohl(sys.flags) & (SYS_FLAG_NTP | SYS_FLAG_KERNEL);
+		if(req->request == REQ_SET_SYS_FLAG) {
+			*flags |= sys.flags;
+		} else {
+			*flags &= ~sys.flags;
+		}
+		printf("  flags now 0x%02x\n", *flags);
+		break;
+	    default:
+		err = INFO_ERR_REQ;
+		break;
+	}
+
+	resp->rm_vn_mode = RM_VN_MODE(1, 0, INFO_VERSION(req->rm_vn_mode));
+	resp->auth_seq = AUTH_SEQ(0, 0);
+	resp->implementation = req->implementation;
+	resp->request = req->request;
+	resp->err_nitems = ERR_NITEMS(err, items);
+	resp->mbz_itemsize = MBZ_ITEMSIZE(itemSize);
+
+	return RESP_HEADER_SIZE + items * itemSize;
+
+}
+
+int
+main(int argc, char **argv)
+{
+
+	struct sockaddr_in addr;
+	struct req_pkt req;
+	struct pollfd pfd;
+	socklen_t addrLen;
+	PendingResponse *resp;
+	uint8_t flags = INFO_FLAG_NTP | INFO_FLAG_KERNEL;
+	int delayMs = 0, drop = 0;
+	int sock, c, length, timeout;
+	int received = 0;
+
+	while((c = getopt(argc, argv, "d:n:f:h")) != -1) {
+		switch(c) {
+		    case 'd':
+			delayMs = atoi(optarg);
+			break;
+		    case 'n':
+			drop = atoi(optarg);
+			break;
+		    case 'f':
+			flags = strtoul(optarg, NULL, 0);
+			break;
+		    default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if((sock = socket(PF_INET, SOCK_DGRAM, IPPROTO_UDP)) < 0) {
+		perror("socket");
+		return 1;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(NTP_PORT);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	if(bind(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+		perror("bind");
+		return 1;
+	}
+
+	setvbuf(stdout, NULL, _IOLBF, 0);
+	printf("answering on 127.0.0.1:%d, delay %d ms, dropping the first %d requests\n",
+	    NTP_PORT, delayMs, drop);
+
+	pfd.fd = sock;
+	pfd.events = POLLIN;
+
+	for(;;) {
+
+		/* responses are queued in arrival order, all with the same delay */
+		timeout = pendingCount ? msUntil(&pending[0].due) : -1;
+
+		if(poll(&pfd, 1, timeout) < 0 && errno != EINTR) {
+			perror("poll");
+			return 1;
+		}
+
+		while(pendingCount && msUntil(&pending[0].due) == 0) {
+			if(sendto(sock, &pending[0].resp, pending[0].length, 0,
+			    (struct sockaddr*)&pending[0].addr, sizeof(pending[0].addr)) < 0) {
+				perror("sendto");
+			}
+			memmove(pending, pending + 1, --pendingCount * sizeof(PendingResponse));
+		}
+
+		if(!(pfd.revents & POLLIN)) {
+			continue;
+		}
+
+		addrLen = sizeof(addr);
+		length = recvfrom(sock, &req, sizeof(req), 0, (struct sockaddr*)&addr, &addrLen);
+		if(length < 0) {
+			continue;
+		}
+
+		received++;
+		printf("request %d, %d bytes, #%d%s\n", length >= REQ_LEN_HDR ? req.request : -1,
+		    length, received, (received <= drop) ? " - dropped" : "");
+
+		if(received <= drop || pendingCount == MAX_PENDING) {
+			continue;
+		}
+
+		resp = &pending[pendingCount];
+		if((resp->length = buildResponse(&req, length, &resp->resp, &flags)) == 0) {
+			continue;
+		}
+		resp->addr = addr;
+		clock_gettime(CLOCK_MONOTONIC, &resp->due);
+		addMs(&resp->due, delayMs);
+		pendingCount++;
+
+	}
+
+	return 0;
+
+}
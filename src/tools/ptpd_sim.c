@@ -0,0 +1,1154 @@
+/*-
+ * Copyright (c) 2026 PTPd contributors,
+ *
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file   ptpd_sim.c
+ * @date   Sun Oct 18 07:43:08 2026
+ *
+ * @brief  Deterministic clock synchronisation simulator
+ *
+ * Runs a chain of virtual clocks - a grandmaster, any number of boundary
+ * clocks and a slave - connected by virtual links, faster than real time.
+ * Each link has a delay, an asymmetry, exponentially distributed queueing
+ * jitter and packet loss. Each clock has a random initial phase and
+ * frequency error plus random walk frequency wander, and timestamps can be
+ * quantised to a hardware clock resolution.
+ *
+ * Every clock below the grandmaster runs the E2E offset and delay
+ * computation of dep/servo.c against its parent, through ptpd's own stat
+ * filters, outlier filters, offset and delay arithmetic (dep/servoarith.c)
+ * and PI servo, all linked in from the daemon sources, so servo and filter
+ * changes can be compared without hardware.
+ * The protocol engine itself is not simulated: it is built around a
+ * single global clock and real sockets.
+ *
+ * The same seed gives the same run, bit for bit.
+ *
+ * With -p, the slave is fed a pcap-ng capture written by ptpd
+ * (global:capture_file) instead of a simulated master: the recorded clock's
+ * frequency adjustments are taken out of its timestamps and the simulated
+ * servo's put in, so a captured day can be run through different servo and
+ * filter settings.
+ */
+
+#include "../ptpd.h"
+
+/* nanoseconds */
+#define SIM_SECOND	1000000000LL
+
+typedef struct {
+	/* virtual clock: phase (ns ahead of true time) as of lastUpdate, frequency offset in ppb */
+	double phase;
+	int64_t lastUpdate;
+	double freqError;
+	double freqAdj;
+
+	/* E2E state, as in PtpClock */
+	Boolean offsetFirstUpdated;
+	ScaledNanoseconds delayMS;
+	Integer32 meanPathDelay;
+	Integer32 offsetFromMaster;
+	offset_from_master_filter ofmFilter;
+	one_way_delay_filter mpdIirFilter;
+
+	DoubleMovingStatFilter *filterMS;
+	DoubleMovingStatFilter *filterSM;
+	OutlierFilter oFilterMS;
+	OutlierFilter oFilterSM;
+	ClockDriver driver;		/* only holds the servo and its name */
+
+	/* results */
+	uint32_t messages;
+	uint32_t lost;
+	uint32_t steps;
+	double processingTime;
+	int64_t insideSince;		/* start of the current run of offsets within the threshold, -1 if outside */
+	int64_t convergedAt;		/* first run within the threshold that lasted the settling time, -1 if none */
+	double sumSquares;
+	double maxOffset;
+	uint32_t samples;
+	double lastOffset;
+} SimNode;
+
+typedef struct {
+	int nodes;
+	double duration;
+	int logSyncInterval;
+	int logDelayReqInterval;
+	double delay;
+	double asymmetry;
+	double jitter;
+	double loss;
+	double maxFreqError;
+	double maxPhase;
+	double wander;
+	double resolution;
+	double kP;
+	double kI;
+	int filterType;
+	int filterWindow;
+	Boolean outlierFilter;
+	double threshold;
+	double settle;
+	uint64_t seed;
+	Boolean trace;
+	Boolean verbose;
+	const char *replayFile;
+} SimConfig;
+
+/* replay: what we know about the captured exchange */
+typedef struct {
+	uint16_t linkType;
+	int64_t tsUnit;			/* capture timestamp unit in ns */
+	Boolean started;
+	int64_t base;			/* first event timestamp: times are kept relative to this */
+	Boolean haveParent;
+	uint8_t parent[10];		/* port identity of the first Sync's sender */
+	uint8_t domain;
+	Boolean haveSelf;
+	uint8_t self[10];		/* our port identity, from our Delay_Req */
+	Boolean syncPending;
+	uint16_t syncSequence;
+	double t2;
+	ScaledNanoseconds syncCorrection;
+	double syncInterval;
+	Boolean delayPending;
+	uint16_t delaySequence;
+	double t3;
+	uint32_t packets;
+	uint32_t syncs;
+	uint32_t delays;
+	int64_t last;			/* last timestamp seen */
+} ReplayState;
+
+static SimConfig sim;
+static uint64_t prngState;
+
+/*
+ * The simulator links in the servo and filters only. These stand in for
+ * the parts of the daemon they would otherwise pull in.
+ */
+void
+logMessage(int priority, const char *format, ...)
+{
+
+	va_list ap;
+
+	if(!sim.verbose) {
+		return;
+	}
+
+	va_start(ap, format);
+	vfprintf(stderr, format, ap);
+	va_end(ap);
+
+}
+
+/* only used by DT_MEASURED servo timing, the simulator uses DT_CONSTANT */
+ClockDriver*
+getSystemClock()
+{
+	return NULL;
+}
+
+/* xorshift64*: fast, and the same sequence on every platform */
+static double
+randomUniform(void)
+{
+
+	prngState ^= prngState >> 12;
+	prngState ^= prngState << 25;
+	prngState ^= prngState >> 27;
+
+	return ((prngState * 0x2545F4914F6CDD1DULL) >> 11) * (1.0 / 9007199254740992.0);
+
+}
+
+static double
+randomNormal(void)
+{
+
+	double u = randomUniform();
+
+	while(u <= 0.0) {
+		u = randomUniform();
+	}
+
+	return sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * randomUniform());
+
+}
+
+static double
+randomExponential(double mean)
+{
+
+	double u = randomUniform();
+
+	if(mean <= 0.0) {
+		return 0.0;
+	}
+
+	while(u <= 0.0) {
+		u = randomUniform();
+	}
+
+	return -mean * log(u);
+
+}
+
+/* time shown by a node's clock at true time t - the grandmaster is perfect */
+static double
+clockTime(SimNode *node, int64_t t)
+{
+
+	double ts = t + node->phase + (node->freqError + node->freqAdj) * (t - node->lastUpdate) / SIM_SECOND;
+
+	if(sim.resolution > 0.0) {
+		ts = floor(ts / sim.resolution) * sim.resolution;
+	}
+
+	return ts;
+
+}
+
+/* move the clock's reference point to t, so the frequency can be changed from there on */
+static void
+advanceClock(SimNode *node, int64_t t)
+{
+
+	double dt = (double)(t - node->lastUpdate) / SIM_SECOND;
+
+	node->phase += (node->freqError + node->freqAdj) * dt;
+	node->lastUpdate = t;
+
+	if(sim.wander > 0.0 && dt > 0.0) {
+		node->freqError += sim.wander * sqrt(dt) * randomNormal();
+	}
+
+}
+
+/* one way link delay in ns, -1 if the message was lost */
+static double
+linkDelay(Boolean masterToSlave)
+{
+
+	if(sim.loss > 0.0 && randomUniform() * 100.0 < sim.loss) {
+		return -1.0;
+	}
+
+	return sim.delay + (masterToSlave ? sim.asymmetry : -sim.asymmetry) / 2.0
+		+ randomExponential(sim.jitter);
+
+}
+
+static void
+resetNode(SimNode *node)
+{
+
+	node->offsetFirstUpdated = FALSE;
+	node->delayMS = 0;
+	node->meanPathDelay = 0;
+	node->offsetFromMaster = 0;
+	memset(&node->ofmFilter, 0, sizeof(node->ofmFilter));
+	memset(&node->mpdIirFilter, 0, sizeof(node->mpdIirFilter));
+
+	resetDoubleMovingStatFilter(node->filterMS);
+	resetDoubleMovingStatFilter(node->filterSM);
+	if(node->oFilterMS.config.enabled) {
+		node->oFilterMS.reset(&node->oFilterMS);
+		node->oFilterSM.reset(&node->oFilterSM);
+	}
+
+}
+
+static void
+initNode(SimNode *node, int index)
+{
+
+	StatFilterOptions filterOpts;
+	OutlierFilterConfig oFilterConfig;
+
+	memset(node, 0, sizeof(SimNode));
+	node->insideSince = -1;
+	node->convergedAt = -1;
+
+	if(index == 0) {
+		return;
+	}
+
+	node->phase = (2.0 * randomUniform() - 1.0) * sim.maxPhase;
+	node->freqError = (2.0 * randomUniform() - 1.0) * sim.maxFreqError;
+
+	/* as configured by the stat filter settings and configdefaults.c */
+	memset(&filterOpts, 0, sizeof(filterOpts));
+	filterOpts.enabled = (sim.filterType != FILTER_NONE);
+	filterOpts.filterType = sim.filterType;
+	filterOpts.windowSize = sim.filterWindow;
+	filterOpts.windowType = WINDOW_SLIDING;
+
+	if(filterOpts.enabled) {
+		node->filterMS = createDoubleMovingStatFilter(&filterOpts, "delayMS");
+		node->filterSM = createDoubleMovingStatFilter(&filterOpts, "delaySM");
+	}
+
+	memset(&oFilterConfig, 0, sizeof(oFilterConfig));
+	oFilterConfig.enabled = sim.outlierFilter;
+	oFilterConfig.discard = TRUE;
+	oFilterConfig.autoTune = TRUE;
+	oFilterConfig.stepThreshold = 1000000;
+	oFilterConfig.stepLevel = 500000;
+	oFilterConfig.capacity = 20;
+	oFilterConfig.threshold = 2.0;
+	oFilterConfig.weight = 1;
+	oFilterConfig.minPercent = 20;
+	oFilterConfig.maxPercent = 95;
+	oFilterConfig.thresholdStep = 0.1;
+	oFilterConfig.minThreshold = 1.5;
+	oFilterConfig.maxThreshold = 5.0;
+	oFilterConfig.delayCredit = 200;
+	oFilterConfig.creditIncrement = 10;
+	oFilterConfig.maxDelay = 1500;
+
+	outlierFilterSetup(&node->oFilterMS);
+	outlierFilterSetup(&node->oFilterSM);
+	node->oFilterMS.init(&node->oFilterMS, &oFilterConfig, "delayMS");
+	node->oFilterSM.init(&node->oFilterSM, &oFilterConfig, "delaySM");
+
+	snprintf(node->driver.name, CLOCKDRIVER_NAME_MAX, "node%d", index);
+	setupPIservo(&node->driver.servo);
+	node->driver.servo.controller = &node->driver;
+	node->driver.servo.kP = sim.kP;
+	node->driver.servo.kI = sim.kI;
+	node->driver.servo.maxOutput = ADJ_FREQ_MAX;
+	node->driver.servo.tauMethod = DT_CONSTANT;
+	node->driver.servo.maxTau = 5;
+	if(filterOpts.enabled) {
+		node->driver.servo.delayFactor = sim.filterWindow;
+	}
+
+}
+
+static void
+freeNode(SimNode *node)
+{
+
+	freeDoubleMovingStatFilter(&node->filterMS);
+	freeDoubleMovingStatFilter(&node->filterSM);
+	if(node->oFilterMS.config.enabled) {
+		node->oFilterMS.shutdown(&node->oFilterMS);
+		node->oFilterSM.shutdown(&node->oFilterSM);
+	}
+
+}
+
+/* updateOffset() + updateClock(), t1 and t2 in ns */
+static void
+processSync(SimNode *node, double t1, double t2, ScaledNanoseconds correction, double dT)
+{
+
+	ScaledNanoseconds delayMS = doubleToScaled((t2 - t1) / 1E9);
+	ScaledNanoseconds offset;
+
+	if(node->filterMS != NULL) {
+		if(!feedDoubleMovingStatFilter(node->filterMS, scaledToDouble(delayMS))) {
+			return;
+		}
+		delayMS = doubleToScaled(node->filterMS->output);
+	}
+
+	if(node->oFilterMS.config.enabled && (node->oFilterMS.config.alwaysFilter || !node->driver.servo.runningMaxOutput)) {
+		if(!node->oFilterMS.filter(&node->oFilterMS, scaledToDouble(delayMS))) {
+			return;
+		}
+		delayMS = doubleToScaled(node->oFilterMS.output);
+	}
+
+	delayMS = correctedDelay(delayMS, correction);
+
+	/* correctionField out of range: updateOffset() ignores the sync */
+	if(llabs(delayMS) == INT64_MAX) {
+		return;
+	}
+
+	node->delayMS = delayMS;
+	offset = scaledSub(node->delayMS, node->meanPathDelay * SCALED_NS_ONE);
+
+	/* beyond what Integer32 nanoseconds can take: step, as the clock driver would */
+	if(llabs(offset) >= SCALED_NS_SECOND) {
+		node->phase -= scaledToNs(offset);
+		node->steps++;
+		resetNode(node);
+		return;
+	}
+
+	node->offsetFromMaster = filterOffsetFromMaster(&node->ofmFilter, scaledToNs(offset));
+	node->offsetFirstUpdated = TRUE;
+
+	/* as syncClockExternal(): the servo is fed master - slave */
+	node->driver.servo.feed(&node->driver.servo, -node->offsetFromMaster, dT);
+	node->freqAdj = node->driver.servo.output;
+
+}
+
+/* updateDelay(), t3 and t4 in ns */
+static void
+processDelayResp(SimNode *node, double t3, double t4, ScaledNanoseconds correction)
+{
+
+	ScaledNanoseconds delaySM = doubleToScaled((t4 - t3) / 1E9);
+	ScaledNanoseconds mpd;
+
+	if(!node->offsetFirstUpdated) {
+		return;
+	}
+
+	if(node->filterSM != NULL) {
+		if(!feedDoubleMovingStatFilter(node->filterSM, scaledToDouble(delaySM))) {
+			return;
+		}
+		delaySM = doubleToScaled(node->filterSM->output);
+	}
+
+	if(node->oFilterMS.config.enabled && node->oFilterMS.lastOutlier) {
+		return;
+	}
+
+	if(node->oFilterSM.config.enabled && (node->oFilterSM.config.alwaysFilter || !node->driver.servo.runningMaxOutput)) {
+		if(!node->oFilterSM.filter(&node->oFilterSM, scaledToDouble(delaySM))) {
+			return;
+		}
+		delaySM = doubleToScaled(node->oFilterSM.output);
+	}
+
+	mpd = calcMeanPathDelay(node->delayMS, delaySM, correction);
+
+	if(llabs(mpd) >= SCALED_NS_SECOND) {
+		node->mpdIirFilter.s_exp = node->mpdIirFilter.nsec_prev = 0;
+		return;
+	}
+
+	if(scaledToNs(mpd) < 0) {
+		return;
+	}
+
+	node->meanPathDelay = filterMeanPathDelay(&node->mpdIirFilter, scaledToNs(mpd), DEFAULT_DELAY_S);
+
+}
+
+static double
+elapsed(const struct timespec *start)
+{
+
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (now.tv_sec - start->tv_sec) * 1E9 + (now.tv_nsec - start->tv_nsec);
+
+}
+
+/* convergence and offset statistics, one sample per sync */
+static void
+recordOffset(SimNode *node, int index, int64_t t, double offset)
+{
+
+	node->lastOffset = offset;
+
+	if(fabs(offset) > sim.threshold) {
+		node->insideSince = -1;
+	} else if(node->insideSince < 0) {
+		node->insideSince = t;
+	}
+
+	if(node->convergedAt < 0 && node->insideSince >= 0 &&
+	    t - node->insideSince >= sim.settle * SIM_SECOND) {
+		node->convergedAt = node->insideSince;
+	}
+
+	/* rms and max from the moment of convergence, excursions included */
+	if(node->convergedAt >= 0) {
+		node->sumSquares += offset * offset;
+		node->maxOffset = max(node->maxOffset, fabs(offset));
+		node->samples++;
+	}
+
+	if(sim.trace) {
+		printf("%.06f, %d, %.01f, %d, %d, %.03f\n", (double)t / SIM_SECOND, index,
+			offset, node->offsetFromMaster, node->meanPathDelay, node->freqAdj);
+	}
+
+}
+
+static void
+syncExchange(SimNode *parent, SimNode *node, int index, int64_t t)
+{
+
+	double d = linkDelay(TRUE);
+	double t1, t2;
+	struct timespec start;
+
+	advanceClock(node, t);
+
+	if(d < 0.0) {
+		node->lost++;
+	} else {
+		t1 = clockTime(parent, t);
+		t2 = clockTime(node, t + (int64_t)d);
+		node->messages++;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		processSync(node, t1, t2, 0, pow(2, sim.logSyncInterval));
+		node->processingTime += elapsed(&start);
+	}
+
+	/* node's clock against the grandmaster, i.e. true time */
+	recordOffset(node, index, t, node->phase);
+
+}
+
+static void
+delayExchange(SimNode *parent, SimNode *node, int64_t t)
+{
+
+	double d = linkDelay(FALSE);
+	double t3, t4;
+	struct timespec start;
+
+	if(d < 0.0) {
+		node->lost++;
+		return;
+	}
+
+	t3 = clockTime(node, t);
+	t4 = clockTime(parent, t + (int64_t)d);
+	node->messages++;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	processDelayResp(node, t3, t4, 0);
+	node->processingTime += elapsed(&start);
+
+}
+
+static void
+report(SimNode *nodes)
+{
+
+	int i;
+	SimNode *node;
+
+	if(sim.replayFile == NULL) {
+		printf("# seed %llu, %d clocks, %.0f s, sync 2^%d s, delay_req 2^%d s\n",
+			(unsigned long long)sim.seed, sim.nodes, sim.duration,
+			sim.logSyncInterval, sim.logDelayReqInterval);
+		printf("# link delay %.0f ns, asymmetry %.0f ns, jitter %.0f ns, loss %.2f%%\n",
+			sim.delay, sim.asymmetry, sim.jitter, sim.loss);
+	}
+
+	for(i = 1; i < sim.nodes; i++) {
+		node = &nodes[i];
+		printf("%s %d: ", (i == sim.nodes - 1) ? "slave" : "bc", i);
+		if(node->samples == 0) {
+			printf("did not converge to %.0f ns, offset now %.0f ns", sim.threshold, node->lastOffset);
+		} else {
+			printf("converged to %.0f ns after %.1f s, then rms %.1f ns, max %.1f ns",
+				sim.threshold, (double)node->convergedAt / SIM_SECOND,
+				sqrt(node->sumSquares / node->samples), node->maxOffset);
+		}
+		printf(", mpd %d ns, %u messages, %u lost, %u steps, %.0f ns / message\n",
+			node->meanPathDelay, node->messages, node->lost, node->steps,
+			node->messages ? node->processingTime / node->messages : 0.0);
+	}
+
+}
+
+static uint16_t
+get16(const uint8_t *buf)
+{
+	return (buf[0] << 8) | buf[1];
+}
+
+static uint32_t
+get32(const uint8_t *buf)
+{
+	return ((uint32_t)get16(buf) << 16) | get16(buf + 2);
+}
+
+/* PTP timestamp (48-bit seconds, 32-bit nanoseconds) in ns relative to the capture start */
+static double
+ptpTime(const ReplayState *state, const uint8_t *buf)
+{
+
+	int64_t seconds = ((int64_t)get16(buf) << 32) | get32(buf + 2);
+
+	return (double)(seconds * SIM_SECOND + get32(buf + 6) - state->base);
+
+}
+
+/* correction field, scaled nanoseconds */
+static ScaledNanoseconds
+ptpCorrection(const uint8_t *buf)
+{
+
+	Integer64 correction;
+
+	correction.msb = get32(buf + 8);
+	correction.lsb = get32(buf + 12);
+
+	return integer64ToScaled(correction);
+
+}
+
+/* strip the link layer, IPv4 and UDP headers: returns the PTP message or NULL */
+static const uint8_t*
+ptpMessage(const ReplayState *state, const uint8_t *packet, uint32_t *length)
+{
+
+	uint16_t etherType = 0x0800;
+	uint32_t headerLength;
+
+	if(state->linkType == PCAPNG_LINKTYPE_ETHERNET) {
+		if(*length < 14) {
+			return NULL;
+		}
+		etherType = get16(packet + 12);
+		packet += 14;
+		*length -= 14;
+		/* 802.1Q tag */
+		if(etherType == 0x8100 && *length >= 4) {
+			etherType = get16(packet + 2);
+			packet += 4;
+			*length -= 4;
+		}
+		if(etherType == 0x88F7) {
+			return packet;
+		}
+	} else if(state->linkType != PCAPNG_LINKTYPE_IPV4) {
+		return NULL;
+	}
+
+	if(etherType != 0x0800 || *length < 28 || (packet[0] >> 4) != 4 || packet[9] != 17) {
+		return NULL;
+	}
+
+	headerLength = (packet[0] & 0x0F) * 4 + 8;
+	if(*length < headerLength) {
+		return NULL;
+	}
+
+	*length -= headerLength;
+	return packet + headerLength;
+
+}
+
+/* one message as ptpd saw it, t being its timestamp relative to the start of the capture */
+static void
+replayMessage(ReplayState *state, SimNode *node, const uint8_t *msg, uint32_t length,
+		int64_t t, Boolean outbound)
+{
+
+	uint8_t type = msg[0] & 0x0F;
+	Integer8 logInterval = (Integer8)msg[33];
+	double local, t1;
+	ScaledNanoseconds correction;
+	struct timespec start;
+
+	if(length < 44 || (msg[1] & 0x0F) != 2) {
+		return;
+	}
+
+	/* the first Sync chooses the master we follow */
+	if(!state->haveParent && type == SYNC && !outbound) {
+		memcpy(state->parent, msg + 20, 10);
+		state->domain = msg[4];
+		state->haveParent = TRUE;
+	}
+
+	if(!state->haveParent || msg[4] != state->domain) {
+		return;
+	}
+
+	/* the simulated clock: the recorded one plus whatever the servos did differently */
+	local = clockTime(node, t);
+
+	switch(type) {
+
+	case SYNC:
+		if(outbound || memcmp(msg + 20, state->parent, 10)) {
+			return;
+		}
+		state->syncInterval = (abs(logInterval) <= 7) ? pow(2, logInterval) :
+					pow(2, sim.logSyncInterval);
+		/* two-step: wait for the Follow_Up */
+		if(msg[6] & 0x02) {
+			state->syncPending = TRUE;
+			state->syncSequence = get16(msg + 30);
+			state->t2 = local;
+			state->syncCorrection = ptpCorrection(msg);
+			return;
+		}
+		state->syncPending = FALSE;
+		t1 = ptpTime(state, msg + 34);
+		correction = ptpCorrection(msg);
+		break;
+
+	case FOLLOW_UP:
+		if(outbound || memcmp(msg + 20, state->parent, 10) ||
+		    !state->syncPending || get16(msg + 30) != state->syncSequence) {
+			return;
+		}
+		state->syncPending = FALSE;
+		t1 = ptpTime(state, msg + 34);
+		correction = scaledAdd(state->syncCorrection, ptpCorrection(msg));
+		local = state->t2;
+		break;
+
+	case DELAY_REQ:
+		if(!outbound || (state->haveSelf && memcmp(msg + 20, state->self, 10))) {
+			return;
+		}
+		memcpy(state->self, msg + 20, 10);
+		state->haveSelf = TRUE;
+		state->delayPending = TRUE;
+		state->delaySequence = get16(msg + 30);
+		state->t3 = local;
+		return;
+
+	case DELAY_RESP:
+		if(outbound || length < 54 || memcmp(msg + 20, state->parent, 10) ||
+		    !state->delayPending || !state->haveSelf || memcmp(msg + 44, state->self, 10) ||
+		    get16(msg + 30) != state->delaySequence) {
+			return;
+		}
+		state->delayPending = FALSE;
+		state->delays++;
+		node->messages++;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		processDelayResp(node, state->t3, ptpTime(state, msg + 34), ptpCorrection(msg));
+		node->processingTime += elapsed(&start);
+		return;
+
+	default:
+		return;
+
+	}
+
+	state->syncs++;
+	node->messages++;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	processSync(node, t1, local, correction, state->syncInterval);
+	node->processingTime += elapsed(&start);
+
+	recordOffset(node, 1, t, node->offsetFromMaster);
+
+}
+
+/* enhanced packet block: direction and frequency adjustment from the options */
+static void
+replayPacket(ReplayState *state, SimNode *node, const uint8_t *block, uint32_t length)
+{
+
+	const PcapngEnhancedPacket *epb = (const PcapngEnhancedPacket*)block;
+	const uint8_t *option, *msg;
+	const PcapngOption *header;
+	uint32_t captured;
+	uint32_t flags = 0;
+	char comment[32];
+	Boolean haveFrequency = FALSE;
+	double frequency = 0.0;
+	int64_t t;
+
+	if(length < sizeof(PcapngEnhancedPacket)) {
+		return;
+	}
+
+	captured = epb->capturedLength;
+
+	if(sizeof(PcapngEnhancedPacket) + PCAPNG_PAD(captured) > length) {
+		return;
+	}
+
+	for(option = block + sizeof(PcapngEnhancedPacket) + PCAPNG_PAD(captured);
+	    option + sizeof(PcapngOption) <= block + length; ) {
+		header = (const PcapngOption*)option;
+		option += sizeof(PcapngOption);
+		if(header->code == PCAPNG_OPT_ENDOFOPT || option + header->length > block + length) {
+			break;
+		}
+		if(header->code == PCAPNG_OPT_EPB_FLAGS && header->length == 4) {
+			memcpy(&flags, option, 4);
+		}
+		if(header->code == PCAPNG_OPT_COMMENT && header->length < sizeof(comment) &&
+		    header->length > strlen(PCAPNG_COMMENT_FREQUENCY) &&
+		    !memcmp(option, PCAPNG_COMMENT_FREQUENCY, strlen(PCAPNG_COMMENT_FREQUENCY))) {
+			memcpy(comment, option, header->length);
+			comment[header->length] = '\0';
+			frequency = atof(comment + strlen(PCAPNG_COMMENT_FREQUENCY));
+			haveFrequency = TRUE;
+		}
+		option += PCAPNG_PAD(header->length);
+	}
+
+	if((msg = ptpMessage(state, block + sizeof(PcapngEnhancedPacket), &captured)) == NULL ||
+	    captured < 1) {
+		return;
+	}
+
+	t = (int64_t)(((uint64_t)epb->timestampHigh << 32) | epb->timestampLow) * state->tsUnit;
+
+	state->packets++;
+
+	/* only event messages are timestamped - others happened when the last one did */
+	if((msg[0] & 0x0F) < 0x08) {
+		if(!state->started) {
+			state->base = t;
+			state->started = TRUE;
+		}
+		if(t - state->base >= state->last) {
+			state->last = t - state->base;
+		}
+	}
+
+	if(!state->started) {
+		return;
+	}
+
+	t = state->last;
+
+	/*
+	 * Bring the simulated clock up to this packet with the adjustment recorded
+	 * so far, then take out the one the recorded clock now runs with.
+	 */
+	advanceClock(node, t);
+	if(haveFrequency) {
+		node->freqError = -frequency;
+	}
+
+	replayMessage(state, node, msg, captured, t, (flags & 0x03) == PCAPNG_EPB_OUTBOUND);
+
+}
+
+/* interface description block: link type and timestamp resolution */
+static void
+replayInterface(ReplayState *state, const uint8_t *block, uint32_t length)
+{
+
+	const PcapngInterfaceDescription *idb = (const PcapngInterfaceDescription*)block;
+	const uint8_t *option;
+	const PcapngOption *header;
+	int i;
+
+	state->linkType = idb->linkType;
+	/* pcap-ng default: microseconds */
+	state->tsUnit = 1000;
+
+	if(length < sizeof(PcapngInterfaceDescription)) {
+		return;
+	}
+
+	for(option = block + sizeof(PcapngInterfaceDescription);
+	    option + sizeof(PcapngOption) <= block + length; ) {
+		header = (const PcapngOption*)option;
+		option += sizeof(PcapngOption);
+		if(header->code == PCAPNG_OPT_ENDOFOPT || option + header->length > block + length) {
+			break;
+		}
+		/* only powers of 10, nanoseconds or coarser */
+		if(header->code == PCAPNG_OPT_IF_TSRESOL && header->length == 1 && option[0] <= 9) {
+			state->tsUnit = 1;
+			for(i = option[0]; i < 9; i++) {
+				state->tsUnit *= 10;
+			}
+		}
+		option += PCAPNG_PAD(header->length);
+	}
+
+}
+
+/* feed a capture file to the slave, block by block */
+static int
+replay(SimNode *node)
+{
+
+	FILE *fp;
+	ReplayState state;
+	uint32_t buf[65536 / sizeof(uint32_t)];
+	PcapngBlockHeader *block = (PcapngBlockHeader*)buf;
+	uint32_t length;
+	Boolean section = FALSE;
+
+	if((fp = fopen(sim.replayFile, "r")) == NULL) {
+		perror(sim.replayFile);
+		return 1;
+	}
+
+	memset(&state, 0, sizeof(state));
+
+	while(fread(block, sizeof(PcapngBlockHeader), 1, fp) == 1) {
+
+		length = block->length;
+
+		if(length < sizeof(PcapngBlockHeader) + sizeof(uint32_t) || length & 3) {
+			fprintf(stderr, "%s: corrupt block\n", sim.replayFile);
+			break;
+		}
+
+		if(length > sizeof(buf)) {
+			fseek(fp, length - sizeof(PcapngBlockHeader), SEEK_CUR);
+			continue;
+		}
+
+		if(fread(buf + 2, length - sizeof(PcapngBlockHeader), 1, fp) != 1) {
+			break;
+		}
+
+		/* leave out the trailing length copy */
+		length -= sizeof(uint32_t);
+
+		switch(block->type) {
+		case PCAPNG_BLOCK_SHB:
+			if(length < sizeof(PcapngBlockHeader) + 4 || buf[2] != PCAPNG_BYTE_ORDER_MAGIC) {
+				fprintf(stderr, "%s: byte order not supported\n", sim.replayFile);
+				fclose(fp);
+				return 1;
+			}
+			section = TRUE;
+			state.linkType = 0;
+			break;
+		case PCAPNG_BLOCK_IDB:
+			/* ptpd writes one interface per section */
+			replayInterface(&state, (uint8_t*)buf, length);
+			break;
+		case PCAPNG_BLOCK_EPB:
+			if(section) {
+				replayPacket(&state, node, (uint8_t*)buf, length);
+			}
+			break;
+		default:
+			break;
+		}
+
+	}
+
+	fclose(fp);
+
+	if(!section) {
+		fprintf(stderr, "%s: not a pcap-ng file\n", sim.replayFile);
+		return 1;
+	}
+
+	printf("# replay of %s: %u packets, %.0f s, %u syncs, %u delay exchanges\n",
+		sim.replayFile, state.packets, (double)state.last / SIM_SECOND,
+		state.syncs, state.delays);
+
+	return 0;
+
+}
+
+static int
+parseFilterType(const char *name)
+{
+
+	if(!strcmp(name, "none")) return FILTER_NONE;
+	if(!strcmp(name, "mean")) return FILTER_MEAN;
+	if(!strcmp(name, "min")) return FILTER_MIN;
+	if(!strcmp(name, "median")) return FILTER_MEDIAN;
+
+	return -1;
+
+}
+
+static void
+usage(const char *name)
+{
+	fprintf(stderr,
+	"usage: %s [options]\n"
+	"\n"
+	"Simulate a grandmaster, boundary clocks and a slave synchronising over\n"
+	"virtual links, using ptpd's filters and servo, faster than real time.\n"
+	"\n"
+	"  -n NUM     clocks in the chain, including the grandmaster (3)\n"
+	"  -d SEC     simulated duration (3600)\n"
+	"  -s LOG     log2 sync interval (0)\n"
+	"  -r LOG     log2 delay request interval (0)\n"
+	"  -D NS      one way link delay (10000)\n"
+	"  -a NS      asymmetry: master to slave minus slave to master delay (0)\n"
+	"  -j NS      mean exponential queueing jitter (500)\n"
+	"  -l PCT     packet loss (0)\n"
+	"  -f PPB     maximum initial frequency error (10000)\n"
+	"  -o NS      maximum initial phase offset (100000)\n"
+	"  -w PPB     frequency random walk per sqrt(second) (0.5)\n"
+	"  -R NS      timestamp resolution, 0 = exact (0)\n"
+	"  -P KP      servo kP (0.1)\n"
+	"  -I KI      servo kI (0.001)\n"
+	"  -F TYPE    delay stat filter: none, mean, min, median (none)\n"
+	"  -W NUM     stat filter window (5)\n"
+	"  -O         enable the delayMS / delaySM outlier filters\n"
+	"  -t NS      convergence threshold (1000)\n"
+	"  -T SEC     time the offset must stay within the threshold to count as converged (60)\n"
+	"  -S SEED    random seed (1)\n"
+	"  -c         print a CSV trace of every sync: time, clock, true offset, ofm, mpd, ppb\n"
+	"  -p FILE    replay a ptpd capture file (global:capture_file) into the slave\n"
+	"             instead of simulating a master: uses -P -I -F -W -O -t -T -s -c -v,\n"
+	"             the offset reported and traced is the offset from master\n"
+	"  -v         print servo and filter log messages\n",
+	name);
+}
+
+int
+main(int argc, char **argv)
+{
+
+	int c, i;
+	int64_t t, end, syncInterval, delayInterval, step;
+	SimNode *nodes;
+
+	sim.nodes = 3;
+	sim.duration = 3600;
+	sim.logSyncInterval = 0;
+	sim.logDelayReqInterval = 0;
+	sim.delay = 10000;
+	sim.asymmetry = 0;
+	sim.jitter = 500;
+	sim.loss = 0;
+	sim.maxFreqError = 10000;
+	sim.maxPhase = 100000;
+	sim.wander = 0.5;
+	sim.resolution = 0;
+	sim.kP = 0.1;
+	sim.kI = 0.001;
+	sim.filterType = FILTER_NONE;
+	sim.filterWindow = 5;
+	sim.threshold = 1000;
+	sim.settle = 60;
+	sim.seed = 1;
+
+	while((c = getopt(argc, argv, "n:d:s:r:D:a:j:l:f:o:w:R:P:I:F:W:Ot:T:S:cp:vh")) != -1) {
+		switch(c) {
+		case 'n': sim.nodes = atoi(optarg); break;
+		case 'd': sim.duration = atof(optarg); break;
+		case 's': sim.logSyncInterval = atoi(optarg); break;
+		case 'r': sim.logDelayReqInterval = atoi(optarg); break;
+		case 'D': sim.delay = atof(optarg); break;
+		case 'a': sim.asymmetry = atof(optarg); break;
+		case 'j': sim.jitter = atof(optarg); break;
+		case 'l': sim.loss = atof(optarg); break;
+		case 'f': sim.maxFreqError = atof(optarg); break;
+		case 'o': sim.maxPhase = atof(optarg); break;
+		case 'w': sim.wander = atof(optarg); break;
+		case 'R': sim.resolution = atof(optarg); break;
+		case 'P': sim.kP = atof(optarg); break;
+		case 'I': sim.kI = atof(optarg); break;
+		case 'F':
+			if((sim.filterType = parseFilterType(optarg)) < 0) {
+				usage(argv[0]);
+				return 1;
+			}
+			break;
+		case 'W': sim.filterWindow = atoi(optarg); break;
+		case 'O': sim.outlierFilter = TRUE; break;
+		case 't': sim.threshold = atof(optarg); break;
+		case 'T': sim.settle = atof(optarg); break;
+		case 'S': sim.seed = strtoull(optarg, NULL, 0); break;
+		case 'c': sim.trace = TRUE; break;
+		case 'p': sim.replayFile = optarg; break;
+		case 'v': sim.verbose = TRUE; break;
+		default:
+			usage(argv[0]);
+			return (c == 'h') ? 0 : 1;
+		}
+	}
+
+	if(sim.nodes < 2 || sim.duration <= 0 || sim.filterWindow < 1 ||
+	    abs(sim.logSyncInterval) > 7 || abs(sim.logDelayReqInterval) > 7) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	/* xorshift must not start from 0 */
+	prngState = sim.seed ? sim.seed : 0x9E3779B97F4A7C15ULL;
+
+	/* replay: a slave and the capture, the recorded clock brings its own phase, frequency and wander */
+	if(sim.replayFile != NULL) {
+		sim.nodes = 2;
+		sim.wander = 0;
+		sim.resolution = 0;
+	}
+
+	if((nodes = calloc(sim.nodes, sizeof(SimNode))) == NULL) {
+		perror("calloc");
+		return 1;
+	}
+
+	for(i = 0; i < sim.nodes; i++) {
+		initNode(&nodes[i], i);
+	}
+
+	if(sim.replayFile != NULL) {
+		nodes[1].phase = 0;
+		nodes[1].freqError = 0;
+		if(sim.trace) {
+			printf("# time, clock, offset from master, offset from master, mean path delay, adjustment ppb\n");
+		}
+		if((c = replay(&nodes[1])) == 0) {
+			report(nodes);
+		}
+		freeNode(&nodes[1]);
+		free(nodes);
+		return c;
+	}
+
+	syncInterval = pow(2, sim.logSyncInterval) * SIM_SECOND;
+	delayInterval = pow(2, sim.logDelayReqInterval) * SIM_SECOND;
+	/* intervals are powers of two, so this hits every event, delay requests half way between */
+	step = min(syncInterval, delayInterval) / 2;
+	end = sim.duration * SIM_SECOND;
+
+	if(sim.trace) {
+		printf("# time, clock, true offset, offset from master, mean path delay, adjustment ppb\n");
+	}
+
+	for(t = 0; t < end; t += step) {
+		for(i = 1; i < sim.nodes; i++) {
+			if(t % syncInterval == 0) {
+				syncExchange(&nodes[i - 1], &nodes[i], i, t);
+			}
+			if((t + delayInterval / 2) % delayInterval == 0) {
+				delayExchange(&nodes[i - 1], &nodes[i], t);
+			}
+		}
+	}
+
+	report(nodes);
+
+	for(i = 0; i < sim.nodes; i++) {
+		freeNode(&nodes[i]);
+	}
+
+	free(nodes);
+
+	return 0;
+
+}
@@ -0,0 +1,323 @@
+/*-
+ * Copyright (c) 2026 PTPd contributors,
+ *
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file   ptpd_stats2csv.c
+ * @date   Sun Oct 18 07:10:21 2026
+ *
+ * @brief  Convert a binary statistics log into the CSV statistics log
+ *
+ * The output is what ptpd writes to the statistics file in CSV mode, line
+ * for line, so existing tools (tools/stats.R, tools/offset.R) can be used
+ * unchanged. The formatting below mirrors logStatistics() in dep/sys.c.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <net/ethernet.h>
+#ifdef HAVE_NETINET_ETHER_H
+#include <netinet/ether.h>
+#endif
+
+#include "../dep/statslog.h"
+
+#define MAXTIMESTR 32
+
+/* timestamp formats, as in constants_dep.h */
+enum {
+	TIMESTAMP_DATETIME,
+	TIMESTAMP_UNIX,
+	TIMESTAMP_BOTH
+};
+
+/* port states, as in constants.h */
+enum {
+	PTP_INITIALIZING=1,  PTP_FAULTY,  PTP_DISABLED,
+	PTP_LISTENING,  PTP_PRE_MASTER,  PTP_MASTER,
+	PTP_PASSIVE,  PTP_UNCALIBRATED,  PTP_SLAVE
+};
+
+static void
+usage(const char *name)
+{
+	fprintf(stderr,
+	"usage: %s [-t datetime|unix|both] [file ...]\n"
+	"\n"
+	"Convert ptpd binary statistics logs (global:statistics_file_format=binary)\n"
+	"to the CSV statistics log format. Reads standard input if no file is given.\n"
+	"\n"
+	"  -t FORMAT  timestamp format - default: as configured when the log was written\n",
+	name);
+}
+
+static const char *
+portStateName(const StatisticsLogRecord *record)
+{
+	switch(record->portState) {
+	    case PTP_INITIALIZING:  return "init";
+	    case PTP_FAULTY:        return "flt";
+	    case PTP_LISTENING:     return (record->resetCount == 1) ? "lstn_init" : "lstn_reset";
+	    case PTP_PASSIVE:       return "pass";
+	    case PTP_UNCALIBRATED:  return "uncl";
+	    case PTP_SLAVE:         return "slv";
+	    case PTP_PRE_MASTER:    return "pmst";
+	    case PTP_MASTER:        return "mst";
+	    case PTP_DISABLED:      return "dsbl";
+	    default:                return "?";
+	}
+}
+
+static void
+printTime(const StatisticsLogTime *t)
+{
+	printf("%c%d.%09d", (t->seconds < 0 || t->nanoseconds < 0) ? '-' : ' ',
+	    abs(t->seconds), abs(t->nanoseconds));
+}
+
+static void
+printClockIdentity(const uint8_t *id)
+{
+
+	int i, j;
+	struct ether_addr e;
+	uint8_t mac[6];
+	char host[1024];
+	char *c;
+
+	for (i = 0; i < 8; i++) {
+		printf("%02x", id[i]);
+	}
+
+	/* hostname from /etc/ethers, MAC address is the identity without bytes 3 and 4 */
+	for (i = 0, j = 0; i < 8; i++) {
+		if(i != 3 && i != 4) {
+			mac[j++] = id[i];
+		}
+	}
+	memcpy(&e, mac, sizeof(mac));
+
+	if(ether_ntohost(host, &e)) {
+		snprintf(host, sizeof(host), "%s", "unknown");
+	}
+
+	while((c = strchr(host, ',')) != NULL) {
+		*c = '_';
+	}
+
+	printf("(%s)", host);
+
+}
+
+static void
+printCsvHeader(int timestampFormat)
+{
+	printf("# %s, State, Clock ID, One Way Delay, "
+	       "Offset From Master, Slave to Master, "
+	       "Master to Slave, Observed Drift, Last packet Received, Sequence ID"
+		", One Way Delay Mean, One Way Delay Std Dev, Offset From Master Mean, Offset From Master Std Dev, Observed Drift Mean, Observed Drift Std Dev, raw delayMS, raw delaySM"
+		"\n", (timestampFormat == TIMESTAMP_BOTH) ? "Timestamp, Unix timestamp" : "Timestamp");
+}
+
+static void
+printCsvRecord(const StatisticsLogRecord *record, int timestampFormat)
+{
+
+	char time_str[MAXTIMESTR];
+	time_t time_s = record->seconds;
+
+	if (timestampFormat == TIMESTAMP_DATETIME ||
+	    timestampFormat == TIMESTAMP_BOTH) {
+	    strftime(time_str, MAXTIMESTR, "%Y-%m-%d %X", localtime(&time_s));
+	    printf("%s.%06d, %s, ", time_str, record->nanoseconds / 1000, portStateName(record));
+	}
+
+	if (timestampFormat == TIMESTAMP_UNIX ||
+	    timestampFormat == TIMESTAMP_BOTH) {
+	    printf("%d.%06d, %s,", (int32_t)record->seconds, record->nanoseconds, portStateName(record));
+	}
+
+	if (record->portState == PTP_SLAVE) {
+
+		printClockIdentity(record->parentClockIdentity);
+		printf("/%d", record->parentPortNumber);
+
+		if (memcmp(record->grandmasterIdentity, record->parentClockIdentity, 8)) {
+			printClockIdentity(record->grandmasterIdentity);
+		}
+
+		printf(", ");
+		printTime(&record->meanPathDelay);
+		printf(", ");
+		printTime(&record->offsetFromMaster);
+		printf(", ");
+		printTime(&record->delaySM);
+		printf(", ");
+		printTime(&record->delayMS);
+
+		printf(", %.09f, %c, %05d", record->observedDrift, record->lastMessage, record->sequenceId);
+		printf(", %.09f, %.00f, %.09f, %.00f",
+		    record->mpdMean, record->mpdStdDev * 1E9,
+		    record->ofmMean, record->ofmStdDev * 1E9);
+
+		printTime(&record->rawDelayMS);
+		printf(", ");
+		printTime(&record->rawDelaySM);
+
+	} else {
+		if (record->portState == PTP_MASTER || record->portState == PTP_PASSIVE) {
+			printClockIdentity(record->parentClockIdentity);
+			printf("/%d", record->parentPortNumber);
+		}
+
+		if (record->portState == PTP_LISTENING) {
+			printf(" %d ", record->resetCount);
+		}
+	}
+
+	printf("\n");
+
+}
+
+static int
+convert(FILE *in, const char *name, int forceFormat)
+{
+
+	uint32_t entry[2];
+	uint64_t buf[512];
+	StatisticsLogHeader *header = (StatisticsLogHeader*)buf;
+	StatisticsLogRecord record;
+	int timestampFormat = -1;
+	uint32_t c;
+
+	while(fread(entry, sizeof(entry), 1, in) == 1) {
+
+		uint32_t tag = entry[0];
+		uint32_t length = entry[1];
+
+		if(length < sizeof(entry)) {
+			fprintf(stderr, "%s: corrupt entry, stopping\n", name);
+			return 0;
+		}
+
+		if(tag == STATSLOG_TAG_HEADER && length <= sizeof(buf) && length >= sizeof(StatisticsLogHeader)) {
+			memcpy(buf, entry, sizeof(entry));
+			if(fread((char*)buf + sizeof(entry), length - sizeof(entry), 1, in) != 1) {
+				break;
+			}
+			if(header->magic != STATSLOG_MAGIC || header->version != STATSLOG_VERSION ||
+			    header->recordSize != sizeof(StatisticsLogRecord)) {
+				fprintf(stderr, "%s: unsupported statistics log (wrong byte order or version)\n", name);
+				return 0;
+			}
+			timestampFormat = (forceFormat >= 0) ? forceFormat : header->timestampFormat;
+			printCsvHeader(timestampFormat);
+			continue;
+		}
+
+		if(tag == STATSLOG_TAG_RECORD && length == sizeof(record) && timestampFormat >= 0) {
+			memcpy(&record, entry, sizeof(entry));
+			if(fread((char*)&record + sizeof(entry), length - sizeof(entry), 1, in) != 1) {
+				break;
+			}
+			printCsvRecord(&record, timestampFormat);
+			continue;
+		}
+
+		if(timestampFormat < 0 && tag != STATSLOG_TAG_HEADER) {
+			fprintf(stderr, "%s: not a binary statistics log\n", name);
+			return 0;
+		}
+
+		/* something we do not know - skip it (input may be a pipe, so read it) */
+		for(length -= sizeof(entry); length > 0; length -= c) {
+			c = (length > sizeof(buf)) ? sizeof(buf) : length;
+			if(fread(buf, c, 1, in) != 1) {
+				return 1;
+			}
+		}
+
+	}
+
+	return 1;
+
+}
+
+int
+main(int argc, char **argv)
+{
+
+	int c, i;
+	int ret = 0;
+	int forceFormat = -1;
+	FILE *in;
+
+	while((c = getopt(argc, argv, "t:h")) != -1) {
+		switch(c) {
+		case 't':
+			if(!strcmp(optarg, "datetime")) {
+				forceFormat = TIMESTAMP_DATETIME;
+			} else if(!strcmp(optarg, "unix")) {
+				forceFormat = TIMESTAMP_UNIX;
+			} else if(!strcmp(optarg, "both")) {
+				forceFormat = TIMESTAMP_BOTH;
+			} else {
+				usage(argv[0]);
+				return 1;
+			}
+			break;
+		default:
+			usage(argv[0]);
+			return (c == 'h') ? 0 : 1;
+		}
+	}
+
+	if(optind >= argc) {
+		return convert(stdin, "stdin", forceFormat) ? 0 : 1;
+	}
+
+	for(i = optind; i < argc; i++) {
+		if((in = fopen(argv[i], "r")) == NULL) {
+			perror(argv[i]);
+			ret = 1;
+			continue;
+		}
+		if(!convert(in, argv[i], forceFormat)) {
+			ret = 1;
+		}
+		fclose(in);
+	}
+
+	return ret;
+
+}
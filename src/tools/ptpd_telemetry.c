@@ -0,0 +1,309 @@
+/*-
+ * Copyright (c) 2026 PTPd contributors,
+ *
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file   ptpd_telemetry.c
+ * @date   Sun Oct 18 07:06:27 2026
+ *
+ * @brief  Reader for the ptpd servo telemetry ring (global:telemetry_file)
+ *
+ * Dumps the records held in the ring as CSV and optionally follows it,
+ * printing new records as ptpd writes them. The reader never writes to
+ * the ring and cannot slow ptpd down: if it falls more than a full ring
+ * behind, the overwritten records are reported as lost and skipped.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "../dep/telemetry.h"
+
+#define DEFAULT_TELEMETRYFILE "/dev/shm/ptpd.telemetry"
+
+typedef struct {
+	const TelemetryHeader *header;
+	size_t size;
+	ino_t inode;
+} TelemetryMap;
+
+static volatile sig_atomic_t stop = 0;
+
+static const char *typeNames[] = { "NONE", "OFFSET", "DELAY", "PDELAY" };
+
+/* order follows PtpPortState in constants.h */
+static const char *portStateNames[] = { "NONE", "INITIALIZING", "FAULTY", "DISABLED",
+	"LISTENING", "PRE_MASTER", "MASTER", "PASSIVE", "UNCALIBRATED", "SLAVE" };
+
+/* order follows ClockState in libcck/clockdriver.h */
+static const char *clockStateNames[] = { "SUSPENDED", "NEGSTEP", "STEP", "HWFAULT",
+	"INIT", "FREERUN", "TRACKING", "HOLDOVER", "LOCKED" };
+
+#define TABLE_NAME(table, index) \
+	(((index) < sizeof(table) / sizeof(table[0])) ? table[index] : "UNKNOWN")
+
+static void
+catchSignal(int sig)
+{
+	stop = 1;
+}
+
+static void
+usage(const char *name)
+{
+	fprintf(stderr,
+	"usage: %s [-f] [-H] [-n records] [-i milliseconds] [file]\n"
+	"\n"
+	"Print the contents of the ptpd servo telemetry ring as CSV.\n"
+	"\n"
+	"  -f     follow: keep printing new records until interrupted\n"
+	"  -H     do not print the CSV header line\n"
+	"  -n N   start with at most N most recent records (default: all held)\n"
+	"  -i MS  poll interval in follow mode (default: 100 ms)\n"
+	"  file   telemetry file (default: %s)\n",
+	name, DEFAULT_TELEMETRYFILE);
+}
+
+static void
+unmapTelemetry(TelemetryMap *map)
+{
+	if(map->header != NULL) {
+		munmap((void*)map->header, map->size);
+		map->header = NULL;
+	}
+}
+
+static int
+mapTelemetry(TelemetryMap *map, const char *path, int quiet)
+{
+
+	int fd;
+	struct stat st;
+	const TelemetryHeader *header;
+
+	if((fd = open(path, O_RDONLY)) < 0) {
+		if(!quiet) fprintf(stderr, "Could not open %s: %s\n", path, strerror(errno));
+		return 0;
+	}
+
+	if(fstat(fd, &st) < 0 || st.st_size < sizeof(TelemetryHeader)) {
+		if(!quiet) fprintf(stderr, "%s is not a telemetry file\n", path);
+		close(fd);
+		return 0;
+	}
+
+	header = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if(header == MAP_FAILED) {
+		if(!quiet) fprintf(stderr, "Could not map %s: %s\n", path, strerror(errno));
+		return 0;
+	}
+
+	if(header->magic != TELEMETRY_MAGIC || header->version != TELEMETRY_VERSION ||
+	    header->recordSize != sizeof(TelemetryRecord) || header->capacity == 0 ||
+	    (header->capacity & (header->capacity - 1)) ||
+	    st.st_size < TELEMETRY_SIZE(header->capacity)) {
+		if(!quiet) fprintf(stderr, "%s is not a telemetry file or was written by an incompatible ptpd\n", path);
+		munmap((void*)header, st.st_size);
+		return 0;
+	}
+
+	map->header = header;
+	map->size = st.st_size;
+	map->inode = st.st_ino;
+
+	return 1;
+
+}
+
+/* copy record n out of the ring, return 0 if it was overwritten meanwhile */
+static int
+readRecord(const TelemetryHeader *header, uint64_t n, TelemetryRecord *out)
+{
+
+	const TelemetryRecord *record = TELEMETRY_RECORD(header, n);
+	uint64_t before, after;
+
+	before = record->sequence;
+	__sync_synchronize();
+	memcpy(out, (const void*)record, sizeof(TelemetryRecord));
+	__sync_synchronize();
+	after = record->sequence;
+
+	return (before == 2 * n + 2) && (after == before);
+
+}
+
+static void
+printTime(const TelemetryTime *t)
+{
+	if(t->seconds < 0 || t->nanoseconds < 0) {
+		printf("-%lld.%09d", -(long long)t->seconds, -t->nanoseconds);
+	} else {
+		printf("%lld.%09d", (long long)t->seconds, t->nanoseconds);
+	}
+}
+
+static void
+printRecord(uint64_t n, const TelemetryRecord *record)
+{
+
+	printf("%llu, %s, ", (unsigned long long)n, TABLE_NAME(typeNames, record->type));
+	printTime(&record->timestamp); printf(", ");
+	printTime(&record->t1); printf(", ");
+	printTime(&record->t2); printf(", ");
+	printTime(&record->t3); printf(", ");
+	printTime(&record->t4); printf(", ");
+	printTime(&record->correction); printf(", ");
+	printTime(&record->rawDelayMS); printf(", ");
+	printTime(&record->rawDelaySM); printf(", ");
+	printTime(&record->offsetFromMaster); printf(", ");
+	printTime(&record->meanPathDelay);
+	printf(", %.3f, %.3f, %u, %s, %s\n", record->servoOutput, record->servoIntegral,
+	    record->ptpSequenceId, TABLE_NAME(portStateNames, record->portState),
+	    record->clockState == 0xff ? "NONE" : TABLE_NAME(clockStateNames, record->clockState));
+
+}
+
+int
+main(int argc, char **argv)
+{
+
+	const char *path = DEFAULT_TELEMETRYFILE;
+	int follow = 0;
+	int header = 1;
+	long long last = -1;
+	long interval = 100;
+	int c;
+
+	TelemetryMap map = { NULL, 0, 0 };
+	TelemetryRecord record;
+	uint64_t next, head, lost = 0;
+	struct timespec pause;
+	struct stat st;
+
+	while((c = getopt(argc, argv, "fHn:i:h")) != -1) {
+		switch(c) {
+		case 'f':
+			follow = 1;
+			break;
+		case 'H':
+			header = 0;
+			break;
+		case 'n':
+			last = atoll(optarg);
+			break;
+		case 'i':
+			interval = atol(optarg);
+			if(interval < 1) interval = 1;
+			break;
+		default:
+			usage(argv[0]);
+			return (c == 'h') ? 0 : 1;
+		}
+	}
+
+	if(optind < argc) {
+		path = argv[optind];
+	}
+
+	if(!mapTelemetry(&map, path, 0)) {
+		return 1;
+	}
+
+	signal(SIGINT, catchSignal);
+	signal(SIGTERM, catchSignal);
+
+	pause.tv_sec = interval / 1000;
+	pause.tv_nsec = (interval % 1000) * 1000000;
+
+	if(header) {
+		printf("# Record, Type, Timestamp, T1, T2, T3, T4, Correction, raw delayMS, raw delaySM, "
+		    "Offset From Master, One Way Delay, Servo Output, Observed Drift, Sequence ID, "
+		    "Port State, Clock State\n");
+	}
+
+	head = map.header->head;
+	next = (last >= 0 && head > last) ? head - last : 0;
+
+	while(!stop) {
+
+		head = map.header->head;
+		__sync_synchronize();
+
+		/* the writer went round the ring past us */
+		if(head - next > map.header->capacity) {
+			lost += head - map.header->capacity - next;
+			next = head - map.header->capacity;
+		}
+
+		for(; next < head; next++) {
+			if(readRecord(map.header, next, &record)) {
+				printRecord(next, &record);
+			} else {
+				lost++;
+			}
+		}
+
+		if(!follow) {
+			break;
+		}
+
+		fflush(stdout);
+		nanosleep(&pause, NULL);
+
+		/* ptpd restarted or reconfigured the ring: a new file replaced ours */
+		if(stat(path, &st) == 0 && st.st_ino != map.inode) {
+			TelemetryMap newMap = { NULL, 0, 0 };
+			if(mapTelemetry(&newMap, path, 1)) {
+				unmapTelemetry(&map);
+				map = newMap;
+				next = 0;
+				fprintf(stderr, "%s was re-created, restarting from the first record\n", path);
+			}
+		}
+
+	}
+
+	unmapTelemetry(&map);
+
+	if(lost) {
+		fprintf(stderr, "%llu records were overwritten before they could be read\n",
+		    (unsigned long long)lost);
+	}
+
+	return 0;
+
+}
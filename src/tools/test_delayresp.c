@@ -0,0 +1,268 @@
+/*-
+ * Copyright (c) 2026 PTPd contributors,
+ *
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file   test_delayresp.c
+ * @date   Sun Oct 18 09:10:58 2026
+ *
+ * @brief  Delay_Resp template check and benchmark
+ *
+ * Packs a Delay_Resp template the way getDelayRespTemplate() does, then for
+ * random Delay_Req headers and receive timestamps checks that copying the
+ * template and calling msgPatchDelayResp() gives the same bytes as packing
+ * the whole response with msgPackDelayResp(). The port identity, domain and
+ * logMinDelayReqInterval are changed between rounds and the template is
+ * rebuilt when they change, as the template key does. The same is then
+ * checked with a PTPMON response TLV appended the way populatePtpMon()
+ * appends it.
+ *
+ * Then times rebuilding the PTPMON response for every request against the
+ * template copy and patch. Run with -b for the timing.
+ */
+
+#include "../ptpd.h"
+#include "../lib1588/ptp_message.h"
+#include "testutil.h"
+
+#define TEST_ROUNDS	200
+#define TEST_REQUESTS	500
+#define BENCH_REQUESTS	200000
+
+RunTimeOpts rtOpts;
+
+static uint64_t arenaBuffer[4096 / sizeof(uint64_t)];
+
+/* msg.c shuts down through this */
+void
+ptpdShutdown(PtpClock *ptpClock)
+{
+	exit(1);
+}
+
+static void
+randomClockIdentity(ClockIdentity identity)
+{
+	uint64_t r = randomNext();
+
+	memcpy(identity, &r, CLOCK_IDENTITY_LENGTH);
+}
+
+/* the port's own identity and settings: what the template key holds */
+static void
+randomClock(PtpClock *ptpClock)
+{
+	ptpClock->portDS.transportSpecific = randomNext() % 2;
+	ptpClock->portDS.versionNumber = 2;
+	ptpClock->defaultDS.domainNumber = randomNext() % 128;
+	ptpClock->defaultDS.twoStepFlag = randomNext() % 2;
+	randomClockIdentity(ptpClock->portDS.portIdentity.clockIdentity);
+	ptpClock->portDS.portIdentity.portNumber = randomNext();
+	ptpClock->portDS.logMinDelayReqInterval = (Integer8)(randomNext() % 16) - 8;
+	ptpClock->portDS.logSyncInterval = (Integer8)(randomNext() % 16) - 8;
+}
+
+/* a Delay_Req as msgUnpackHeader() leaves it, domain rewritten as issueDelayResp() does */
+static void
+randomRequest(MsgHeader *header, Timestamp *receiveTimestamp, PtpClock *ptpClock)
+{
+	uint64_t r = randomNext();
+
+	memset(header, 0, sizeof(MsgHeader));
+	header->messageType = DELAY_REQ;
+	header->domainNumber = ptpClock->defaultDS.domainNumber;
+	header->flagField0 = (r & 1) ? PTP_UNICAST : 0;
+	header->flagField1 = r >> 8;
+	header->correctionField.msb = (Integer32)(r >> 16);
+	header->correctionField.lsb = (UInteger32)randomNext();
+	header->sequenceId = r >> 48;
+	header->logMessageInterval = 0x7F;
+	randomClockIdentity(header->sourcePortIdentity.clockIdentity);
+	header->sourcePortIdentity.portNumber = r >> 32;
+
+	/* fromInternalTime() leaves the seconds msb zero, as lib1588 does when it repacks */
+	r = randomNext();
+	receiveTimestamp->secondsField.msb = 0;
+	receiveTimestamp->secondsField.lsb = r & 0x7FFFFFFF;
+	receiveTimestamp->nanosecondsField = (r >> 32) % 1000000000;
+}
+
+/* append a PTPMON response TLV to a packed Delay_Resp, return the new length */
+static int
+appendPtpMon(Octet *buf, PtpClock *ptpClock)
+{
+
+	PtpArena arena;
+	PtpArena *previous;
+	PtpMessage message;
+	PtpTlv *tlv;
+	int ret;
+
+	initPtpArena(&arena, arenaBuffer, sizeof(arenaBuffer));
+	previous = usePtpArena(&arena);
+
+	memset(&message, 0, sizeof(message));
+	ret = unpackPtpMessage(&message, buf, buf + DELAY_RESP_LENGTH);
+
+	if(ret >= DELAY_RESP_LENGTH && (tlv = createPtpTlv()) != NULL) {
+		tlv->tlvType = PTP_TLVTYPE_PTPMON_RESPONSE;
+		attachPtpTlv(&message, tlv);
+		tlv->body.ptpMonResponse.portState = PTP_MASTER;
+		tlv->body.ptpMonResponse.parentPortAddress.addressLength = 4;
+		tlv->body.ptpMonResponse.parentPortAddress.networkProtocol = 1;
+		tlv->body.ptpMonResponse.parentPortAddress.addressField = ptpCalloc(4);
+		tlv->body.ptpMonResponse.stepsRemoved = ptpClock->currentDS.stepsRemoved;
+		copyClockIdentity(tlv->body.ptpMonResponse.grandmasterIdentity,
+		    ptpClock->portDS.portIdentity.clockIdentity);
+		ret = packPtpMessage(buf, &message, buf + PACKET_SIZE);
+	} else {
+		ret = 0;
+	}
+
+	freePtpMessage(&message);
+	usePtpArena(previous);
+
+	return ret;
+
+}
+
+/* a whole response, packed the way it was before templates */
+static int
+packResponse(Octet *buf, MsgHeader *header, Timestamp *receiveTimestamp,
+	     Boolean ptpmon, PtpClock *ptpClock)
+{
+	memset(buf, 0, PACKET_SIZE);
+	msgPackDelayResp(buf, header, receiveTimestamp, ptpClock);
+	return ptpmon ? appendPtpMon(buf, ptpClock) : DELAY_RESP_LENGTH;
+}
+
+static Boolean
+checkTemplate(Boolean ptpmon)
+{
+
+	PtpClock ptpClock;
+	MsgHeader header;
+	Timestamp receiveTimestamp, zero;
+	Octet template[PACKET_SIZE], patched[PACKET_SIZE], reference[PACKET_SIZE];
+	int templateLength, referenceLength;
+	int round, i;
+
+	memset(&ptpClock, 0, sizeof(ptpClock));
+	memset(&zero, 0, sizeof(zero));
+
+	for(round = 0; round < TEST_ROUNDS; round++) {
+
+		/* anything in the template key changed: rebuild, as getDelayRespTemplate() would */
+		randomClock(&ptpClock);
+		randomRequest(&header, &receiveTimestamp, &ptpClock);
+		templateLength = packResponse(template, &header, &zero, ptpmon, &ptpClock);
+
+		if(templateLength <= 0) {
+			fprintf(stderr, "could not build the %s template\n", ptpmon ? "PTPMON" : "plain");
+			return FALSE;
+		}
+
+		for(i = 0; i < TEST_REQUESTS; i++) {
+
+			/* things outside the key may change without a rebuild */
+			ptpClock.defaultDS.twoStepFlag = randomNext() % 2;
+			ptpClock.portDS.logSyncInterval = (Integer8)(randomNext() % 16) - 8;
+
+			randomRequest(&header, &receiveTimestamp, &ptpClock);
+			referenceLength = packResponse(reference, &header, &receiveTimestamp, ptpmon, &ptpClock);
+
+			memset(patched, 0, sizeof(patched));
+			memcpy(patched, template, templateLength);
+			msgPatchDelayResp(patched, &header, &receiveTimestamp, &ptpClock);
+
+			if(referenceLength != templateLength ||
+			    memcmp(patched, reference, referenceLength)) {
+				fprintf(stderr, "%s template round %d request %d: patched response differs\n",
+				    ptpmon ? "PTPMON" : "plain", round, i);
+				return FALSE;
+			}
+
+		}
+
+	}
+
+	return TRUE;
+
+}
+
+int
+main(int argc, char **argv)
+{
+
+	PtpClock ptpClock;
+	MsgHeader header;
+	Timestamp receiveTimestamp, zero;
+	Octet template[PACKET_SIZE], buf[PACKET_SIZE];
+	struct timespec start;
+	double rebuildTime, templateTime;
+	volatile int sink = 0;
+	int length, i;
+
+	if(!checkTemplate(FALSE) || !checkTemplate(TRUE)) {
+		return 1;
+	}
+
+	printf("%d template copies patched per template type match the full pack\n",
+	    TEST_ROUNDS * TEST_REQUESTS);
+
+	if(!testBenchmark(argc, argv)) {
+		return 0;
+	}
+
+	memset(&ptpClock, 0, sizeof(ptpClock));
+	memset(&zero, 0, sizeof(zero));
+	randomClock(&ptpClock);
+	randomRequest(&header, &receiveTimestamp, &ptpClock);
+	length = packResponse(template, &header, &zero, TRUE, &ptpClock);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(i = 0; i < BENCH_REQUESTS; i++) {
+		header.sequenceId = i;
+		msgPackDelayResp(buf, &header, &receiveTimestamp, &ptpClock);
+		sink += appendPtpMon(buf, &ptpClock);
+	}
+	rebuildTime = testElapsed(&start) / BENCH_REQUESTS;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(i = 0; i < BENCH_REQUESTS; i++) {
+		header.sequenceId = i;
+		memcpy(buf, template, length);
+		msgPatchDelayResp(buf, &header, &receiveTimestamp, &ptpClock);
+		sink += buf[31];
+	}
+	templateTime = testElapsed(&start) / BENCH_REQUESTS;
+
+	printf("PTPMON Delay_Resp (%d bytes): rebuild %.1f ns/response, template %.1f ns/response\n",
+	    length, rebuildTime, templateTime);
+
+	return 0;
+
+}
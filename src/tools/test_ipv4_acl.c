@@ -0,0 +1,307 @@
+/*-
+ * Copyright (c) 2026 PTPd contributors,
+ *
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file   test_ipv4_acl.c
+ * @date   Sun Oct 18 09:07:02 2026
+ *
+ * @brief  IPv4 ACL parser and prefix trie check and benchmark
+ *
+ * Checks that ACL entries parse as documented, that shortcuts expand and
+ * that non-contiguous masks are rejected. Then builds random ACLs with
+ * overlapping and duplicate prefixes, /0 and dotted masks, and matches
+ * random addresses against both the compiled trie and a linear scan of the
+ * sorted entries - the original matching code. Verdicts and per-entry hit
+ * counters must be identical. Finally times both for growing ACL sizes.
+ * Run with -b for the timing.
+ */
+
+#include "../ptpd.h"
+#include "testutil.h"
+
+#define TEST_LOOKUPS	300000
+#define BENCH_LOOKUPS	2000000
+#define MAX_ENTRIES	512
+
+
+/* the linear scan ipv4_acl.c used before the trie: first match in sorted order */
+static int
+refMatchAddress(uint32_t addr, const MaskTable *table, uint32_t *hits)
+{
+
+	int i;
+
+	if(table == NULL || table->numEntries == 0) {
+		return -1;
+	}
+
+	for(i = 0; i < table->numEntries; i++) {
+		if((table->entries[i].bitmask & addr) == table->entries[i].network) {
+			if(hits != NULL) {
+				hits[i]++;
+			}
+			return 1;
+		}
+	}
+
+	return 0;
+
+}
+
+static int
+refMatch(const Ipv4AccessList *acl, uint32_t addr, uint32_t *permitHits, uint32_t *denyHits)
+{
+
+	int matchPermit = refMatchAddress(addr, acl->permitTable, permitHits) > 0;
+	int matchDeny = refMatchAddress(addr, acl->denyTable, denyHits) > 0;
+
+	if(acl->processingOrder == ACL_PERMIT_DENY) {
+		return matchPermit && !matchDeny;
+	}
+
+	return !(matchDeny && !matchPermit);
+
+}
+
+static Boolean
+checkParser(void)
+{
+
+	static const struct {
+		const char *text;
+		int entries;
+	} cases[] = {
+		{ "10.0.0.1", 1 },
+		{ "10.0.0.0/8, 192.168.1.0/24; 172.16/12", 3 },
+		{ "0.0.0.0/0", 1 },
+		{ "192.168/255.255", 1 },
+		{ "10.0.0.0/255.255.252.0", 1 },
+		{ "10.0.0.0/255.255.255.255", 1 },
+		{ "10.0.0.0/0.0.0.0", 1 },
+		{ "10.0.0.0/33", -1 },
+		{ "10.0.0.0/255.255.253.0", -1 },
+		{ "10.0.0.0/255.0.255.0", -1 },
+		{ "10.0.0.0/0.255.255.255", -1 },
+		{ "10.0.0.256", -1 },
+	};
+	AclEntry a, b;
+	int i, found;
+
+	for(i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+		if((found = maskParser(cases[i].text, NULL)) != cases[i].entries) {
+			fprintf(stderr, "ACL \"%s\": parsed %d entries, expected %d\n",
+			    cases[i].text, found, cases[i].entries);
+			return FALSE;
+		}
+	}
+
+	/* shortcuts expand to the full form */
+	if(maskParser("172.16/12", &a) != 1 || maskParser("172.16.0.0/255.240.0.0", &b) != 1 ||
+	    a.network != b.network || a.bitmask != b.bitmask || a.netmask != 12 || b.netmask != 12) {
+		fprintf(stderr, "172.16/12 does not expand to 172.16.0.0/255.240.0.0\n");
+		return FALSE;
+	}
+
+	return TRUE;
+
+}
+
+/* random prefixes of minPrefix bits or more around a few networks, so entries overlap and repeat */
+static char*
+randomAcl(int count, int minPrefix)
+{
+
+	static const uint32_t bases[] = { 0x0A000000, 0xAC100000, 0xC0A80000 };
+	char *text = calloc(count, 40);
+	int i, len = 0;
+
+	for(i = 0; i < count; i++) {
+
+		uint32_t addr = bases[randomNext32() % 3] | (randomNext32() & 0x00FFFFFF);
+		int prefix = minPrefix + randomNext32() % (33 - minPrefix);
+
+		if(minPrefix == 0 && randomNext32() % 16 == 0) {
+			prefix = 0;
+		}
+
+		if(randomNext32() % 4 == 0) {
+			uint32_t mask = prefix ? ~0U << (32 - prefix) : 0;
+			len += sprintf(text + len, "%s%u.%u.%u.%u/%u.%u.%u.%u", i ? "," : "",
+			    addr >> 24, (addr >> 16) & 0xFF, (addr >> 8) & 0xFF, addr & 0xFF,
+			    mask >> 24, (mask >> 16) & 0xFF, (mask >> 8) & 0xFF, mask & 0xFF);
+		} else {
+			len += sprintf(text + len, "%s%u.%u.%u.%u/%d", i ? "," : "",
+			    addr >> 24, (addr >> 16) & 0xFF, (addr >> 8) & 0xFF, addr & 0xFF, prefix);
+		}
+
+	}
+
+	return text;
+
+}
+
+static uint32_t
+randomAddress(void)
+{
+
+	static const uint32_t bases[] = { 0x0A000000, 0xAC100000, 0xC0A80000 };
+	uint32_t r = randomNext32();
+
+	/* mostly near the ACL networks, sometimes anywhere */
+	if(r % 4 == 0) {
+		return randomNext32();
+	}
+
+	return bases[r % 3] | (randomNext32() & 0x00FFFFFF);
+
+}
+
+static Boolean
+checkTrie(int entries, int order)
+{
+
+	char *permit = randomAcl(entries, 0);
+	char *deny = randomAcl(entries, 0);
+	Ipv4AccessList *acl = createIpv4AccessList(permit, deny, order);
+	uint32_t permitHits[MAX_ENTRIES], denyHits[MAX_ENTRIES];
+	Boolean ret = TRUE;
+	int i;
+
+	memset(permitHits, 0, sizeof(permitHits));
+	memset(denyHits, 0, sizeof(denyHits));
+
+	for(i = 0; i < TEST_LOOKUPS; i++) {
+
+		uint32_t addr = randomAddress();
+		int ref = refMatch(acl, addr, permitHits, denyHits);
+
+		if(matchIpv4AccessList(acl, addr) != ref) {
+			fprintf(stderr, "%d entries, order %d: address %08x matched %d, expected %d\n",
+			    entries, order, addr, !ref, ref);
+			ret = FALSE;
+			goto end;
+		}
+
+	}
+
+	for(i = 0; i < acl->permitTable->numEntries; i++) {
+		if(acl->permitTable->entries[i].hitCount != permitHits[i]) {
+			fprintf(stderr, "%d entries: permit entry %d hit %u times, expected %u\n",
+			    entries, i, acl->permitTable->entries[i].hitCount, permitHits[i]);
+			ret = FALSE;
+			goto end;
+		}
+	}
+
+	for(i = 0; i < acl->denyTable->numEntries; i++) {
+		if(acl->denyTable->entries[i].hitCount != denyHits[i]) {
+			fprintf(stderr, "%d entries: deny entry %d hit %u times, expected %u\n",
+			    entries, i, acl->denyTable->entries[i].hitCount, denyHits[i]);
+			ret = FALSE;
+			goto end;
+		}
+	}
+
+end:
+	freeIpv4AccessList(&acl);
+	free(permit);
+	free(deny);
+	return ret;
+
+}
+
+/* per lookup time of the trie against the linear scan, in nanoseconds */
+static void
+benchAcl(int entries)
+{
+
+	/* no short prefixes: they would match first and end the linear scan early */
+	char *permit = randomAcl(entries, 16);
+	char *deny = randomAcl(entries, 16);
+	Ipv4AccessList *acl = createIpv4AccessList(permit, deny, ACL_PERMIT_DENY);
+	static uint32_t addresses[4096];
+	struct timespec start;
+	volatile int sink = 0;
+	double trieTime, linearTime;
+	int i;
+
+	for(i = 0; i < 4096; i++) {
+		addresses[i] = randomAddress();
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(i = 0; i < BENCH_LOOKUPS; i++) {
+		sink += refMatch(acl, addresses[i & 4095], NULL, NULL);
+	}
+	linearTime = testElapsed(&start) / BENCH_LOOKUPS;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(i = 0; i < BENCH_LOOKUPS; i++) {
+		sink += matchIpv4AccessList(acl, addresses[i & 4095]);
+	}
+	trieTime = testElapsed(&start) / BENCH_LOOKUPS;
+
+	printf("%3d + %3d entries: linear %7.1f ns/lookup, trie %5.1f ns/lookup\n",
+	    entries, entries, linearTime, trieTime);
+
+	freeIpv4AccessList(&acl);
+	free(permit);
+	free(deny);
+
+}
+
+int
+main(int argc, char **argv)
+{
+
+	static const int sizes[] = { 1, 2, 8, 64, MAX_ENTRIES };
+	int i;
+
+	if(!checkParser()) {
+		return 1;
+	}
+
+	for(i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		if(!checkTrie(sizes[i], ACL_PERMIT_DENY) || !checkTrie(sizes[i], ACL_DENY_PERMIT)) {
+			return 1;
+		}
+	}
+
+	printf("trie verdicts and hit counters match the linear scan\n");
+
+	if(!testBenchmark(argc, argv)) {
+		return 0;
+	}
+
+	benchAcl(1);
+	benchAcl(8);
+	benchAcl(64);
+	benchAcl(MAX_ENTRIES);
+
+	return 0;
+
+}
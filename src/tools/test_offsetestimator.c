@@ -0,0 +1,145 @@
+/*-
+ * Copyright (c) 2026 PTPd contributors,
+ *
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file   test_offsetestimator.c
+ * @date   Sun Oct 18 09:01:00 2026
+ *
+ * @brief  Clock offset estimator check
+ *
+ * Feeds the offset estimator with synthetic clock reads: a true offset of
+ * 1 us, read latency of 600-700 ns with +/-10 ns of measurement noise, and
+ * on a busy bus a 30% chance of an extra 0-8 us delay which skews the
+ * measured offset by up to half of it. Compares the mean absolute error
+ * of fastest-sample mode with a 50th percentile cut, and checks that the
+ * adaptive window stays within bounds and grows on the busy bus.
+ */
+
+#include "../ptpd.h"
+#include "testutil.h"
+
+#define TRUE_OFFSET	1000
+#define MEASUREMENTS	2000
+#define WARMUP		200
+
+
+/* run one estimator over the synthetic reads, return the mean absolute error in ns */
+static double
+runEstimator(int rejectPercentile, Boolean busy, int *window)
+{
+
+	OffsetEstimator estimator;
+	OffsetSample samples[OFFSETEST_MAX_SAMPLES];
+	TimeInternal output;
+	double error = 0;
+	int m, i, count = 0;
+
+	randomSeed(TEST_RANDOM_SEED);
+
+	setupOffsetEstimator(&estimator);
+	estimator.rejectPercentile = rejectPercentile;
+	estimator.reset(&estimator);
+
+	for(m = 0; m < MEASUREMENTS; m++) {
+
+		int w = estimator.getWindow(&estimator);
+
+		if(w < OFFSETEST_MIN_SAMPLES || w > OFFSETEST_MAX_SAMPLES) {
+			fprintf(stderr, "window %d out of bounds\n", w);
+			return -1;
+		}
+
+		for(i = 0; i < w; i++) {
+			int tail = (busy && (randomNext32() % 10) < 3) ? randomNext32() % 8000 : 0;
+			int skew = (randomNext32() & 1) ? tail / 2 : -tail / 2;
+			samples[i].duration = 600 + randomNext32() % 100 + tail;
+			samples[i].offset.seconds = 0;
+			samples[i].offset.nanoseconds = TRUE_OFFSET + skew + (int)(randomNext32() % 21) - 10;
+		}
+
+		if(!estimator.estimate(&estimator, samples, w, &output)) {
+			fprintf(stderr, "estimate failed\n");
+			return -1;
+		}
+
+		if(m >= WARMUP) {
+			error += fabs(output.seconds * 1E9 + output.nanoseconds - TRUE_OFFSET);
+			count++;
+		}
+
+	}
+
+	*window = estimator.getWindow(&estimator);
+	return error / count;
+
+}
+
+int
+main(int argc, char **argv)
+{
+
+	OffsetEstimator estimator;
+	OffsetSample sample;
+	TimeInternal output;
+	double fastest, percentile, quiet;
+	int fastestWindow, percentileWindow, quietWindow;
+
+	/* a cross-timestamp has no latency: it must come out as it went in */
+	setupOffsetEstimator(&estimator);
+	sample.duration = -1;
+	sample.offset.seconds = 0;
+	sample.offset.nanoseconds = -1234;
+	if(!estimator.estimate(&estimator, &sample, 1, &output) ||
+	    output.seconds != 0 || output.nanoseconds != -1234) {
+		fprintf(stderr, "cross-timestamp sample changed: %d.%09d\n",
+		    output.seconds, output.nanoseconds);
+		return 1;
+	}
+
+	if((quiet = runEstimator(0, FALSE, &quietWindow)) < 0 ||
+	    (fastest = runEstimator(0, TRUE, &fastestWindow)) < 0 ||
+	    (percentile = runEstimator(50, TRUE, &percentileWindow)) < 0) {
+		return 1;
+	}
+
+	printf("quiet bus, fastest sample: mean abs error %.1f ns, window %d\n", quiet, quietWindow);
+	printf("busy bus, fastest sample:  mean abs error %.1f ns, window %d\n", fastest, fastestWindow);
+	printf("busy bus, 50th percentile: mean abs error %.1f ns, window %d\n", percentile, percentileWindow);
+
+	if(fastestWindow <= quietWindow) {
+		fprintf(stderr, "adaptive window did not grow on the busy bus\n");
+		return 1;
+	}
+
+	if(percentile >= fastest) {
+		fprintf(stderr, "percentile cut did not improve on the fastest sample\n");
+		return 1;
+	}
+
+	return 0;
+
+}
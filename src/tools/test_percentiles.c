@@ -0,0 +1,221 @@
+/*-
+ * Copyright (c) 2026 PTPd contributors,
+ *
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file   test_percentiles.c
+ * @date   Sun Oct 18 09:24:23 2026
+ *
+ * @brief  P-square percentile estimator check and benchmark
+ *
+ * Feeds the slave statistics percentile estimators with windows of delay
+ * like samples - uniform, exponential queueing and exponential with rare
+ * large spikes - and compares p50, p90, p99 and p99.9 with the nearest
+ * rank percentiles of the sorted window. Windows of up to
+ * STAT_PERCENTILE_EXACT samples must match exactly. For longer windows
+ * the mean error over many windows must stay within a few tens of ns at
+ * p50 and p90, and the p50 must be closer than the median-of-3 buckets
+ * the slave statistics used before.
+ *
+ * Then times all four estimators per sample. Run with -b for the
+ * timing.
+ */
+
+#include "../ptpd.h"
+#include "testutil.h"
+
+#define TEST_WINDOWS	200
+#define LONG_WINDOW	3000
+/* mean absolute error allowed over LONG_WINDOW samples, ns: p50, p90 */
+#define P50_ERROR	20.0
+#define P90_ERROR	150.0
+#define BENCH_SAMPLES	1000000
+
+
+/* uniform in (0,1] */
+static double
+randomUniform(void)
+{
+	return ((randomNext() >> 11) + 1) / 9007199254740992.0;
+}
+
+/* 20 us path delay: +/-0.5 us uniform, 2 us exponential queueing, or 1 us plus 2% spikes up to 200 us */
+static double
+delaySample(int kind)
+{
+
+	switch(kind) {
+	    case 0:
+		return 20E-6 + (randomUniform() - 0.5) * 1E-6;
+	    case 1:
+		return 20E-6 - 2E-6 * log(randomUniform());
+	    default:
+		return 20E-6 - 1E-6 * log(randomUniform()) +
+		    (randomUniform() < 0.02 ? 200E-6 * randomUniform() : 0.0);
+	}
+
+}
+
+static int
+cmpDouble(const void *vA, const void *vB)
+{
+	double a = *(double*)vA;
+	double b = *(double*)vB;
+
+	return ((a < b) ? -1 : (a > b) ? 1 : 0);
+}
+
+/* nearest rank percentile of a sorted window */
+static double
+nearestRank(const double *sorted, int count, double p)
+{
+	int rank = (int)ceil(p * count) - 1;
+
+	return sorted[max(rank, 0)];
+}
+
+static Boolean
+checkExact(int kind)
+{
+
+	static const double percentiles[STAT_PERCENTILE_COUNT] = STAT_PERCENTILES;
+	DoublePermanentPercentiles estimator;
+	double window[STAT_PERCENTILE_EXACT];
+	int count, i, j;
+
+	for(count = 1; count <= STAT_PERCENTILE_EXACT; count++) {
+
+		resetDoublePermanentPercentiles(&estimator);
+
+		for(i = 0; i < count; i++) {
+			window[i] = delaySample(kind);
+			feedDoublePermanentPercentiles(&estimator, window[i]);
+		}
+
+		qsort(window, count, sizeof(double), cmpDouble);
+
+		for(j = 0; j < STAT_PERCENTILE_COUNT; j++) {
+			if(getDoublePermanentPercentile(&estimator, j) != nearestRank(window, count, percentiles[j])) {
+				fprintf(stderr, "distribution %d, %d samples, p%g: got %.09f, expected %.09f\n",
+				    kind, count, percentiles[j] * 100.0, getDoublePermanentPercentile(&estimator, j),
+				    nearestRank(window, count, percentiles[j]));
+				return FALSE;
+			}
+		}
+
+	}
+
+	return TRUE;
+
+}
+
+static Boolean
+checkLongWindow(int kind)
+{
+
+	static const double percentiles[STAT_PERCENTILE_COUNT] = STAT_PERCENTILES;
+	static const char *names[STAT_PERCENTILE_COUNT] = STAT_PERCENTILE_NAMES;
+	static double window[LONG_WINDOW];
+	DoublePermanentPercentiles estimator;
+	DoublePermanentMedian median;
+	double error[STAT_PERCENTILE_COUNT] = { 0 };
+	double medianError = 0;
+	int w, i, j;
+
+	for(w = 0; w < TEST_WINDOWS; w++) {
+
+		resetDoublePermanentPercentiles(&estimator);
+		resetDoublePermanentMedian(&median);
+
+		for(i = 0; i < LONG_WINDOW; i++) {
+			window[i] = delaySample(kind);
+			feedDoublePermanentPercentiles(&estimator, window[i]);
+			feedDoublePermanentMedian(&median, window[i]);
+		}
+
+		qsort(window, LONG_WINDOW, sizeof(double), cmpDouble);
+
+		for(j = 0; j < STAT_PERCENTILE_COUNT; j++) {
+			error[j] += fabs(getDoublePermanentPercentile(&estimator, j) -
+				    nearestRank(window, LONG_WINDOW, percentiles[j]));
+		}
+		medianError += fabs(median.median - nearestRank(window, LONG_WINDOW, 0.5));
+
+	}
+
+	printf("distribution %d, %d samples: mean error", kind, LONG_WINDOW);
+	for(j = 0; j < STAT_PERCENTILE_COUNT; j++) {
+		error[j] *= 1E9 / TEST_WINDOWS;
+		printf(" %s %.1f ns,", names[j], error[j]);
+	}
+	medianError *= 1E9 / TEST_WINDOWS;
+	printf(" median-of-3 %.1f ns\n", medianError);
+
+	if(error[0] > P50_ERROR || error[1] > P90_ERROR || error[0] >= medianError) {
+		fprintf(stderr, "distribution %d: p50 error %.1f ns, p90 error %.1f ns, median-of-3 error %.1f ns\n",
+		    kind, error[0], error[1], medianError);
+		return FALSE;
+	}
+
+	return TRUE;
+
+}
+
+int
+main(int argc, char **argv)
+{
+
+	DoublePermanentPercentiles estimator;
+	static double samples[BENCH_SAMPLES];
+	struct timespec start;
+	int kind, i;
+
+	for(kind = 0; kind < 3; kind++) {
+		if(!checkExact(kind) || !checkLongWindow(kind)) {
+			return 1;
+		}
+	}
+
+	printf("windows up to %d samples are exact\n", STAT_PERCENTILE_EXACT);
+
+	if(!testBenchmark(argc, argv)) {
+		return 0;
+	}
+
+	for(i = 0; i < BENCH_SAMPLES; i++) {
+		samples[i] = delaySample(2);
+	}
+
+	resetDoublePermanentPercentiles(&estimator);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(i = 0; i < BENCH_SAMPLES; i++) {
+		feedDoublePermanentPercentiles(&estimator, samples[i]);
+	}
+	printf("%d percentiles: %.1f ns/sample\n", STAT_PERCENTILE_COUNT, testElapsed(&start) / BENCH_SAMPLES);
+
+	return 0;
+
+}
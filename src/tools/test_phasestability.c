@@ -0,0 +1,239 @@
+/*-
+ * Copyright (c) 2026 PTPd contributors,
+ *
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file   test_phasestability.c
+ * @date   Sun Oct 18 09:22:43 2026
+ *
+ * @brief  MTIE / TDEV / ADEV phase stability check and benchmark
+ *
+ * Feeds the streaming phase stability statistics with a random walk plus
+ * white phase noise and compares MTIE, TDEV and overlapping ADEV for each
+ * observation interval with a brute force computation over the whole
+ * record: the largest peak to peak in every window of the interval, and
+ * the second differences of phase and of window sums. Intervals computed
+ * at level 0 of the decimation cascade must match to rounding; intervals
+ * computed on decimated blocks must be within a few percent. Then checks
+ * that a reset gives the same results again.
+ *
+ * Then times the default interval set per sample. Run with -b for the
+ * timing.
+ */
+
+#include "../ptpd.h"
+#include "testutil.h"
+
+#define TEST_SAMPLES	20000
+#define BENCH_SAMPLES	1000000
+/* relative error allowed: level 0, decimated levels */
+#define EXACT_ERROR	1E-9
+#define DECIMATED_ERROR	0.03
+
+
+/* uniform in (0,1] */
+static double
+randomUniform(void)
+{
+	return ((randomNext() >> 11) + 1) / 9007199254740992.0;
+}
+
+static double
+randomGauss(void)
+{
+	return sqrt(-2.0 * log(randomUniform())) * cos(2.0 * M_PI * randomUniform());
+}
+
+/* offset from master: 1 us, 1 ns/sample random walk, 20 ns white noise */
+static void
+makePhase(double *phase, int count)
+{
+
+	double walk = 0;
+	int i;
+
+	for(i = 0; i < count; i++) {
+		walk += 1E-9 * randomGauss();
+		phase[i] = 1E-6 + walk + 20E-9 * randomGauss();
+	}
+
+}
+
+/* the textbook estimators over the whole record, n samples per interval */
+static void
+bruteForce(const double *x, int count, int n, double tau0, double *mtie, double *tdev, double *adev)
+{
+
+	double sum = 0, lo, hi;
+	int i, j, c = 0;
+
+	for(*mtie = 0, i = 0; i + n < count; i++) {
+		for(lo = hi = x[i], j = i + 1; j <= i + n; j++) {
+			lo = min(lo, x[j]);
+			hi = max(hi, x[j]);
+		}
+		*mtie = max(*mtie, hi - lo);
+	}
+
+	for(i = 0; i + 2 * n < count; i++, c++) {
+		double d = x[i + 2 * n] - 2 * x[i + n] + x[i];
+		sum += d * d;
+	}
+	*adev = sqrt(sum / (2.0 * c)) / (n * tau0);
+
+	for(sum = 0, c = 0, j = 0; j + 3 * n <= count; j++, c++) {
+		double t = 0;
+		for(i = j; i < j + n; i++) {
+			t += x[i + 2 * n] - 2 * x[i + n] + x[i];
+		}
+		sum += t * t;
+	}
+	*tdev = sqrt(sum / (6.0 * n * n * c));
+
+}
+
+static Boolean
+withinError(double value, double reference, double error)
+{
+	return fabs(value - reference) <= error * fabs(reference);
+}
+
+static Boolean
+checkIntervals(const char *intervals, double tau0, double *worst)
+{
+
+	PhaseStability *stability = createPhaseStability(intervals);
+	PhaseStabilityInterval *interval, first[STABILITY_MAX_INTERVALS];
+	double phase[TEST_SAMPLES];
+	double mtie, tdev, adev, error;
+	int round, i, n;
+
+	if(stability == NULL) {
+		fprintf(stderr, "could not create phase stability for \"%s\"\n", intervals);
+		return FALSE;
+	}
+
+	makePhase(phase, TEST_SAMPLES);
+
+	/* the second round after a reset must give the same results */
+	for(round = 0; round < 2; round++) {
+
+		resetPhaseStability(stability, tau0);
+		for(i = 0; i < TEST_SAMPLES; i++) {
+			feedPhaseStability(stability, phase[i]);
+		}
+		statPhaseStability(stability);
+
+		if(round == 0) {
+			memcpy(first, stability->interval, sizeof(first));
+			continue;
+		}
+
+		for(i = 0; i < stability->intervalCount; i++) {
+			if(memcmp(&first[i], &stability->interval[i], sizeof(PhaseStabilityInterval))) {
+				fprintf(stderr, "tau %d at tau0 %.3f differs after a reset\n",
+				    stability->interval[i].tau, tau0);
+				return FALSE;
+			}
+		}
+
+	}
+
+	for(i = 0; i < stability->intervalCount; i++) {
+
+		interval = &stability->interval[i];
+		n = lround(interval->actualTau / tau0);
+		error = (interval->level == 0) ? EXACT_ERROR : DECIMATED_ERROR;
+
+		if(!interval->valid) {
+			fprintf(stderr, "tau %d at tau0 %.3f not valid after %d samples\n",
+			    interval->tau, tau0, TEST_SAMPLES);
+			return FALSE;
+		}
+
+		bruteForce(phase, TEST_SAMPLES, n, tau0, &mtie, &tdev, &adev);
+
+		if(!withinError(interval->mtie, mtie, error) || !withinError(interval->tdev, tdev, error) ||
+		    !withinError(interval->adev, adev, error)) {
+			fprintf(stderr, "tau %d at tau0 %.3f (level %d, span %d): MTIE %.4e / %.4e, "
+			    "TDEV %.4e / %.4e, ADEV %.4e / %.4e\n", interval->tau, tau0,
+			    interval->level, interval->span, interval->mtie, mtie,
+			    interval->tdev, tdev, interval->adev, adev);
+			return FALSE;
+		}
+
+		if(interval->level > 0) {
+			*worst = max(*worst, fabs(interval->tdev - tdev) / tdev);
+			*worst = max(*worst, fabs(interval->adev - adev) / adev);
+			*worst = max(*worst, fabs(interval->mtie - mtie) / mtie);
+		}
+
+	}
+
+	freePhaseStability(&stability);
+
+	return TRUE;
+
+}
+
+int
+main(int argc, char **argv)
+{
+
+	PhaseStability *stability;
+	struct timespec start;
+	double worst = 0, walk = 0;
+	int i;
+
+	if(!checkIntervals("1 10 50 100 300 1000", 1.0, &worst) ||
+	    !checkIntervals("1 8 16 64", 0.125, &worst) ||
+	    !checkIntervals("2 3 40 127 128 129", 0.5, &worst)) {
+		return 1;
+	}
+
+	printf("level 0 intervals match the brute force reference, decimated ones within %.2f%%\n",
+	    worst * 100.0);
+
+	if(!testBenchmark(argc, argv)) {
+		return 0;
+	}
+
+	stability = createPhaseStability(STABILITY_DEFAULT_INTERVALS);
+	resetPhaseStability(stability, 1.0);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(i = 0; i < BENCH_SAMPLES; i++) {
+		walk += 1E-9 * randomGauss();
+		feedPhaseStability(stability, walk);
+	}
+	printf("intervals \"%s\": %.1f ns/sample, %d levels\n", STABILITY_DEFAULT_INTERVALS,
+	    testElapsed(&start) / BENCH_SAMPLES, stability->levelCount);
+
+	freePhaseStability(&stability);
+
+	return 0;
+
+}
@@ -0,0 +1,184 @@
+/*-
+ * Copyright (c) 2026 PTPd contributors,
+ *
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file   test_ptparena.c
+ * @date   Sun Oct 18 09:08:07 2026
+ *
+ * @brief  lib1588 message arena check and benchmark
+ *
+ * Unpacks and repacks a Delay_Resp carrying a PTPMON response TLV - what
+ * protocol.c does for PTPMON - with a message arena in use, and checks
+ * that the packed message comes out byte for byte the same, that nothing
+ * fell back to the heap and that resetPtpArena() returns everything. With
+ * an arena too small for the message, the output must still be the same
+ * and the fallbacks counted. Then times the arena against the heap.
+ * Run with -b for the timing.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "../lib1588/ptp_message.h"
+#include "../lib1588/ptp_tlv.h"
+#include "testutil.h"
+
+#define TEST_MESSAGES	100000
+#define PTP_ARENA_SIZE	4096
+
+static uint64_t arenaBuffer[PTP_ARENA_SIZE / sizeof(uint64_t)];
+
+/* unpack the message and pack it again, return the packed length */
+static int
+repack(char *out, size_t outSize, char *in, int length)
+{
+
+	PtpMessage message;
+	int ret;
+
+	memset(&message, 0, sizeof(message));
+
+	if((ret = unpackPtpMessage(&message, in, in + length)) >= 0) {
+		ret = packPtpMessage(out, &message, out + outSize);
+	}
+
+	freePtpMessage(&message);
+
+	return ret;
+
+}
+
+static int
+repackInArena(PtpArena *arena, char *out, size_t outSize, char *in, int length)
+{
+
+	PtpArena *previous = usePtpArena(arena);
+	int ret = repack(out, outSize, in, length);
+
+	usePtpArena(previous);
+	resetPtpArena(arena);
+
+	return ret;
+
+}
+
+int
+main(int argc, char **argv)
+{
+
+	char reference[1500], buf[1500];
+	PtpMessage message;
+	PtpTlv *tlv;
+	PtpArena arena, tiny;
+	char tinyBuffer[64];
+	struct timespec start;
+	double arenaTime, heapTime;
+	int length, i;
+
+	/* the kind of message the PTPMON code rebuilds for every Delay_Req */
+	memset(&message, 0, sizeof(message));
+	memset(reference, 0, sizeof(reference));
+	message.header.messageType = PTP_MSGTYPE_DELAY_RESP;
+	message.header.versionPTP = 2;
+	message.header.messageLength = PTP_MSGLEN_DELAY_RESP;
+	tlv = createPtpTlv();
+	tlv->tlvType = PTP_TLVTYPE_PTPMON_RESPONSE;
+	tlv->body.ptpMonResponse.parentPortAddress.addressLength = 4;
+	tlv->body.ptpMonResponse.parentPortAddress.networkProtocol = 1;
+	tlv->body.ptpMonResponse.parentPortAddress.addressField = ptpCalloc(4);
+	memcpy(tlv->body.ptpMonResponse.parentPortAddress.addressField, "\x0a\x00\x00\x01", 4);
+	attachPtpTlv(&message, tlv);
+	length = packPtpMessage(reference, &message, reference + sizeof(reference));
+	freePtpMessage(&message);
+
+	if(length <= PTP_MSGLEN_DELAY_RESP) {
+		fprintf(stderr, "could not pack the test message: %d\n", length);
+		return 1;
+	}
+
+	initPtpArena(&arena, arenaBuffer, sizeof(arenaBuffer));
+
+	for(i = 0; i < TEST_MESSAGES; i++) {
+		memset(buf, 0, sizeof(buf));
+		if(repackInArena(&arena, buf, sizeof(buf), reference, length) != length ||
+		    memcmp(buf, reference, length)) {
+			fprintf(stderr, "message %d changed after repacking in the arena\n", i);
+			return 1;
+		}
+		if(arena.used != 0) {
+			fprintf(stderr, "arena not empty after reset: %zu bytes\n", arena.used);
+			return 1;
+		}
+	}
+
+	if(arena.fallbacks != 0) {
+		fprintf(stderr, "%u allocations fell back to the heap\n", arena.fallbacks);
+		return 1;
+	}
+
+	/* too small for the TLV: the heap takes over, the result is the same */
+	initPtpArena(&tiny, tinyBuffer, sizeof(tinyBuffer));
+	memset(buf, 0, sizeof(buf));
+	if(repackInArena(&tiny, buf, sizeof(buf), reference, length) != length ||
+	    memcmp(buf, reference, length)) {
+		fprintf(stderr, "message changed after repacking in a full arena\n");
+		return 1;
+	}
+
+	if(tiny.fallbacks == 0) {
+		fprintf(stderr, "full arena did not count its fallbacks\n");
+		return 1;
+	}
+
+	printf("%d messages of %d bytes repacked in the arena, 0 heap allocations; "
+	    "%u fallbacks with a %zu byte arena\n", TEST_MESSAGES, length, tiny.fallbacks,
+	    sizeof(tinyBuffer));
+
+	if(!testBenchmark(argc, argv)) {
+		return 0;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(i = 0; i < TEST_MESSAGES; i++) {
+		repackInArena(&arena, buf, sizeof(buf), reference, length);
+	}
+	arenaTime = testElapsed(&start) / TEST_MESSAGES;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(i = 0; i < TEST_MESSAGES; i++) {
+		repack(buf, sizeof(buf), reference, length);
+	}
+	heapTime = testElapsed(&start) / TEST_MESSAGES;
+
+	printf("unpack and repack: heap %.1f ns/message, arena %.1f ns/message\n", heapTime, arenaTime);
+
+	return 0;
+
+}
@@ -0,0 +1,375 @@
+/*-
+ * Copyright (c) 2026 PTPd contributors,
+ *
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file   test_scaledtime.c
+ * @date   Sun Oct 18 09:20:35 2026
+ *
+ * @brief  Scaled nanosecond servo arithmetic check
+ *
+ * Compares the scaled nanosecond arithmetic of the servo with the
+ * TimeInternal chain it replaced: subTime(), addTime(), div2Time() and
+ * integer64_to_internalTime(). Intervals include negative values and
+ * differences across second boundaries, and correctionFields have
+ * negative fractions and range up to the largest the scaled arithmetic
+ * accepts. Where the old chain truncated the fraction or the half
+ * nanosecond, the new result must be the exact value rounded once and at
+ * most 1 ns away from the old one; otherwise the two must agree exactly.
+ *
+ * Then feeds correctionFields anywhere in the 64-bit range, and checks
+ * that sums saturate instead of overflowing and that a saturated mean
+ * path delay is rejected as over a second.
+ */
+
+#include "../ptpd.h"
+#include "testutil.h"
+
+#define TEST_CASES	1000000
+
+
+static int64_t
+randomRange(int64_t range)
+{
+	return (int64_t)(randomNext() % (2 * range + 1)) - range;
+}
+
+static int64_t
+nanoseconds(const TimeInternal *t)
+{
+	return (int64_t)t->seconds * 1000000000LL + t->nanoseconds;
+}
+
+/* a normalised interval up to +/-seconds, often just either side of a second boundary */
+static TimeInternal
+randomTime(int seconds)
+{
+
+	TimeInternal t;
+
+	t.seconds = randomRange(seconds);
+
+	switch(randomNext() % 4) {
+	    case 0:
+		t.nanoseconds = randomNext() % 3;
+		break;
+	    case 1:
+		t.nanoseconds = 999999999 - randomNext() % 3;
+		break;
+	    default:
+		t.nanoseconds = randomNext() % 1000000000;
+	}
+
+	if(t.seconds < 0 || (t.seconds == 0 && (randomNext() & 1))) {
+		t.nanoseconds = -t.nanoseconds;
+	}
+
+	return t;
+
+}
+
+/* the second of a pair: a second apart from the first, or anywhere */
+static TimeInternal
+randomPair(const TimeInternal *x, int seconds)
+{
+
+	TimeInternal y = randomTime(seconds);
+
+	if(randomNext() & 1) {
+		y.seconds = x->seconds + randomRange(1);
+		y.nanoseconds = (y.seconds < 0) ? -abs(y.nanoseconds) : abs(y.nanoseconds);
+	}
+
+	return y;
+
+}
+
+/* a correctionField up to +/-limit ns, with a fraction, or whole nanoseconds */
+static int64_t
+randomCorrection(int64_t limit)
+{
+
+	int64_t correction = randomRange(limit) * SCALED_NS_ONE;
+
+	if(randomNext() & 1) {
+		correction += (correction < 0 ? -1 : 1) * (int64_t)(randomNext() % SCALED_NS_ONE);
+	}
+
+	return correction;
+
+}
+
+static Integer64
+toInteger64(int64_t value)
+{
+
+	Integer64 r;
+
+	r.msb = (Integer32)((uint64_t)value >> 32);
+	r.lsb = (UInteger32)value;
+
+	return r;
+
+}
+
+/* exact value in 2^-bits ns units, rounded to ns, halves away from zero */
+static int64_t
+roundExact(int64_t value, int bits)
+{
+
+	uint64_t magnitude = (value < 0) ? -(uint64_t)value : (uint64_t)value;
+
+	magnitude = (magnitude + (1ULL << (bits - 1))) >> bits;
+
+	return (value < 0) ? -(int64_t)magnitude : (int64_t)magnitude;
+
+}
+
+/*
+ * x + y or x - y as the saturating helpers should give it: overflow found by
+ * the sign of the wrapped result, +/-INT64_MAX kept once reached
+ */
+static int64_t
+refSaturated(int64_t x, int64_t y, Boolean subtract)
+{
+
+	uint64_t u = subtract ? (uint64_t)x - (uint64_t)y : (uint64_t)x + (uint64_t)y;
+	int64_t r = (int64_t)u;
+	Boolean sameSign = ((x < 0) == (y < 0));
+
+	if(llabs(x) == INT64_MAX) {
+		return x;
+	}
+
+	if(llabs(y) == INT64_MAX) {
+		return subtract ? -y : y;
+	}
+
+	if((subtract ? !sameSign : sameSign) && ((r < 0) != (x < 0))) {
+		return (x < 0) ? -INT64_MAX : INT64_MAX;
+	}
+
+	return (r == INT64_MIN) ? -INT64_MAX : r;
+
+}
+
+static Boolean
+checkDifference(void)
+{
+
+	TimeInternal x = randomTime(50000);
+	TimeInternal y = randomPair(&x, 50000);
+	TimeInternal old, new;
+	ScaledNanoseconds s;
+	double oldDouble;
+
+	subTime(&old, &x, &y);
+
+	if(!scaledTimeDiff(&s, &x, &y)) {
+		fprintf(stderr, "%d.%09d - %d.%09d out of the scaled range\n",
+		    x.seconds, x.nanoseconds, y.seconds, y.nanoseconds);
+		return FALSE;
+	}
+
+	scaledToTimeInternal(s, &new);
+	oldDouble = timeInternalToDouble(&old);
+
+	if(old.seconds != new.seconds || old.nanoseconds != new.nanoseconds ||
+	    fabs(scaledToDouble(s) - oldDouble) > 1E-15 * fabs(oldDouble)) {
+		fprintf(stderr, "%d.%09d - %d.%09d: subTime %d.%09d, scaled %d.%09d\n",
+		    x.seconds, x.nanoseconds, y.seconds, y.nanoseconds,
+		    old.seconds, old.nanoseconds, new.seconds, new.nanoseconds);
+		return FALSE;
+	}
+
+	return TRUE;
+
+}
+
+static Boolean
+checkCorrection(void)
+{
+
+	int64_t correction = randomCorrection(SCALED_NS_MAX_NS);
+	int64_t truncated = (correction < 0) ? -(-correction >> SCALED_NS_SHIFT) : correction >> SCALED_NS_SHIFT;
+	TimeInternal old;
+
+	integer64_to_internalTime(toInteger64(correction), &old);
+
+	if(integer64ToScaled(toInteger64(correction)) != correction || nanoseconds(&old) != truncated) {
+		fprintf(stderr, "correctionField %lld: scaled %lld, old %lld ns\n", (long long)correction,
+		    (long long)integer64ToScaled(toInteger64(correction)), (long long)nanoseconds(&old));
+		return FALSE;
+	}
+
+	return TRUE;
+
+}
+
+/* updateOffset(): delayMS less the correctionField, less the mean path delay */
+static Boolean
+checkOffsetFromMaster(void)
+{
+
+	TimeInternal send = randomTime(20000);
+	TimeInternal recv = randomPair(&send, 20000);
+	TimeInternal mpd = randomTime(1);
+	int64_t correction = randomCorrection(SCALED_NS_MAX_NS / 2);
+	TimeInternal correctionField, delayMS, old, new;
+	ScaledNanoseconds delay;
+	int64_t exact;
+
+	/* the old chain */
+	integer64_to_internalTime(toInteger64(correction), &correctionField);
+	subTime(&delayMS, &recv, &send);
+	subTime(&delayMS, &delayMS, &correctionField);
+	subTime(&old, &delayMS, &mpd);
+
+	/* the new one */
+	scaledTimeDiff(&delay, &recv, &send);
+	delay = correctedDelay(delay, correction);
+	scaledToTimeInternal(scaledSub(delay, timeInternalToScaled(&mpd)), &new);
+
+	exact = (nanoseconds(&recv) - nanoseconds(&send) - nanoseconds(&mpd)) * SCALED_NS_ONE - correction;
+
+	if(nanoseconds(&new) != roundExact(exact, SCALED_NS_SHIFT) ||
+	    llabs(nanoseconds(&new) - nanoseconds(&old)) > 1 ||
+	    ((correction % SCALED_NS_ONE) == 0 && nanoseconds(&new) != nanoseconds(&old))) {
+		fprintf(stderr, "offset with correctionField %lld: old %d.%09d, scaled %d.%09d\n",
+		    (long long)correction, old.seconds, old.nanoseconds, new.seconds, new.nanoseconds);
+		return FALSE;
+	}
+
+	return TRUE;
+
+}
+
+/* updateDelay() and updatePeerDelay(): half of both delays less the correctionField */
+static Boolean
+checkMeanPathDelay(void)
+{
+
+	TimeInternal delayMS = randomTime(20000);
+	TimeInternal delaySM = randomPair(&delayMS, 20000);
+	int64_t correction = randomCorrection(SCALED_NS_MAX_NS / 2);
+	TimeInternal correctionField, old, new;
+	int64_t exact;
+
+	integer64_to_internalTime(toInteger64(correction), &correctionField);
+	addTime(&old, &delaySM, &delayMS);
+	subTime(&old, &old, &correctionField);
+	div2Time(&old);
+
+	scaledToTimeInternal(calcMeanPathDelay(timeInternalToScaled(&delayMS),
+	    timeInternalToScaled(&delaySM), correction), &new);
+
+	exact = (nanoseconds(&delayMS) + nanoseconds(&delaySM)) * SCALED_NS_ONE - correction;
+
+	if(nanoseconds(&new) != roundExact(exact, SCALED_NS_SHIFT + 1) ||
+	    llabs(nanoseconds(&new) - nanoseconds(&old)) > 1 ||
+	    ((exact % (2 * SCALED_NS_ONE)) == 0 && nanoseconds(&new) != nanoseconds(&old))) {
+		fprintf(stderr, "mean path delay with correctionField %lld: old %d.%09d, scaled %d.%09d\n",
+		    (long long)correction, old.seconds, old.nanoseconds, new.seconds, new.nanoseconds);
+		return FALSE;
+	}
+
+	return TRUE;
+
+}
+
+/*
+ * correctionFields anywhere in 64 bits, against delays up to the largest
+ * scaledTimeDiff() gives: the sums saturate, and once saturated the offset
+ * is dropped and the mean path delay rejected as over a second
+ */
+static Boolean
+checkLargeCorrection(int i)
+{
+
+	static const int64_t edges[] = { INT64_MAX, INT64_MIN, INT64_MAX - 1, INT64_MIN + 1,
+					  1LL << 62, -(1LL << 62), 0, -1 };
+	const int count = sizeof(edges) / sizeof(edges[0]);
+	const ScaledNanoseconds limit = SCALED_NS_MAX_NS * SCALED_NS_ONE;
+	int64_t raw = (i < count * count) ? edges[i % count] : (int64_t)randomNext();
+	int64_t rawPrevious = (i < count * count) ? edges[i / count] : (int64_t)randomNext() >> (randomNext() % 64);
+	ScaledNanoseconds correction = integer64ToScaled(toInteger64(raw));
+	ScaledNanoseconds previous = integer64ToScaled(toInteger64(rawPrevious));
+	ScaledNanoseconds delayMS = (randomNext() & 1) ? limit : (int64_t)(randomNext() % limit);
+	ScaledNanoseconds delaySM = (randomNext() & 1) ? -limit : -(int64_t)(randomNext() % limit);
+	ScaledNanoseconds sum, delay, mpd;
+	TimeInternal t;
+
+	if(correction != ((raw == INT64_MIN) ? -INT64_MAX : raw)) {
+		fprintf(stderr, "correctionField %lld read as %lld\n", (long long)raw, (long long)correction);
+		return FALSE;
+	}
+
+	/* Sync + Follow_Up, Pdelay_Resp + Pdelay_Resp_Follow_Up */
+	sum = scaledAdd(correction, previous);
+	delay = correctedDelay(delayMS, sum);
+	mpd = calcMeanPathDelay(delayMS, delaySM, sum);
+
+	if(sum != refSaturated(correction, previous, FALSE) ||
+	    delay != refSaturated(delayMS, sum, TRUE) ||
+	    mpd != refSaturated(refSaturated(delayMS, delaySM, FALSE), sum, TRUE) / 2) {
+		fprintf(stderr, "correctionField %lld + %lld: sum %lld, delay %lld, mean path delay %lld\n",
+		    (long long)correction, (long long)previous, (long long)sum, (long long)delay, (long long)mpd);
+		return FALSE;
+	}
+
+	if(llabs(sum) == INT64_MAX && (llabs(delay) != INT64_MAX || llabs(mpd) < SCALED_NS_SECOND)) {
+		fprintf(stderr, "correctionField out of range: delay %lld, mean path delay %lld accepted\n",
+		    (long long)delay, (long long)mpd);
+		return FALSE;
+	}
+
+	/* as the servo stores them */
+	scaledToTimeInternal(delay, &t);
+	scaledToTimeInternal(mpd, &t);
+
+	return TRUE;
+
+}
+
+int
+main(int argc, char **argv)
+{
+
+	int i;
+
+	for(i = 0; i < TEST_CASES; i++) {
+		if(!checkDifference() || !checkCorrection() || !checkOffsetFromMaster() ||
+		    !checkMeanPathDelay() || !checkLargeCorrection(i)) {
+			return 1;
+		}
+	}
+
+	printf("%d differences, correctionFields, offsets, mean path delays and large corrections "
+	    "each match the TimeInternal arithmetic\n", TEST_CASES);
+
+	return 0;
+
+}
@@ -0,0 +1,314 @@
+/*-
+ * Copyright (c) 2026 PTPd contributors,
+ *
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file   test_statfilter.c
+ * @date   Sun Oct 18 08:56:54 2026
+ *
+ * @brief  Moving stat filter check and benchmark
+ *
+ * Feeds every moving stat filter type, int and double, with random walk
+ * and noisy samples over a range of window sizes, and compares each output
+ * with the original implementation: copy the window, qsort it and read the
+ * order statistic. Absmin and absmax only have to agree in magnitude, as
+ * the qsort based version picked either of two equal-magnitude values.
+ *
+ * Then times the median and MAD filters against the qsort reference for
+ * a few window sizes. Run with -b for the timing.
+ */
+
+#include "../ptpd.h"
+#include "testutil.h"
+
+#define TEST_SAMPLES	5000
+#define BENCH_SAMPLES	2000
+
+
+static int
+cmpInt32(const void *vA, const void *vB)
+{
+	int32_t a = *(int32_t*)vA;
+	int32_t b = *(int32_t*)vB;
+
+	return ((a < b) ? -1 : (a > b) ? 1 : 0);
+}
+
+static int
+cmpDouble(const void *vA, const void *vB)
+{
+	double a = *(double*)vA;
+	double b = *(double*)vB;
+
+	return ((a < b) ? -1 : (a > b) ? 1 : 0);
+}
+
+/* the qsort based filter output for the current window, as statistics.c computed it before */
+static int32_t
+refIntFilter(int type, const int32_t *samples, int count, int32_t sample)
+{
+
+	int32_t sorted[count];
+	int32_t median;
+	int i;
+	Boolean odd = ((count % 2) == 1);
+
+	memcpy(sorted, samples, count * sizeof(int32_t));
+	qsort(sorted, count, sizeof(int32_t), cmpInt32);
+
+	median = odd ? sorted[count / 2] : (sorted[(count / 2) - 1] + sorted[count / 2]) / 2;
+
+	switch(type) {
+	    case FILTER_MEDIAN:
+		return median;
+	    case FILTER_MAD:
+		for(i = 0; i < count; i++) {
+			sorted[i] = labs(sorted[i] - median);
+		}
+		qsort(sorted, count, sizeof(int32_t), cmpInt32);
+		if(odd) {
+			return sorted[count / 2] / 0.6745;
+		}
+		return ((sorted[(count / 2) - 1] + sorted[count / 2]) / 2) / 0.6745;
+	    case FILTER_MIN:
+		return sorted[0];
+	    case FILTER_MAX:
+		return sorted[count - 1];
+	    case FILTER_ABSMIN:
+		for(i = 1, median = sorted[0]; i < count; i++) {
+			if(labs(sorted[i]) < labs(median)) {
+				median = sorted[i];
+			}
+		}
+		return median;
+	    case FILTER_ABSMAX:
+		return (labs(sorted[0]) > labs(sorted[count - 1])) ? sorted[0] : sorted[count - 1];
+	    default:
+		return sample;
+	}
+
+}
+
+static double
+refDoubleFilter(int type, const double *samples, int count, double sample)
+{
+
+	double sorted[count];
+	double median;
+	int i;
+	Boolean odd = ((count % 2) == 1);
+	Boolean incr = TRUE, decr = TRUE;
+
+	memcpy(sorted, samples, count * sizeof(double));
+	qsort(sorted, count, sizeof(double), cmpDouble);
+
+	median = odd ? sorted[count / 2] : (sorted[(count / 2) - 1] + sorted[count / 2]) / 2;
+
+	switch(type) {
+	    case FILTER_MEDIAN:
+		for(i = 1; i < count; i++) {
+			incr &= (samples[i] > samples[i - 1]);
+			decr &= (samples[i] < samples[i - 1]);
+		}
+		return (incr || decr) ? sample : median;
+	    case FILTER_MAD:
+		for(i = 0; i < count; i++) {
+			sorted[i] = fabs(sorted[i] - median);
+		}
+		qsort(sorted, count, sizeof(double), cmpDouble);
+		if(odd) {
+			return sorted[count / 2] / 0.6745;
+		}
+		return ((sorted[(count / 2) - 1] + sorted[count / 2]) / 2) / 0.6745;
+	    case FILTER_MIN:
+		return sorted[0];
+	    case FILTER_MAX:
+		return sorted[count - 1];
+	    case FILTER_ABSMIN:
+		for(i = 1, median = sorted[0]; i < count; i++) {
+			if(fabs(sorted[i]) < fabs(median)) {
+				median = sorted[i];
+			}
+		}
+		return median;
+	    case FILTER_ABSMAX:
+		return (fabs(sorted[0]) > fabs(sorted[count - 1])) ? sorted[0] : sorted[count - 1];
+	    default:
+		return sample;
+	}
+
+}
+
+/*
+ * Random walk with noise, with runs of rising and falling samples, repeated
+ * values and sign changes, so every branch of the sorted window code runs.
+ */
+static double
+nextSample(double *walk)
+{
+
+	uint64_t r = randomNext();
+
+	switch(r % 8) {
+	    case 0:
+		return *walk;
+	    case 1:
+		*walk += 7;
+		return *walk;
+	    case 2:
+		*walk = -*walk;
+		return *walk;
+	    default:
+		*walk += (double)((int64_t)(r >> 32) % 2001 - 1000);
+		return *walk + (double)((int64_t)(r >> 16) % 101);
+	}
+
+}
+
+static Boolean
+checkFilter(int type, int windowSize)
+{
+
+	StatFilterOptions config = { TRUE, type, windowSize, WINDOW_SLIDING, 0 };
+	IntMovingStatFilter *intFilter = createIntMovingStatFilter(&config, "test");
+	DoubleMovingStatFilter *doubleFilter = createDoubleMovingStatFilter(&config, "test");
+	Boolean absOnly = (type == FILTER_ABSMIN || type == FILTER_ABSMAX);
+	double walk = 0;
+	int i;
+
+	if(intFilter == NULL || doubleFilter == NULL) {
+		fprintf(stderr, "could not create filter type %d window %d\n", type, windowSize);
+		return FALSE;
+	}
+
+	for(i = 0; i < TEST_SAMPLES; i++) {
+
+		double sample = nextSample(&walk);
+		int32_t intSample = (int32_t)sample;
+		int32_t intRef;
+		double doubleRef;
+
+		feedIntMovingStatFilter(intFilter, intSample);
+		feedDoubleMovingStatFilter(doubleFilter, sample);
+
+		intRef = refIntFilter(type, intFilter->meanContainer->samples,
+				    intFilter->meanContainer->count, intSample);
+		doubleRef = refDoubleFilter(type, doubleFilter->meanContainer->samples,
+				    doubleFilter->meanContainer->count, sample);
+
+		if(absOnly ? (labs(intRef) != labs(intFilter->output)) : (intRef != intFilter->output)) {
+			fprintf(stderr, "int filter type %d window %d sample %d: got %d, expected %d\n",
+			    type, windowSize, i, intFilter->output, intRef);
+			return FALSE;
+		}
+
+		if(absOnly ? (fabs(doubleRef) != fabs(doubleFilter->output)) : (doubleRef != doubleFilter->output)) {
+			fprintf(stderr, "double filter type %d window %d sample %d: got %.09f, expected %.09f\n",
+			    type, windowSize, i, doubleFilter->output, doubleRef);
+			return FALSE;
+		}
+
+	}
+
+	freeIntMovingStatFilter(&intFilter);
+	freeDoubleMovingStatFilter(&doubleFilter);
+
+	return TRUE;
+
+}
+
+/* per sample time of the double filter against its qsort reference, in microseconds */
+static void
+benchFilter(int type, int windowSize)
+{
+
+	StatFilterOptions config = { TRUE, type, windowSize, WINDOW_SLIDING, 0 };
+	DoubleMovingStatFilter *filter = createDoubleMovingStatFilter(&config, "bench");
+	struct timespec start;
+	double walk = 0, newTime, refTime;
+	volatile double sink = 0;
+	int i;
+
+	/* fill the window first */
+	for(i = 0; i < windowSize; i++) {
+		feedDoubleMovingStatFilter(filter, nextSample(&walk));
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(i = 0; i < BENCH_SAMPLES; i++) {
+		feedDoubleMovingStatFilter(filter, nextSample(&walk));
+		sink += filter->output;
+	}
+	newTime = testElapsed(&start) / 1E3 / BENCH_SAMPLES;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(i = 0; i < BENCH_SAMPLES; i++) {
+		double sample = nextSample(&walk);
+		feedDoubleMovingMean(filter->meanContainer, sample);
+		sink += refDoubleFilter(type, filter->meanContainer->samples,
+			filter->meanContainer->count, sample);
+	}
+	refTime = testElapsed(&start) / 1E3 / BENCH_SAMPLES;
+
+	printf("%-6s window %4d: qsort %9.3f us/sample, sorted window %7.3f us/sample\n",
+	    type == FILTER_MAD ? "MAD" : "median", windowSize, refTime, newTime);
+
+	freeDoubleMovingStatFilter(&filter);
+
+}
+
+int
+main(int argc, char **argv)
+{
+
+	static const int windows[] = { 1, 2, 3, 4, 5, 8, 16, 31, 64, 127, 128, 255, 1000 };
+	int type, i;
+	int checks = 0;
+
+	/* the mean filter does not sort */
+	for(type = FILTER_MIN; type < FILTER_MAXVALUE; type++) {
+		for(i = 0; i < sizeof(windows) / sizeof(windows[0]); i++) {
+			if(!checkFilter(type, windows[i])) {
+				return 1;
+			}
+			checks++;
+		}
+	}
+
+	printf("%d filter and window combinations match the qsort reference\n", checks);
+
+	if(!testBenchmark(argc, argv)) {
+		return 0;
+	}
+
+	benchFilter(FILTER_MEDIAN, 128);
+	benchFilter(FILTER_MEDIAN, 2560);
+	benchFilter(FILTER_MAD, 128);
+	benchFilter(FILTER_MAD, 2560);
+
+	return 0;
+
+}
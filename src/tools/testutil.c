@@ -0,0 +1,88 @@
+/*-
+ * Copyright (c) 2026 PTPd contributors,
+ *
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file   testutil.c
+ * @date   Sun Oct 18 09:40:00 2026
+ *
+ * @brief  Helpers shared by the make check programs
+ */
+
+#include "../ptpd.h"
+#include "testutil.h"
+
+static uint64_t prngState = TEST_RANDOM_SEED;
+
+/* the sources under test only log through these */
+void
+logMessage(int priority, const char *format, ...)
+{
+}
+
+ClockDriver*
+getSystemClock()
+{
+	return NULL;
+}
+
+void
+randomSeed(uint64_t seed)
+{
+	prngState = seed;
+}
+
+uint64_t
+randomNext(void)
+{
+	prngState ^= prngState >> 12;
+	prngState ^= prngState << 25;
+	prngState ^= prngState >> 27;
+	return prngState * 2685821657736338717ULL;
+}
+
+uint32_t
+randomNext32(void)
+{
+	return randomNext() >> 32;
+}
+
+double
+testElapsed(const struct timespec *start)
+{
+
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) * 1E9 + (now.tv_nsec - start->tv_nsec);
+
+}
+
+int
+testBenchmark(int argc, char **argv)
+{
+	return argc > 1 && !strcmp(argv[1], "-b");
+}
@@ -0,0 +1,59 @@
+/*-
+ * Copyright (c) 2026 PTPd contributors,
+ *
+ * All Rights Reserved
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file   testutil.h
+ * @date   Sun Oct 18 09:40:00 2026
+ *
+ * @brief  Helpers shared by the make check programs
+ *
+ * A repeatable random source, a benchmark timer and the -b switch. The
+ * programs are quiet checks by default: make check runs them as they
+ * are, and -b adds the timings quoted when the code under test went in.
+ * testutil.c also stubs the daemon functions the linked sources log
+ * through.
+ */
+
+#ifndef PTPD_TESTUTIL_H_
+#define PTPD_TESTUTIL_H_
+
+#include <stdint.h>
+#include <time.h>
+
+/* every check starts from the same xorshift64* state, so runs are repeatable */
+#define TEST_RANDOM_SEED	88172645463325252ULL
+
+void randomSeed(uint64_t seed);
+uint64_t randomNext(void);
+uint32_t randomNext32(void);
+
+/* nanoseconds since start, CLOCK_MONOTONIC */
+double testElapsed(const struct timespec *start);
+/* non-zero if -b was given: run the benchmarks after the checks */
+int testBenchmark(int argc, char **argv);
+
+#endif /* PTPD_TESTUTIL_H_ */